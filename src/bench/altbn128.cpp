@@ -0,0 +1,101 @@
+#include <bench/bench.h>
+#include <util/strencodings.h>
+
+#include <libdevcore/FixedHash.h>
+#include <libdevcrypto/AltBn128.h>
+#include <libdevcrypto/LibSnark.h>
+
+#include <cassert>
+#include <vector>
+
+using Precompile = std::pair<bool, dev::bytes> (*)(dev::bytesConstRef);
+
+static const dev::bytes G1 = ParseHex("0000000000000000000000000000000000000000000000000000000000000001"
+                                      "0000000000000000000000000000000000000000000000000000000000000002");
+static const dev::bytes G2 = ParseHex("198e9393920d483a7260bfb731fb5d25f1aa493335a9e71297e485b7aef312c21800deef121f1e76426a00665e5c4479674322d4f75edadd46debd5cd992f6ed"
+                                      "090689d0585ff075ec9e99ad690c3395bc4b313370b38ef355acdadcd122975b12c85ea5db8c6deb4aab71808dcb408fe3d1e7690c43d37b4ce6cc0166fa7daa");
+static const dev::h256 ORDER_MINUS_ONE("30644e72e131a029b85045b68181585d2833e84879b9709143e1f593f0000000");
+
+static void Append(dev::bytes& input, const dev::bytes& part)
+{
+    input.insert(input.end(), part.begin(), part.end());
+}
+
+static dev::bytes MulG1(const dev::bytes& point, const dev::h256& k)
+{
+    dev::bytes input = point;
+    Append(input, k.asBytes());
+    auto result = dev::crypto::libff_alt_bn128_G1_mul(&input);
+    assert(result.first);
+    return result.second;
+}
+
+static void RunPrecompile(benchmark::Bench& bench, Precompile precompile, const dev::bytes& input)
+{
+    bench.run([&] {
+        auto result = precompile(&input);
+        assert(result.first);
+    });
+}
+
+// e(P, G2) * e(-P, G2), the check of a proof verifier with 2 pairs
+static dev::bytes PairingInput()
+{
+    dev::bytes p = MulG1(G1, dev::h256(123456789));
+    dev::bytes input = p;
+    Append(input, G2);
+    Append(input, MulG1(p, ORDER_MINUS_ONE));
+    Append(input, G2);
+    return input;
+}
+
+static dev::bytes AddInput()
+{
+    dev::bytes input = MulG1(G1, dev::h256(123456789));
+    Append(input, MulG1(G1, dev::h256(987654321)));
+    return input;
+}
+
+static dev::bytes MulInput()
+{
+    dev::bytes input = MulG1(G1, dev::h256(123456789));
+    Append(input, ORDER_MINUS_ONE.asBytes());
+    return input;
+}
+
+static void AltBn128Pairing(benchmark::Bench& bench)
+{
+    RunPrecompile(bench, dev::crypto::bn254::pairingProduct, PairingInput());
+}
+
+static void AltBn128PairingLibFF(benchmark::Bench& bench)
+{
+    RunPrecompile(bench, dev::crypto::libff_alt_bn128_pairing_product, PairingInput());
+}
+
+static void AltBn128G1Add(benchmark::Bench& bench)
+{
+    RunPrecompile(bench, dev::crypto::bn254::g1Add, AddInput());
+}
+
+static void AltBn128G1AddLibFF(benchmark::Bench& bench)
+{
+    RunPrecompile(bench, dev::crypto::libff_alt_bn128_G1_add, AddInput());
+}
+
+static void AltBn128G1Mul(benchmark::Bench& bench)
+{
+    RunPrecompile(bench, dev::crypto::bn254::g1Mul, MulInput());
+}
+
+static void AltBn128G1MulLibFF(benchmark::Bench& bench)
+{
+    RunPrecompile(bench, dev::crypto::libff_alt_bn128_G1_mul, MulInput());
+}
+
+BENCHMARK(AltBn128Pairing, benchmark::PriorityLevel::HIGH);
+BENCHMARK(AltBn128PairingLibFF, benchmark::PriorityLevel::HIGH);
+BENCHMARK(AltBn128G1Add, benchmark::PriorityLevel::HIGH);
+BENCHMARK(AltBn128G1AddLibFF, benchmark::PriorityLevel::HIGH);
+BENCHMARK(AltBn128G1Mul, benchmark::PriorityLevel::HIGH);
+BENCHMARK(AltBn128G1MulLibFF, benchmark::PriorityLevel::HIGH);
@@ -5,14 +5,24 @@
 #include <bench/bench.h>
 #include <bench/data.h>
 
+#include <addresstype.h>
 #include <chainparams.h>
+#include <coins.h>
 #include <common/args.h>
 #include <consensus/validation.h>
+#include <key.h>
+#include <script/sign.h>
+#include <script/signingprovider.h>
 #include <streams.h>
 #include <util/chaintype.h>
+#include <util/strencodings.h>
 #include <validation.h>
 #include <test/util/setup_common.h>
 
+#include <map>
+#include <string>
+#include <vector>
+
 // These are the two major time-sinks which happen after we have fully received
 // a block off the wire, but before we can relay the block on to peers using
 // compact block relay.
@@ -54,5 +64,63 @@ static void DeserializeAndCheckBlockTest(benchmark::Bench& bench)
     });
 }
 
+static const size_t CONTRACT_BLOCK_TXS = 100;
+static const int64_t CONTRACT_GAS_LIMIT = 100000;
+static const int64_t CONTRACT_GAS_PRICE = 40;
+
+// Init code returning the runtime code SSTORE(calldata[0], calldata[32])
+static const char* STORE_CONTRACT_CODE = "67602035600035550060005260086018f3";
+
+// Connect a block of contract deployments, each one with a signed input and
+// a signed OP_SENDER output, so both the signature checks and the contract
+// execution are part of the measurement.
+static void ConnectContractBlockTest(benchmark::Bench& bench)
+{
+    // Disable the signature cache, every iteration verifies the signatures again
+    const auto test_setup = MakeNoLogFileContext<TestChain100Setup>(ChainType::UNITTEST, {"-maxsigcachesize=0"});
+    Chainstate& chainstate = test_setup->m_node.chainman->ActiveChainstate();
+    const CKey& key = test_setup->coinbaseKey;
+    const CScript scriptPubKey = GetScriptForDestination(PKHash(key.GetPubKey()));
+    FillableSigningProvider keystore;
+    keystore.AddKey(key);
+
+    // Split a mature coinbase into one coin per contract transaction
+    const CTransactionRef coinbase = test_setup->m_coinbase_txns[0];
+    const CAmount value = coinbase->vout[0].nValue / (CONTRACT_BLOCK_TXS + 1);
+    assert(value > CONTRACT_GAS_LIMIT * CONTRACT_GAS_PRICE);
+    const CMutableTransaction split = test_setup->CreateValidMempoolTransaction({coinbase}, {COutPoint(coinbase->GetHash(), 0)}, /*input_height=*/1, {key},
+                                                                                std::vector<CTxOut>(CONTRACT_BLOCK_TXS, CTxOut(value, scriptPubKey)), /*submit=*/false);
+    test_setup->CreateAndProcessBlock({split}, scriptPubKey);
+
+    std::vector<CMutableTransaction> txs;
+    for (uint32_t n = 0; n < CONTRACT_BLOCK_TXS; n++) {
+        CMutableTransaction tx;
+        const COutPoint prevout(split.GetHash(), n);
+        tx.vin.emplace_back(prevout);
+        const CScript sender = CScript() << CScriptNum(addresstype::PUBKEYHASH) << ToByteVector(key.GetPubKey().GetID()) << std::vector<unsigned char>() << OP_SENDER;
+        tx.vout.emplace_back(0, sender + (CScript() << CScriptNum(VersionVM::GetEVMDefault().toRaw()) << CScriptNum(CONTRACT_GAS_LIMIT) << CScriptNum(CONTRACT_GAS_PRICE) << ParseHex(STORE_CONTRACT_CODE) << OP_CREATE));
+
+        // The output signature must be in place before the input is signed
+        std::map<int, std::string> output_errors;
+        bool signed_output = SignTransactionOutput(tx, &keystore, SIGHASH_ALL, output_errors);
+        assert(signed_output);
+        std::map<COutPoint, Coin> coins{{prevout, Coin(split.vout[n], /*nHeightIn=*/0, /*fCoinBaseIn=*/false, /*fCoinStakeIn=*/false)}};
+        std::map<int, bilingual_str> input_errors;
+        bool signed_input = SignTransaction(tx, &keystore, coins, SIGHASH_ALL, input_errors);
+        assert(signed_input);
+        txs.push_back(tx);
+    }
+
+    LOCK(::cs_main);
+    const CBlock block = test_setup->CreateBlock(txs, scriptPubKey, chainstate);
+
+    bench.unit("block").run([&] {
+        BlockValidationState state;
+        bool checked = TestBlockValidity(state, chainstate.m_chainman.GetParams(), chainstate, block, chainstate.m_chain.Tip(), /*fCheckPOW=*/false, /*fCheckMerkleRoot=*/true);
+        assert(checked);
+    });
+}
+
 BENCHMARK(DeserializeBlockTest, benchmark::PriorityLevel::HIGH);
 BENCHMARK(DeserializeAndCheckBlockTest, benchmark::PriorityLevel::HIGH);
+BENCHMARK(ConnectContractBlockTest, benchmark::PriorityLevel::HIGH);
@@ -0,0 +1,101 @@
+#include <bench/bench.h>
+#include <checkqueue.h>
+#include <odan/odanDGP.h>
+#include <odan/parallelexec.h>
+#include <test/util/setup_common.h>
+#include <util/strencodings.h>
+#include <validation.h>
+
+#include <vector>
+
+static const size_t CONTRACT_TXS = 200;
+static const int CONTRACT_EXEC_THREADS = 3;
+
+// Init code returning the runtime code SSTORE(calldata[0], calldata[32])
+static const char* STORE_CONTRACT_CODE = "67602035600035550060005260086018f3";
+
+static OdanTransaction CreateOdanTransaction(const dev::bytes& data, const dev::Address& recipient, uint32_t n)
+{
+    OdanTransaction tx;
+    if (recipient == dev::Address()) {
+        tx = OdanTransaction(0, 40, 100000, data, 0);
+    } else {
+        tx = OdanTransaction(0, 40, 100000, recipient, data, 0);
+    }
+    tx.forceSender(dev::Address("0101010101010101010101010101010101010101"));
+    tx.setHashWith(dev::sha3(dev::h256(n)));
+    tx.setNVout(0);
+    tx.setVersion(VersionVM::GetEVMDefault());
+    return tx;
+}
+
+static CBlock CreateBlock()
+{
+    CBlock block;
+    CMutableTransaction tx;
+    tx.vout.emplace_back(0, CScript() << OP_DUP << OP_HASH160 << ParseHex("abababababababababababababababababababab") << OP_EQUALVERIFY << OP_CHECKSIG);
+    block.vtx.push_back(MakeTransactionRef(CTransaction(tx)));
+    return block;
+}
+
+// Replay a block of contract calls, every call writes the storage slot number
+// slot(n) of the same contract
+template <typename SlotFn>
+static void ContractExec(benchmark::Bench& bench, bool parallel, SlotFn slot)
+{
+    const auto testing_setup = MakeNoLogFileContext<const TestingSetup>();
+    LOCK(::cs_main);
+    CChain& chain = testing_setup->m_node.chainman->ActiveChain();
+    const CBlock block = CreateBlock();
+    const uint64_t blockGasLimit = DEFAULT_BLOCK_GAS_LIMIT_DGP;
+
+    std::vector<OdanTransaction> deploy{CreateOdanTransaction(ParseHex(STORE_CONTRACT_CODE), dev::Address(), 0)};
+    ByteCodeExec deployExec(block, deploy, blockGasLimit, chain.Tip(), chain);
+    assert(deployExec.performByteCode());
+    const dev::Address contract = OdanState::createOdanAddress(deploy[0].getHashWith(), 0);
+
+    std::vector<std::vector<OdanTransaction>> txs;
+    for (size_t n = 0; n < CONTRACT_TXS; n++) {
+        dev::bytes data = dev::h256(slot(n)).asBytes();
+        dev::bytes value = dev::h256(n + 1).asBytes();
+        data.insert(data.end(), value.begin(), value.end());
+        txs.push_back({CreateOdanTransaction(data, contract, n + 1)});
+    }
+
+    CCheckQueue<CContractExecCheck> queue{/*batch_size=*/1, CONTRACT_EXEC_THREADS};
+    bench.unit("block").run([&] {
+        TemporaryState ts(globalState);
+        std::unique_ptr<ParallelContractExec> parallelExec;
+        if (parallel) {
+            parallelExec = std::make_unique<ParallelContractExec>(block, chain.Tip(), blockGasLimit, chain);
+            for (size_t n = 0; n < txs.size(); n++) {
+                parallelExec->Add(n, txs[n]);
+            }
+            parallelExec->Run(queue);
+        }
+        for (size_t n = 0; n < txs.size(); n++) {
+            ByteCodeExec exec(block, txs[n], blockGasLimit, chain.Tip(), chain);
+            assert(parallelExec ? parallelExec->Execute(n, txs[n], exec) : exec.performByteCode());
+        }
+    });
+}
+
+static void ContractExecSerial(benchmark::Bench& bench)
+{
+    ContractExec(bench, false, [](size_t n) { return n; });
+}
+
+static void ContractExecParallel(benchmark::Bench& bench)
+{
+    ContractExec(bench, true, [](size_t n) { return n; });
+}
+
+static void ContractExecParallelConflicts(benchmark::Bench& bench)
+{
+    // Every fourth call writes the same slot, those are executed again in block order
+    ContractExec(bench, true, [](size_t n) { return n % 4 == 0 ? 0 : n; });
+}
+
+BENCHMARK(ContractExecSerial, benchmark::PriorityLevel::HIGH);
+BENCHMARK(ContractExecParallel, benchmark::PriorityLevel::HIGH);
+BENCHMARK(ContractExecParallelConflicts, benchmark::PriorityLevel::HIGH);
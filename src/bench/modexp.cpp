@@ -0,0 +1,68 @@
+#include <bench/bench.h>
+
+#include <libdevcore/CommonData.h>
+#include <libdevcrypto/ModExp.h>
+
+#include <vector>
+
+using ModExp = dev::bigint (*)(dev::bigint const&, dev::bytesConstRef, dev::bigint const&);
+
+/** An odd modulus and a base of the given number of bits, with a deterministic pattern */
+static dev::bigint Number(size_t bits, uint8_t seed)
+{
+    dev::bytes bytes(bits / 8);
+    for (size_t i = 0; i < bytes.size(); i++)
+        bytes[i] = uint8_t(seed + i * 29);
+    bytes.front() |= 0x80;
+    bytes.back() |= 1;
+    return dev::fromBigEndian<dev::bigint>(bytes);
+}
+
+static void RunModExp(benchmark::Bench& bench, ModExp modexp, size_t bits, const dev::bytes& exp)
+{
+    const dev::bigint mod = Number(bits, 3);
+    const dev::bigint base = Number(bits, 7) % mod;
+    bench.run([&] {
+        dev::bigint result = modexp(base, &exp, mod);
+        ankerl::nanobench::doNotOptimizeAway(result);
+    });
+}
+
+// RSA signature verification with the public exponent 65537
+static void ModExpRsa2048Verify(benchmark::Bench& bench)
+{
+    RunModExp(bench, dev::crypto::modexp, 2048, {1, 0, 1});
+}
+
+static void ModExpRsa2048VerifyBoost(benchmark::Bench& bench)
+{
+    RunModExp(bench, dev::crypto::modexpReference, 2048, {1, 0, 1});
+}
+
+static void ModExpRsa4096Verify(benchmark::Bench& bench)
+{
+    RunModExp(bench, dev::crypto::modexp, 4096, {1, 0, 1});
+}
+
+static void ModExpRsa4096VerifyBoost(benchmark::Bench& bench)
+{
+    RunModExp(bench, dev::crypto::modexpReference, 4096, {1, 0, 1});
+}
+
+// A full size exponent, as in RSA signing or in a Fermat test
+static void ModExp2048FullExponent(benchmark::Bench& bench)
+{
+    RunModExp(bench, dev::crypto::modexp, 2048, dev::bytes(256, 0xa5));
+}
+
+static void ModExp2048FullExponentBoost(benchmark::Bench& bench)
+{
+    RunModExp(bench, dev::crypto::modexpReference, 2048, dev::bytes(256, 0xa5));
+}
+
+BENCHMARK(ModExpRsa2048Verify, benchmark::PriorityLevel::HIGH);
+BENCHMARK(ModExpRsa2048VerifyBoost, benchmark::PriorityLevel::HIGH);
+BENCHMARK(ModExpRsa4096Verify, benchmark::PriorityLevel::HIGH);
+BENCHMARK(ModExpRsa4096VerifyBoost, benchmark::PriorityLevel::HIGH);
+BENCHMARK(ModExp2048FullExponent, benchmark::PriorityLevel::HIGH);
+BENCHMARK(ModExp2048FullExponentBoost, benchmark::PriorityLevel::HIGH);
@@ -0,0 +1,84 @@
+#include <bench/bench.h>
+#include <checkqueue.h>
+#include <common/system.h>
+#include <pos.h>
+#include <random.h>
+#include <test/util/setup_common.h>
+
+#include <vector>
+
+// Prevouts of a large staking wallet
+static const size_t STAKE_PREVOUTS = 10000;
+// Kernels per check in the threaded search
+static const size_t STAKE_CHUNK = 1000;
+
+static std::vector<std::pair<COutPoint, CStakeCache>> CreateStakeCoins()
+{
+    FastRandomContext rng(true);
+    std::vector<std::pair<COutPoint, CStakeCache>> coins;
+    for (size_t i = 0; i < STAKE_PREVOUTS; i++) {
+        COutPoint prevout(Txid::FromUint256(rng.rand256()), rng.randrange(10));
+        coins.emplace_back(prevout, CStakeCache(1000, 1 + rng.randrange(1000 * COIN)));
+    }
+    return coins;
+}
+
+static void StakeKernelHash(benchmark::Bench& bench)
+{
+    const auto test_setup = MakeNoLogFileContext<const BasicTestingSetup>();
+    std::vector<std::pair<COutPoint, CStakeCache>> coins = CreateStakeCoins();
+    CBlockIndex index;
+    index.nHeight = 1000;
+    const unsigned int nBits = 0x1a00ffff;
+
+    uint32_t nTimeBlock = 2000;
+    bench.batch(coins.size()).unit("kernel").run([&] {
+        uint256 hashProofOfStake, targetProofOfStake;
+        for (const auto& coin : coins) {
+            CheckStakeKernelHash(&index, nBits, coin.second.blockFromTime, coin.second.amount, coin.first, nTimeBlock, hashProofOfStake, targetProofOfStake);
+        }
+        nTimeBlock += 16;
+    });
+}
+
+static void StakeKernelBatchSearch(benchmark::Bench& bench, int worker_threads_num)
+{
+    const auto test_setup = MakeNoLogFileContext<const BasicTestingSetup>();
+    std::vector<std::pair<COutPoint, CStakeCache>> coins = CreateStakeCoins();
+    CBlockIndex index;
+    index.nHeight = 1000;
+    StakeKernelBatch batch(&index, 0x1a00ffff);
+    for (const auto& coin : coins) {
+        batch.Add(coin.first, coin.second);
+    }
+    CCheckQueue<CStakeKernelCheck> queue{/*batch_size=*/1, worker_threads_num};
+
+    uint32_t nTimeBlock = 2000;
+    bench.batch(batch.Size()).unit("kernel").run([&] {
+        std::vector<std::vector<std::pair<size_t, uint256>>> solved(batch.Size() / STAKE_CHUNK);
+        std::vector<CStakeKernelCheck> vChecks;
+        for (size_t i = 0; i < solved.size(); i++) {
+            vChecks.emplace_back(batch, i * STAKE_CHUNK, (i + 1) * STAKE_CHUNK, nTimeBlock, solved[i]);
+        }
+        CCheckQueueControl<CStakeKernelCheck> control(&queue);
+        control.Add(std::move(vChecks));
+        control.Wait();
+        nTimeBlock += 16;
+    });
+}
+
+static void StakeKernelBatchSingleThread(benchmark::Bench& bench)
+{
+    StakeKernelBatchSearch(bench, 0);
+}
+
+static void StakeKernelBatchMultiThread(benchmark::Bench& bench)
+{
+    // There is nothing to share with a single core
+    if (GetNumCores() <= 1) return;
+    StakeKernelBatchSearch(bench, GetNumCores() - 1);
+}
+
+BENCHMARK(StakeKernelHash, benchmark::PriorityLevel::HIGH);
+BENCHMARK(StakeKernelBatchSingleThread, benchmark::PriorityLevel::HIGH);
+BENCHMARK(StakeKernelBatchMultiThread, benchmark::PriorityLevel::HIGH);
@@ -0,0 +1,106 @@
+#include <bench/bench.h>
+#include <odan/storageresults.h>
+#include <test/util/setup_common.h>
+#include <util/convert.h>
+#include <util/fs.h>
+
+#include <vector>
+
+// Contract transactions per block and logs per receipt
+static const size_t RECEIPT_BLOCK_TXS = 100;
+static const size_t RECEIPT_LOGS = 2;
+
+static std::vector<TransactionReceiptInfo> CreateReceipts(uint32_t n)
+{
+    TransactionReceiptInfo tri;
+    tri.blockHash = h256Touint(dev::sha3(dev::h256(n / RECEIPT_BLOCK_TXS)));
+    tri.blockNumber = n / RECEIPT_BLOCK_TXS;
+    tri.transactionHash = h256Touint(dev::sha3(dev::h256(n)));
+    tri.transactionIndex = n % RECEIPT_BLOCK_TXS;
+    tri.from = dev::Address(n);
+    tri.to = dev::Address(n + 1);
+    tri.cumulativeGasUsed = 50000;
+    tri.gasUsed = 50000;
+    for (size_t i = 0; i < RECEIPT_LOGS; i++) {
+        dev::h256s topics{dev::sha3(dev::h256(i)), dev::h256(n), dev::h256(n + 1)};
+        tri.logs.push_back(dev::eth::LogEntry(tri.to, topics, dev::bytes(32, uint8_t(i))));
+        tri.bloom |= tri.logs.back().bloom();
+    }
+    tri.excepted = dev::eth::TransactionException::None;
+    tri.outputIndex = 0;
+    tri.stateRoot = dev::sha3(dev::h256(n + 2));
+    tri.utxoRoot = dev::sha3(dev::h256(n + 3));
+    return {tri};
+}
+
+static std::unique_ptr<StorageResults> CreateStorageResults(const BasicTestingSetup& test_setup)
+{
+    fs::path dir = test_setup.m_path_root / "receipts";
+    fs::create_directories(dir);
+    return std::make_unique<StorageResults>(fs::PathToString(dir));
+}
+
+static void StorageResultsCommit(benchmark::Bench& bench)
+{
+    const auto test_setup = MakeNoLogFileContext<const BasicTestingSetup>();
+    std::unique_ptr<StorageResults> results = CreateStorageResults(*test_setup);
+
+    uint32_t n = 0;
+    bench.unit("block").run([&] {
+        for (size_t i = 0; i < RECEIPT_BLOCK_TXS; i++, n++) {
+            std::vector<TransactionReceiptInfo> receipts = CreateReceipts(n);
+            results->addResult(dev::sha3(dev::h256(n)), receipts);
+        }
+        results->commitResults();
+    });
+}
+
+template <typename Lookup>
+static void StorageResultsLookup(benchmark::Bench& bench, Lookup lookup)
+{
+    const auto test_setup = MakeNoLogFileContext<const BasicTestingSetup>();
+    std::unique_ptr<StorageResults> results = CreateStorageResults(*test_setup);
+
+    const uint32_t count = 100 * RECEIPT_BLOCK_TXS;
+    for (uint32_t n = 0; n < count; n++) {
+        std::vector<TransactionReceiptInfo> receipts = CreateReceipts(n);
+        results->addResult(dev::sha3(dev::h256(n)), receipts);
+        if (n % RECEIPT_BLOCK_TXS == RECEIPT_BLOCK_TXS - 1) results->commitResults();
+    }
+
+    uint32_t n = 0;
+    bench.unit("receipt").run([&] {
+        lookup(*results, dev::sha3(dev::h256(n)));
+        n = (n + 7919) % count;
+    });
+}
+
+static void StorageResultsLookupReceipt(benchmark::Bench& bench)
+{
+    StorageResultsLookup(bench, [](StorageResults& results, const dev::h256& hashTx) {
+        assert(results.getResult(hashTx).size() == 1);
+    });
+}
+
+static void StorageResultsLookupLogs(benchmark::Bench& bench)
+{
+    StorageResultsLookup(bench, [](StorageResults& results, const dev::h256& hashTx) {
+        std::vector<dev::eth::LogEntries> logs;
+        bool found = results.getResultLogs(hashTx, logs);
+        assert(found && logs.size() == 1);
+    });
+}
+
+static void StorageResultsLookupBlooms(benchmark::Bench& bench)
+{
+    StorageResultsLookup(bench, [](StorageResults& results, const dev::h256& hashTx) {
+        std::vector<dev::eth::LogBloom> blooms;
+        bool found = results.getResultBlooms(hashTx, blooms);
+        assert(found && blooms.size() == 1);
+    });
+}
+
+BENCHMARK(StorageResultsCommit, benchmark::PriorityLevel::HIGH);
+BENCHMARK(StorageResultsLookupReceipt, benchmark::PriorityLevel::HIGH);
+BENCHMARK(StorageResultsLookupLogs, benchmark::PriorityLevel::HIGH);
+BENCHMARK(StorageResultsLookupBlooms, benchmark::PriorityLevel::HIGH);
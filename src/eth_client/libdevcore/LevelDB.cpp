@@ -83,6 +83,10 @@ leveldb::Options LevelDB::defaultDBOptions()
     leveldb::Options options;
     options.create_if_missing = true;
     options.max_open_files = 256;
+    // The trie nodes are cached by TrieNodeCache, the filter avoids reading the tables for
+    // the keys that are not in the database
+    static std::unique_ptr<leveldb::FilterPolicy const> const filterPolicy(leveldb::NewBloomFilterPolicy(10));
+    options.filter_policy = filterPolicy.get();
     return options;
 }
 
@@ -8,6 +8,7 @@
 
 #include <boost/filesystem.hpp>
 #include <leveldb/db.h>
+#include <leveldb/filter_policy.h>
 #include <leveldb/write_batch.h>
 
 namespace dev
@@ -54,6 +54,17 @@ void OverlayDB::commit()
                     b.push_back(255);   // for aux
                     writeBatch->insert(toSlice(b), toSlice(i.second.first));
                 }
+
+            if (m_trackRefs)
+            {
+                // Inserts not killed again, minus the kills of nodes already in the backend
+                for (auto const& i: m_main)
+                    if (i.second.second)
+                        m_refDeltas[i.first] += i.second.second;
+                for (auto const& i: m_refKills)
+                    m_refDeltas[i.first] -= i.second;
+                m_refKills.clear();
+            }
         }
 
         for (unsigned i = 0; i < 10; ++i)
@@ -75,6 +86,13 @@ void OverlayDB::commit()
                 std::this_thread::sleep_for(std::chrono::seconds(i + 1));
             }
         }
+        if (m_nodeCache)
+        {
+            // The nodes written by a block are the most likely to be read by the next one
+            for (auto const& i: m_main)
+                if (i.second.second)
+                    m_nodeCache->insert(i.first, i.second.first);
+        }
 #if DEV_GUARDED_DB
         DEV_WRITE_GUARDED(x_this)
 #endif
@@ -106,6 +124,7 @@ void OverlayDB::rollback()
     WriteGuard l(x_this);
 #endif
     m_main.clear();
+    m_refKills.clear();
 }
 
 std::string OverlayDB::lookup(h256 const& _h) const
@@ -114,23 +133,38 @@ std::string OverlayDB::lookup(h256 const& _h) const
     if (!ret.empty() || !m_db)
         return ret;
 
-    return m_db->lookup(toSlice(_h));
+    if (m_nodeCache && m_nodeCache->lookup(_h, ret))
+        return ret;
+    ret = m_db->lookup(toSlice(_h));
+    if (m_nodeCache)
+        m_nodeCache->insert(_h, ret);
+    return ret;
 }
 
 bool OverlayDB::exists(h256 const& _h) const
 {
     if (StateCacheDB::exists(_h))
         return true;
-    return m_db && m_db->exists(toSlice(_h));
+    return m_db && backendExists(_h);
+}
+
+bool OverlayDB::backendExists(h256 const& _h) const
+{
+    std::string value;
+    if (m_nodeCache && m_nodeCache->lookup(_h, value))
+        return true;
+    return m_db->exists(toSlice(_h));
 }
 
 void OverlayDB::kill(h256 const& _h)
 {
     if (!StateCacheDB::kill(_h))
     {
+        if (m_trackRefs)
+            m_refKills[_h]++;
         if (m_db)
         {
-            if (!m_db->exists(toSlice(_h)))
+            if (!backendExists(_h))
             {
                 // No point node ref decreasing for EmptyTrie since we never bother incrementing it
                 // in the first place for empty storage tries.
@@ -138,7 +172,6 @@ void OverlayDB::kill(h256 const& _h)
                     cnote << "Decreasing DB node ref count below zero with no DB node. Probably "
                              "have a corrupt Trie."
                           << _h;
-                // TODO: for 1.1: ref-counted triedb.
             }
         }
     }
@@ -5,10 +5,12 @@
 #pragma once
 
 #include <memory>
+#include <unordered_map>
 #include <libdevcore/db.h>
 #include <libdevcore/Common.h>
 #include <libdevcore/Log.h>
 #include <libdevcore/StateCacheDB.h>
+#include <libdevcore/TrieNodeCache.h>
 
 namespace dev
 {
@@ -41,10 +43,31 @@ public:
 
 	bytes lookupAux(h256 const& _h) const;
 
+	/// Record the reference count changes of the committed nodes, used by the state pruning.
+	void setTrackRefs(bool _track) { m_trackRefs = _track; m_refKills.clear(); m_refDeltas.clear(); }
+	bool trackRefs() const { return m_trackRefs; }
+
+	/// @returns the reference count changes of the nodes committed since the last call.
+	std::unordered_map<h256, int64_t> takeRefDeltas() { return std::move(m_refDeltas); }
+
+	db::DatabaseFace* backend() const { return m_db.get(); }
+
+	/// Read the nodes of the backend through @a _cache, shared by the copies of this database.
+	void setNodeCache(TrieNodeCache* _cache) { m_nodeCache = _cache; }
+	TrieNodeCache* nodeCache() const { return m_nodeCache; }
+
 private:
 	using StateCacheDB::clear;
 
+	bool backendExists(h256 const& _h) const;
+
     std::shared_ptr<db::DatabaseFace> m_db;
+	TrieNodeCache* m_nodeCache = nullptr;
+
+	bool m_trackRefs = false;
+	/// Kills of nodes that are only in the backend, they are not in m_main to be decreased.
+	std::unordered_map<h256, unsigned> m_refKills;
+	std::unordered_map<h256, int64_t> m_refDeltas;
 };
 
 }
@@ -0,0 +1,164 @@
+#pragma once
+
+#include <libdevcore/Common.h>
+#include <libdevcore/FixedHash.h>
+#include <libdevcore/Guards.h>
+
+#include <array>
+#include <atomic>
+#include <list>
+#include <unordered_map>
+
+namespace dev
+{
+
+/**
+ * @brief Thread-safe memory bounded cache of values keyed by a hash of their content.
+ * The cache is split in shards by the first byte of the hash, each shard evicts its least
+ * recently used entries to stay under its part of the memory budget. @a Derived provides
+ * the estimated memory used by an entry with a static entryBytes(Value const&).
+ */
+template <class Derived, class Value>
+class ShardedLRUCache
+{
+public:
+	struct Stats
+	{
+		size_t entries = 0;
+		size_t bytes = 0;
+		size_t maxBytes = 0;
+		uint64_t hits = 0;
+		uint64_t misses = 0;
+		uint64_t evictions = 0;
+	};
+
+	explicit ShardedLRUCache(size_t _maxBytes = 0): m_maxBytes(_maxBytes) {}
+
+	/// @returns true and sets @a _value when @a _hash is cached, counting a hit or a miss.
+	bool get(h256 const& _hash, Value& _value)
+	{
+		Shard& s = shard(_hash);
+		Guard g(s.x_shard);
+		auto it = s.entries.find(_hash);
+		if (it == s.entries.end())
+		{
+			++m_misses;
+			return false;
+		}
+		++m_hits;
+		s.lru.splice(s.lru.begin(), s.lru, it->second.second);
+		_value = it->second.first;
+		return true;
+	}
+
+	/// Cache @a _value for @a _hash, the value already cached for it is kept and copied to @a _cached if any.
+	void insert(h256 const& _hash, Value const& _value, Value* _cached = nullptr)
+	{
+		Shard& s = shard(_hash);
+		Guard g(s.x_shard);
+		auto it = s.entries.find(_hash);
+		if (it != s.entries.end())
+		{
+			s.lru.splice(s.lru.begin(), s.lru, it->second.second);
+			if (_cached)
+				*_cached = it->second.first;
+			return;
+		}
+
+		s.lru.push_front(_hash);
+		s.entries.emplace(_hash, std::make_pair(_value, s.lru.begin()));
+		s.bytes += Derived::entryBytes(_value);
+		evict(s);
+		if (_cached)
+			*_cached = _value;
+	}
+
+	/// Remove the value of @a _hash if cached.
+	void remove(h256 const& _hash)
+	{
+		Shard& s = shard(_hash);
+		Guard g(s.x_shard);
+		auto it = s.entries.find(_hash);
+		if (it == s.entries.end())
+			return;
+		s.bytes -= Derived::entryBytes(it->second.first);
+		s.lru.erase(it->second.second);
+		s.entries.erase(it);
+	}
+
+	/// Change the memory budget, evicting entries when it is reduced.
+	void setMaxBytes(size_t _maxBytes)
+	{
+		m_maxBytes = _maxBytes;
+		for (Shard& s: m_shards)
+		{
+			Guard g(s.x_shard);
+			evict(s);
+		}
+	}
+
+	size_t maxBytes() const { return m_maxBytes; }
+
+	void clear()
+	{
+		for (Shard& s: m_shards)
+		{
+			Guard g(s.x_shard);
+			s.entries.clear();
+			s.lru.clear();
+			s.bytes = 0;
+		}
+	}
+
+	Stats stats() const
+	{
+		Stats ret;
+		for (Shard const& s: m_shards)
+		{
+			Guard g(s.x_shard);
+			ret.entries += s.entries.size();
+			ret.bytes += s.bytes;
+		}
+		ret.maxBytes = m_maxBytes;
+		ret.hits = m_hits;
+		ret.misses = m_misses;
+		ret.evictions = m_evictions;
+		return ret;
+	}
+
+private:
+	static const size_t c_shards = 16;
+
+	struct Shard
+	{
+		mutable Mutex x_shard;
+		/// Most recently used first.
+		std::list<h256> lru;
+		std::unordered_map<h256, std::pair<Value, std::list<h256>::iterator>> entries;
+		size_t bytes = 0;
+	};
+
+	Shard& shard(h256 const& _hash) { return m_shards[_hash[0] % c_shards]; }
+
+	/// Evict the least recently used entries of the shard until it fits in its budget.
+	void evict(Shard& _shard)
+	{
+		size_t maxBytes = m_maxBytes / c_shards;
+		while (_shard.bytes > maxBytes && !_shard.lru.empty())
+		{
+			auto it = _shard.entries.find(_shard.lru.back());
+			_shard.bytes -= Derived::entryBytes(it->second.first);
+			_shard.entries.erase(it);
+			_shard.lru.pop_back();
+			++m_evictions;
+		}
+	}
+
+	std::array<Shard, c_shards> m_shards;
+	std::atomic<size_t> m_maxBytes;
+	std::atomic<uint64_t> m_hits{0};
+	std::atomic<uint64_t> m_misses{0};
+	std::atomic<uint64_t> m_evictions{0};
+};
+
+}
@@ -0,0 +1,13 @@
+#include "TrieNodeCache.h"
+
+namespace dev
+{
+
+void TrieNodeCache::insert(h256 const& _hash, std::string const& _value)
+{
+	if (_value.empty() || _value.size() > c_maxValueSize || maxBytes() == 0)
+		return;
+	ShardedLRUCache::insert(_hash, _value);
+}
+
+}
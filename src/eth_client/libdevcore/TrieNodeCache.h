@@ -0,0 +1,38 @@
+#pragma once
+
+#include <libdevcore/ShardedLRUCache.h>
+
+#include <string>
+
+namespace dev
+{
+
+/**
+ * @brief Thread-safe cache of the trie nodes read from the state databases, keyed by node hash.
+ * A node is stored under the hash of its content, so a cached node stays valid until the node is
+ * deleted from the database by the state pruning, which removes it from the cache. Values larger
+ * than a trie node, like the contract code, are not cached.
+ */
+class TrieNodeCache: public ShardedLRUCache<TrieNodeCache, std::string>
+{
+public:
+	/// @returns true and sets @a _value when the node of @a _hash is cached, counting a hit or a miss.
+	bool lookup(h256 const& _hash, std::string& _value) { return get(_hash, _value); }
+
+	/// Cache the node read from or written to the database.
+	void insert(h256 const& _hash, std::string const& _value);
+
+	/// Estimated memory used by a node in the cache, with the list and the map entries.
+	static size_t entrySize(size_t _valueSize) { return _valueSize + c_entryOverhead; }
+
+	static size_t entryBytes(std::string const& _value) { return entrySize(_value.size()); }
+
+	static TrieNodeCache& instance() { static TrieNodeCache cache; return cache; }
+
+private:
+	static const size_t c_entryOverhead = 128;
+	/// The largest branch node with a value is a little over 532 bytes.
+	static const size_t c_maxValueSize = 1024;
+};
+
+}
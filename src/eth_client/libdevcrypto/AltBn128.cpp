@@ -0,0 +1,889 @@
+#include <libdevcrypto/AltBn128.h>
+
+#include <libdevcore/Exceptions.h>
+#include <libdevcore/FixedHash.h>
+
+#if defined(__x86_64__) || defined(__amd64__)
+#include <cpuid.h>
+#define BN254_X86_64
+#endif
+
+using namespace std;
+using namespace dev;
+
+namespace
+{
+
+DEV_SIMPLE_EXCEPTION(InvalidEncoding);
+
+using u128 = unsigned __int128;
+
+/// Element of the base field in the Montgomery form, least significant limb first.
+struct Fp
+{
+	uint64_t v[4];
+};
+
+struct Fp2
+{
+	Fp c0, c1;
+};
+
+struct Fp6
+{
+	Fp2 c0, c1, c2;
+};
+
+struct Fp12
+{
+	Fp6 c0, c1;
+};
+
+constexpr Fp c_p{{0x3c208c16d87cfd47, 0x97816a916871ca8d, 0xb85045b68181585d, 0x30644e72e131a029}};
+constexpr uint64_t c_inv = 0x87d20782e4866389; // -p^-1 mod 2^64
+constexpr Fp c_r2{{0xf32cfc5b538afa89, 0xb5e71911d44501fb, 0x47ab1eff0a417ff6, 0x06d89f71cab8351f}};
+constexpr Fp c_pMinus2{{0x3c208c16d87cfd45, 0x97816a916871ca8d, 0xb85045b68181585d, 0x30644e72e131a029}};
+/// Optimal ate loop count 6z+2 and the BN parameter z, both positive.
+constexpr u128 c_ateLoopCount = (u128(1) << 64) | 0x9d797039be763ba8;
+constexpr uint64_t c_z = 0x44e992b44a6909f1;
+
+constexpr Fp c_zero{};
+
+constexpr bool operator==(Fp const& _a, Fp const& _b)
+{
+	return _a.v[0] == _b.v[0] && _a.v[1] == _b.v[1] && _a.v[2] == _b.v[2] && _a.v[3] == _b.v[3];
+}
+
+constexpr bool isZero(Fp const& _a)
+{
+	return (_a.v[0] | _a.v[1] | _a.v[2] | _a.v[3]) == 0;
+}
+
+/// Subtract p when _t, the low limbs of a number below 2p, is not reduced.
+constexpr void reduceOnce(Fp& _t)
+{
+	Fp s{};
+	uint64_t borrow = 0;
+	for (int i = 0; i < 4; i++)
+	{
+		u128 d = u128(_t.v[i]) - c_p.v[i] - borrow;
+		s.v[i] = uint64_t(d);
+		borrow = uint64_t(d >> 64) & 1;
+	}
+	if (!borrow)
+		_t = s;
+}
+
+/// Montgomery multiplication (CIOS). p < 2^254, so the partial results fit in five limbs.
+constexpr Fp mulPortable(Fp const& _a, Fp const& _b)
+{
+	uint64_t t[6] = {};
+	for (int i = 0; i < 4; i++)
+	{
+		u128 c = 0;
+		for (int j = 0; j < 4; j++)
+		{
+			c += u128(_a.v[j]) * _b.v[i] + t[j];
+			t[j] = uint64_t(c);
+			c >>= 64;
+		}
+		c += t[4];
+		t[4] = uint64_t(c);
+		t[5] = uint64_t(c >> 64);
+
+		uint64_t m = t[0] * c_inv;
+		c = (u128(m) * c_p.v[0] + t[0]) >> 64;
+		for (int j = 1; j < 4; j++)
+		{
+			c += u128(m) * c_p.v[j] + t[j];
+			t[j - 1] = uint64_t(c);
+			c >>= 64;
+		}
+		c += t[4];
+		t[3] = uint64_t(c);
+		t[4] = t[5] + uint64_t(c >> 64);
+	}
+	Fp r{{t[0], t[1], t[2], t[3]}};
+	reduceOnce(r);
+	return r;
+}
+
+constexpr Fp toMont(Fp const& _a)
+{
+	return mulPortable(_a, c_r2);
+}
+
+constexpr Fp2 toMont(Fp const& _c0, Fp const& _c1)
+{
+	return Fp2{toMont(_c0), toMont(_c1)};
+}
+
+constexpr Fp c_one = toMont(Fp{{1, 0, 0, 0}});
+constexpr Fp c_three = toMont(Fp{{3, 0, 0, 0}});
+constexpr Fp c_twoInv = toMont(Fp{{0x9e10460b6c3e7ea4, 0xcbc0b548b438e546, 0xdc2822db40c0ac2e, 0x183227397098d014}});
+
+/// Twist coefficient b' = 3 / (9 + u) of G2
+constexpr Fp2 c_twistB = toMont(
+	Fp{{0x3267e6dc24a138e5, 0xb5b4c5e559dbefa3, 0x81be18991be06ac3, 0x2b149d40ceb8aaae}},
+	Fp{{0xe4a2bd0685c315d2, 0xa74fa084e52d1852, 0xcd2cafadeed8fdf4, 0x009713b03af0fed4}});
+
+/// Coefficients of the Frobenius maps of the tower for the powers 1 to 3, as in libff
+constexpr Fp2 c_frobFp6C1[3] = {
+	toMont(Fp{{0x99e39557176f553d, 0xb78cc310c2c3330c, 0x4c0bec3cf559b143, 0x2fb347984f7911f7}},
+		Fp{{0x1665d51c640fcba2, 0x32ae2a1d0b7c9dce, 0x4ba4cc8bd75a0794, 0x16c9e55061ebae20}}),
+	toMont(Fp{{0xe4bd44e5607cfd48, 0xc28f069fbb966e3d, 0x5e6dd9e7e0acccb0, 0x30644e72e131a029}}, c_zero),
+	toMont(Fp{{0x7b746ee87bdcfb6d, 0x805ffd3d5d6942d3, 0xbaff1c77959f25ac, 0x0856e078b755ef0a}},
+		Fp{{0x380cab2baaa586de, 0x0fdf31bf98ff2631, 0xa9f30e6dec26094f, 0x04f1de41b3d1766f}}),
+};
+constexpr Fp2 c_frobFp6C2[3] = {
+	toMont(Fp{{0x848a1f55921ea762, 0xd33365f7be94ec72, 0x80f3c0b75a181e84, 0x05b54f5e64eea801}},
+		Fp{{0xc13b4711cd2b8126, 0x3685d2ea1bdec763, 0x9f3a80b03b0b1c92, 0x2c145edbe7fd8aee}}),
+	toMont(Fp{{0x5763473177fffffe, 0xd4f263f1acdb5c4f, 0x59e26bcea0d48bac, 0x0000000000000000}}, c_zero),
+	toMont(Fp{{0x0e1a92bc3ccbf066, 0xe633094575b06bcb, 0x19bee0f7b5b2444e, 0x0bc58c6611c08dab}},
+		Fp{{0x5fe3ed9d730c239f, 0xa44a9e08737f96e5, 0xfeb0f6ef0cd21d04, 0x23d5e999e1910a12}}),
+};
+constexpr Fp2 c_frobFp12C1[3] = {
+	toMont(Fp{{0xd60b35dadcc9e470, 0x5c521e08292f2176, 0xe8b99fdd76e68b60, 0x1284b71c2865a7df}},
+		Fp{{0xca5cf05f80f362ac, 0x747992778eeec7e5, 0xa6327cfe12150b8e, 0x246996f3b4fae7e6}}),
+	toMont(Fp{{0xe4bd44e5607cfd49, 0xc28f069fbb966e3d, 0x5e6dd9e7e0acccb0, 0x30644e72e131a029}}, c_zero),
+	toMont(Fp{{0xe86f7d391ed4a67f, 0x894cb38dbe55d24a, 0xefe9608cd0acaa90, 0x19dc81cfcc82e4bb}},
+		Fp{{0x7694aa2bf4c0c101, 0x7f03a5e397d439ec, 0x06cbeee33576139d, 0x00abf8b60be77d73}}),
+};
+/// Coefficients of the Frobenius endomorphism of the twist
+constexpr Fp2 c_twistMulByQX = c_frobFp6C1[0];
+constexpr Fp2 c_twistMulByQY = toMont(
+	Fp{{0xdc54014671a0135a, 0xdbaae0eda9c95998, 0xdc5ec698b6e2f9b9, 0x063cf305489af5dc}},
+	Fp{{0x82d37f632623b0e3, 0x21807dc98fa25bd2, 0x0704b5a7ec796f2b, 0x07c03cbcac41049a}});
+
+constexpr Fp2 c_fp2Zero{};
+constexpr Fp2 c_fp2One{c_one, c_zero};
+
+inline Fp operator+(Fp const& _a, Fp const& _b)
+{
+	Fp r;
+	uint64_t carry = 0;
+	for (int i = 0; i < 4; i++)
+	{
+		u128 s = u128(_a.v[i]) + _b.v[i] + carry;
+		r.v[i] = uint64_t(s);
+		carry = uint64_t(s >> 64);
+	}
+	reduceOnce(r);
+	return r;
+}
+
+inline Fp operator-(Fp const& _a, Fp const& _b)
+{
+	Fp r;
+	uint64_t borrow = 0;
+	for (int i = 0; i < 4; i++)
+	{
+		u128 d = u128(_a.v[i]) - _b.v[i] - borrow;
+		r.v[i] = uint64_t(d);
+		borrow = uint64_t(d >> 64) & 1;
+	}
+	if (borrow)
+	{
+		uint64_t carry = 0;
+		for (int i = 0; i < 4; i++)
+		{
+			u128 s = u128(r.v[i]) + c_p.v[i] + carry;
+			r.v[i] = uint64_t(s);
+			carry = uint64_t(s >> 64);
+		}
+	}
+	return r;
+}
+
+inline Fp operator-(Fp const& _a)
+{
+	return isZero(_a) ? _a : c_p - _a;
+}
+
+inline bool operator==(Fp2 const& _a, Fp2 const& _b) { return _a.c0 == _b.c0 && _a.c1 == _b.c1; }
+inline bool isZero(Fp2 const& _a) { return isZero(_a.c0) && isZero(_a.c1); }
+inline Fp2 operator+(Fp2 const& _a, Fp2 const& _b) { return {_a.c0 + _b.c0, _a.c1 + _b.c1}; }
+inline Fp2 operator-(Fp2 const& _a, Fp2 const& _b) { return {_a.c0 - _b.c0, _a.c1 - _b.c1}; }
+inline Fp2 operator-(Fp2 const& _a) { return {-_a.c0, -_a.c1}; }
+inline Fp2 conjugate(Fp2 const& _a) { return {_a.c0, -_a.c1}; }
+
+/// Multiplication by the non residue 9 + u of Fp6 and Fp12
+inline Fp2 mulByXi(Fp2 const& _a)
+{
+	Fp2 a8 = _a + _a;
+	a8 = a8 + a8;
+	a8 = a8 + a8;
+	Fp2 a9 = a8 + _a;
+	return {a9.c0 - _a.c1, a9.c1 + _a.c0};
+}
+
+inline Fp6 operator+(Fp6 const& _a, Fp6 const& _b) { return {_a.c0 + _b.c0, _a.c1 + _b.c1, _a.c2 + _b.c2}; }
+inline Fp6 operator-(Fp6 const& _a, Fp6 const& _b) { return {_a.c0 - _b.c0, _a.c1 - _b.c1, _a.c2 - _b.c2}; }
+inline Fp6 operator-(Fp6 const& _a) { return {-_a.c0, -_a.c1, -_a.c2}; }
+
+/// Multiplication by the non residue v of Fp12
+inline Fp6 mulByV(Fp6 const& _a)
+{
+	return {mulByXi(_a.c2), _a.c0, _a.c1};
+}
+
+inline bool operator==(Fp6 const& _a, Fp6 const& _b) { return _a.c0 == _b.c0 && _a.c1 == _b.c1 && _a.c2 == _b.c2; }
+inline bool operator==(Fp12 const& _a, Fp12 const& _b) { return _a.c0 == _b.c0 && _a.c1 == _b.c1; }
+inline Fp12 operator+(Fp12 const& _a, Fp12 const& _b) { return {_a.c0 + _b.c0, _a.c1 + _b.c1}; }
+inline Fp12 operator-(Fp12 const& _a, Fp12 const& _b) { return {_a.c0 - _b.c0, _a.c1 - _b.c1}; }
+inline Fp12 unitaryInverse(Fp12 const& _a) { return {_a.c0, -_a.c1}; }
+
+Fp12 const c_fp12One{{c_fp2One, c_fp2Zero, c_fp2Zero}, {c_fp2Zero, c_fp2Zero, c_fp2Zero}};
+
+/// Field multiplication in plain C++
+struct PortableMul
+{
+	static Fp mul(Fp const& _a, Fp const& _b) { return mulPortable(_a, _b); }
+};
+
+#ifdef BN254_X86_64
+
+/// One row of the Montgomery multiplication with two carry chains: t += a * b[i], then
+/// t += m * p with m = t0 * inv, which clears t0. The next row uses t1, ..., t4, t0.
+#define BN254_MULX_ROW(i, t0, t1, t2, t3, t4) \
+	"movq " #i "*8(%[b]), %%rdx\n\t" \
+	"xorl %k[z], %k[z]\n\t" \
+	"mulxq 0(%[a]), %[lo], %[hi]\n\t" \
+	"adoxq %[lo], %[" #t0 "]\n\t" \
+	"adcxq %[hi], %[" #t1 "]\n\t" \
+	"mulxq 8(%[a]), %[lo], %[hi]\n\t" \
+	"adoxq %[lo], %[" #t1 "]\n\t" \
+	"adcxq %[hi], %[" #t2 "]\n\t" \
+	"mulxq 16(%[a]), %[lo], %[hi]\n\t" \
+	"adoxq %[lo], %[" #t2 "]\n\t" \
+	"adcxq %[hi], %[" #t3 "]\n\t" \
+	"mulxq 24(%[a]), %[lo], %[hi]\n\t" \
+	"adoxq %[lo], %[" #t3 "]\n\t" \
+	"adcxq %[hi], %[" #t4 "]\n\t" \
+	"adoxq %[z], %[" #t4 "]\n\t" \
+	"movq %[" #t0 "], %%rdx\n\t" \
+	"imulq %[inv], %%rdx\n\t" \
+	"xorl %k[z], %k[z]\n\t" \
+	"mulxq 0(%[p]), %[lo], %[hi]\n\t" \
+	"adoxq %[lo], %[" #t0 "]\n\t" \
+	"adcxq %[hi], %[" #t1 "]\n\t" \
+	"mulxq 8(%[p]), %[lo], %[hi]\n\t" \
+	"adoxq %[lo], %[" #t1 "]\n\t" \
+	"adcxq %[hi], %[" #t2 "]\n\t" \
+	"mulxq 16(%[p]), %[lo], %[hi]\n\t" \
+	"adoxq %[lo], %[" #t2 "]\n\t" \
+	"adcxq %[hi], %[" #t3 "]\n\t" \
+	"mulxq 24(%[p]), %[lo], %[hi]\n\t" \
+	"adoxq %[lo], %[" #t3 "]\n\t" \
+	"adcxq %[hi], %[" #t4 "]\n\t" \
+	"adoxq %[z], %[" #t4 "]\n\t"
+
+/// Field multiplication with the MULX/ADCX/ADOX instructions of BMI2 and ADX, only used when
+/// the CPU has them.
+struct AdxMul
+{
+	static Fp mul(Fp const& _a, Fp const& _b)
+	{
+		uint64_t t0, t1, t2, t3, t4, lo, hi, z;
+		__asm__(
+			"xorl %k[t0], %k[t0]\n\t"
+			"xorl %k[t1], %k[t1]\n\t"
+			"xorl %k[t2], %k[t2]\n\t"
+			"xorl %k[t3], %k[t3]\n\t"
+			"xorl %k[t4], %k[t4]\n\t"
+			BN254_MULX_ROW(0, t0, t1, t2, t3, t4)
+			BN254_MULX_ROW(1, t1, t2, t3, t4, t0)
+			BN254_MULX_ROW(2, t2, t3, t4, t0, t1)
+			BN254_MULX_ROW(3, t3, t4, t0, t1, t2)
+			: [t0] "=&r"(t0), [t1] "=&r"(t1), [t2] "=&r"(t2), [t3] "=&r"(t3), [t4] "=&r"(t4),
+			  [lo] "=&r"(lo), [hi] "=&r"(hi), [z] "=&r"(z)
+			: [a] "r"(_a.v), [b] "r"(_b.v), [p] "r"(c_p.v), [inv] "m"(c_inv)
+			: "rdx", "cc", "memory");
+		Fp r{{t4, t0, t1, t2}};
+		reduceOnce(r);
+		return r;
+	}
+};
+
+#undef BN254_MULX_ROW
+
+bool detectAdx()
+{
+	unsigned a, b, c, d;
+	if (__get_cpuid_max(0, nullptr) < 7)
+		return false;
+	__cpuid_count(7, 0, a, b, c, d);
+	return (b & (1 << 8)) && (b & (1 << 19));
+}
+
+#else
+
+bool detectAdx()
+{
+	return false;
+}
+
+#endif
+
+bool const c_hasAdx = detectAdx();
+
+/// Point in Jacobian coordinates, Z is zero at infinity
+template <class F>
+struct Jacobian
+{
+	F X, Y, Z;
+};
+
+/// The curve arithmetic over the field multiplication M
+template <class M>
+class Curve
+{
+public:
+	static pair<bool, bytes> pairingProduct(bytesConstRef _in);
+	static pair<bool, bytes> g1Add(bytesConstRef _in);
+	static pair<bool, bytes> g1Mul(bytesConstRef _in);
+
+private:
+	using G1 = Jacobian<Fp>;
+	using G2 = Jacobian<Fp2>;
+
+	/// Coefficients of a line of the Miller loop, as in libff
+	struct Line
+	{
+		Fp2 ell0, ellVW, ellVV;
+	};
+
+	/// State of the Miller loop of one pair, R is in homogeneous projective coordinates
+	struct MillerPair
+	{
+		Fp px, py;
+		Fp2 qx, qy;
+		G2 R;
+	};
+
+	static Fp mul(Fp const& _a, Fp const& _b) { return M::mul(_a, _b); }
+	static Fp sqr(Fp const& _a) { return M::mul(_a, _a); }
+
+	static Fp inverse(Fp const& _a)
+	{
+		Fp r = c_one;
+		for (int i = 3; i >= 0; i--)
+			for (int j = 63; j >= 0; j--)
+			{
+				r = sqr(r);
+				if ((c_pMinus2.v[i] >> j) & 1)
+					r = mul(r, _a);
+			}
+		return r;
+	}
+
+	static Fp2 mul(Fp2 const& _a, Fp2 const& _b)
+	{
+		Fp v0 = mul(_a.c0, _b.c0);
+		Fp v1 = mul(_a.c1, _b.c1);
+		return {v0 - v1, mul(_a.c0 + _a.c1, _b.c0 + _b.c1) - v0 - v1};
+	}
+
+	static Fp2 mul(Fp2 const& _a, Fp const& _b)
+	{
+		return {mul(_a.c0, _b), mul(_a.c1, _b)};
+	}
+
+	static Fp2 sqr(Fp2 const& _a)
+	{
+		Fp ab = mul(_a.c0, _a.c1);
+		return {mul(_a.c0 + _a.c1, _a.c0 - _a.c1), ab + ab};
+	}
+
+	static Fp2 inverse(Fp2 const& _a)
+	{
+		Fp t = inverse(sqr(_a.c0) + sqr(_a.c1));
+		return {mul(_a.c0, t), -mul(_a.c1, t)};
+	}
+
+	static Fp6 mul(Fp6 const& _a, Fp6 const& _b)
+	{
+		Fp2 v0 = mul(_a.c0, _b.c0);
+		Fp2 v1 = mul(_a.c1, _b.c1);
+		Fp2 v2 = mul(_a.c2, _b.c2);
+		return {
+			v0 + mulByXi(mul(_a.c1 + _a.c2, _b.c1 + _b.c2) - v1 - v2),
+			mul(_a.c0 + _a.c1, _b.c0 + _b.c1) - v0 - v1 + mulByXi(v2),
+			mul(_a.c0 + _a.c2, _b.c0 + _b.c2) - v0 + v1 - v2};
+	}
+
+	static Fp6 sqr(Fp6 const& _a)
+	{
+		// Chung-Hasan SQR2
+		Fp2 s0 = sqr(_a.c0);
+		Fp2 ab = mul(_a.c0, _a.c1);
+		Fp2 s1 = ab + ab;
+		Fp2 s2 = sqr(_a.c0 - _a.c1 + _a.c2);
+		Fp2 bc = mul(_a.c1, _a.c2);
+		Fp2 s3 = bc + bc;
+		Fp2 s4 = sqr(_a.c2);
+		return {s0 + mulByXi(s3), s1 + mulByXi(s4), s1 + s2 + s3 - s0 - s4};
+	}
+
+	static Fp6 inverse(Fp6 const& _a)
+	{
+		Fp2 c0 = sqr(_a.c0) - mulByXi(mul(_a.c1, _a.c2));
+		Fp2 c1 = mulByXi(sqr(_a.c2)) - mul(_a.c0, _a.c1);
+		Fp2 c2 = sqr(_a.c1) - mul(_a.c0, _a.c2);
+		Fp2 t = inverse(mul(_a.c0, c0) + mulByXi(mul(_a.c2, c1) + mul(_a.c1, c2)));
+		return {mul(c0, t), mul(c1, t), mul(c2, t)};
+	}
+
+	static Fp12 mul(Fp12 const& _a, Fp12 const& _b)
+	{
+		Fp6 aa = mul(_a.c0, _b.c0);
+		Fp6 bb = mul(_a.c1, _b.c1);
+		return {aa + mulByV(bb), mul(_a.c0 + _a.c1, _b.c0 + _b.c1) - aa - bb};
+	}
+
+	static Fp12 sqr(Fp12 const& _a)
+	{
+		Fp6 ab = mul(_a.c0, _a.c1);
+		return {mul(_a.c0 + _a.c1, _a.c0 + mulByV(_a.c1)) - ab - mulByV(ab), ab + ab};
+	}
+
+	static Fp12 inverse(Fp12 const& _a)
+	{
+		Fp6 t = inverse(sqr(_a.c0) - mulByV(sqr(_a.c1)));
+		return {mul(_a.c0, t), -mul(_a.c1, t)};
+	}
+
+	/// Multiplication by the sparse element (ell0, 0, ellVV) + (0, ellVW, 0) w of a line
+	static Fp12 mulBy024(Fp12 const& _f, Fp2 const& _ell0, Fp2 const& _ellVW, Fp2 const& _ellVV)
+	{
+		Fp6 const& a = _f.c0;
+		Fp6 const& b = _f.c1;
+		// a * (ell0 + ellVV v^2)
+		Fp2 a0 = mul(a.c0, _ell0);
+		Fp2 a2 = mul(a.c2, _ellVV);
+		Fp6 aa{
+			a0 + mulByXi(mul(a.c1 + a.c2, _ellVV) - a2),
+			mul(a.c1, _ell0) + mulByXi(a2),
+			mul(a.c0 + a.c2, _ell0 + _ellVV) - a0 - a2};
+		// b * ellVW v
+		Fp6 bb{mulByXi(mul(b.c2, _ellVW)), mul(b.c0, _ellVW), mul(b.c1, _ellVW)};
+		Fp6 c1 = mul(a + b, Fp6{_ell0, _ellVW, _ellVV}) - aa - bb;
+		return {aa + mulByV(bb), c1};
+	}
+
+	/// Squaring in the cyclotomic subgroup (Granger-Scott), as in libff
+	static Fp12 cyclotomicSqr(Fp12 const& _a)
+	{
+		Fp2 z0 = _a.c0.c0, z4 = _a.c0.c1, z3 = _a.c0.c2;
+		Fp2 z2 = _a.c1.c0, z1 = _a.c1.c1, z5 = _a.c1.c2;
+
+		auto square = [](Fp2 const& _x, Fp2 const& _y, Fp2& _t0, Fp2& _t1) {
+			Fp2 tmp = mul(_x, _y);
+			_t0 = mul(_x + _y, _x + mulByXi(_y)) - tmp - mulByXi(tmp);
+			_t1 = tmp + tmp;
+		};
+		Fp2 t0, t1, t2, t3, t4, t5;
+		square(z0, z1, t0, t1);
+		square(z2, z3, t2, t3);
+		square(z4, z5, t4, t5);
+
+		// 3t - 2z for the c0 coefficients and 3t + 2z for the c1 coefficients
+		auto minus = [](Fp2 const& _t, Fp2 const& _z) { Fp2 r = _t - _z; return r + r + _t; };
+		auto plus = [](Fp2 const& _t, Fp2 const& _z) { Fp2 r = _t + _z; return r + r + _t; };
+		return {
+			{minus(t0, z0), minus(t2, z4), minus(t4, z3)},
+			{plus(mulByXi(t5), z2), plus(t1, z1), plus(t3, z5)}};
+	}
+
+	static Fp12 cyclotomicExp(Fp12 const& _a, uint64_t _e)
+	{
+		Fp12 r = _a;
+		for (int i = 62 - __builtin_clzll(_e); i >= 0; i--)
+		{
+			r = cyclotomicSqr(r);
+			if ((_e >> i) & 1)
+				r = mul(r, _a);
+		}
+		return r;
+	}
+
+	static Fp2 frobenius(Fp2 const& _a, int _power)
+	{
+		return _power % 2 ? conjugate(_a) : _a;
+	}
+
+	static Fp6 frobenius(Fp6 const& _a, int _power)
+	{
+		return {
+			frobenius(_a.c0, _power),
+			mul(c_frobFp6C1[_power - 1], frobenius(_a.c1, _power)),
+			mul(c_frobFp6C2[_power - 1], frobenius(_a.c2, _power))};
+	}
+
+	/// The Frobenius map x^(p^power) for the powers 1 to 3
+	static Fp12 frobenius(Fp12 const& _a, int _power)
+	{
+		Fp6 c1 = frobenius(_a.c1, _power);
+		return {frobenius(_a.c0, _power), {mul(c_frobFp12C1[_power - 1], c1.c0), mul(c_frobFp12C1[_power - 1], c1.c1), mul(c_frobFp12C1[_power - 1], c1.c2)}};
+	}
+
+	static Fp12 expByNegZ(Fp12 const& _a)
+	{
+		return unitaryInverse(cyclotomicExp(_a, c_z));
+	}
+
+	/// The final exponentiation of libff: the easy part, then the hard part of Fuentes-Castaneda et al.
+	static Fp12 finalExponentiation(Fp12 const& _f)
+	{
+		Fp12 c = mul(unitaryInverse(_f), inverse(_f));
+		Fp12 elt = mul(frobenius(c, 2), c);
+
+		Fp12 A = expByNegZ(elt);
+		Fp12 B = cyclotomicSqr(A);
+		Fp12 C = cyclotomicSqr(B);
+		Fp12 D = mul(C, B);
+		Fp12 E = expByNegZ(D);
+		Fp12 F = cyclotomicSqr(E);
+		Fp12 G = expByNegZ(F);
+		Fp12 H = unitaryInverse(D);
+		Fp12 I = unitaryInverse(G);
+		Fp12 J = mul(I, E);
+		Fp12 K = mul(J, H);
+		Fp12 L = mul(K, B);
+		Fp12 N = mul(mul(K, E), elt);
+		Fp12 P = mul(frobenius(L, 1), N);
+		Fp12 R = mul(frobenius(K, 2), P);
+		Fp12 T = mul(unitaryInverse(elt), L);
+		return mul(frobenius(T, 3), R);
+	}
+
+	/// Doubling step of the flipped Miller loop of libff
+	static Line doublingStep(G2& _r)
+	{
+		Fp2 const X = _r.X, Y = _r.Y, Z = _r.Z;
+		Fp2 A = mul(mul(X, Y), c_twoInv);
+		Fp2 B = sqr(Y);
+		Fp2 C = sqr(Z);
+		Fp2 D = C + C + C;
+		Fp2 E = mul(c_twistB, D);
+		Fp2 F = E + E + E;
+		Fp2 G = mul(B + F, c_twoInv);
+		Fp2 H = sqr(Y + Z) - (B + C);
+		Fp2 I = E - B;
+		Fp2 J = sqr(X);
+		Fp2 E2 = sqr(E);
+
+		_r.X = mul(A, B - F);
+		_r.Y = sqr(G) - (E2 + E2 + E2);
+		_r.Z = mul(B, H);
+		return {mulByXi(I), -H, J + J + J};
+	}
+
+	/// Mixed addition step of the flipped Miller loop of libff
+	static Line additionStep(Fp2 const& _x2, Fp2 const& _y2, G2& _r)
+	{
+		Fp2 const X1 = _r.X, Y1 = _r.Y, Z1 = _r.Z;
+		Fp2 D = X1 - mul(_x2, Z1);
+		Fp2 E = Y1 - mul(_y2, Z1);
+		Fp2 F = sqr(D);
+		Fp2 G = sqr(E);
+		Fp2 H = mul(D, F);
+		Fp2 I = mul(X1, F);
+		Fp2 J = H + mul(Z1, G) - (I + I);
+
+		_r.X = mul(D, J);
+		_r.Y = mul(E, I - J) - mul(H, Y1);
+		_r.Z = mul(Z1, H);
+		return {mulByXi(mul(E, _x2) - mul(D, _y2)), D, -E};
+	}
+
+	static Fp12 evaluate(Fp12 const& _f, Line const& _line, MillerPair const& _pair)
+	{
+		return mulBy024(_f, _line.ell0, mul(_line.ellVW, _pair.py), mul(_line.ellVV, _pair.px));
+	}
+
+	/// The product of the Miller loops of the pairs, sharing the squarings of the accumulator
+	static Fp12 millerLoop(vector<MillerPair>& _pairs)
+	{
+		Fp12 f = c_fp12One;
+		bool first = true;
+		for (int i = 126 - __builtin_clzll(uint64_t(c_ateLoopCount >> 64)); i >= 0; i--)
+		{
+			if (!first)
+				f = sqr(f);
+			first = false;
+			for (MillerPair& pair: _pairs)
+				f = evaluate(f, doublingStep(pair.R), pair);
+			if ((c_ateLoopCount >> i) & 1)
+				for (MillerPair& pair: _pairs)
+					f = evaluate(f, additionStep(pair.qx, pair.qy, pair.R), pair);
+		}
+		for (MillerPair& pair: _pairs)
+		{
+			// Q1 = pi(Q) and Q2 = -pi^2(Q)
+			Fp2 q1x = mul(c_twistMulByQX, conjugate(pair.qx));
+			Fp2 q1y = mul(c_twistMulByQY, conjugate(pair.qy));
+			Fp2 q2x = mul(c_twistMulByQX, conjugate(q1x));
+			Fp2 q2y = -mul(c_twistMulByQY, conjugate(q1y));
+			f = evaluate(f, additionStep(q1x, q1y, pair.R), pair);
+			f = evaluate(f, additionStep(q2x, q2y, pair.R), pair);
+		}
+		return f;
+	}
+
+	template <class F>
+	static Jacobian<F> dbl(Jacobian<F> const& _p)
+	{
+		if (isZero(_p.Z))
+			return _p;
+		F A = sqr(_p.X);
+		F B = sqr(_p.Y);
+		F C = sqr(B);
+		F D = sqr(_p.X + B) - A - C;
+		D = D + D;
+		F E = A + A + A;
+		F X3 = sqr(E) - (D + D);
+		F C8 = C + C;
+		C8 = C8 + C8;
+		C8 = C8 + C8;
+		F YZ = mul(_p.Y, _p.Z);
+		return {X3, mul(E, D - X3) - C8, YZ + YZ};
+	}
+
+	template <class F>
+	static Jacobian<F> add(Jacobian<F> const& _p, Jacobian<F> const& _q)
+	{
+		if (isZero(_p.Z))
+			return _q;
+		if (isZero(_q.Z))
+			return _p;
+		F Z1Z1 = sqr(_p.Z);
+		F Z2Z2 = sqr(_q.Z);
+		F U1 = mul(_p.X, Z2Z2);
+		F U2 = mul(_q.X, Z1Z1);
+		F S1 = mul(mul(_p.Y, _q.Z), Z2Z2);
+		F S2 = mul(mul(_q.Y, _p.Z), Z1Z1);
+		F H = U2 - U1;
+		F R = S2 - S1;
+		if (isZero(H))
+			return isZero(R) ? dbl(_p) : Jacobian<F>{_p.X, _p.Y, F{}};
+		F I = sqr(H + H);
+		F J = mul(H, I);
+		R = R + R;
+		F V = mul(U1, I);
+		F X3 = sqr(R) - J - (V + V);
+		F S1J = mul(S1, J);
+		return {X3, mul(R, V - X3) - (S1J + S1J), mul(sqr(_p.Z + _q.Z) - Z1Z1 - Z2Z2, H)};
+	}
+
+	/// The endomorphism psi = untwist-Frobenius-twist of G2, as mul_by_q of libff
+	static G2 psi(G2 const& _q)
+	{
+		return {mul(c_twistMulByQX, conjugate(_q.X)), mul(c_twistMulByQY, conjugate(_q.Y)), conjugate(_q.Z)};
+	}
+
+	/// Subgroup check of El Housni, Guillevic and Piellard (eprint 2022/348), equivalent to
+	/// [r]Q == 0 on the twist: [z+1]Q + psi([z]Q) + psi^2([z]Q) == psi^3([2z]Q)
+	static bool isInG2(G2 const& _q)
+	{
+		G2 const zq = mulScalar(_q, Fp{{c_z, 0, 0, 0}});
+		G2 const psiZq = psi(zq);
+		G2 const psi2Zq = psi(psiZq);
+		G2 const lhs = add(add(add(zq, _q), psiZq), psi2Zq);
+		G2 const rhs = dbl(psi(psi2Zq));
+		return isZero(add(lhs, G2{rhs.X, -rhs.Y, rhs.Z}).Z);
+	}
+
+	/// Multiplication by a 256 bit scalar with a fixed window of 4 bits
+	template <class F>
+	static Jacobian<F> mulScalar(Jacobian<F> const& _p, Fp const& _k)
+	{
+		Jacobian<F> table[16];
+		table[0] = Jacobian<F>{_p.X, _p.Y, F{}};
+		table[1] = _p;
+		for (int i = 2; i < 16; i++)
+			table[i] = i % 2 ? add(table[i - 1], _p) : dbl(table[i / 2]);
+		Jacobian<F> r = table[0];
+		for (int i = 63; i >= 0; i--)
+		{
+			r = dbl(dbl(dbl(dbl(r))));
+			r = add(r, table[(_k.v[i / 16] >> (4 * (i % 16))) & 15]);
+		}
+		return r;
+	}
+
+	static Fp decodeFp(bytesConstRef _data)
+	{
+		// h256::AlignLeft zero-fills the h256 on the right if _data is too short.
+		h256 const xbin(_data, h256::AlignLeft);
+		Fp x;
+		for (int i = 0; i < 4; i++)
+		{
+			x.v[i] = 0;
+			for (int j = 0; j < 8; j++)
+				x.v[i] = (x.v[i] << 8) | xbin[(3 - i) * 8 + j];
+		}
+		for (int i = 3; i >= 0; i--)
+		{
+			if (x.v[i] < c_p.v[i])
+				return mul(x, c_r2);
+			if (x.v[i] > c_p.v[i])
+				break;
+		}
+		BOOST_THROW_EXCEPTION(InvalidEncoding());
+	}
+
+	static h256 encodeFp(Fp const& _x)
+	{
+		Fp const x = mul(_x, Fp{{1, 0, 0, 0}});
+		h256 r;
+		for (int i = 0; i < 4; i++)
+			for (int j = 0; j < 8; j++)
+				r[(3 - i) * 8 + j] = uint8_t(x.v[i] >> (8 * (7 - j)));
+		return r;
+	}
+
+	static G1 decodePointG1(bytesConstRef _data)
+	{
+		Fp const x = decodeFp(_data.cropped(0));
+		Fp const y = decodeFp(_data.cropped(32));
+		if (isZero(x) && isZero(y))
+			return G1{x, y, c_zero};
+		if (!(sqr(y) == mul(sqr(x), x) + c_three))
+			BOOST_THROW_EXCEPTION(InvalidEncoding());
+		return G1{x, y, c_one};
+	}
+
+	static bytes encodePointG1(G1 const& _p)
+	{
+		if (isZero(_p.Z))
+			return bytes(64, 0);
+		Fp const zInv = inverse(_p.Z);
+		Fp const zInv2 = sqr(zInv);
+		bytes out = encodeFp(mul(_p.X, zInv2)).asBytes();
+		h256 const y = encodeFp(mul(_p.Y, mul(zInv2, zInv)));
+		out.insert(out.end(), y.begin(), y.end());
+		return out;
+	}
+
+	static G2 decodePointG2(bytesConstRef _data)
+	{
+		// Encoding: c1 (256 bits) c0 (256 bits)
+		Fp2 const x{decodeFp(_data.cropped(32)), decodeFp(_data.cropped(0))};
+		Fp2 const y{decodeFp(_data.cropped(96)), decodeFp(_data.cropped(64))};
+		if (isZero(x) && isZero(y))
+			return G2{x, y, c_fp2Zero};
+		if (!(sqr(y) == mul(sqr(x), x) + c_twistB))
+			BOOST_THROW_EXCEPTION(InvalidEncoding());
+		return G2{x, y, c_fp2One};
+	}
+};
+
+template <class M>
+pair<bool, bytes> Curve<M>::pairingProduct(bytesConstRef _in)
+{
+	size_t constexpr pairSize = 2 * 32 + 2 * 64;
+	size_t const pairs = _in.size() / pairSize;
+	if (pairs * pairSize != _in.size())
+		// Invalid length.
+		return {false, bytes{}};
+
+	try
+	{
+		vector<MillerPair> millerPairs;
+		millerPairs.reserve(pairs);
+		for (size_t i = 0; i < pairs; ++i)
+		{
+			bytesConstRef const pair = _in.cropped(i * pairSize, pairSize);
+			G1 const g1 = decodePointG1(pair);
+			G2 const p = decodePointG2(pair.cropped(2 * 32));
+			if (!isInG2(p))
+				// p is not an element of the group (has wrong order)
+				return {false, bytes()};
+			if (isZero(p.Z) || isZero(g1.Z))
+				continue; // the pairing is one
+			millerPairs.push_back({g1.X, g1.Y, p.X, p.Y, p});
+		}
+		bool result = true;
+		if (!millerPairs.empty())
+			result = finalExponentiation(millerLoop(millerPairs)) == c_fp12One;
+		return {true, h256{result}.asBytes()};
+	}
+	catch (InvalidEncoding const&)
+	{
+		// Signal the call failure for invalid input.
+		return {false, bytes{}};
+	}
+}
+
+template <class M>
+pair<bool, bytes> Curve<M>::g1Add(bytesConstRef _in)
+{
+	try
+	{
+		G1 const p1 = decodePointG1(_in);
+		G1 const p2 = decodePointG1(_in.cropped(32 * 2));
+		return {true, encodePointG1(add(p1, p2))};
+	}
+	catch (InvalidEncoding const&)
+	{
+		return {false, bytes{}};
+	}
+}
+
+template <class M>
+pair<bool, bytes> Curve<M>::g1Mul(bytesConstRef _in)
+{
+	try
+	{
+		G1 const p = decodePointG1(_in.cropped(0));
+		// The scalar is not reduced, as in libff
+		h256 const kbin(_in.cropped(64), h256::AlignLeft);
+		Fp k;
+		for (int i = 0; i < 4; i++)
+		{
+			k.v[i] = 0;
+			for (int j = 0; j < 8; j++)
+				k.v[i] = (k.v[i] << 8) | kbin[(3 - i) * 8 + j];
+		}
+		return {true, encodePointG1(mulScalar(p, k))};
+	}
+	catch (InvalidEncoding const&)
+	{
+		return {false, bytes{}};
+	}
+}
+
+}
+
+pair<bool, bytes> dev::crypto::bn254::pairingProduct(bytesConstRef _in)
+{
+#ifdef BN254_X86_64
+	if (c_hasAdx)
+		return Curve<AdxMul>::pairingProduct(_in);
+#endif
+	return Curve<PortableMul>::pairingProduct(_in);
+}
+
+pair<bool, bytes> dev::crypto::bn254::g1Add(bytesConstRef _in)
+{
+#ifdef BN254_X86_64
+	if (c_hasAdx)
+		return Curve<AdxMul>::g1Add(_in);
+#endif
+	return Curve<PortableMul>::g1Add(_in);
+}
+
+pair<bool, bytes> dev::crypto::bn254::g1Mul(bytesConstRef _in)
+{
+#ifdef BN254_X86_64
+	if (c_hasAdx)
+		return Curve<AdxMul>::g1Mul(_in);
+#endif
+	return Curve<PortableMul>::g1Mul(_in);
+}
+
+bool dev::crypto::bn254::hasAdx()
+{
+	return c_hasAdx;
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <libdevcore/Common.h>
+
+namespace dev
+{
+namespace crypto
+{
+/// Native BN254 (alt_bn128) arithmetic for the precompiles, with the same input rules and
+/// results as the libff implementation in LibSnark.
+namespace bn254
+{
+
+std::pair<bool, bytes> pairingProduct(bytesConstRef _in);
+std::pair<bool, bytes> g1Add(bytesConstRef _in);
+std::pair<bool, bytes> g1Mul(bytesConstRef _in);
+
+/// True when the field multiplication uses the BMI2/ADX instructions of the CPU.
+bool hasAdx();
+
+}
+}
+}
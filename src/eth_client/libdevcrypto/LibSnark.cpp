@@ -2,6 +2,7 @@
 // Copyright 2017-2019 Aleth Authors.
 // Licensed under the GNU General Public License, Version 3.
 #include <libdevcrypto/LibSnark.h>
+#include <libdevcrypto/AltBn128.h>
 
 #include <algebra/curves/alt_bn128/alt_bn128_g1.hpp>
 #include <algebra/curves/alt_bn128/alt_bn128_g2.hpp>
@@ -12,6 +13,8 @@
 #include <libdevcore/Exceptions.h>
 #include <libdevcore/Log.h>
 
+#include <atomic>
+
 using namespace std;
 using namespace dev;
 using namespace dev::crypto;
@@ -21,6 +24,8 @@ namespace
 
 DEV_SIMPLE_EXCEPTION(InvalidEncoding);
 
+std::atomic<AltBn128Backend> s_backend{AltBn128Backend::Native};
+
 void initLibSnark() noexcept
 {
 	static bool s_initialized = []() noexcept
@@ -114,7 +119,38 @@ libff::alt_bn128_G2 decodePointG2(dev::bytesConstRef _data)
 
 }
 
+void dev::crypto::setAltBn128Backend(AltBn128Backend _backend)
+{
+	s_backend = _backend;
+}
+
+AltBn128Backend dev::crypto::altBn128Backend()
+{
+	return s_backend;
+}
+
 pair<bool, bytes> dev::crypto::alt_bn128_pairing_product(dev::bytesConstRef _in)
+{
+	if (s_backend == AltBn128Backend::LibFF)
+		return libff_alt_bn128_pairing_product(_in);
+	return bn254::pairingProduct(_in);
+}
+
+pair<bool, bytes> dev::crypto::alt_bn128_G1_add(dev::bytesConstRef _in)
+{
+	if (s_backend == AltBn128Backend::LibFF)
+		return libff_alt_bn128_G1_add(_in);
+	return bn254::g1Add(_in);
+}
+
+pair<bool, bytes> dev::crypto::alt_bn128_G1_mul(dev::bytesConstRef _in)
+{
+	if (s_backend == AltBn128Backend::LibFF)
+		return libff_alt_bn128_G1_mul(_in);
+	return bn254::g1Mul(_in);
+}
+
+pair<bool, bytes> dev::crypto::libff_alt_bn128_pairing_product(dev::bytesConstRef _in)
 {
 	// Input: list of pairs of G1 and G2 points
 	// Output: 1 if pairing evaluates to 1, 0 otherwise (left-padded to 32 bytes)
@@ -154,7 +190,7 @@ pair<bool, bytes> dev::crypto::alt_bn128_pairing_product(dev::bytesConstRef _in)
 	}
 }
 
-pair<bool, bytes> dev::crypto::alt_bn128_G1_add(dev::bytesConstRef _in)
+pair<bool, bytes> dev::crypto::libff_alt_bn128_G1_add(dev::bytesConstRef _in)
 {
 	try
 	{
@@ -170,7 +206,7 @@ pair<bool, bytes> dev::crypto::alt_bn128_G1_add(dev::bytesConstRef _in)
 	}
 }
 
-pair<bool, bytes> dev::crypto::alt_bn128_G1_mul(dev::bytesConstRef _in)
+pair<bool, bytes> dev::crypto::libff_alt_bn128_G1_mul(dev::bytesConstRef _in)
 {
 	try
 	{
@@ -12,9 +12,25 @@ namespace dev
 namespace crypto
 {
 
+/// Implementation of the alt_bn128 precompiles
+enum class AltBn128Backend
+{
+	Native, ///< The BN254 arithmetic of AltBn128.h
+	LibFF   ///< The generic libff arithmetic, kept as the reference
+};
+
+void setAltBn128Backend(AltBn128Backend _backend);
+AltBn128Backend altBn128Backend();
+
+/// Run on the selected backend
 std::pair<bool, bytes> alt_bn128_pairing_product(bytesConstRef _in);
 std::pair<bool, bytes> alt_bn128_G1_add(bytesConstRef _in);
 std::pair<bool, bytes> alt_bn128_G1_mul(bytesConstRef _in);
 
+/// Run on libff whatever the backend
+std::pair<bool, bytes> libff_alt_bn128_pairing_product(bytesConstRef _in);
+std::pair<bool, bytes> libff_alt_bn128_G1_add(bytesConstRef _in);
+std::pair<bool, bytes> libff_alt_bn128_G1_mul(bytesConstRef _in);
+
 }
 }
@@ -0,0 +1,238 @@
+#include <libdevcrypto/ModExp.h>
+
+#include <libdevcore/CommonData.h>
+
+#include <array>
+
+using namespace std;
+using namespace dev;
+
+namespace
+{
+
+using u128 = unsigned __int128;
+
+template <size_t N>
+using Limbs = array<uint64_t, N>;
+
+/// Least significant limb first, _x must fit in N limbs.
+template <size_t N>
+Limbs<N> toLimbs(bigint _x)
+{
+	Limbs<N> ret{};
+	for (size_t i = 0; i < N && _x != 0; ++i)
+	{
+		ret[i] = static_cast<uint64_t>(_x & numeric_limits<uint64_t>::max());
+		_x >>= 64;
+	}
+	return ret;
+}
+
+template <size_t N>
+bigint fromLimbs(Limbs<N> const& _x)
+{
+	bigint ret;
+	for (size_t i = N; i > 0; --i)
+	{
+		ret <<= 64;
+		ret |= _x[i - 1];
+	}
+	return ret;
+}
+
+/// -_m^-1 mod 2^64 for an odd _m, each Newton step doubles the correct bits.
+uint64_t negInverse(uint64_t _m)
+{
+	uint64_t inv = _m;
+	for (int i = 0; i < 5; ++i)
+		inv *= 2 - _m * inv;
+	return -inv;
+}
+
+/// Montgomery arithmetic modulo an odd modulus of at most N limbs, with R = 2^(64 * N).
+template <size_t N>
+class Montgomery
+{
+public:
+	explicit Montgomery(bigint const& _mod):
+		m_mod(toLimbs<N>(_mod)),
+		m_inv(negInverse(m_mod[0])),
+		m_one(toLimbs<N>((bigint(1) << (64 * N)) % _mod)),
+		m_r2(toLimbs<N>((bigint(1) << (128 * N)) % _mod))
+	{}
+
+	/// _x must be reduced.
+	Limbs<N> toMont(bigint const& _x) const { return mul(toLimbs<N>(_x), m_r2); }
+	bigint fromMont(Limbs<N> const& _x) const { return fromLimbs<N>(mul(_x, Limbs<N>{1})); }
+
+	Limbs<N> const& one() const { return m_one; }
+
+	/// _a * _b / R mod m, with coarsely integrated operand scanning.
+	Limbs<N> mul(Limbs<N> const& _a, Limbs<N> const& _b) const
+	{
+		uint64_t t[N + 2] = {};
+		for (size_t i = 0; i < N; ++i)
+		{
+			uint64_t carry = 0;
+			for (size_t j = 0; j < N; ++j)
+			{
+				u128 const s = u128(_a[j]) * _b[i] + t[j] + carry;
+				t[j] = uint64_t(s);
+				carry = uint64_t(s >> 64);
+			}
+			u128 s = u128(t[N]) + carry;
+			t[N] = uint64_t(s);
+			t[N + 1] = uint64_t(s >> 64);
+
+			uint64_t const q = t[0] * m_inv;
+			s = u128(q) * m_mod[0] + t[0];
+			carry = uint64_t(s >> 64);
+			for (size_t j = 1; j < N; ++j)
+			{
+				s = u128(q) * m_mod[j] + t[j] + carry;
+				t[j - 1] = uint64_t(s);
+				carry = uint64_t(s >> 64);
+			}
+			s = u128(t[N]) + carry;
+			t[N - 1] = uint64_t(s);
+			t[N] = t[N + 1] + uint64_t(s >> 64);
+		}
+
+		// t < 2m, subtract m once if needed
+		Limbs<N> ret;
+		uint64_t borrow = 0;
+		for (size_t j = 0; j < N; ++j)
+		{
+			u128 const d = u128(t[j]) - m_mod[j] - borrow;
+			ret[j] = uint64_t(d);
+			borrow = uint64_t(d >> 64) & 1;
+		}
+		if (t[N] == 0 && borrow)
+			copy(t, t + N, ret.begin());
+		return ret;
+	}
+
+private:
+	Limbs<N> m_mod;
+	uint64_t m_inv;
+	Limbs<N> m_one;
+	Limbs<N> m_r2;
+};
+
+size_t bitLength(bytesConstRef _exp)
+{
+	size_t i = 0;
+	while (i < _exp.size() && _exp[i] == 0)
+		++i;
+	if (i == _exp.size())
+		return 0;
+	return (_exp.size() - i) * 8 - (__builtin_clz(_exp[i]) - 24);
+}
+
+unsigned bit(bytesConstRef _exp, size_t _i)
+{
+	return (_exp[_exp.size() - 1 - _i / 8] >> (_i % 8)) & 1;
+}
+
+/// Window size of the sliding window exponentiation for an exponent of _bits bits.
+size_t windowSize(size_t _bits)
+{
+	if (_bits > 671)
+		return 6;
+	if (_bits > 239)
+		return 5;
+	if (_bits > 79)
+		return 4;
+	if (_bits > 23)
+		return 3;
+	return 1;
+}
+
+/// Left to right sliding window exponentiation modulo an odd modulus of at most N limbs.
+template <size_t N>
+bigint powmOdd(bigint const& _base, bytesConstRef _exp, bigint const& _mod)
+{
+	Montgomery<N> const mont(_mod);
+	size_t const bits = bitLength(_exp);
+	size_t const window = windowSize(bits);
+
+	// The odd powers _base, _base^3, ..., _base^(2^window - 1)
+	vector<Limbs<N>> table(size_t(1) << (window - 1));
+	table[0] = mont.toMont(_base % _mod);
+	if (table.size() > 1)
+	{
+		Limbs<N> const square = mont.mul(table[0], table[0]);
+		for (size_t i = 1; i < table.size(); ++i)
+			table[i] = mont.mul(table[i - 1], square);
+	}
+
+	Limbs<N> result = mont.one();
+	bool started = false;
+	size_t i = bits;
+	while (i > 0)
+	{
+		if (!bit(_exp, i - 1))
+		{
+			result = mont.mul(result, result);
+			--i;
+			continue;
+		}
+
+		// The longest window of at most window bits starting and ending with a set bit
+		size_t length = min(window, i);
+		while (!bit(_exp, i - length))
+			--length;
+		size_t value = 0;
+		for (size_t j = 1; j <= length; ++j)
+			value = (value << 1) | bit(_exp, i - j);
+
+		if (started)
+		{
+			for (size_t j = 0; j < length; ++j)
+				result = mont.mul(result, result);
+			result = mont.mul(result, table[value >> 1]);
+		}
+		else
+		{
+			result = table[value >> 1];
+			started = true;
+		}
+		i -= length;
+	}
+	return mont.fromMont(result);
+}
+
+}
+
+bigint dev::crypto::modexp(bigint const& _base, bytesConstRef _exp, bigint const& _mod)
+{
+	if (_mod == 0 || !boost::multiprecision::bit_test(_mod, 0))
+		return modexpReference(_base, _exp, _mod);
+
+	// Round up to the closest specialization, RSA moduli of 1024 to 4096 bits have their own
+	size_t const limbs = msb(_mod) / 64 + 1;
+	if (limbs <= 1)
+		return powmOdd<1>(_base, _exp, _mod);
+	if (limbs <= 2)
+		return powmOdd<2>(_base, _exp, _mod);
+	if (limbs <= 4)
+		return powmOdd<4>(_base, _exp, _mod);
+	if (limbs <= 8)
+		return powmOdd<8>(_base, _exp, _mod);
+	if (limbs <= 16)
+		return powmOdd<16>(_base, _exp, _mod);
+	if (limbs <= 24)
+		return powmOdd<24>(_base, _exp, _mod);
+	if (limbs <= 32)
+		return powmOdd<32>(_base, _exp, _mod);
+	if (limbs <= 48)
+		return powmOdd<48>(_base, _exp, _mod);
+	if (limbs <= 64)
+		return powmOdd<64>(_base, _exp, _mod);
+	return modexpReference(_base, _exp, _mod);
+}
+
+bigint dev::crypto::modexpReference(bigint const& _base, bytesConstRef _exp, bigint const& _mod)
+{
+	return _mod != 0 ? boost::multiprecision::powm(_base, fromBigEndian<bigint>(_exp), _mod) : bigint{0};
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <libdevcore/Common.h>
+
+namespace dev
+{
+namespace crypto
+{
+
+/// Computes _base ^ _exp mod _mod for the MODEXP precompile, _exp is big endian.
+/// Odd moduli up to 4096 bits use Montgomery multiplication with a fixed number of limbs,
+/// the other ones use boost. The result is 0 for a zero modulus.
+bigint modexp(bigint const& _base, bytesConstRef _exp, bigint const& _mod);
+
+/// Generic boost implementation with the same results, kept as the reference of the tests.
+bigint modexpReference(bigint const& _base, bytesConstRef _exp, bigint const& _mod);
+
+}
+}
@@ -12,6 +12,7 @@
 #include <libdevcrypto/Hash.h>
 #include <libdevcrypto/LibSnark.h>
 #include <libdevcrypto/LibKzg.h>
+#include <libdevcrypto/ModExp.h>
 #include <libethcore/Common.h>
 #include <odan/odanutils.h>
 using namespace std;
@@ -173,6 +174,20 @@ bigint parseBigEndianRightPadded(bytesConstRef _in, bigint const& _begin, bigint
     return ret;
 }
 
+// Copy _count bytes of _in starting with _begin offset, right-padded with zeroes like
+// parseBigEndianRightPadded.
+bytes copyRightPadded(bytesConstRef _in, bigint const& _begin, bigint const& _count)
+{
+    assert(_count <= numeric_limits<size_t>::max() / 8);
+    bytes ret(static_cast<size_t>(_count));
+    if (_begin < _in.count())
+    {
+        bytesConstRef cropped = _in.cropped(size_t(_begin));
+        memcpy(ret.data(), cropped.data(), min(ret.size(), cropped.size()));
+    }
+    return ret;
+}
+
 ETH_REGISTER_PRECOMPILED(modexp)(bytesConstRef _in)
 {
     bigint const baseLength(parseBigEndianRightPadded(_in, 0, 32));
@@ -184,11 +199,14 @@ ETH_REGISTER_PRECOMPILED(modexp)(bytesConstRef _in)
         return {true, bytes{}}; // This is a special case where expLength can be very big.
     assert(expLength <= numeric_limits<size_t>::max() / 8);
 
+    if (modLength == 0)
+        return {true, bytes{}}; // The result is empty whatever the exponent is.
+
     bigint const base(parseBigEndianRightPadded(_in, 96, baseLength));
-    bigint const exp(parseBigEndianRightPadded(_in, 96 + baseLength, expLength));
+    bytes const exp(copyRightPadded(_in, 96 + baseLength, expLength));
     bigint const mod(parseBigEndianRightPadded(_in, 96 + baseLength + expLength, modLength));
 
-    bigint const result = mod != 0 ? boost::multiprecision::powm(base, exp, mod) : bigint{0};
+    bigint const result = dev::crypto::modexp(base, &exp, mod);
 
     size_t const retLength(modLength);
     bytes ret(retLength);
@@ -5,6 +5,7 @@
 
 #include "Account.h"
 #include "SecureTrieDB.h"
+#include "StateSnapshot.h"
 #include "ValidationSchemes.h"
 #include <libdevcore/JsonUtils.h>
 #include <libdevcore/OverlayDB.h>
@@ -52,6 +53,23 @@ u256 Account::originalStorageValue(u256 const& _key, OverlayDB const& _db) const
     return value;
 }
 
+u256 Account::originalStorageValue(u256 const& _key, OverlayDB const& _db, SnapshotView& _snapshot,
+    h256 const& _root, h256 const& _hashedAddress) const
+{
+    auto it = m_storageOriginal.find(_key);
+    if (it != m_storageOriginal.end())
+        return it->second;
+
+    // The base storage of an account read from the trie at _root is its storage in the snapshot,
+    // unless it was cleared since
+    bytes payload;
+    if (m_storageRoot == EmptyTrie || !_snapshot.storage(_root, _hashedAddress, sha3(h256(_key)), payload))
+        return originalStorageValue(_key, _db);
+    auto const value = payload.size() ? RLP(payload).toInt<u256>() : 0;
+    m_storageOriginal[_key] = value;
+    return value;
+}
+
 namespace js = json_spirit;
 
 // TODO move AccountMaskObj to libtesteth (it is used only in test logic)
@@ -18,6 +18,7 @@ class OverlayDB;
 
 namespace eth
 {
+class SnapshotView;
 
 /**
  * Models the state of a single Ethereum account.
@@ -131,10 +132,26 @@ public:
         return originalStorageValue(_key, _db);
     }
 
+    /// Same as above, the original value is read from the snapshot @a _snapshot when it is available.
+    u256 storageValue(u256 const& _key, OverlayDB const& _db, SnapshotView& _snapshot,
+        h256 const& _root, h256 const& _hashedAddress) const
+    {
+        auto mit = m_storageOverlay.find(_key);
+        if (mit != m_storageOverlay.end())
+            return mit->second;
+
+        return originalStorageValue(_key, _db, _snapshot, _root, _hashedAddress);
+    }
+
     /// @returns account's original storage value corresponding to the @_key
     /// not taking into account overlayed modifications
     u256 originalStorageValue(u256 const& _key, OverlayDB const& _db) const;
 
+    /// Same as above, read from the snapshot @a _snapshot of the state trie at @a _root when it
+    /// is available. @a _hashedAddress is the hash of the address of the account.
+    u256 originalStorageValue(u256 const& _key, OverlayDB const& _db, SnapshotView& _snapshot,
+        h256 const& _root, h256 const& _hashedAddress) const;
+
     /// @returns the storage overlay as a simple hash map.
     std::unordered_map<u256, u256> const& storageOverlay() const { return m_storageOverlay; }
 
@@ -175,6 +192,9 @@ public:
     /// equal to codeHash().
     void noteCode(bytesConstRef _code) { assert(sha3(_code) == m_codeHash); m_codeCache = _code.toBytes(); }
 
+    /// Specify the code from the code cache, which was checked against its hash when cached.
+    void noteCachedCode(bytes const& _code) { m_codeCache = _code; }
+
     /// @returns the account's code.
     bytes const& code() const { return m_codeCache; }
 
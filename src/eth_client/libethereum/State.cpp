@@ -34,7 +34,8 @@ State::State(State const& _s):
     m_nonExistingAccountsCache(_s.m_nonExistingAccountsCache),
     m_touched(_s.m_touched),
     m_unrevertablyTouched(_s.m_unrevertablyTouched),
-    m_accountStartNonce(_s.m_accountStartNonce)
+    m_accountStartNonce(_s.m_accountStartNonce),
+    m_snapshot(_s.m_snapshot)
 {}
 
 OverlayDB State::openDB(fs::path const& _basePath, h256 const& _genesisHash, WithExisting _we)
@@ -147,6 +148,7 @@ State& State::operator=(State const& _s)
     m_touched = _s.m_touched;
     m_unrevertablyTouched = _s.m_unrevertablyTouched;
     m_accountStartNonce = _s.m_accountStartNonce;
+    m_snapshot = _s.m_snapshot;
     return *this;
 }
 
@@ -157,6 +159,9 @@ Account const* State::account(Address const& _a) const
 
 Account* State::account(Address const& _addr)
 {
+    if (m_accessRecorder) // odan
+        m_accessRecorder->accounts.insert(_addr);
+
     auto it = m_cache.find(_addr);
     if (it != m_cache.end())
         return &it->second;
@@ -165,7 +170,12 @@ Account* State::account(Address const& _addr)
         return nullptr;
 
     // Populate basic info.
-    string stateBack = m_state.at(_addr);
+    string stateBack;
+    bytes snapshotBack;
+    if (m_snapshot.entry(m_state.root(), sha3(_addr), snapshotBack))
+        stateBack = asString(snapshotBack);
+    else
+        stateBack = m_state.at(_addr);
     if (stateBack.empty())
     {
         m_nonExistingAccountsCache.insert(_addr);
@@ -211,7 +221,23 @@ void State::commit(CommitBehaviour _commitBehaviour)
 {
     if (_commitBehaviour == CommitBehaviour::RemoveEmptyAccounts)
         removeEmptyAccounts();
-    m_touched += dev::eth::commit(m_cache, m_state);
+    SnapshotDiff* diff = m_snapshot.beginCommit(m_state.root());
+    if (diff)
+    {
+        // The slots of a removed account or of a cleared storage are deleted from the snapshot
+        for (auto const& i: m_cache)
+            if (i.second.isDirty() && (!i.second.isAlive() || i.second.baseRoot() == EmptyTrie))
+            {
+                h256 const hashedAddress = sha3(i.first);
+                bytes before;
+                if (!m_snapshot.entry(m_state.root(), hashedAddress, before))
+                    before = asBytes(m_state.at(i.first));
+                if (!before.empty() && RLP(before)[2].toHash<h256>() != EmptyTrie)
+                    diff->wipeStorage(hashedAddress);
+            }
+    }
+    m_touched += dev::eth::commit(m_cache, m_state, diff);
+    m_snapshot.endCommit(m_state.root());
     m_changeLog.clear();
     m_cache.clear();
     m_unchangedCacheEntries.clear();
@@ -409,6 +435,8 @@ void State::createContract(Address const& _address)
 void State::createAccount(Address const& _address, Account const&& _account)
 {
     assert(!addressInUse(_address) && "Account already exists");
+    if (m_accessRecorder) // odan
+        m_accessRecorder->accounts.insert(_address);
     m_cache[_address] = std::move(_account);
     m_nonExistingAccountsCache.erase(_address);
     m_changeLog.emplace_back(Change::Create, _address);
@@ -431,8 +459,10 @@ u256 State::getNonce(Address const& _addr) const
 
 u256 State::storage(Address const& _id, u256 const& _key) const
 {
+    if (m_accessRecorder) // odan
+        m_accessRecorder->storage.emplace(_id, _key);
     if (Account const* a = account(_id))
-        return a->storageValue(_key, m_db);
+        return a->storageValue(_key, m_db, m_snapshot, m_state.root(), sha3(_id));
     else
         return 0;
 }
@@ -462,8 +492,10 @@ void State::setTransientStorage(Address const& _contract, u256 const& _key, u256
 
 u256 State::originalStorageValue(Address const& _contract, u256 const& _key) const
 {
+    if (m_accessRecorder) // odan
+        m_accessRecorder->storage.emplace(_contract, _key);
     if (Account const* a = account(_contract))
-        return a->originalStorageValue(_key, m_db);
+        return a->originalStorageValue(_key, m_db, m_snapshot, m_state.root(), sha3(_contract));
     else
         return 0;
 }
@@ -540,15 +572,24 @@ bytes const& State::code(Address const& _addr) const
 
     if (a->code().empty())
     {
-        // Load the code from the backend.
+        // Load the code from the shared cache or from the backend.
         Account* mutableAccount = const_cast<Account*>(a);
-        mutableAccount->noteCode(m_db.lookup(a->codeHash()));
-        CodeSizeCache::instance().store(a->codeHash(), a->code().size());
+        mutableAccount->noteCachedCode(cachedCode(a->codeHash())->code);
     }
 
     return a->code();
 }
 
+std::shared_ptr<CodeCache::Entry const> State::cachedCode(h256 const& _hash) const
+{
+    auto& codeCache = CodeCache::instance();
+    if (auto entry = codeCache.get(_hash))
+        return entry;
+    std::string const code = m_db.lookup(_hash);
+    assert(sha3(code) == _hash);
+    return codeCache.insert(_hash, bytesConstRef(code));
+}
+
 void State::setCode(Address const& _address, bytes&& _code, u256 const& _version)
 {
     // rollback assumes that overwriting of the code never happens
@@ -570,18 +611,10 @@ size_t State::codeSize(Address const& _a) const
 {
     if (Account const* a = account(_a))
     {
-        if (a->hasNewCode())
+        if (a->hasNewCode() || !a->code().empty() || a->codeHash() == EmptySHA3)
             return a->code().size();
-        auto& codeSizeCache = CodeSizeCache::instance();
-        h256 codeHash = a->codeHash();
-        if (codeSizeCache.contains(codeHash))
-            return codeSizeCache.get(codeHash);
-        else
-        {
-            size_t size = code(_a).size();
-            codeSizeCache.store(codeHash, size);
-            return size;
-        }
+        // The size does not need a copy of the code in the account
+        return cachedCode(a->codeHash())->code.size();
     }
     else
         return 0;
@@ -781,14 +814,18 @@ std::ostream& dev::eth::operator<<(std::ostream& _out, State const& _s)
 }
 
 template <class DB>
-AddressHash dev::eth::commit(AccountMap const& _cache, SecureTrieDB<Address, DB>& _state)
+AddressHash dev::eth::commit(AccountMap const& _cache, SecureTrieDB<Address, DB>& _state, SnapshotDiff* _diff)
 {
     AddressHash ret;
     for (auto const& i: _cache)
         if (i.second.isDirty())
         {
             if (!i.second.isAlive())
+            {
                 _state.remove(i.first);
+                if (_diff)
+                    _diff->entries[sha3(i.first)].clear();
+            }
             else
             {
                 auto const version = i.second.version();
@@ -806,11 +843,16 @@ AddressHash dev::eth::commit(AccountMap const& _cache, SecureTrieDB<Address, DB>
                 else
                 {
                     SecureTrieDB<h256, DB> storageDB(_state.db(), i.second.baseRoot());
+                    SnapshotStorageDiff* storageDiff = _diff ? &_diff->storage[sha3(i.first)] : nullptr;
                     for (auto const& j: i.second.storageOverlay())
+                    {
                         if (j.second)
                             storageDB.insert(j.first, rlp(j.second));
                         else
                             storageDB.remove(j.first);
+                        if (storageDiff)
+                            storageDiff->slots[sha3(h256(j.first))] = j.second ? rlp(j.second) : bytes();
+                    }
                     assert(storageDB.root());
                     s.append(storageDB.root());
                 }
@@ -818,8 +860,8 @@ AddressHash dev::eth::commit(AccountMap const& _cache, SecureTrieDB<Address, DB>
                 if (i.second.hasNewCode())
                 {
                     h256 ch = i.second.codeHash();
-                    // Store the size of the code
-                    CodeSizeCache::instance().store(ch, i.second.code().size());
+                    // Cache the new code for the next blocks
+                    CodeCache::instance().insert(ch, &i.second.code());
                     _state.db()->insert(ch, &i.second.code());
                     s << ch;
                 }
@@ -830,6 +872,8 @@ AddressHash dev::eth::commit(AccountMap const& _cache, SecureTrieDB<Address, DB>
                     s << i.second.version();
 
                 _state.insert(i.first, &s.out());
+                if (_diff)
+                    _diff->entries[sha3(i.first)] = s.out();
             }
             ret.insert(i.first);
         }
@@ -837,5 +881,5 @@ AddressHash dev::eth::commit(AccountMap const& _cache, SecureTrieDB<Address, DB>
 }
 
 
-template AddressHash dev::eth::commit<OverlayDB>(AccountMap const& _cache, SecureTrieDB<Address, OverlayDB>& _state);
-template AddressHash dev::eth::commit<StateCacheDB>(AccountMap const& _cache, SecureTrieDB<Address, StateCacheDB>& _state);
+template AddressHash dev::eth::commit<OverlayDB>(AccountMap const& _cache, SecureTrieDB<Address, OverlayDB>& _state, SnapshotDiff* _diff);
+template AddressHash dev::eth::commit<StateCacheDB>(AccountMap const& _cache, SecureTrieDB<Address, StateCacheDB>& _state, SnapshotDiff* _diff);
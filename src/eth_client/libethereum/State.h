@@ -6,6 +6,7 @@
 
 #include "Account.h"
 #include "SecureTrieDB.h"
+#include "StateSnapshot.h"
 #include "Transaction.h"
 #include "TransactionReceipt.h"
 #include <libdevcore/Common.h>
@@ -13,7 +14,7 @@
 #include <libdevcore/RLP.h>
 #include <libethcore/BlockHeader.h>
 #include <libethcore/Exceptions.h>
-#include <libethereum/CodeSizeCache.h>
+#include <libevm/CodeCache.h>
 #include <libevm/ExtVMFace.h>
 #include <array>
 #include <unordered_map>
@@ -67,6 +68,15 @@ DEV_SIMPLE_EXCEPTION(IncorrectAccountStartNonceInState);
 class SealEngineFace;
 class Executive;
 
+//////////////////////////////////////////////////////////////////////////// // odan
+/// Accounts and storage slots accessed through a State while it has an access recorder attached.
+struct StateAccess
+{
+    AddressHash accounts;
+    std::set<std::pair<Address, u256>> storage;
+};
+////////////////////////////////////////////////////////////////////////////
+
 /// An atomic state changelog entry.
 struct Change
 {
@@ -318,6 +328,22 @@ public:
     /// Mark account as touched and keep it touched even in case of rollback
     void unrevertableTouch(Address const& _addr);
 
+    /// @returns the accounts that stay touched even in case of rollback.
+    AddressHash const& unrevertablyTouched() const { return m_unrevertablyTouched; } // odan
+
+    /// Record every account and storage slot accessed from now on into @p _access (nullptr to stop). // odan
+    void setAccessRecorder(StateAccess* _access) { m_accessRecorder = _access; }
+
+    /// @returns true if the accesses are being recorded. // odan
+    bool hasAccessRecorder() const { return m_accessRecorder != nullptr; }
+
+    /// Read the accounts and the storage from the snapshot layers of @p _provider when they have
+    /// the root of the state (nullptr to always read the trie). Copied with the state. // odan
+    void setSnapshotProvider(SnapshotProvider const* _provider) { m_snapshot.setProvider(_provider); }
+
+    /// @returns the snapshot of the state, with the changes committed since the root of its layer. // odan
+    SnapshotView& snapshotView() { return m_snapshot; }
+
     /// Create a savepoint in the state changelog.
     /// @return The savepoint index that can be used in rollback() function.
     size_t savepoint() const;
@@ -341,6 +367,9 @@ protected:
     /// The pointer is valid until the next access to the state or account.
     Account* account(Address const& _addr);
 
+    /// @returns the code of @a _hash from the shared cache, loading it from the backend on a miss.
+    std::shared_ptr<CodeCache::Entry const> cachedCode(h256 const& _hash) const;
+
     /// Purges non-modified entries in m_cache if it grows too large.
     void clearCacheIfTooLarge() const;
 
@@ -372,12 +401,19 @@ protected:
 
     friend std::ostream& operator<<(std::ostream& _out, State const& _s);
     ChangeLog m_changeLog;
+
+    /// Collects the accessed accounts and storage slots, if set. Never copied with the state. // odan
+    StateAccess* m_accessRecorder = nullptr;
+
+    /// Flat snapshot of the state trie, read before the trie. // odan
+    mutable SnapshotView m_snapshot;
 };
 
 std::ostream& operator<<(std::ostream& _out, State const& _s);
 
+/// Commit the dirty accounts of @a _cache to the trie and record the changes into @a _diff if set.
 template <class DB>
-AddressHash commit(AccountMap const& _cache, SecureTrieDB<Address, DB>& _state);
+AddressHash commit(AccountMap const& _cache, SecureTrieDB<Address, DB>& _state, SnapshotDiff* _diff = nullptr);
 
 }
 }
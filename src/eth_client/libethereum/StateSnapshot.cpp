@@ -0,0 +1,74 @@
+#include "StateSnapshot.h"
+
+using namespace dev;
+using namespace dev::eth;
+
+void SnapshotDiff::wipeStorage(h256 const& _hashedKey)
+{
+	SnapshotStorageDiff& s = storage[_hashedKey];
+	s.wiped = true;
+	s.slots.clear();
+}
+
+void SnapshotView::setProvider(SnapshotProvider const* _provider)
+{
+	m_provider = _provider;
+	m_layer.reset();
+	m_baseRoot = m_root = h256();
+	m_diff.clear();
+}
+
+bool SnapshotView::sync(h256 const& _root)
+{
+	if (!m_provider)
+		return false;
+	if (_root != m_root)
+	{
+		m_layer = m_provider->layer(_root);
+		m_baseRoot = m_root = _root;
+		m_diff.clear();
+	}
+	return !!m_layer;
+}
+
+bool SnapshotView::entry(h256 const& _root, h256 const& _hashedKey, bytes& o_value)
+{
+	if (!sync(_root))
+		return false;
+	auto it = m_diff.entries.find(_hashedKey);
+	if (it != m_diff.entries.end())
+	{
+		o_value = it->second;
+		return true;
+	}
+	return m_layer->entry(_hashedKey, o_value);
+}
+
+bool SnapshotView::storage(h256 const& _root, h256 const& _hashedKey, h256 const& _hashedSlot, bytes& o_value)
+{
+	if (!sync(_root))
+		return false;
+	auto it = m_diff.storage.find(_hashedKey);
+	if (it != m_diff.storage.end())
+	{
+		auto slot = it->second.slots.find(_hashedSlot);
+		if (slot != it->second.slots.end())
+		{
+			o_value = slot->second;
+			return true;
+		}
+		if (it->second.wiped)
+		{
+			o_value.clear();
+			return true;
+		}
+	}
+	return m_layer->storage(_hashedKey, _hashedSlot, o_value);
+}
+
+void SnapshotView::reset(h256 const& _root, std::shared_ptr<SnapshotLayer const> _layer)
+{
+	m_layer = std::move(_layer);
+	m_baseRoot = m_root = _root;
+	m_diff.clear();
+}
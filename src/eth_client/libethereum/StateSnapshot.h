@@ -0,0 +1,105 @@
+#pragma once
+
+#include <libdevcore/Common.h>
+#include <libdevcore/FixedHash.h>
+
+#include <memory>
+#include <unordered_map>
+
+namespace dev
+{
+namespace eth
+{
+
+/// Changes of the storage of one account by hashed slot, an empty value is a deleted slot.
+struct SnapshotStorageDiff
+{
+	/// The slots of the older versions are deleted, the account was removed or its storage cleared.
+	bool wiped = false;
+	std::unordered_map<h256, bytes> slots;
+};
+
+/// Changes of a secure trie by hashed key, an empty value is a deleted entry.
+struct SnapshotDiff
+{
+	std::unordered_map<h256, bytes> entries;
+	/// Storage of the accounts, only used by the account trie.
+	std::unordered_map<h256, SnapshotStorageDiff> storage;
+
+	bool empty() const { return entries.empty() && storage.empty(); }
+	void clear() { entries.clear(); storage.clear(); }
+	void wipeStorage(h256 const& _hashedKey);
+};
+
+/**
+ * @brief Flat, read-only version of a secure trie at one root.
+ * The entries are read with one lookup by hashed key instead of a walk from the trie root.
+ */
+class SnapshotLayer
+{
+public:
+	virtual ~SnapshotLayer() = default;
+
+	/// @returns false when the layer is not available any more and the trie must be read instead.
+	/// @a o_value is the value stored in the trie, empty when the entry does not exist.
+	virtual bool entry(h256 const& _hashedKey, bytes& o_value) const = 0;
+
+	/// Same as entry() for the storage slot @a _hashedSlot of the account @a _hashedKey.
+	virtual bool storage(h256 const& _hashedKey, h256 const& _hashedSlot, bytes& o_value) const = 0;
+};
+
+/// Source of the snapshot layers of a trie by root.
+class SnapshotProvider
+{
+public:
+	virtual ~SnapshotProvider() = default;
+
+	/// @returns the layer of the trie at @a _root or nullptr when there is none.
+	virtual std::shared_ptr<SnapshotLayer const> layer(h256 const& _root) const = 0;
+};
+
+/**
+ * @brief Snapshot of the trie of a State: a layer and the changes committed to the trie since its root.
+ * The view follows the root of the trie, it is dropped when the trie is set to another root and
+ * the layer of the new root is used if the provider has one.
+ */
+class SnapshotView
+{
+public:
+	void setProvider(SnapshotProvider const* _provider);
+	SnapshotProvider const* provider() const { return m_provider; }
+
+	/// Follow the trie at @a _root. @returns true when the view can answer the reads at this root.
+	bool sync(h256 const& _root);
+
+	/// Read @a _hashedKey in the trie at @a _root. @returns false when the trie must be read instead.
+	bool entry(h256 const& _root, h256 const& _hashedKey, bytes& o_value);
+	bool storage(h256 const& _root, h256 const& _hashedKey, h256 const& _hashedSlot, bytes& o_value);
+
+	/// @returns the diff to record the changes about to be committed to the trie at @a _root, or
+	/// nullptr when the view is not available.
+	SnapshotDiff* beginCommit(h256 const& _root) { return sync(_root) ? &m_diff : nullptr; }
+
+	/// The changes recorded since beginCommit() are committed, the trie is now at @a _root.
+	void endCommit(h256 const& _root) { if (m_layer) m_root = _root; }
+
+	/// Use @a _layer for the trie at @a _root, after the changes of the view were added to the provider.
+	void reset(h256 const& _root, std::shared_ptr<SnapshotLayer const> _layer);
+
+	std::shared_ptr<SnapshotLayer const> const& layer() const { return m_layer; }
+	/// Root of the layer.
+	h256 const& baseRoot() const { return m_baseRoot; }
+	/// Root of the layer with the changes of the diff.
+	h256 const& root() const { return m_root; }
+	SnapshotDiff const& diff() const { return m_diff; }
+
+private:
+	SnapshotProvider const* m_provider = nullptr;
+	std::shared_ptr<SnapshotLayer const> m_layer;
+	h256 m_baseRoot;
+	h256 m_root;
+	SnapshotDiff m_diff;
+};
+
+}
+}
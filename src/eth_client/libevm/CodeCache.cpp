@@ -0,0 +1,39 @@
+#include "CodeCache.h"
+
+#include <evmone/baseline.hpp>
+
+namespace dev
+{
+namespace eth
+{
+
+std::shared_ptr<CodeCache::Entry const> CodeCache::get(h256 const& _hash)
+{
+	std::shared_ptr<Entry const> entry;
+	ShardedLRUCache::get(_hash, entry);
+	return entry;
+}
+
+std::shared_ptr<CodeCache::Entry const> CodeCache::insert(h256 const& _hash, bytesConstRef _code)
+{
+	std::shared_ptr<Entry const> entry;
+	ShardedLRUCache::insert(_hash, std::make_shared<Entry const>(_code), &entry);
+	return entry;
+}
+
+std::shared_ptr<evmone::baseline::CodeAnalysis const> CodeCache::analysis(h256 const& _hash, bytesConstRef _code)
+{
+	std::shared_ptr<Entry const> entry = get(_hash);
+	if (!entry)
+		entry = insert(_hash, _code);
+
+	// Analyzed outside of the shard lock, other threads executing the same code wait for the result
+	std::call_once(entry->analyzed, [&]() {
+		entry->analysis = std::make_shared<evmone::baseline::CodeAnalysis const>(
+			evmone::baseline::analyze({entry->code.data(), entry->code.size()}, false));
+	});
+	return entry->analysis;
+}
+
+}
+}
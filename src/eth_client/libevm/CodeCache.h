@@ -0,0 +1,67 @@
+#pragma once
+
+#include <libdevcore/ShardedLRUCache.h>
+
+#include <memory>
+#include <mutex>
+
+namespace evmone
+{
+namespace baseline
+{
+class CodeAnalysis;
+}
+}
+
+namespace dev
+{
+namespace eth
+{
+
+/// Default memory budget of the contract code cache in MiB.
+static const size_t c_defaultCodeCacheSize = 64;
+
+/**
+ * @brief Thread-safe cache of the deployed contract code and its evmone analysis, keyed by code hash.
+ * The code for a hash never changes, so the entries are shared by every State, the block
+ * validation, the RPC calls and the block assembly. The analysis is computed on the first
+ * execution of the code.
+ */
+struct CodeCacheEntry
+{
+	explicit CodeCacheEntry(bytesConstRef _code): code(_code.toBytes()) {}
+
+	bytes const code;
+	mutable std::once_flag analyzed;
+	mutable std::shared_ptr<evmone::baseline::CodeAnalysis const> analysis;
+};
+
+class CodeCache: public ShardedLRUCache<CodeCache, std::shared_ptr<CodeCacheEntry const>>
+{
+public:
+	using Entry = CodeCacheEntry;
+
+	CodeCache(): ShardedLRUCache(c_defaultCodeCacheSize << 20) {}
+
+	/// @returns the cached code for @a _hash or nullptr, counting a hit or a miss.
+	std::shared_ptr<Entry const> get(h256 const& _hash);
+
+	/// Cache the code of @a _hash, @a _code must have a SHA3 equal to @a _hash.
+	std::shared_ptr<Entry const> insert(h256 const& _hash, bytesConstRef _code);
+
+	/// @returns the evmone analysis of the code, analyzing and caching the code if needed.
+	std::shared_ptr<evmone::baseline::CodeAnalysis const> analysis(h256 const& _hash, bytesConstRef _code);
+
+	/// Estimated memory used by the code, its padded copy and its jump destination map.
+	static size_t entrySize(size_t _codeSize) { return 2 * _codeSize + _codeSize / 8 + c_entryOverhead; }
+
+	static size_t entryBytes(std::shared_ptr<Entry const> const& _entry) { return entrySize(_entry->code.size()); }
+
+	static CodeCache& instance() { static CodeCache cache; return cache; }
+
+private:
+	static const size_t c_entryOverhead = 256;
+};
+
+}
+}
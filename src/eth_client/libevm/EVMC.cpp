@@ -4,8 +4,14 @@
 #include "EVMC.h"
 
 #include <libdevcore/Log.h>
+#include <libevm/CodeCache.h>
 #include <libevm/VMFactory.h>
 
+#include <evmone/baseline.hpp>
+#include <evmone/vm.hpp>
+
+#include <cstring>
+
 namespace dev
 {
 namespace eth
@@ -46,9 +52,14 @@ EVMC::EVMC(evmc_vm* _vm, std::vector<std::pair<std::string, std::string>> const&
     assert(_vm != nullptr);
     assert(is_abi_compatible());
 
+    m_evmoneBaseline = std::strcmp(_vm->name, "evmone") == 0;
+
     // Set the options.
     for (auto& pair : _options)
     {
+        if (pair.first == "advanced")
+            m_evmoneBaseline = false;
+
         auto result = set_option(pair.first.c_str(), pair.second.c_str());
         switch (result)
         {
@@ -90,7 +101,16 @@ owning_bytes_ref EVMC::exec(u256& io_gas, ExtVMFace& _ext, const OnOpFunc& _onOp
         toEvmC(_ext.caller), _ext.data.data(), _ext.data.size(), toEvmC(_ext.value),
         toEvmC(0x0_cppui256), toEvmC(_ext.myAddress)};
     EvmCHost host{_ext};
-    auto r = execute(host, mode, msg, _ext.code.data(), _ext.code.size());
+    evmc::Result r;
+    if (m_evmoneBaseline && !_ext.isCreate && !_ext.code.empty() && _ext.code[0] != 0xEF)
+    {
+        // Deployed legacy code is analyzed once and the analysis is shared by every execution
+        auto analysis = CodeCache::instance().analysis(_ext.codeHash, &_ext.code);
+        r = evmc::Result{evmone::baseline::execute(*static_cast<evmone::VM*>(get_raw_pointer()),
+            EvmCHost::get_interface(), host.to_context(), mode, msg, *analysis)};
+    }
+    else
+        r = execute(host, mode, msg, _ext.code.data(), _ext.code.size());
     // FIXME: Copy the output for now, but copyless version possible.
     auto output = owning_bytes_ref{{&r.output_data[0], &r.output_data[r.output_size]}, 0, r.output_size};
 
@@ -20,6 +20,10 @@ public:
     EVMC(evmc_vm* _vm, std::vector<std::pair<std::string, std::string>> const& _options) noexcept;
 
     owning_bytes_ref exec(u256& io_gas, ExtVMFace& _ext, OnOpFunc const& _onOp) final;
+
+private:
+    /// The VM is evmone running the baseline interpreter, which can execute a cached code analysis.
+    bool m_evmoneBaseline = false;
 };
 }  // namespace eth
 }  // namespace dev
@@ -271,6 +271,7 @@ evmc_tx_context EvmCHost::get_tx_context() const noexcept
     result.tx_origin = toEvmC(m_extVM.origin);
 
     auto const& envInfo = m_extVM.envInfo();
+    envInfo.noteBlockContextRead();
     result.block_coinbase = toEvmC(envInfo.author());
     result.block_number = envInfo.number();
     result.block_timestamp = envInfo.timestamp();
@@ -282,6 +283,7 @@ evmc_tx_context EvmCHost::get_tx_context() const noexcept
 
 evmc::bytes32 EvmCHost::get_block_hash(int64_t _number) const noexcept
 {
+    m_extVM.envInfo().noteBlockContextRead();
     return toEvmC(m_extVM.blockHash(_number));
 }
 
@@ -15,9 +15,11 @@
 #include <evmc/evmc.hpp>
 
 #include <boost/optional.hpp>
+#include <atomic>
 #include <functional>
 #include <set>
 #include <map>
+#include <memory>
 #include <unordered_map>
 
 namespace dev
@@ -154,11 +156,22 @@ public:
     u256 const& gasUsed() const { return m_gasUsed; }
     u256 const& chainID() const { return m_chainID; }
 
+    /// Set @p _flag when the executed code reads the block context (author, timestamp, number,
+    /// block hashes...). The flag is owned by the execution, the copies made for nested calls
+    /// point to the same one. // odan
+    void setBlockContextFlag(std::atomic<bool>* _flag) { m_blockContextRead = _flag; }
+    void noteBlockContextRead() const
+    {
+        if (m_blockContextRead)
+            m_blockContextRead->store(true, std::memory_order_relaxed);
+    }
+
 private:
     BlockHeader m_headerInfo;
     LastBlockHashesFace const& m_lastHashes;
     u256 m_gasUsed;
     u256 m_chainID;
+    std::atomic<bool>* m_blockContextRead = nullptr;
 };
 
 /// Represents a call result.
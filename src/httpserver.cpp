@@ -59,6 +59,11 @@ public:
     void operator()() override
     {
         func(req.get(), path);
+        // A detached request is streamed without the worker thread
+        if (req->detachOwner) {
+            auto owner = std::move(req->detachOwner);
+            owner(std::move(req));
+        }
     }
 
     std::unique_ptr<HTTPRequest> req;
@@ -657,6 +662,10 @@ bool HTTPRequest::isChunkMode() {
     return startedChunkTransfer;
 }
 
+void HTTPRequest::Detach(std::function<void(std::unique_ptr<HTTPRequest>)> owner) {
+    detachOwner = std::move(owner);
+}
+
 std::pair<bool, std::string> HTTPRequest::GetHeader(const std::string& hdr) const
 {
     const struct evkeyvalq* headers = evhttp_request_get_input_headers(req);
@@ -6,6 +6,7 @@
 #define BITCOIN_HTTPSERVER_H
 
 #include <functional>
+#include <memory>
 #include <optional>
 #include <string>
 #include <mutex>
@@ -71,6 +72,9 @@ private:
     std::mutex cs;
     std::condition_variable closeCv;
 
+    std::function<void(std::unique_ptr<HTTPRequest>)> detachOwner;
+    friend class HTTPWorkItem;
+
     void startDetectClientClose();
     void waitClientClose();
 
@@ -154,6 +158,12 @@ public:
 	 */
     void ChunkEnd();
 
+    /**
+     * Hand the request over to owner when the handler returns, so the worker thread
+     * is released while the reply is still being streamed in chunks.
+     */
+    void Detach(std::function<void(std::unique_ptr<HTTPRequest>)> owner);
+
     /**
      * Is reply sent?
      */
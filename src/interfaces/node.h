@@ -32,6 +32,7 @@ class Proxy;
 enum class SynchronizationState;
 enum class TransactionError;
 struct CNodeStateStats;
+struct TokenEvent;
 struct bilingual_str;
 namespace node {
 struct NodeContext;
@@ -246,6 +247,12 @@ public:
     //! Get PoS kernel PS
     virtual double getPoSKernelPS() = 0;
 
+    //! Get the token events of a holder from the token index, false when the index is disabled
+    virtual bool getTokenEvents(int64_t fromBlock, int64_t toBlock, int64_t minconf, const std::string& eventName, const std::string& contractAddress, const std::string& senderAddress, int numTopics, std::vector<TokenEvent>& result) = 0;
+
+    //! Check that a log of a token search result is an event of the holder, like the events of the token index
+    virtual bool isHolderTokenEvent(const std::string& logAddress, const std::vector<std::string>& topics, const std::string& eventName, const std::string& contractAddress, const std::string& senderAddress, int numTopics) = 0;
+
     //! Register handler for init messages.
     using InitMessageFn = std::function<void(const std::string& message)>;
     virtual std::unique_ptr<Handler> handleInitMessage(InitMessageFn fn) = 0;
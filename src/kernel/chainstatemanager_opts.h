@@ -46,6 +46,8 @@ struct ChainstateManagerOpts {
     Notifications& notifications;
     //! Number of script check worker threads. Zero means no parallel verification.
     int worker_threads_num{0};
+    //! Number of worker threads executing contract transactions speculatively. Zero means serial execution.
+    int contract_exec_threads_num{0};
 };
 
 } // namespace kernel
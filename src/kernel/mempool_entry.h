@@ -14,14 +14,18 @@
 #include <util/epochguard.h>
 #include <util/overflow.h>
 
+#include <algorithm>
 #include <chrono>
 #include <functional>
 #include <memory>
+#include <optional>
 #include <set>
 #include <stddef.h>
 #include <stdint.h>
+#include <vector>
 
 class CBlockIndex;
+struct ContractSimulation;
 
 struct LockPoints {
     // Will be set to the blockchain height and median time past
@@ -90,6 +94,10 @@ private:
     CAmount m_modified_fee;         //!< Used for determining the priority of the transaction for mining in a block
     mutable LockPoints lockPoints;  //!< Track the height and time at which tx was final
     CAmount nMinGasPrice{0};        //!< The minimum gas price among the contract outputs of the tx
+    const std::optional<std::vector<unsigned char>> m_contract_sender; //!< The owner of the output spent by vin[0] of a contract tx, resolved once
+    mutable std::shared_ptr<const ContractSimulation> m_contract_simulation; //!< Outcome of the contract outputs on the tip state, set by the mempool simulator
+    const uint64_t nGasLimit;       //!< The sum of the gas limits of the contract outputs of the tx
+    uint64_t nGas;                  //!< The gas used by the contract outputs on the tip state when simulated, the gas limit otherwise
 
     // Information about descendants of this transaction that are in the
     // mempool; if we remove this transaction we must remove all of these
@@ -110,7 +118,9 @@ public:
     CTxMemPoolEntry(const CTransactionRef& tx, CAmount fee,
                     int64_t time, unsigned int entry_height, uint64_t entry_sequence,
                     bool spends_coinbase,
-                    int64_t sigops_cost, LockPoints lp, CAmount min_gas_price = 0)
+                    int64_t sigops_cost, LockPoints lp, CAmount min_gas_price = 0,
+                    std::optional<std::vector<unsigned char>> contract_sender = std::nullopt,
+                    uint64_t gas_limit = 0)
         : tx{tx},
           nFee{fee},
           nTxWeight{GetTransactionWeight(*tx)},
@@ -123,6 +133,9 @@ public:
           m_modified_fee{nFee},
           lockPoints{lp},
           nMinGasPrice{min_gas_price},
+          m_contract_sender{std::move(contract_sender)},
+          nGasLimit{gas_limit},
+          nGas{gas_limit},
           nSizeWithDescendants{GetTxSize()},
           nModFeesWithDescendants{nFee},
           nSizeWithAncestors{GetTxSize()},
@@ -152,6 +165,16 @@ public:
     size_t DynamicMemoryUsage() const { return nUsageSize; }
     const LockPoints& GetLockPoints() const { return lockPoints; }
     const CAmount& GetMinGasPrice() const { return nMinGasPrice; }
+    const std::optional<std::vector<unsigned char>>& GetContractSender() const { return m_contract_sender; }
+    const std::shared_ptr<const ContractSimulation>& GetContractSimulation() const { return m_contract_simulation; }
+    uint64_t GetGasLimit() const { return nGasLimit; }
+    uint64_t GetGas() const { return nGas; }
+    // The fee kept by the block producer for the gas of the tx, the refund of the unused gas is
+    // estimated with the minimum gas price among the outputs
+    CAmount GetModifiedFeeForGas() const
+    {
+        return SaturatingAdd(m_modified_fee, -CAmount((nGasLimit - nGas) * nMinGasPrice));
+    }
 
     // Adjusts the descendant state.
     void UpdateDescendantState(int32_t modifySize, CAmount modifyFee, int64_t modifyCount);
@@ -171,6 +194,18 @@ public:
         lockPoints = lp;
     }
 
+    // Update the contract simulation after the tx or the tip changed
+    void UpdateContractSimulation(std::shared_ptr<const ContractSimulation> simulation) const
+    {
+        m_contract_simulation = std::move(simulation);
+    }
+
+    // Update the gas expected to be used, the entry must be modified through the mempool index
+    void UpdateGas(uint64_t gas)
+    {
+        if (nGasLimit) nGas = std::clamp<uint64_t>(gas, 1, nGasLimit);
+    }
+
     uint64_t GetCountWithDescendants() const { return m_count_with_descendants; }
     int64_t GetSizeWithDescendants() const { return nSizeWithDescendants; }
     CAmount GetModFeesWithDescendants() const { return nModFeesWithDescendants; }
@@ -17,6 +17,10 @@
 static constexpr unsigned int DEFAULT_MAX_MEMPOOL_SIZE_MB{300};
 /** Default for -maxmempool when blocksonly is set */
 static constexpr unsigned int DEFAULT_BLOCKSONLY_MAX_MEMPOOL_SIZE_MB{5};
+/** Default for -maxmempoolgas, maximum gas of the mempool contract txs, the gas limit of 100 blocks */
+static constexpr uint64_t DEFAULT_MAX_MEMPOOL_GAS{4'000'000'000};
+/** Default for -maxmempoolsendergas, maximum gas limit of the mempool contract txs of a sender */
+static constexpr uint64_t DEFAULT_MAX_MEMPOOL_SENDER_GAS{400'000'000};
 /** Default for -mempoolexpiry, expiration time for mempool transactions in hours */
 static constexpr unsigned int DEFAULT_MEMPOOL_EXPIRY_HOURS{336};
 /** Default for -mempoolfullrbf, if the transaction replaceability signaling is ignored */
@@ -38,6 +42,8 @@ struct MemPoolOptions {
     /* The ratio used to determine how often sanity checks will run.  */
     int check_ratio{0};
     int64_t max_size_bytes{DEFAULT_MAX_MEMPOOL_SIZE_MB * 1'000'000};
+    uint64_t max_gas{DEFAULT_MAX_MEMPOOL_GAS};
+    uint64_t max_sender_gas{DEFAULT_MAX_MEMPOOL_SENDER_GAS};
     std::chrono::seconds expiry{std::chrono::hours{DEFAULT_MEMPOOL_EXPIRY_HOURS}};
     CFeeRate incremental_relay_feerate{DEFAULT_INCREMENTAL_RELAY_FEE};
     /** A fee rate smaller than this is considered zero fee (for relaying, mining and transaction creation) */
@@ -37,10 +37,105 @@
 #include <util/translation.h>
 #include <validation.h>
 #include <chainparams.h>
+#include <libdevcore/SHA3.h>
+#include <util/convert.h>
 
 #include <map>
 #include <unordered_map>
 
+dev::h2048 LogBloomOf(const dev::h160& address)
+{
+    dev::h2048 bloom;
+    return bloom.shiftBloom<3>(dev::sha3(address.ref()));
+}
+
+dev::h2048 LogBloomOf(const dev::h256& topic)
+{
+    dev::h2048 bloom;
+    return bloom.shiftBloom<3>(dev::sha3(topic.ref()));
+}
+
+const dev::h256& TokenTransferTopic()
+{
+    static const dev::h256 topic = dev::sha3(std::string("Transfer(address,address,uint256)"));
+    return topic;
+}
+
+const dev::h256& TokenBurnTopic()
+{
+    static const dev::h256 topic = dev::sha3(std::string("Burn(address,uint256)"));
+    return topic;
+}
+
+bool GetTokenTransfer(const dev::eth::LogEntry& log, CTokenTransfer& transfer)
+{
+    // The indexed addresses are in the topics and the amount is the only data, other logs with
+    // the same signature like the NFT transfers are not token transfers
+    if (log.data.size() != 32 || log.topics.empty()) {
+        return false;
+    }
+    if (log.topics.size() == 3 && log.topics[0] == TokenTransferTopic()) {
+        transfer.type = TOKEN_TRANSFER;
+        transfer.receiver = h160Touint(dev::h160(log.topics[2], dev::h160::AlignRight));
+    } else if (log.topics.size() == 2 && log.topics[0] == TokenBurnTopic()) {
+        transfer.type = TOKEN_BURN;
+        transfer.receiver.SetNull();
+    } else {
+        return false;
+    }
+    transfer.contract = h160Touint(log.address);
+    transfer.sender = h160Touint(dev::h160(log.topics[1], dev::h160::AlignRight));
+    transfer.value = h256Touint(dev::h256(log.data));
+    return true;
+}
+
+/** a - b, zero instead of wrapping around */
+static dev::u256 TokenBalanceSub(const dev::u256& a, const dev::u256& b)
+{
+    return a > b ? a - b : 0;
+}
+
+/** a + b, the maximum value instead of wrapping around */
+static dev::u256 TokenBalanceAdd(const dev::u256& a, const dev::u256& b)
+{
+    dev::u256 sum = a + b;
+    return sum < a ? ~dev::u256(0) : sum;
+}
+
+/**
+ * Balance of holder after the transfer from its balance before, the amount of a transfer to self cancels out.
+ * The tokens that mint without a Transfer log spend more than their logged balance, the balances saturate
+ * instead of wrapping around.
+ */
+static dev::u256 TokenBalanceAfter(const CTokenIndexValue& value, const uint160& holder, dev::u256 balance)
+{
+    if (holder == value.sender && holder == value.receiver) {
+        return balance;
+    }
+    if (holder == value.sender) {
+        balance = TokenBalanceSub(balance, uintTou256(value.value));
+    }
+    if (holder == value.receiver) {
+        balance = TokenBalanceAdd(balance, uintTou256(value.value));
+    }
+    return balance;
+}
+
+static dev::u256 TokenBalanceBefore(const CTokenIndexValue& value, const uint160& holder)
+{
+    dev::u256 balance = uintTou256(value.balance);
+    if (holder == value.sender && holder == value.receiver) {
+        return balance;
+    }
+    if (holder == value.sender) {
+        balance = TokenBalanceAdd(balance, uintTou256(value.value));
+    }
+    if (holder == value.receiver) {
+        balance = TokenBalanceSub(balance, uintTou256(value.value));
+    }
+    return balance;
+}
+
 namespace kernel {
 static constexpr uint8_t DB_BLOCK_FILES{'f'};
 static constexpr uint8_t DB_BLOCK_INDEX{'b'};
@@ -56,11 +151,40 @@ static constexpr uint8_t DB_LAST_BLOCK{'l'};
 static constexpr uint8_t DB_HEIGHTINDEX{'h'};
 static constexpr uint8_t DB_STAKEINDEX{'s'};
 static constexpr uint8_t DB_DELEGATEINDEX{'d'};
+static constexpr uint8_t DB_DELEGATIONINDEX{'D'};
+static constexpr uint8_t DB_DELEGATIONUNDO{'U'};
+static constexpr uint8_t DB_DELEGATIONBEST{'E'};
 static constexpr uint8_t DB_ADDRESSINDEX{'a'};
 static constexpr uint8_t DB_ADDRESSUNSPENTINDEX{'u'};
+static constexpr uint8_t DB_ADDRESSWEIGHTINDEX{'w'};
 static constexpr uint8_t DB_TIMESTAMPINDEX{'S'};
 static constexpr uint8_t DB_BLOCKHASHINDEX{'z'};
 static constexpr uint8_t DB_SPENTINDEX{'p'};
+static constexpr uint8_t DB_BLOCKLOGBLOOM{'g'};
+static constexpr uint8_t DB_SECTIONLOGBLOOM{'G'};
+static constexpr uint8_t DB_LOGBLOOMSTART{'H'};
+static constexpr uint8_t DB_TOKENINDEX{'k'};
+static constexpr uint8_t DB_TOKENBALANCE{'K'};
+static constexpr uint8_t DB_TOKENUNDO{'V'};
+static constexpr uint8_t DB_TOKENBEST{'W'};
+
+static bool MatchLogBloom(const valtype& bloom, const LogBloomFilter& filter)
+{
+    dev::h2048 logBloom(bloom);
+    for (const std::vector<dev::h2048>& group : filter) {
+        bool match = group.empty();
+        for (const dev::h2048& b : group) {
+            if (logBloom.contains(b)) {
+                match = true;
+                break;
+            }
+        }
+        if (!match) {
+            return false;
+        }
+    }
+    return true;
+}
 
 struct DelegateEntry {
     uint160 address;
@@ -198,19 +322,31 @@ bool BlockTreeDB::WriteHeightIndex(const CHeightTxIndexKey &heightIndex, const s
 
 int BlockTreeDB::ReadHeightIndex(int low, int high, int minconf,
         std::vector<std::vector<uint256>> &blocksOfHashes,
-        std::set<dev::h160> const &addresses, ChainstateManager &chainman) {
+        std::set<dev::h160> const &addresses, ChainstateManager &chainman,
+        LogBloomFilter const &bloomFilter) {
 
     if ((high < low && high > -1) || (high == 0 && low == 0) || (high < -1 || low < 0)) {
        return -1;
     }
 
+    // Blocks connected before the log bloom index existed have no bloom
+    int bloomStart = -1;
+    if (!bloomFilter.empty()) {
+        unsigned int start;
+        if (Read(DB_LOGBLOOMSTART, start)) {
+            bloomStart = start;
+        }
+    }
+    int sectionChecked = -1;
+    bool sectionMatch = true;
+
     std::unique_ptr<CDBIterator> pcursor(NewIterator());
 
     pcursor->Seek(std::make_pair(DB_HEIGHTINDEX, CHeightTxIndexIteratorKey(low)));
 
     int curheight = 0;
 
-    for (size_t count = 0; pcursor->Valid(); pcursor->Next()) {
+    for (size_t count = 0; pcursor->Valid();) {
 
         std::pair<uint8_t, CHeightTxIndexKey> key;
         if (!pcursor->GetKey(key) || key.first != DB_HEIGHTINDEX) {
@@ -232,8 +368,36 @@ int BlockTreeDB::ReadHeightIndex(int low, int high, int minconf,
 
         curheight = nextHeight;
 
+        if (bloomStart > -1 && nextHeight >= bloomStart) {
+            // A missing bloom is treated as a match, the height index entries are checked then
+            int section = nextHeight / LOG_BLOOM_SECTION_SIZE;
+            if (section != sectionChecked) {
+                valtype bloom;
+                sectionMatch = !Read(std::make_pair(DB_SECTIONLOGBLOOM, CHeightTxIndexIteratorKey(section)), bloom) || MatchLogBloom(bloom, bloomFilter);
+                sectionChecked = section;
+            }
+            if (!sectionMatch) {
+                // Skip the rest of the section, its heights are reported as iterated
+                int sectionEnd = (section + 1) * LOG_BLOOM_SECTION_SIZE - 1;
+                int lastHeight = chainman.ActiveChain().Height() - std::max(minconf, 0);
+                if (high > -1) {
+                    lastHeight = std::min(lastHeight, high);
+                }
+                curheight = std::max(curheight, std::min(sectionEnd, lastHeight));
+                pcursor->Seek(std::make_pair(DB_HEIGHTINDEX, CHeightTxIndexIteratorKey(sectionEnd + 1)));
+                continue;
+            }
+
+            valtype bloom;
+            if (Read(std::make_pair(DB_BLOCKLOGBLOOM, CHeightTxIndexIteratorKey(nextHeight)), bloom) && !MatchLogBloom(bloom, bloomFilter)) {
+                pcursor->Seek(std::make_pair(DB_HEIGHTINDEX, CHeightTxIndexIteratorKey(nextHeight + 1)));
+                continue;
+            }
+        }
+
         auto address = key.second.address;
         if (!addresses.empty() && addresses.find(address) == addresses.end()) {
+            pcursor->Next();
             continue;
         }
 
@@ -246,6 +410,7 @@ int BlockTreeDB::ReadHeightIndex(int low, int high, int minconf,
         count += hashesTx.size();
 
         blocksOfHashes.push_back(hashesTx);
+        pcursor->Next();
     }
 
     return curheight;
@@ -268,6 +433,34 @@ bool BlockTreeDB::EraseHeightIndex(const unsigned int &height) {
         }
     }
 
+    // Rebuild the section bloom from the blooms of the blocks left in the section
+    if (Exists(std::make_pair(DB_BLOCKLOGBLOOM, CHeightTxIndexIteratorKey(height)))) {
+        batch.Erase(std::make_pair(DB_BLOCKLOGBLOOM, CHeightTxIndexIteratorKey(height)));
+
+        unsigned int section = height / LOG_BLOOM_SECTION_SIZE;
+        dev::h2048 sectionBloom;
+        bool sectionEmpty = true;
+        pcursor->Seek(std::make_pair(DB_BLOCKLOGBLOOM, CHeightTxIndexIteratorKey(section * LOG_BLOOM_SECTION_SIZE)));
+        while (pcursor->Valid()) {
+            std::pair<uint8_t, CHeightTxIndexIteratorKey> key;
+            if (!pcursor->GetKey(key) || key.first != DB_BLOCKLOGBLOOM || key.second.height / LOG_BLOOM_SECTION_SIZE != section) {
+                break;
+            }
+            valtype bloom;
+            if (key.second.height != height && pcursor->GetValue(bloom)) {
+                sectionBloom |= dev::h2048(bloom);
+                sectionEmpty = false;
+            }
+            pcursor->Next();
+        }
+
+        if (sectionEmpty) {
+            batch.Erase(std::make_pair(DB_SECTIONLOGBLOOM, CHeightTxIndexIteratorKey(section)));
+        } else {
+            batch.Write(std::make_pair(DB_SECTIONLOGBLOOM, CHeightTxIndexIteratorKey(section)), sectionBloom.asBytes());
+        }
+    }
+
     return WriteBatch(batch);
 }
 
@@ -288,6 +481,41 @@ bool BlockTreeDB::WipeHeightIndex() {
         }
     }
 
+    // The log bloom index is wiped with the height index it summarizes
+    for (uint8_t prefix : {DB_BLOCKLOGBLOOM, DB_SECTIONLOGBLOOM}) {
+        pcursor->Seek(prefix);
+        while (pcursor->Valid()) {
+            std::pair<uint8_t, CHeightTxIndexIteratorKey> key;
+            if (pcursor->GetKey(key) && key.first == prefix) {
+                batch.Erase(key);
+                pcursor->Next();
+            } else {
+                break;
+            }
+        }
+    }
+    batch.Erase(DB_LOGBLOOMSTART);
+
+    return WriteBatch(batch);
+}
+
+bool BlockTreeDB::WriteLogBloomIndex(unsigned int height, const dev::h2048& bloom) {
+    CDBBatch batch(*this);
+    batch.Write(std::make_pair(DB_BLOCKLOGBLOOM, CHeightTxIndexIteratorKey(height)), bloom.asBytes());
+
+    unsigned int section = height / LOG_BLOOM_SECTION_SIZE;
+    valtype sectionBloom;
+    if (Read(std::make_pair(DB_SECTIONLOGBLOOM, CHeightTxIndexIteratorKey(section)), sectionBloom)) {
+        batch.Write(std::make_pair(DB_SECTIONLOGBLOOM, CHeightTxIndexIteratorKey(section)), (dev::h2048(sectionBloom) | bloom).asBytes());
+    } else {
+        batch.Write(std::make_pair(DB_SECTIONLOGBLOOM, CHeightTxIndexIteratorKey(section)), bloom.asBytes());
+    }
+
+    // Heights below the first stored bloom are not covered by the index
+    unsigned int start;
+    if (!Read(DB_LOGBLOOMSTART, start)) {
+        batch.Write(DB_LOGBLOOMSTART, height);
+    }
     return WriteBatch(batch);
 }
 
@@ -403,6 +631,359 @@ bool BlockTreeDB::EraseDelegateIndex(unsigned int height) {
     return WriteBatch(batch);
 }
 
+bool BlockTreeDB::UpdateDelegationIndex(unsigned int height, const std::vector<std::pair<uint160, Delegation> > &vect, const CIndexBestBlock &best) {
+    // The delegations before the block, in the order of their first change
+    std::map<uint160, Delegation> delegations;
+    std::vector<std::pair<uint160, Delegation> > undo;
+    for (const auto& [address, delegation] : vect) {
+        if (delegations.find(address) == delegations.end()) {
+            Delegation previous;
+            ReadDelegationIndex(address, previous);
+            undo.emplace_back(address, previous);
+        }
+        delegations[address] = delegation;
+    }
+
+    CDBBatch batch(*this);
+    for (const auto& [address, delegation] : delegations) {
+        if (delegation.IsNull()) {
+            batch.Erase(std::make_pair(DB_DELEGATIONINDEX, address));
+        } else {
+            batch.Write(std::make_pair(DB_DELEGATIONINDEX, address), delegation);
+        }
+    }
+    if (!undo.empty()) {
+        batch.Write(std::make_pair(DB_DELEGATIONUNDO, height), undo);
+    }
+    batch.Write(DB_DELEGATIONBEST, best);
+    return WriteBatch(batch);
+}
+
+bool BlockTreeDB::EraseDelegationIndex(unsigned int height, const CIndexBestBlock &best) {
+    // Most blocks have no delegation changes
+    std::vector<std::pair<uint160, Delegation> > undo;
+    ReadDelegationUndo(height, undo);
+
+    CDBBatch batch(*this);
+    for (const auto& [address, delegation] : undo) {
+        if (delegation.IsNull()) {
+            batch.Erase(std::make_pair(DB_DELEGATIONINDEX, address));
+        } else {
+            batch.Write(std::make_pair(DB_DELEGATIONINDEX, address), delegation);
+        }
+    }
+    batch.Erase(std::make_pair(DB_DELEGATIONUNDO, height));
+    batch.Write(DB_DELEGATIONBEST, best);
+    return WriteBatch(batch);
+}
+
+bool BlockTreeDB::ReadDelegationIndex(const uint160 &address, Delegation &delegation) {
+    return Read(std::make_pair(DB_DELEGATIONINDEX, address), delegation);
+}
+
+bool BlockTreeDB::ReadDelegationIndex(std::map<uint160, Delegation> &delegations) {
+    std::unique_ptr<CDBIterator> pcursor(NewIterator());
+
+    pcursor->Seek(DB_DELEGATIONINDEX);
+    while (pcursor->Valid()) {
+        std::pair<uint8_t, uint160> key;
+        if (pcursor->GetKey(key) && key.first == DB_DELEGATIONINDEX) {
+            Delegation delegation;
+            if (!pcursor->GetValue(delegation)) {
+                return error("failed to get delegation index value");
+            }
+            delegations[key.second] = delegation;
+            pcursor->Next();
+        } else {
+            break;
+        }
+    }
+
+    return true;
+}
+
+bool BlockTreeDB::ReadDelegationUndo(unsigned int height, std::vector<std::pair<uint160, Delegation> > &vect) {
+    return Read(std::make_pair(DB_DELEGATIONUNDO, height), vect);
+}
+
+bool BlockTreeDB::ReadDelegationIndexBest(CIndexBestBlock &best) {
+    return Read(DB_DELEGATIONBEST, best);
+}
+
+bool BlockTreeDB::WriteDelegationIndexBest(const CIndexBestBlock &best) {
+    return Write(DB_DELEGATIONBEST, best);
+}
+
+bool BlockTreeDB::RewindDelegationIndex(const CBlockIndex* pindexBest, const CBlockIndex* pindexTip) {
+    // One batch per block, an interrupted rewind continues from the block it reached
+    for (const CBlockIndex* pindex = pindexBest; pindex != pindexTip; pindex = pindex->pprev) {
+        if (!pindex->pprev || !EraseDelegationIndex(pindex->nHeight, CIndexBestBlock(pindex->pprev))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool BlockTreeDB::WipeDelegationIndex(const CIndexBestBlock &best) {
+    std::unique_ptr<CDBIterator> pcursor(NewIterator());
+    CDBBatch batch(*this);
+
+    pcursor->Seek(DB_DELEGATIONINDEX);
+    while (pcursor->Valid()) {
+        std::pair<uint8_t, uint160> key;
+        if (pcursor->GetKey(key) && key.first == DB_DELEGATIONINDEX) {
+            batch.Erase(key);
+            pcursor->Next();
+        } else {
+            break;
+        }
+    }
+
+    pcursor->Seek(DB_DELEGATIONUNDO);
+    while (pcursor->Valid()) {
+        std::pair<uint8_t, unsigned int> key;
+        if (pcursor->GetKey(key) && key.first == DB_DELEGATIONUNDO) {
+            batch.Erase(key);
+            pcursor->Next();
+        } else {
+            break;
+        }
+    }
+
+    batch.Write(DB_DELEGATIONBEST, best);
+    return WriteBatch(batch);
+}
+
+bool BlockTreeDB::UpdateTokenIndex(unsigned int height, const std::vector<CTokenTransfer> &vect, const CIndexBestBlock &best) {
+    // The balances before the block, in the order of their first change
+    std::map<std::pair<uint160, uint160>, dev::u256> balances;
+    std::vector<std::pair<std::pair<uint160, uint160>, uint256> > undo;
+
+    CDBBatch batch(*this);
+    for (size_t i = 0; i < vect.size(); i++) {
+        const CTokenTransfer& transfer = vect[i];
+        for (const uint160* pholder : {&transfer.sender, &transfer.receiver}) {
+            // The null address of mints and burns has no balance, a transfer to self is listed once
+            const uint160& holder = *pholder;
+            if (holder.IsNull() || (pholder == &transfer.receiver && holder == transfer.sender)) {
+                continue;
+            }
+            std::pair<uint160, uint160> address(transfer.contract, holder);
+            auto it = balances.find(address);
+            if (it == balances.end()) {
+                uint256 previous;
+                ReadTokenBalance(transfer.contract, holder, -1, previous);
+                undo.emplace_back(address, previous);
+                it = balances.emplace(address, uintTou256(previous)).first;
+            }
+
+            CTokenIndexValue value(transfer);
+            it->second = TokenBalanceAfter(value, holder, it->second);
+            value.balance = u256Touint(it->second);
+            batch.Write(std::make_pair(DB_TOKENINDEX, CTokenIndexKey(transfer.contract, holder, height, i)), value);
+        }
+    }
+
+    for (const auto& [address, balance] : balances) {
+        if (balance == 0) {
+            batch.Erase(std::make_pair(DB_TOKENBALANCE, address));
+        } else {
+            batch.Write(std::make_pair(DB_TOKENBALANCE, address), u256Touint(balance));
+        }
+    }
+    if (!undo.empty()) {
+        batch.Write(std::make_pair(DB_TOKENUNDO, height), undo);
+    }
+    batch.Write(DB_TOKENBEST, best);
+    return WriteBatch(batch);
+}
+
+bool BlockTreeDB::EraseTokenIndex(unsigned int height, const CIndexBestBlock &best) {
+    // Most blocks have no token transfers
+    std::vector<std::pair<std::pair<uint160, uint160>, uint256> > undo;
+    Read(std::make_pair(DB_TOKENUNDO, height), undo);
+
+    std::unique_ptr<CDBIterator> pcursor(NewIterator());
+    CDBBatch batch(*this);
+    for (const auto& [address, balance] : undo) {
+        const auto& [contract, holder] = address;
+        pcursor->Seek(std::make_pair(DB_TOKENINDEX, CTokenIndexKey(contract, holder, height, 0)));
+        while (pcursor->Valid()) {
+            std::pair<uint8_t, CTokenIndexKey> key;
+            if (pcursor->GetKey(key) && key.first == DB_TOKENINDEX && key.second.contract == contract &&
+                key.second.holder == holder && key.second.blockHeight == (int)height) {
+                batch.Erase(key);
+                pcursor->Next();
+            } else {
+                break;
+            }
+        }
+
+        if (balance.IsNull()) {
+            batch.Erase(std::make_pair(DB_TOKENBALANCE, address));
+        } else {
+            batch.Write(std::make_pair(DB_TOKENBALANCE, address), balance);
+        }
+    }
+    batch.Erase(std::make_pair(DB_TOKENUNDO, height));
+    batch.Write(DB_TOKENBEST, best);
+    return WriteBatch(batch);
+}
+
+bool BlockTreeDB::ReadTokenIndexBest(CIndexBestBlock &best) {
+    return Read(DB_TOKENBEST, best);
+}
+
+bool BlockTreeDB::WriteTokenIndexBest(const CIndexBestBlock &best) {
+    return Write(DB_TOKENBEST, best);
+}
+
+bool BlockTreeDB::RewindTokenIndex(const CBlockIndex* pindexBest, const CBlockIndex* pindexTip) {
+    // One batch per block, an interrupted rewind continues from the block it reached
+    for (const CBlockIndex* pindex = pindexBest; pindex != pindexTip; pindex = pindex->pprev) {
+        if (!pindex->pprev || !EraseTokenIndex(pindex->nHeight, CIndexBestBlock(pindex->pprev))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool BlockTreeDB::ReadTokenIndex(const uint160 &contract, const uint160 &holder, int low, int high,
+                                 std::vector<std::pair<CTokenIndexKey, CTokenIndexValue> > &vect) {
+    std::unique_ptr<CDBIterator> pcursor(NewIterator());
+
+    pcursor->Seek(std::make_pair(DB_TOKENINDEX, CTokenIndexKey(contract, holder, std::max(low, 0), 0)));
+    while (pcursor->Valid()) {
+        std::pair<uint8_t, CTokenIndexKey> key;
+        if (pcursor->GetKey(key) && key.first == DB_TOKENINDEX && key.second.contract == contract && key.second.holder == holder) {
+            if (high > -1 && key.second.blockHeight > high) {
+                break;
+            }
+            CTokenIndexValue value;
+            if (!pcursor->GetValue(value)) {
+                return error("failed to get token index value");
+            }
+            vect.emplace_back(key.second, value);
+            pcursor->Next();
+        } else {
+            break;
+        }
+    }
+
+    return true;
+}
+
+bool BlockTreeDB::ReadTokenBalance(const uint160 &contract, const uint160 &holder, int height, uint256 &balance) {
+    if (height > -1) {
+        // The balance before the first transfer after height, when there is one
+        std::unique_ptr<CDBIterator> pcursor(NewIterator());
+        pcursor->Seek(std::make_pair(DB_TOKENINDEX, CTokenIndexKey(contract, holder, height + 1, 0)));
+        std::pair<uint8_t, CTokenIndexKey> key;
+        if (pcursor->Valid() && pcursor->GetKey(key) && key.first == DB_TOKENINDEX &&
+            key.second.contract == contract && key.second.holder == holder) {
+            CTokenIndexValue value;
+            if (!pcursor->GetValue(value)) {
+                return error("failed to get token index value");
+            }
+            balance = u256Touint(TokenBalanceBefore(value, holder));
+            return true;
+        }
+    }
+
+    if (!Read(std::make_pair(DB_TOKENBALANCE, std::make_pair(contract, holder)), balance)) {
+        balance.SetNull();
+    }
+    return true;
+}
+
+/** Erase the keys of type K starting with prefix */
+template<typename K>
+static void EraseKeys(CDBIterator& cursor, CDBBatch& batch, uint8_t prefix)
+{
+    cursor.Seek(prefix);
+    while (cursor.Valid()) {
+        std::pair<uint8_t, K> key;
+        if (cursor.GetKey(key) && key.first == prefix) {
+            batch.Erase(key);
+            cursor.Next();
+        } else {
+            break;
+        }
+    }
+}
+
+bool BlockTreeDB::WipeTokenIndex(const CIndexBestBlock &best) {
+    std::unique_ptr<CDBIterator> pcursor(NewIterator());
+    CDBBatch batch(*this);
+
+    EraseKeys<CTokenIndexKey>(*pcursor, batch, DB_TOKENINDEX);
+    EraseKeys<std::pair<uint160, uint160> >(*pcursor, batch, DB_TOKENBALANCE);
+    EraseKeys<unsigned int>(*pcursor, batch, DB_TOKENUNDO);
+
+    batch.Write(DB_TOKENBEST, best);
+    return WriteBatch(batch);
+}
+
+bool BlockTreeDB::BuildTokenIndex(ChainstateManager &chainman) {
+    // The transfers are taken from the stored logs
+    if (!fLogEvents) {
+        return error("Events indexing disabled");
+    }
+
+    // The best block stays null while the index is built
+    LOCK(cs_main);
+    if (!WipeTokenIndex(CIndexBestBlock())) {
+        return error("Failed to wipe the token index");
+    }
+
+    std::vector<std::vector<uint256>> hashesToBlock;
+    LogBloomFilter bloomFilter{{LogBloomOf(TokenTransferTopic()), LogBloomOf(TokenBurnTopic())}};
+    if (ReadHeightIndex(0, -1, 0, hashesToBlock, {}, chainman, bloomFilter) == -1) {
+        return error("Failed to read the height index");
+    }
+
+    // The logs of the active chain per block, in the order of the transactions and outputs
+    std::map<uint32_t, std::map<std::pair<uint32_t, uint32_t>, std::pair<uint256, dev::eth::LogEntries> > > blockLogs;
+    std::set<uint256> dupes;
+    for (const auto& hashesTx : hashesToBlock) {
+        for (const auto& e : hashesTx) {
+            if (!dupes.insert(e).second) {
+                continue;
+            }
+            for (const TransactionReceiptInfo& receipt : pstorageresult->getResult(uintToh256(e))) {
+                const CBlockIndex* pindex = chainman.ActiveChain()[receipt.blockNumber];
+                if (receipt.logs.empty() || !pindex || pindex->GetBlockHash() != receipt.blockHash) {
+                    continue;
+                }
+                blockLogs[receipt.blockNumber][std::make_pair(receipt.transactionIndex, receipt.outputIndex)] = std::make_pair(e, receipt.logs);
+            }
+        }
+    }
+
+    for (const auto& [height, txLogs] : blockLogs) {
+        std::vector<CTokenTransfer> transfers;
+        for (const auto& [position, logs] : txLogs) {
+            for (const dev::eth::LogEntry& log : logs.second) {
+                CTokenTransfer transfer;
+                if (GetTokenTransfer(log, transfer)) {
+                    transfer.txhash = logs.first;
+                    transfers.push_back(transfer);
+                }
+            }
+        }
+        if (!transfers.empty() && !UpdateTokenIndex(height, transfers, CIndexBestBlock())) {
+            return error("Failed to write the token index");
+        }
+    }
+
+    const CBlockIndex* tip = chainman.ActiveChain().Tip();
+    if (tip && !WriteTokenIndexBest(CIndexBestBlock(tip))) {
+        return error("Failed to write the token index best block");
+    }
+
+    return true;
+}
+
 bool BlockTreeDB::WriteAddressIndex(const std::vector<std::pair<CAddressIndexKey, CAmount > >&vect) {
     CDBBatch batch(*this);
     for (std::vector<std::pair<CAddressIndexKey, CAmount> >::const_iterator it=vect.begin(); it!=vect.end(); it++)
@@ -486,6 +1067,121 @@ bool BlockTreeDB::ReadAddressUnspentIndex(uint256 addressHash, int type,
     return true;
 }
 
+bool BlockTreeDB::UpdateAddressWeightIndex(const std::vector<std::pair<CAddressIndexIteratorKey, CAddressWeightDelta> > &vect, int compactHeight) {
+    std::map<std::pair<uint8_t, uint256>, CAddressWeightValue> values;
+    for (std::vector<std::pair<CAddressIndexIteratorKey, CAddressWeightDelta> >::const_iterator it=vect.begin(); it!=vect.end(); it++) {
+        std::pair<uint8_t, uint256> address(it->first.type, it->first.hashBytes);
+        auto value = values.find(address);
+        if (value == values.end()) {
+            value = values.emplace(address, CAddressWeightValue()).first;
+            if (!ReadAddressWeightIndex(address.second, address.first, value->second)) {
+                value->second.compactHeight = compactHeight;
+            }
+        }
+        value->second.Add(it->second);
+    }
+
+    CDBBatch batch(*this);
+    for (auto& [address, value] : values) {
+        value.Compact(compactHeight);
+        if (value.IsNull()) {
+            batch.Erase(std::make_pair(DB_ADDRESSWEIGHTINDEX, CAddressIndexIteratorKey(address.first, address.second)));
+        } else {
+            batch.Write(std::make_pair(DB_ADDRESSWEIGHTINDEX, CAddressIndexIteratorKey(address.first, address.second)), value);
+        }
+    }
+    return WriteBatch(batch);
+}
+
+bool BlockTreeDB::ReadAddressWeightIndex(uint256 addressHash, int type, CAddressWeightValue &value) {
+    return Read(std::make_pair(DB_ADDRESSWEIGHTINDEX, CAddressIndexIteratorKey(type, addressHash)), value);
+}
+
+bool BlockTreeDB::BuildAddressWeightIndex(int compactHeight) {
+    // Balances and weights from the unspent outputs
+    std::unique_ptr<CDBIterator> pcursor(NewIterator());
+    pcursor->Seek(DB_ADDRESSUNSPENTINDEX);
+
+    CDBBatch batch(*this);
+    CAddressIndexIteratorKey address;
+    CAddressWeightValue value;
+    value.compactHeight = compactHeight;
+    auto writeValue = [&] {
+        if (!value.IsNull()) {
+            batch.Write(std::make_pair(DB_ADDRESSWEIGHTINDEX, address), value);
+        }
+        value.SetNull();
+        value.compactHeight = compactHeight;
+    };
+
+    while (pcursor->Valid()) {
+        std::pair<uint8_t,CAddressUnspentKey> key;
+        if (!pcursor->GetKey(key) || key.first != DB_ADDRESSUNSPENTINDEX) {
+            break;
+        }
+        if (key.second.type != address.type || key.second.hashBytes != address.hashBytes) {
+            writeValue();
+            address = CAddressIndexIteratorKey(key.second.type, key.second.hashBytes);
+            if (batch.SizeEstimate() > ADDRESS_WEIGHT_BATCH_SIZE) {
+                if (!WriteBatch(batch)) return false;
+                batch.Clear();
+            }
+        }
+        CAddressUnspentValue nValue;
+        if (!pcursor->GetValue(nValue)) {
+            return error("failed to get address unspent value");
+        }
+        value.Add(CAddressWeightDelta(nValue.blockHeight, nValue.satoshis, 0));
+        pcursor->Next();
+    }
+    writeValue();
+    if (!WriteBatch(batch)) return false;
+    batch.Clear();
+
+    // Received amounts from the address history, the aggregates written above are complete
+    pcursor->Seek(DB_ADDRESSINDEX);
+    address.SetNull();
+    CAmount received = 0;
+    auto writeReceived = [&] {
+        if (received == 0) {
+            return;
+        }
+        CAddressWeightValue receivedValue;
+        if (!ReadAddressWeightIndex(address.hashBytes, address.type, receivedValue)) {
+            receivedValue.compactHeight = compactHeight;
+        }
+        receivedValue.received = received;
+        batch.Write(std::make_pair(DB_ADDRESSWEIGHTINDEX, address), receivedValue);
+        received = 0;
+    };
+
+    while (pcursor->Valid()) {
+        std::pair<uint8_t,CAddressIndexKey> key;
+        if (!pcursor->GetKey(key) || key.first != DB_ADDRESSINDEX) {
+            break;
+        }
+        if (key.second.type != address.type || key.second.hashBytes != address.hashBytes) {
+            writeReceived();
+            address = CAddressIndexIteratorKey(key.second.type, key.second.hashBytes);
+            if (batch.SizeEstimate() > ADDRESS_WEIGHT_BATCH_SIZE) {
+                if (!WriteBatch(batch)) return false;
+                batch.Clear();
+            }
+        }
+        CAmount nValue;
+        if (!pcursor->GetValue(nValue)) {
+            return error("failed to get address index value");
+        }
+        if (nValue > 0) {
+            received += nValue;
+        }
+        pcursor->Next();
+    }
+    writeReceived();
+    batch.Write(std::make_pair(DB_FLAG, std::string("addrweightindex")), uint8_t{'1'});
+    return WriteBatch(batch, true);
+}
+
 bool BlockTreeDB::WriteTimestampIndex(const CTimestampIndexKey &timestampIndex) {
     CDBBatch batch(*this);
     batch.Write(std::make_pair(DB_TIMESTAMPINDEX, timestampIndex), 0);
@@ -981,6 +1677,10 @@ bool BlockManager::LoadBlockIndexDB(const std::optional<uint256>& snapshot_block
     ///////////////////////////////////////////////////////////// // odan
     m_block_tree_db->ReadFlag("addrindex", fAddressIndex);
     LogPrintf("LoadBlockIndexDB(): address index %s\n", fAddressIndex ? "enabled" : "disabled");
+    m_block_tree_db->ReadFlag("delegationindex", fDelegationIndex);
+    LogPrintf("LoadBlockIndexDB(): delegation index %s\n", fDelegationIndex ? "enabled" : "disabled");
+    m_block_tree_db->ReadFlag("tokenindex", fTokenIndex);
+    LogPrintf("LoadBlockIndexDB(): token index %s\n", fTokenIndex ? "enabled" : "disabled");
     /////////////////////////////////////////////////////////////
     // Check whether we have a transaction index
     m_block_tree_db->ReadFlag("logevents", fLogEvents);
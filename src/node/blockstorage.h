@@ -50,10 +50,23 @@ struct CHeightTxIndexIteratorKey;
 struct CAddressIndexKey;
 struct CAddressUnspentKey;
 struct CAddressUnspentValue;
+struct CAddressIndexIteratorKey;
+struct CAddressWeightDelta;
+struct CAddressWeightValue;
 struct CMempoolAddressDeltaKey;
 struct CTimestampIndexKey;
 struct CTimestampBlockIndexKey;
 struct CTimestampBlockIndexValue;
+struct Delegation;
+struct CIndexBestBlock;
+struct CTokenTransfer;
+struct CTokenIndexKey;
+struct CTokenIndexValue;
+namespace dev {
+namespace eth {
+struct LogEntry;
+}
+}
 ////////////////////////////////////
 namespace Consensus {
 struct Params;
@@ -63,6 +76,26 @@ class SignalInterrupt;
 } // namespace util
 using valtype = std::vector<unsigned char>;
 
+/** Number of blocks covered by a section bloom of the log bloom index */
+static const unsigned int LOG_BLOOM_SECTION_SIZE = 4096;
+
+/**
+ * Log bloom query for BlockTreeDB::ReadHeightIndex: a block can only have matching logs
+ * when its log bloom contains at least one of the blooms of every group.
+ */
+using LogBloomFilter = std::vector<std::vector<dev::h2048>>;
+
+/** Bloom of a log address or topic, as set in the log bloom of a receipt */
+dev::h2048 LogBloomOf(const dev::h160& address);
+dev::h2048 LogBloomOf(const dev::h256& topic);
+
+/** First topic of the standard Transfer(address,address,uint256) and Burn(address,uint256) token logs */
+const dev::h256& TokenTransferTopic();
+const dev::h256& TokenBurnTopic();
+
+/** Read a standard Transfer or Burn log of a QRC20 / OAS-F token, the transaction hash is not set */
+bool GetTokenTransfer(const dev::eth::LogEntry& log, CTokenTransfer& transfer);
+
 namespace kernel {
 /** Access to the block database (blocks/index/) */
 class BlockTreeDB : public CDBWrapper
@@ -90,15 +123,21 @@ public:
      * @param minconf stop iterating of the block height does not have enough confirmations (ignored if <= 0)
      * @param blocksOfHashes transaction hashes in blocks iterated are collected into this vector.
      * @param addresses filter out a block unless it matches one of the addresses in this set.
+     * @param bloomFilter skip the blocks and sections whose log bloom does not match this filter.
      *
      * @return the height of the latest block iterated. 0 if no block is iterated.
      */
     int ReadHeightIndex(int low, int high, int minconf,
             std::vector<std::vector<uint256>> &blocksOfHashes,
-            std::set<dev::h160> const &addresses, ChainstateManager &chainman);
+            std::set<dev::h160> const &addresses, ChainstateManager &chainman,
+            LogBloomFilter const &bloomFilter = {});
+    /** Erase the height index and the log bloom of a disconnected block */
     bool EraseHeightIndex(const unsigned int &height);
     bool WipeHeightIndex();
 
+    /** Store the log bloom of a block and add it to the bloom of its section */
+    bool WriteLogBloomIndex(unsigned int height, const dev::h2048& bloom);
+
 
     bool WriteStakeIndex(unsigned int height, uint160 address);
     bool ReadStakeIndex(unsigned int height, uint160& address);
@@ -109,6 +148,46 @@ public:
     bool ReadDelegateIndex(unsigned int height, uint160& address, uint8_t& fee);
     bool EraseDelegateIndex(unsigned int height);
 
+    /**
+     * Apply the delegation changes of the block at height to the delegation index, a null delegation is removed.
+     * The delegations before the block are kept for EraseDelegationIndex, best is written in the same batch.
+     */
+    bool UpdateDelegationIndex(unsigned int height, const std::vector<std::pair<uint160, Delegation> > &vect, const CIndexBestBlock &best);
+    /** Restore the delegations changed by a disconnected block, best is the previous block */
+    bool EraseDelegationIndex(unsigned int height, const CIndexBestBlock &best);
+    bool ReadDelegationIndex(const uint160 &address, Delegation &delegation);
+    /** Read every delegation of the index */
+    bool ReadDelegationIndex(std::map<uint160, Delegation> &delegations);
+    /** Read the delegations from before the block at height, in the order of their first change */
+    bool ReadDelegationUndo(unsigned int height, std::vector<std::pair<uint160, Delegation> > &vect);
+    /** Read the block the delegation index is at, null while the index is built */
+    bool ReadDelegationIndexBest(CIndexBestBlock &best);
+    bool WriteDelegationIndexBest(const CIndexBestBlock &best);
+    /** Restore the delegations changed by the blocks from pindexBest down to pindexTip, which is an ancestor */
+    bool RewindDelegationIndex(const CBlockIndex* pindexBest, const CBlockIndex* pindexTip);
+    bool WipeDelegationIndex(const CIndexBestBlock &best);
+
+    /**
+     * Add the token transfers of the block at height to the token index, with the balance of the holders
+     * after each transfer. The balances before the block are kept for EraseTokenIndex, best is written in the same batch.
+     */
+    bool UpdateTokenIndex(unsigned int height, const std::vector<CTokenTransfer> &vect, const CIndexBestBlock &best);
+    /** Remove the token transfers of a disconnected block and restore the balances, best is the previous block */
+    bool EraseTokenIndex(unsigned int height, const CIndexBestBlock &best);
+    /** Read the block the token index is at, null while the index is built */
+    bool ReadTokenIndexBest(CIndexBestBlock &best);
+    bool WriteTokenIndexBest(const CIndexBestBlock &best);
+    /** Remove the token transfers of the blocks from pindexBest down to pindexTip, which is an ancestor */
+    bool RewindTokenIndex(const CBlockIndex* pindexBest, const CBlockIndex* pindexTip);
+    /** Read the transfers of a token holder from the block height low to high (ignored if < 0), in chain order */
+    bool ReadTokenIndex(const uint160 &contract, const uint160 &holder, int low, int high,
+                        std::vector<std::pair<CTokenIndexKey, CTokenIndexValue> > &vect);
+    /** Read the token balance of a holder after the block at height, the current balance when height < 0 */
+    bool ReadTokenBalance(const uint160 &contract, const uint160 &holder, int height, uint256 &balance);
+    bool WipeTokenIndex(const CIndexBestBlock &best);
+    /** Build the token index from the stored receipts, for databases created before the index */
+    bool BuildTokenIndex(ChainstateManager &chainman);
+
     bool EraseBlockIndex(const std::vector<uint256>&vect);
 
     // Block explorer database functions
@@ -120,6 +199,14 @@ public:
     bool UpdateAddressUnspentIndex(const std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue > >&vect);
     bool ReadAddressUnspentIndex(uint256 addressHash, int type,
                                 std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > &vect);
+    /**
+     * Apply the unspent output changes of a block to the per address balance and weight aggregates.
+     * The amounts of the outputs below compactHeight are merged into a single value.
+     */
+    bool UpdateAddressWeightIndex(const std::vector<std::pair<CAddressIndexIteratorKey, CAddressWeightDelta> > &vect, int compactHeight);
+    bool ReadAddressWeightIndex(uint256 addressHash, int type, CAddressWeightValue &value);
+    /** Build the weight aggregates from the address unspent index, for databases created before the aggregates */
+    bool BuildAddressWeightIndex(int compactHeight);
     bool WriteTimestampIndex(const CTimestampIndexKey &timestampIndex);
     bool ReadTimestampIndex(const unsigned int &high, const unsigned int &low, const bool fActiveOnly, std::vector<std::pair<uint256, unsigned int> > &vect, ChainstateManager & chainman);
     bool WriteTimestampBlockIndex(const CTimestampBlockIndexKey &blockhashIndex, const CTimestampBlockIndexValue &logicalts);
@@ -842,5 +929,217 @@ struct CAddressIndexIteratorKey {
         hashBytes.SetNull();
     }
 };
+
+struct CAddressWeightDelta {
+    int blockHeight;
+    CAmount satoshis;
+    CAmount received;
+
+    CAddressWeightDelta(int height, CAmount sats, CAmount receivedSats) {
+        blockHeight = height;
+        satoshis = sats;
+        received = receivedSats;
+    }
+};
+
+struct CAddressWeightValue {
+    CAmount balance;
+    CAmount received;
+    // Amount of the unspent outputs below compactHeight
+    CAmount compactedAmount;
+    int compactHeight;
+    // Amount of the unspent outputs per block height, starting from compactHeight
+    std::map<int, CAmount> heightAmounts;
+
+    SERIALIZE_METHODS(CAddressWeightValue, obj) { READWRITE(obj.balance, obj.received, obj.compactedAmount, obj.compactHeight, obj.heightAmounts); }
+
+    CAddressWeightValue() {
+        SetNull();
+    }
+
+    void SetNull() {
+        balance = 0;
+        received = 0;
+        compactedAmount = 0;
+        compactHeight = 0;
+        heightAmounts.clear();
+    }
+
+    bool IsNull() const {
+        return balance == 0 && received == 0 && compactedAmount == 0 && heightAmounts.empty();
+    }
+
+    void Add(const CAddressWeightDelta& delta) {
+        balance += delta.satoshis;
+        received += delta.received;
+        if (delta.blockHeight < compactHeight) {
+            compactedAmount += delta.satoshis;
+            return;
+        }
+        CAmount& heightAmount = heightAmounts[delta.blockHeight];
+        heightAmount += delta.satoshis;
+        if (heightAmount == 0) {
+            heightAmounts.erase(delta.blockHeight);
+        }
+    }
+
+    void Compact(int height) {
+        if (height <= compactHeight) {
+            return;
+        }
+        auto end = heightAmounts.lower_bound(height);
+        for (auto it = heightAmounts.begin(); it != end; it++) {
+            compactedAmount += it->second;
+        }
+        heightAmounts.erase(heightAmounts.begin(), end);
+        compactHeight = height;
+    }
+
+    /** Amount of the unspent outputs up to maxHeight, false when maxHeight is inside the compacted range */
+    bool GetAmount(int maxHeight, CAmount& amount) const {
+        if (maxHeight < compactHeight - 1) {
+            return false;
+        }
+        amount = compactedAmount;
+        for (auto it = heightAmounts.begin(); it != heightAmounts.end() && it->first <= maxHeight; it++) {
+            amount += it->second;
+        }
+        return true;
+    }
+};
+
+/** The block an index of the block tree DB is at, written in the same batch as the changes of the block */
+struct CIndexBestBlock {
+    uint256 blockHash;
+    uint256 stateRoot;
+
+    SERIALIZE_METHODS(CIndexBestBlock, obj) { READWRITE(obj.blockHash, obj.stateRoot); }
+
+    CIndexBestBlock() {
+        SetNull();
+    }
+
+    explicit CIndexBestBlock(const CBlockIndex* pindex) {
+        blockHash = pindex->GetBlockHash();
+        stateRoot = pindex->hashStateRoot;
+    }
+
+    CIndexBestBlock(const uint256& hash, const uint256& root) :
+        blockHash(hash), stateRoot(root)
+    {}
+
+    void SetNull() {
+        blockHash.SetNull();
+        stateRoot.SetNull();
+    }
+
+    bool IsNull() const {
+        return blockHash.IsNull();
+    }
+};
+
+enum TokenTransferType : uint8_t {
+    TOKEN_TRANSFER = 0,
+    TOKEN_BURN = 1,
+};
+
+struct CTokenTransfer {
+    uint8_t type;
+    uint160 contract;
+    uint160 sender;
+    // Null for a burn
+    uint160 receiver;
+    uint256 txhash;
+    uint256 value;
+
+    CTokenTransfer() {
+        SetNull();
+    }
+
+    void SetNull() {
+        type = TOKEN_TRANSFER;
+        contract.SetNull();
+        sender.SetNull();
+        receiver.SetNull();
+        txhash.SetNull();
+        value.SetNull();
+    }
+};
+
+struct CTokenIndexKey {
+    uint160 contract;
+    uint160 holder;
+    int blockHeight;
+    // Position of the transfer among the token transfers of the block
+    unsigned int index;
+
+    template<typename Stream>
+    void Serialize(Stream& s) const {
+        contract.Serialize(s);
+        holder.Serialize(s);
+        // Heights are stored big-endian for key sorting in LevelDB
+        ser_writedata32be(s, blockHeight);
+        ser_writedata32be(s, index);
+    }
+    template<typename Stream>
+    void Unserialize(Stream& s) {
+        contract.Unserialize(s);
+        holder.Unserialize(s);
+        blockHeight = ser_readdata32be(s);
+        index = ser_readdata32be(s);
+    }
+
+    CTokenIndexKey(const uint160& tokenAddress, const uint160& holderAddress, int height, unsigned int indexValue) {
+        contract = tokenAddress;
+        holder = holderAddress;
+        blockHeight = height;
+        index = indexValue;
+    }
+
+    CTokenIndexKey() {
+        SetNull();
+    }
+
+    void SetNull() {
+        contract.SetNull();
+        holder.SetNull();
+        blockHeight = 0;
+        index = 0;
+    }
+};
+
+struct CTokenIndexValue {
+    uint8_t type;
+    uint160 sender;
+    uint160 receiver;
+    uint256 txhash;
+    uint256 value;
+    // Balance of the holder after the transfer, saturating for the tokens that do not log all their mints
+    uint256 balance;
+
+    SERIALIZE_METHODS(CTokenIndexValue, obj) { READWRITE(obj.type, obj.sender, obj.receiver, obj.txhash, obj.value, obj.balance); }
+
+    CTokenIndexValue(const CTokenTransfer& transfer) {
+        type = transfer.type;
+        sender = transfer.sender;
+        receiver = transfer.receiver;
+        txhash = transfer.txhash;
+        value = transfer.value;
+        balance.SetNull();
+    }
+
+    CTokenIndexValue() {
+        SetNull();
+    }
+
+    void SetNull() {
+        type = TOKEN_TRANSFER;
+        sender.SetNull();
+        receiver.SetNull();
+        txhash.SetNull();
+        value.SetNull();
+        balance.SetNull();
+    }
+};
 ////////////////////////////////////////////////////////////
 #endif // BITCOIN_NODE_BLOCKSTORAGE_H
@@ -33,6 +33,8 @@ CacheSizes CalculateCacheSizes(const ArgsManager& args, size_t n_indexes)
     sizes.coins_db = std::min(nTotalCache / 2, (nTotalCache / 4) + (1 << 23)); // use 25%-50% of the remainder for disk cache
     sizes.coins_db = std::min(sizes.coins_db, nMaxCoinsDBCache << 20); // cap total coins db cache
     nTotalCache -= sizes.coins_db;
+    sizes.state_trie = std::min(nTotalCache / 4, nMaxStateTrieCache << 20); // cache of the contract state trie nodes
+    nTotalCache -= sizes.state_trie;
     sizes.coins = nTotalCache; // the rest goes to in-memory cache
     return sizes;
 }
@@ -15,6 +15,7 @@ struct CacheSizes {
     int64_t block_tree_db;
     int64_t coins_db;
     int64_t coins;
+    int64_t state_trie;
     int64_t tx_index;
     int64_t filter_index;
 };
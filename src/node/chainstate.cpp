@@ -11,6 +11,11 @@
 #include <logging.h>
 #include <node/blockstorage.h>
 #include <node/caches.h>
+#include <odan/odandelegation.h>
+#include <odan/stateprune.h>
+#include <odan/statesnapshot.h>
+#include <libethereum/DatabasePaths.h>
+#include <libdevcore/TrieNodeCache.h>
 #include <sync.h>
 #include <threadsafety.h>
 #include <tinyformat.h>
@@ -44,6 +49,7 @@ static ChainstateLoadResult CompleteChainstateInitialization(
     // fails if it's still open from the previous loop. Close it first:
     pblocktree.reset();
     pstorageresult.reset();
+    pvmlogwriter.reset();
     globalState.reset();
     globalSealEngine.reset();
     pblocktree = std::make_unique<BlockTreeDB>(DBParams{
@@ -156,7 +162,35 @@ static ChainstateLoadResult CompleteChainstateInitialization(
     const std::string dirOdan = PathToString(odanStateDir);
     const dev::h256 hashDB(dev::sha3(dev::rlp("")));
     dev::eth::BaseState existsOdanstate = fStatus ? dev::eth::BaseState::PreExisting : dev::eth::BaseState::Empty;
+
+    // States of the last blocks, kept for reorganizations by the state pruning and the compaction
+    const int nStateDepth = std::max(options.prune_state, Params().GetConsensus().MaxCheckpointSpan());
+    std::vector<dev::h256> rootsState, rootsUTXO;
+    int nTipHeight;
+    {
+        LOCK(cs_main);
+        const CChain& active_chain = chainman.ActiveChain();
+        nTipHeight = active_chain.Height();
+        for (int height = std::max(0, nTipHeight - nStateDepth); height <= nTipHeight; height++) {
+            const CBlockIndex* pindex = active_chain[height];
+            if (pindex->hashStateRoot == uint256() || pindex->hashUTXORoot == uint256()) continue;
+            rootsState.push_back(uintToh256(pindex->hashStateRoot));
+            rootsUTXO.push_back(uintToh256(pindex->hashUTXORoot));
+        }
+    }
+    if (options.compact_state && fStatus && !rootsState.empty()) {
+        LogPrintf("Compacting the contract state databases...\n");
+        if (!CompactStateDB(dev::eth::DatabasePaths(dirOdan, hashDB).statePath().string(), true, rootsState) ||
+            !CompactStateDB(dev::eth::DatabasePaths(dirOdan + "/odanDB", hashDB).statePath().string(), false, rootsUTXO)) {
+            return {ChainstateLoadStatus::FAILURE_FATAL, _("Error compacting the contract state databases")};
+        }
+    }
+
+    // The nodes cached from a previous state database may not be in the one opened
+    dev::TrieNodeCache::instance().clear();
     globalState = std::unique_ptr<OdanState>(new OdanState(dev::u256(0), OdanState::openDB(dirOdan, hashDB, dev::WithExisting::Trust), dirOdan, existsOdanstate));
+    globalState->db().setNodeCache(&dev::TrieNodeCache::instance());
+    globalState->dbUtxo().setNodeCache(&dev::TrieNodeCache::instance());
     const CChainParams& chainparams = Params();
     dev::eth::ChainParams cp(chainparams.EVMGenesisInfo());
     globalSealEngine = std::unique_ptr<dev::eth::SealEngineFace>(cp.createSealEngine());
@@ -181,14 +215,56 @@ static ChainstateLoadResult CompleteChainstateInitialization(
         globalState->dbUtxo().commit();
     }
 
+    if (options.prune_state > 0) {
+        // The background chainstate of a UTXO snapshot connects the blocks below the contract state of the snapshot
+        if (chainman.IsSnapshotActive()) {
+            return {ChainstateLoadStatus::FAILURE, _("The contract state cannot be pruned while a UTXO snapshot is validated in the background, restart without -prunestate")};
+        }
+        if (rootsState.empty()) {
+            rootsState.push_back(globalState->rootHash());
+            rootsUTXO.push_back(globalState->rootHashUTXO());
+        }
+        pstatepruner = std::make_unique<OdanStatePruner>(nStateDepth);
+        if (!pstatepruner->Init(*globalState, rootsState, rootsUTXO, nTipHeight)) {
+            return {ChainstateLoadStatus::FAILURE, _("Error building the reference counts of the contract state")};
+        }
+    } else {
+        // The counts are not kept up to date, they are built again when the pruning is enabled
+        pstatepruner.reset();
+        OdanStatePruner::Disable(*globalState);
+    }
+
+    pstatesnapshot.reset();
+    if (options.state_snapshot) {
+        pstatesnapshot = std::make_unique<OdanStateSnapshot>(odanStateDir / "snapshot");
+        if (!pstatesnapshot->Init(*globalState)) {
+            return {ChainstateLoadStatus::FAILURE, _("Error generating the snapshot of the contract state")};
+        }
+    } else if (fs::exists(odanStateDir / "snapshot")) {
+        // The snapshot is not kept up to date, it is generated again when it is enabled
+        LogPrintf("Removing the snapshot of the contract state\n");
+        fs::remove_all(odanStateDir / "snapshot");
+    }
+
     fRecordLogOpcodes = options.record_log_opcodes;
-    fIsVMlogFile = fs::exists(gArgs.GetDataDirNet() / "vmExecLogs.json");
+    if (fRecordLogOpcodes) {
+        pvmlogwriter = std::make_unique<VMLogWriter>(gArgs.GetDataDirNet() / "vmlogs", options.reindex);
+    }
     ///////////////////////////////////////////////////////////
 
     /////////////////////////////////////////////////////////////// // odan
     if (fAddressIndex != options.addrindex) {
         return {ChainstateLoadStatus::FAILURE, _("You need to rebuild the database using -reindex to change -addrindex")};
     }
+    bool fAddressWeightIndex = false;
+    pblocktree->ReadFlag("addrweightindex", fAddressWeightIndex);
+    if (fAddressIndex && !fAddressWeightIndex) {
+        LogPrintf("Building the address weight index...\n");
+        int height = chainman.ActiveChain().Height();
+        if (!pblocktree->BuildAddressWeightIndex(GetAddressWeightCompactHeight(height, chainman.GetConsensus()))) {
+            return {ChainstateLoadStatus::FAILURE, _("Error building the address weight index")};
+        }
+    }
     ///////////////////////////////////////////////////////////////
     // Check for changed -logevents state
     if (fLogEvents != options.logevents && !fLogEvents) {
@@ -201,6 +277,87 @@ static ChainstateLoadResult CompleteChainstateInitialization(
         pblocktree->WipeHeightIndex();
         fLogEvents = false;
         pblocktree->WriteFlag("logevents", fLogEvents);
+        if (fTokenIndex) {
+            pblocktree->WipeTokenIndex(CIndexBestBlock());
+            fTokenIndex = false;
+            pblocktree->WriteFlag("tokenindex", fTokenIndex);
+        }
+    }
+
+    // The delegation and token indexes are rebuilt with the chainstate, databases created before them build them
+    // from the logs. They are written before the coins are flushed, after an unclean shutdown they are rewound to
+    // the coins tip with their undo records, or rebuilt from the logs when they are not at a descendant of the tip.
+    const CBlockIndex* index_tip{chainman.ActiveChain().Tip()};
+    const CIndexBestBlock index_genesis{chainman.GetParams().GenesisBlock().GetHash(), chainman.GetParams().GenesisBlock().hashStateRoot};
+    auto index_descendant_of_tip = [&](const CIndexBestBlock& best) EXCLUSIVE_LOCKS_REQUIRED(::cs_main) -> const CBlockIndex* {
+        const CBlockIndex* pindex_best{chainman.m_blockman.LookupBlockIndex(best.blockHash)};
+        return pindex_best && pindex_best->GetAncestor(index_tip->nHeight) == index_tip ? pindex_best : nullptr;
+    };
+
+    if (options.reindex_chainstate || !index_tip) {
+        if (!pblocktree->WipeDelegationIndex(index_genesis)) {
+            return {ChainstateLoadStatus::FAILURE, _("Error wiping the delegation index")};
+        }
+        fDelegationIndex = true;
+        pblocktree->WriteFlag("delegationindex", fDelegationIndex);
+    } else if (fDelegationIndex) {
+        CIndexBestBlock delegation_best;
+        const CBlockIndex* pindex_best{pblocktree->ReadDelegationIndexBest(delegation_best) ? index_descendant_of_tip(delegation_best) : nullptr};
+        if (!pindex_best) {
+            LogPrintf("The delegation index is not at the chain tip, it is rebuilt\n");
+            if (!pblocktree->WipeDelegationIndex(CIndexBestBlock())) {
+                return {ChainstateLoadStatus::FAILURE, _("Error wiping the delegation index")};
+            }
+            fDelegationIndex = false;
+            pblocktree->WriteFlag("delegationindex", fDelegationIndex);
+        } else if (pindex_best != index_tip) {
+            LogPrintf("Rewinding the delegation index from height %d to %d...\n", pindex_best->nHeight, index_tip->nHeight);
+            if (!pblocktree->RewindDelegationIndex(pindex_best, index_tip)) {
+                return {ChainstateLoadStatus::FAILURE, _("Error rewinding the delegation index")};
+            }
+        }
+    }
+    if (!fDelegationIndex && fLogEvents) {
+        LogPrintf("Building the delegation index...\n");
+        OdanDelegation odanDelegation;
+        if (!odanDelegation.BuildDelegationIndex(chainman)) {
+            return {ChainstateLoadStatus::FAILURE, _("Error building the delegation index")};
+        }
+        fDelegationIndex = true;
+        pblocktree->WriteFlag("delegationindex", fDelegationIndex);
+    }
+
+    // The token index follows the event logs
+    if (fLogEvents && (options.reindex_chainstate || !index_tip)) {
+        if (!pblocktree->WipeTokenIndex(index_genesis)) {
+            return {ChainstateLoadStatus::FAILURE, _("Error wiping the token index")};
+        }
+        fTokenIndex = true;
+        pblocktree->WriteFlag("tokenindex", fTokenIndex);
+    } else if (fTokenIndex) {
+        CIndexBestBlock token_best;
+        const CBlockIndex* pindex_best{pblocktree->ReadTokenIndexBest(token_best) ? index_descendant_of_tip(token_best) : nullptr};
+        if (!pindex_best) {
+            LogPrintf("The token index is not at the chain tip, it is rebuilt\n");
+            if (!pblocktree->WipeTokenIndex(CIndexBestBlock())) {
+                return {ChainstateLoadStatus::FAILURE, _("Error wiping the token index")};
+            }
+            fTokenIndex = false;
+            pblocktree->WriteFlag("tokenindex", fTokenIndex);
+        } else if (pindex_best != index_tip) {
+            LogPrintf("Rewinding the token index from height %d to %d...\n", pindex_best->nHeight, index_tip->nHeight);
+            if (!pblocktree->RewindTokenIndex(pindex_best, index_tip)) {
+                return {ChainstateLoadStatus::FAILURE, _("Error rewinding the token index")};
+            }
+        }
+    }
+    if (!fTokenIndex && fLogEvents) {
+        LogPrintf("Building the token index...\n");
+        if (!pblocktree->BuildTokenIndex(chainman)) {
+            return {ChainstateLoadStatus::FAILURE, _("Error building the token index")};
+        }
+        fTokenIndex = true;
+        pblocktree->WriteFlag("tokenindex", fTokenIndex);
     }
 
     if (!options.reindex) {
@@ -242,6 +399,7 @@ ChainstateLoadResult LoadChainstate(ChainstateManager& chainman, const CacheSize
 
     chainman.m_total_coinstip_cache = cache_sizes.coins;
     chainman.m_total_coinsdb_cache = cache_sizes.coins_db;
+    chainman.m_total_state_trie_cache = cache_sizes.state_trie;
 
     // Load the fully validated chainstate.
     chainman.InitializeChainstate(options.mempool);
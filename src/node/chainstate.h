@@ -37,6 +37,9 @@ struct ChainstateLoadOptions {
     bool record_log_opcodes{false};
     bool addrindex{false};
     bool logevents{false};
+    int prune_state{0};
+    bool compact_state{false};
+    bool state_snapshot{false};
 };
 
 //! Chainstate load status. Simple applications can just check for the success
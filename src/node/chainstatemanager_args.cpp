@@ -53,6 +53,17 @@ util::Result<void> ApplyArgsManOptions(const ArgsManager& args, ChainstateManage
     opts.worker_threads_num = std::clamp(script_threads - 1, 0, MAX_SCRIPTCHECK_THREADS);
     LogPrintf("Script verification uses %d additional threads\n", opts.worker_threads_num);
 
+    int contract_threads = args.GetIntArg("-parcontract", DEFAULT_CONTRACTEXEC_THREADS);
+    if (contract_threads < 0) {
+        // -parcontract=-n means "leave n cores free"
+        contract_threads += GetNumCores();
+    }
+    // Subtract 1 because the main thread counts towards the parcontract threads.
+    opts.contract_exec_threads_num = std::clamp(contract_threads - 1, 0, MAX_CONTRACTEXEC_THREADS);
+    if (opts.contract_exec_threads_num > 0) {
+        LogPrintf("Contract execution uses %d additional threads\n", opts.contract_exec_threads_num);
+    }
+
     return {};
 }
 } // namespace node
@@ -14,6 +14,10 @@ class ArgsManager;
 static constexpr int MAX_SCRIPTCHECK_THREADS{15};
 /** -par default (number of script-checking threads, 0 = auto) */
 static constexpr int DEFAULT_SCRIPTCHECK_THREADS{0};
+/** Maximum number of dedicated contract execution threads allowed */
+static constexpr int MAX_CONTRACTEXEC_THREADS{15};
+/** -parcontract default (number of contract execution threads, 0 = serial execution) */
+static constexpr int DEFAULT_CONTRACTEXEC_THREADS{0};
 
 namespace node {
 [[nodiscard]] util::Result<void> ApplyArgsManOptions(const ArgsManager& args, ChainstateManager::Options& opts);
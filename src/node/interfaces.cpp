@@ -53,7 +53,9 @@
 #include <validationinterface.h>
 #include <warnings.h>
 #include <odan/odandelegation.h>
+#include <pos.h>
 #include <odan/odanDGP.h>
+#include <rpc/contract_util.h>
 
 #if defined(HAVE_CONFIG_H)
 #include <config/bitcoin-config.h>
@@ -428,6 +430,14 @@ public:
     {
         return GetPoSKernelPS(chainman());
     }
+    bool getTokenEvents(int64_t fromBlock, int64_t toBlock, int64_t minconf, const std::string& eventName, const std::string& contractAddress, const std::string& senderAddress, int numTopics, std::vector<TokenEvent>& result) override
+    {
+        return ReadTokenEvents(chainman(), fromBlock, toBlock, minconf, eventName, contractAddress, senderAddress, numTopics, result);
+    }
+    bool isHolderTokenEvent(const std::string& logAddress, const std::vector<std::string>& topics, const std::string& eventName, const std::string& contractAddress, const std::string& senderAddress, int numTopics) override
+    {
+        return IsHolderTokenEvent(logAddress, topics, eventName, contractAddress, senderAddress, numTopics);
+    }
     std::unique_ptr<Handler> handleInitMessage(InitMessageFn fn) override
     {
         return MakeSignalHandler(::uiInterface.InitMessage_connect(fn));
@@ -969,8 +979,11 @@ public:
 #endif
     bool getDelegation(const uint160& address, Delegation& delegation) override
     {
-        OdanDelegation odanDelegation;
-        return odanDelegation.ExistDelegationContract() ? odanDelegation.GetDelegation(address, delegation, chainman().ActiveChainstate()) : false;
+        OdanDelegation& odanDelegation = GetOdanDelegation();
+        const uint256 stateRoot = WITH_LOCK(::cs_main, return h256Touint(globalState->rootHash()));
+        // The delegation index is read without checking the contract under cs_main
+        if (fDelegationIndex) return odanDelegation.GetDelegation(address, delegation, chainman().ActiveChainstate(), stateRoot);
+        return odanDelegation.ExistDelegationContract() ? odanDelegation.GetDelegation(address, delegation, chainman().ActiveChainstate(), stateRoot) : false;
     }
     bool verifyDelegation(const uint160& address, const Delegation& delegation) override
     {
@@ -43,6 +43,16 @@ util::Result<void> ApplyArgsManOptions(const ArgsManager& argsman, const CChainP
 
     if (auto mb = argsman.GetIntArg("-maxmempool")) mempool_opts.max_size_bytes = *mb * 1'000'000;
 
+    if (auto gas = argsman.GetIntArg("-maxmempoolgas")) {
+        if (*gas <= 0) return util::Error{Untranslated("-maxmempoolgas must be positive")};
+        mempool_opts.max_gas = *gas;
+    }
+
+    if (auto gas = argsman.GetIntArg("-maxmempoolsendergas")) {
+        if (*gas <= 0) return util::Error{Untranslated("-maxmempoolsendergas must be positive")};
+        mempool_opts.max_sender_gas = *gas;
+    }
+
     if (auto hours = argsman.GetIntArg("-mempoolexpiry")) mempool_opts.expiry = std::chrono::hours{*hours};
 
     // incremental relay fee sets the minimum feerate increase necessary for replacement in the mempool
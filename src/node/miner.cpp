@@ -25,10 +25,12 @@
 #include <util/moneystr.h>
 #include <util/time.h>
 #include <validation.h>
+#include <validationinterface.h>
 #include <util/threadnames.h>
 #include <key_io.h>
 #include <odan/odanledger.h>
 #include <odan/odandelegation.h>
+#include <odan/contractcall.h>
 #ifdef ENABLE_WALLET
 #include <wallet/wallet.h>
 #include <wallet/receive.h>
@@ -87,6 +89,23 @@ int64_t UpdateTime(CBlockHeader* pblock, const Consensus::Params& consensusParam
     return nNewTime - nOldTime;
 }
 
+int32_t SpeculativeBlockTimeLimit(int64_t nNow, int32_t nTimeLimit)
+{
+    // The contracts stop nBytecodeTimeBuffer before the limit, the other transactions are added quickly
+    return std::min<int64_t>(nTimeLimit, nNow + nBytecodeTimeBuffer + STAKER_SPECULATIVE_BLOCK_TIME);
+}
+
+bool CanUseSpeculativeBlock(const CBlockTemplate& speculative, const CBlockHeader& header, uint32_t blockTime, const CScript& author)
+{
+    // The contracts were executed for this tip and author, the time only matters when a contract read it.
+    // A block stopped by its time limit has fewer transactions than the block built for the kernel.
+    const CBlock& block = speculative.block;
+    if(speculative.fTimeLimitReached || block.vtx.size() < 2 || block.vtx[1]->vout.size() < 2)
+        return false;
+    return block.hashPrevBlock == header.hashPrevBlock && block.nBits == header.nBits && block.vtx[1]->vout[1].scriptPubKey == author &&
+           (!speculative.fBlockContextRead || block.nTime == blockTime);
+}
+
 void RegenerateCommitments(CBlock& block, ChainstateManager& chainman)
 {
     CMutableTransaction tx{*block.vtx.at(0)};
@@ -171,7 +190,7 @@ void BlockAssembler::RebuildRefundTransaction(CBlock* pblock){
     pblock->vtx[refundtx] = MakeTransactionRef(std::move(contrTx));
 }
 
-std::unique_ptr<CBlockTemplate> BlockAssembler::CreateNewBlock(const CScript& scriptPubKeyIn, bool fProofOfStake, int64_t* pTotalFees, int32_t txProofTime, int32_t nTimeLimit)
+std::unique_ptr<CBlockTemplate> BlockAssembler::CreateNewBlock(const CScript& scriptPubKeyIn, bool fProofOfStake, int64_t* pTotalFees, int32_t txProofTime, int32_t nTimeLimit, bool fSnapshot)
 {
     const auto time_start{SteadyClock::now()};
 
@@ -198,10 +217,11 @@ std::unique_ptr<CBlockTemplate> BlockAssembler::CreateNewBlock(const CScript& sc
     if(pwallet && pwallet->IsStakeClosing())
         return nullptr;
 #endif
-    LOCK(::cs_main);
+    WAIT_LOCK(::cs_main, lock);
     CBlockIndex* pindexPrev = m_chainstate.m_chain.Tip();
     assert(pindexPrev != nullptr);
     nHeight = pindexPrev->nHeight + 1;
+    m_pindexPrev = pindexPrev;
 
     pblock->nVersion = m_chainstate.m_chainman.m_versionbitscache.ComputeBlockVersion(pindexPrev, chainparams.GetConsensus());
     // -regtest only: allow overriding block.nVersion with
@@ -277,24 +297,40 @@ std::unique_ptr<CBlockTemplate> BlockAssembler::CreateNewBlock(const CScript& sc
     txGasLimit = gArgs.GetIntArg("-staker-max-tx-gas-limit", softBlockGasLimit);
 
     m_options.nBlockMaxWeight = blockSizeDGP ? blockSizeDGP * WITNESS_SCALE_FACTOR : m_options.nBlockMaxWeight;
+
+    if(fSnapshot){
+        // The contracts are executed on a copy of the tip state, so the validation is not blocked meanwhile
+        m_snapshotState = std::make_unique<OdanState>(*globalState);
+        m_snapshotSealEngine.reset(dev::eth::SealEngineRegistrar::create(globalSealEngine->chainParams()));
+        m_snapshotSealEngine->setOdanSchedule(globalSealEngine->getOdanSchedule());
+        m_state = m_snapshotState.get();
+    }else{
+        m_state = globalState.get();
+    }
     
-    dev::h256 oldHashStateRoot(globalState->rootHash());
-    dev::h256 oldHashUTXORoot(globalState->rootHashUTXO());
+    dev::h256 oldHashStateRoot(m_state->rootHash());
+    dev::h256 oldHashUTXORoot(m_state->rootHashUTXO());
     ////////////////////////////////////////////////// deploy offline staking contract
     if(nHeight == chainparams.GetConsensus().nOfflineStakeHeight){
-        globalState->deployDelegationsContract();
+        m_state->deployDelegationsContract();
     }
     /////////////////////////////////////////////////
     int nPackagesSelected = 0;
     int nDescendantsUpdated = 0;
     if (m_mempool) {
-        LOCK(m_mempool->cs);
-        addPackageTxs(*m_mempool, nPackagesSelected, nDescendantsUpdated, minGasPrice, pblock);
+        if (fSnapshot) {
+            REVERSE_LOCK(lock);
+            LOCK(m_mempool->cs);
+            addPackageTxs(*m_mempool, nPackagesSelected, nDescendantsUpdated, minGasPrice, pblock);
+        } else {
+            LOCK(m_mempool->cs);
+            addPackageTxs(*m_mempool, nPackagesSelected, nDescendantsUpdated, minGasPrice, pblock);
+        }
     }
-    pblock->hashStateRoot = uint256(h256Touint(dev::h256(globalState->rootHash())));
-    pblock->hashUTXORoot = uint256(h256Touint(dev::h256(globalState->rootHashUTXO())));
-    globalState->setRoot(oldHashStateRoot);
-    globalState->setRootUTXO(oldHashUTXORoot);
+    pblock->hashStateRoot = uint256(h256Touint(dev::h256(m_state->rootHash())));
+    pblock->hashUTXORoot = uint256(h256Touint(dev::h256(m_state->rootHashUTXO())));
+    m_state->setRoot(oldHashStateRoot);
+    m_state->setRootUTXO(oldHashUTXORoot);
 
     //this should already be populated by AddBlock in case of contracts, but if no contracts
     //then it won't get populated
@@ -474,8 +510,30 @@ bool BlockAssembler::TestPackageTransactions(const CTxMemPool::setEntries& packa
     return true;
 }
 
+// Whether the tx depends on a mempool tx that creates or calls a contract
+static bool HasContractAncestor(const CTxMemPoolEntry& entry)
+{
+    if(entry.GetCountWithAncestors() <= 1)
+        return false;
+    std::set<const CTxMemPoolEntry*> visited;
+    std::vector<const CTxMemPoolEntry*> stack{&entry};
+    while(!stack.empty()){
+        const CTxMemPoolEntry* current = stack.back();
+        stack.pop_back();
+        for(const CTxMemPoolEntry& parent : current->GetMemPoolParentsConst()){
+            if(!visited.insert(&parent).second)
+                continue;
+            if(parent.GetTx().HasCreateOrCall())
+                return true;
+            stack.push_back(&parent);
+        }
+    }
+    return false;
+}
+
 bool BlockAssembler::AttemptToAddContractToBlock(CTxMemPool::txiter iter, uint64_t minGasPrice, CBlock* pblock) {
     if (nTimeLimit != 0 && GetAdjustedTimeSeconds() >= nTimeLimit - nBytecodeTimeBuffer) {
+        pblocktemplate->fTimeLimitReached = true;
         return false;
     }
     if (gArgs.GetBoolArg("-disablecontractstaking", false))
@@ -484,14 +542,20 @@ bool BlockAssembler::AttemptToAddContractToBlock(CTxMemPool::txiter iter, uint64
         return false;
     }
     
-    dev::h256 oldHashStateRoot(globalState->rootHash());
-    dev::h256 oldHashUTXORoot(globalState->rootHashUTXO());
+    dev::h256 oldHashStateRoot(m_state->rootHash());
+    dev::h256 oldHashUTXORoot(m_state->rootHashUTXO());
     // operate on local vars first, then later apply to `this`
     uint64_t nBlockWeight = this->nBlockWeight;
     uint64_t nBlockSigOpsCost = this->nBlockSigOpsCost;
 
     unsigned int contractflags = GetContractScriptFlags(nHeight, chainparams.GetConsensus());
-    OdanTxConverter convert(iter->GetTx(), m_chainstate, m_mempool, NULL, &pblock->vtx, contractflags);
+    // The sender was resolved when the tx entered the mempool
+    const std::optional<valtype>& contractSender = iter->GetContractSender();
+    if(m_snapshotState && !contractSender){
+        // The coins of the sender can not be read without cs_main
+        return false;
+    }
+    OdanTxConverter convert(iter->GetTx(), m_chainstate, m_mempool, NULL, NULL, contractflags, contractSender ? &*contractSender : NULL);
 
     ExtractOdanTX resultConverter;
     if(!convert.extractionOdanTransactions(resultConverter)){
@@ -501,6 +565,16 @@ bool BlockAssembler::AttemptToAddContractToBlock(CTxMemPool::txiter iter, uint64
         return false;
     }
     std::vector<OdanTransaction> odanTransactions = resultConverter.first;
+
+    // The mempool simulation ran the tx alone on the tip state, so it tells the gas the tx uses and whether it fails
+    // only when no contract ancestor ran before it and the earlier txs of the block left the keys it accessed unchanged
+    std::shared_ptr<const ContractSimulation> simulation = iter->GetContractSimulation();
+    if(simulation && (simulation->snapshot->GetTip() != m_pindexPrev || simulation->blockContextRead ||
+            HasContractAncestor(*iter) || !simulation->snapshot->UnchangedInState(*m_state, simulation->keys)))
+        simulation.reset();
+    if(simulation && simulation->failed)
+        return false;
+
     dev::u256 txGas = 0;
     for(OdanTransaction odanTransaction : odanTransactions){
         txGas += odanTransaction.gas();
@@ -510,7 +584,7 @@ bool BlockAssembler::AttemptToAddContractToBlock(CTxMemPool::txiter iter, uint64
             return false;
         }
 
-        if(bceResult.usedGas + odanTransaction.gas() > softBlockGasLimit){
+        if(!simulation && bceResult.usedGas + odanTransaction.gas() > softBlockGasLimit){
             // If this transaction's gasLimit could cause block gas limit to be exceeded, then don't add it
             // Log if the contract is the only contract tx
             if(bceResult.usedGas == 0)
@@ -523,28 +597,34 @@ bool BlockAssembler::AttemptToAddContractToBlock(CTxMemPool::txiter iter, uint64
             return false;
         }
     }
+    if(simulation && bceResult.usedGas + simulation->gasUsed > softBlockGasLimit){
+        // Packed by the gas used on the tip state, the limit is checked again after the execution
+        return false;
+    }
     // We need to pass the DGP's block gas limit (not the soft limit) since it is consensus critical.
-    ByteCodeExec exec(*pblock, odanTransactions, hardBlockGasLimit, m_chainstate.m_chain.Tip(), m_chainstate.m_chain);
+    ByteCodeExec exec(*pblock, odanTransactions, hardBlockGasLimit, m_pindexPrev, m_chainstate.m_chain);
+    if(m_snapshotState)
+        exec.setPrivateState(m_state, m_snapshotSealEngine.get());
     if(!exec.performByteCode()){
         //error, don't add contract
-        globalState->setRoot(oldHashStateRoot);
-        globalState->setRootUTXO(oldHashUTXORoot);
+        m_state->setRoot(oldHashStateRoot);
+        m_state->setRootUTXO(oldHashUTXORoot);
         LogPrintf("AttemptToAddContractToBlock(): Perform byte code fails for the contract tx %s\n", iter->GetTx().GetHash().ToString());
         return false;
     }
 
     ByteCodeExecResult testExecResult;
     if(!exec.processingResults(testExecResult)){
-        globalState->setRoot(oldHashStateRoot);
-        globalState->setRootUTXO(oldHashUTXORoot);
+        m_state->setRoot(oldHashStateRoot);
+        m_state->setRootUTXO(oldHashUTXORoot);
         LogPrintf("AttemptToAddContractToBlock(): Processing results fails for the contract tx %s\n", iter->GetTx().GetHash().ToString());
         return false;
     }
 
     if(bceResult.usedGas + testExecResult.usedGas > softBlockGasLimit){
         // If this transaction could cause block gas limit to be exceeded, then don't add it
-        globalState->setRoot(oldHashStateRoot);
-        globalState->setRootUTXO(oldHashUTXORoot);
+        m_state->setRoot(oldHashStateRoot);
+        m_state->setRootUTXO(oldHashUTXORoot);
         // Log if the contract is the only contract tx
         if(bceResult.usedGas == 0)
             LogPrintf("AttemptToAddContractToBlock(): The gas used is bigger than -staker-soft-block-gas-limit for the contract tx %s\n", iter->GetTx().GetHash().ToString());
@@ -583,8 +663,8 @@ bool BlockAssembler::AttemptToAddContractToBlock(CTxMemPool::txiter iter, uint64
     if (nBlockSigOpsCost * WITNESS_SCALE_FACTOR > (uint64_t)dgpMaxBlockSigOps ||
             nBlockWeight > dgpMaxBlockWeight) {
         //contract will not be added to block, so revert state to before we tried
-        globalState->setRoot(oldHashStateRoot);
-        globalState->setRootUTXO(oldHashUTXORoot);
+        m_state->setRoot(oldHashStateRoot);
+        m_state->setRootUTXO(oldHashUTXORoot);
         return false;
     }
 
@@ -595,6 +675,7 @@ bool BlockAssembler::AttemptToAddContractToBlock(CTxMemPool::txiter iter, uint64
     bceResult.refundSender += testExecResult.refundSender;
     bceResult.refundOutputs.insert(bceResult.refundOutputs.end(), testExecResult.refundOutputs.begin(), testExecResult.refundOutputs.end());
     bceResult.valueTransfers = std::move(testExecResult.valueTransfers);
+    pblocktemplate->fBlockContextRead |= exec.readBlockContext();
 
     pblock->vtx.emplace_back(iter->GetSharedTx());
     pblocktemplate->vTxFees.push_back(iter->GetFee());
@@ -713,6 +794,7 @@ void BlockAssembler::addPackageTxs(const CTxMemPool& mempool, int& nPackagesSele
     while (mi != mempool.mapTx.get<ancestor_score_or_gas_price>().end() || !mapModifiedTx.empty()) {
         if(nTimeLimit != 0 && GetAdjustedTimeSeconds() >= nTimeLimit){
             //no more time to add transactions, just exit
+            pblocktemplate->fTimeLimitReached = true;
             return;
         }
         // First try to find a new transaction in mapTx to evaluate.
@@ -826,6 +908,7 @@ void BlockAssembler::addPackageTxs(const CTxMemPool& mempool, int& nPackagesSele
             if(!wasAdded || (nTimeLimit != 0 && GetAdjustedTimeSeconds() >= nTimeLimit))
             {
                 //if out of time, or earlier ancestor failed, then skip the rest of the transactions
+                if(wasAdded) pblocktemplate->fTimeLimitReached = true;
                 mapModifiedTx.erase(sortedEntries[i]);
                 wasAdded=false;
                 continue;
@@ -884,9 +967,99 @@ bool CanStake()
 // Looking for suitable coins for creating new block.
 //
 
+/**
+ * Delegation events of the connected and disconnected blocks, queued for the staker thread.
+ * The events are only queued after Start(), so they can be applied over a delegation map loaded
+ * from the delegation index after that. The events already in the index are replayed with the
+ * same result, since every event sets or removes the delegation of a delegate.
+ */
+class DelegationEventsQueue : public CValidationInterface
+{
+public:
+    void DelegationEvents(const std::vector<DelegationEvent>& events, int nHeight) override
+    {
+        LOCK(cs);
+        if(!fStarted)
+            return;
+        queue.insert(queue.end(), events.begin(), events.end());
+        height = nHeight;
+    }
+
+    void Start()
+    {
+        LOCK(cs);
+        fStarted = true;
+        queue.clear();
+    }
+
+    /** Take the queued events, nHeight is the height of the last block they come from */
+    std::vector<DelegationEvent> Take(int& nHeight)
+    {
+        LOCK(cs);
+        std::vector<DelegationEvent> events;
+        events.swap(queue);
+        nHeight = height;
+        return events;
+    }
+
+private:
+    Mutex cs;
+    bool fStarted GUARDED_BY(cs){false};
+    std::vector<DelegationEvent> queue GUARDED_BY(cs);
+    int height GUARDED_BY(cs){0};
+};
+
 class DelegationFilterBase : public IDelegationFilter
 {
 public:
+    DelegationFilterBase():
+        eventsQueue(std::make_shared<DelegationEventsQueue>())
+    {
+        RegisterSharedValidationInterface(eventsQueue);
+    }
+
+    virtual ~DelegationFilterBase()
+    {
+        UnregisterSharedValidationInterface(eventsQueue);
+    }
+
+    /**
+     * Update the delegations that match the filter from the delegation index.
+     * The first call loads the complete index, the next ones only apply the new delegation events to it.
+     * The filter is applied when the delegations are taken, so changes in the wallet keys
+     * or the super stakers also apply to the delegations that already exist.
+     */
+    void UpdateFromIndex(ChainstateManager& chainman, std::map<uint160, Delegation>& delegations, int32_t& height)
+    {
+        if(!fIndexLoaded)
+        {
+            // The index is written when a block is connected, start the events at the same block
+            LOCK(cs_main);
+            eventsQueue->Start();
+            indexDelegations.clear();
+            chainman.m_blockman.m_block_tree_db->ReadDelegationIndex(indexDelegations);
+            indexHeight = chainman.ActiveChain().Height();
+            fIndexLoaded = true;
+        }
+
+        int eventsHeight = 0;
+        OdanDelegation::UpdateDelegationsFromEvents(eventsQueue->Take(eventsHeight), indexDelegations);
+        if(eventsHeight > 0)
+            indexHeight = eventsHeight;
+
+        delegations.clear();
+        for(const auto& [address, delegation] : indexDelegations)
+        {
+            DelegationEvent event;
+            static_cast<Delegation&>(event.item) = delegation;
+            event.item.delegate = address;
+            event.type = DelegationType::DELEGATION_ADD;
+            if(Match(event))
+                delegations[address] = delegation;
+        }
+        height = indexHeight;
+    }
+
     bool GetKey(const std::string& strAddress, uint160& keyId)
     {
         CTxDestination destination = DecodeDestination(strAddress);
@@ -902,6 +1075,12 @@ public:
 
         return true;
     }
+
+private:
+    std::shared_ptr<DelegationEventsQueue> eventsQueue;
+    std::map<uint160, Delegation> indexDelegations;
+    int32_t indexHeight = 0;
+    bool fIndexLoaded = false;
 };
 
 class DelegationsStaker : public DelegationFilterBase
@@ -1004,6 +1183,14 @@ public:
             pwallet->fUpdatedSuperStaker = false;
         }
 
+        if(fDelegationIndex)
+        {
+            // Keep the delegations for the staker from the delegation events, without searching the logs
+            UpdateFromIndex(pwallet->chain().chainman(), cacheDelegationsStaker, cacheHeight);
+            pwallet->updateDelegationsStaker(cacheDelegationsStaker);
+            return;
+        }
+
         std::map<uint160, Delegation> delegations_staker;
         int checkpointSpan = Params().GetConsensus().CheckpointSpan(nHeight);
         if(nHeight <= checkpointSpan)
@@ -1064,7 +1251,13 @@ public:
 
     void Update(int32_t nHeight)
     {
-        if(fLogEvents)
+        if(fDelegationIndex)
+        {
+            // Keep the complete list of my delegations from the delegation events
+            UpdateFromIndex(pwallet->chain().chainman(), cacheMyDelegations, cacheHeight);
+            pwallet->m_my_delegations = cacheMyDelegations;
+        }
+        else if(fLogEvents)
         {
             // When log events are enabled, search the log events to get complete list of my delegations
             int checkpointSpan = Params().GetConsensus().CheckpointSpan(nHeight);
@@ -1121,11 +1314,12 @@ public:
                 }
 
                 // Search my delegations in the addresses
+                const uint256 stateRoot = WITH_LOCK(cs_main, return h256Touint(globalState->rootHash()));
                 for(auto item: mapAddress)
                 {
                     Delegation delegation;
                     uint160 address = item.first;
-                    if(odanDelegations.GetDelegation(address, delegation, pwallet->chain().chainman().ActiveChainstate()) && OdanDelegation::VerifyDelegation(address, delegation))
+                    if(odanDelegations.GetDelegation(address, delegation, pwallet->chain().chainman().ActiveChainstate(), stateRoot) && OdanDelegation::VerifyDelegation(address, delegation))
                     {
                         cacheMyDelegations[address] = delegation;
                     }
@@ -1444,10 +1638,10 @@ public:
     bool fDelegationsContract = false;
     bool fEmergencyStaking = false;
     bool fAggressiveStaking = false;
+    bool fSpeculativeStaking = false;
     bool fError = false;
     int numThreads = 1;
-    boost::thread_group threads;
-    mutable RecursiveMutex cs_worker;
+    std::unique_ptr<CCheckQueue<CStakeKernelCheck>> kernelQueue;
     bool privateKeysDisabled = false;;
 
 public:
@@ -1471,6 +1665,8 @@ public:
     std::multimap<uint256, SolveItem> mapSolvedBlock;
     std::map<uint32_t, std::vector<COutPoint>> mapSolveSelectedCoins;
     std::map<uint32_t, std::vector<COutPoint>> mapSolveDelegateCoins;
+    std::unique_ptr<StakeKernelBatch> kernelBatch;
+    std::vector<bool> kernelDelegate;
     uint32_t beginningTime = 0;
     uint32_t endingTime = 0;
     uint32_t waitBestHeaderAttempts = 0;
@@ -1480,6 +1676,15 @@ public:
     std::shared_ptr<CBlock> pblockfilled;
     std::unique_ptr<CBlockTemplate> pblocktemplatefilled;
 
+    // Block with the mempool transactions built while waiting for a kernel
+    std::unique_ptr<CBlockTemplate> pblocktemplatespeculative;
+    int64_t nSpeculativeFees = 0;
+    unsigned int nSpeculativeMempoolUpdated = 0;
+    SteadyClock::time_point speculativeBuildTime;
+    bool fSpeculativeTimeLimitReached = false;
+    // The author of the last block found, the contracts of the speculative block are executed for it
+    CScript lastAuthor;
+
 public:
     StakeMinerPriv(wallet::CWallet *_pwallet):
         pwallet(_pwallet),
@@ -1503,12 +1708,18 @@ public:
         fDelegationsContract = !consensusParams.delegationsAddress.IsNull();
         fEmergencyStaking = gArgs.GetBoolArg("-emergencystaking", false);
         fAggressiveStaking = gArgs.IsArgSet("-aggressive-staking");
+        fSpeculativeStaking = gArgs.GetBoolArg("-speculativestaking", node::DEFAULT_SPECULATIVE_STAKE);
         int maxWaitForBestHeader = gArgs.GetIntArg("-maxstakerwaitforbestheader", node::DEFAULT_MAX_STAKER_WAIT_FOR_BEST_BLOCK_HEADER);
         if(maxWaitForBestHeader > 0)
         {
             waitBestHeaderAttempts = maxWaitForBestHeader / nMinerWaitBestBlockHeader;
         }
         if(pwallet) numThreads = pwallet->m_num_threads;
+        if(numThreads > 1)
+        {
+            // The staker thread joins the workers when searching for a kernel
+            kernelQueue = std::make_unique<CCheckQueue<CStakeKernelCheck>>(1, numThreads - 1, "stakech");
+        }
         if(pwallet) privateKeysDisabled = pwallet->IsWalletFlagSet(wallet::WALLET_FLAG_DISABLE_PRIVATE_KEYS);
     }
 
@@ -1530,6 +1741,8 @@ public:
         mapSolvedBlock.clear();
         mapSolveSelectedCoins.clear();
         mapSolveDelegateCoins.clear();
+        kernelBatch.reset();
+        kernelDelegate.clear();
         beginningTime = 0;
         endingTime = 0;
 
@@ -1537,6 +1750,9 @@ public:
         pblocktemplate.reset();
         pblockfilled.reset();
         pblocktemplatefilled.reset();
+        pblocktemplatespeculative.reset();
+        nSpeculativeFees = 0;
+        fSpeculativeTimeLimitReached = false;
     }
 };
 
@@ -1557,7 +1773,12 @@ public:
 
         while (Next()) {
             // Is ready for mining
-            if(!IsReady()) continue;
+            if(!IsReady())
+            {
+                // Keep the speculative block up to date while waiting for the next lookahead window
+                UpdateSpeculativeBlock();
+                continue;
+            }
 
             // Cache mining data
             if(!CacheData()) continue;
@@ -1828,50 +2049,61 @@ protected:
         if(searchInterval > 0) d->pwallet->m_last_coin_stake_search_interval = searchInterval;
     }
 
-    void SloveBlock(uint32_t blockTime, size_t delegateSize, size_t from, size_t to)
+    void SloveBlock(const uint32_t& blockTime)
     {
-        std::multimap<uint256, SolveItem> tmpSolvedBlock;
-        for(size_t i = from; i < to; i++)
+        // Prepare the kernels of the prevouts once per block template
+        if(!d->kernelBatch || !d->kernelBatch->IsFor(d->pindexPrev, d->pblock->nBits))
         {
-            const COutPoint &prevoutStake = d->prevouts[i];
-            uint256 hashProofOfStake;
-            if (CheckKernelCache(d->pindexPrev, d->pblock->nBits, blockTime, prevoutStake, d->pwallet->minerStakeCache, hashProofOfStake))
+            size_t delegateSize = d->setDelegateCoins.size();
+            d->kernelBatch = std::make_unique<StakeKernelBatch>(d->pindexPrev, d->pblock->nBits);
+            d->kernelDelegate.clear();
+            for(size_t i = 0; i < d->prevouts.size(); i++)
             {
-                bool delegate = i < delegateSize;
-                tmpSolvedBlock.insert(std::make_pair(hashProofOfStake, SolveItem(prevoutStake, blockTime, delegate)));
+                if(d->kernelBatch->Add(d->prevouts[i], d->pwallet->minerStakeCache))
+                    d->kernelDelegate.push_back(i < delegateSize);
             }
         }
 
-        if(tmpSolvedBlock.size() > 0)
-        {
-            LOCK(d->cs_worker);
-            d->mapSolveBlockTime[blockTime] = true;
-            d->mapSolvedBlock.insert(tmpSolvedBlock.begin(), tmpSolvedBlock.end());
-        }
-    }
-
-    void SloveBlock(const uint32_t& blockTime)
-    {
-        // Init variables
-        size_t listSize = d->prevouts.size();
-        size_t delegateSize = d->setDelegateCoins.size();
-
         // Solve block
-        int numThreads = std::min(d->numThreads, (int)listSize);
-        if(listSize < 1000 || numThreads < 2)
+        size_t listSize = d->kernelBatch->Size();
+        std::vector<std::pair<size_t, uint256>> solved;
+        if(listSize < 1000 || !d->kernelQueue)
         {
-            SloveBlock(blockTime, delegateSize, 0, listSize);
+            d->kernelBatch->Check(0, listSize, blockTime, solved);
         }
         else
         {
-            size_t chunk = listSize / numThreads;
-            for(int i = 0; i < numThreads; i++)
+            // Use more chunks than threads so the workers finish at about the same time
+            size_t numChunks = d->numThreads * 4;
+            size_t chunk = listSize / numChunks;
+            std::vector<std::vector<std::pair<size_t, uint256>>> chunkSolved(numChunks);
+            std::vector<CStakeKernelCheck> vChecks;
+            vChecks.reserve(numChunks);
+            for(size_t i = 0; i < numChunks; i++)
             {
                 size_t from = i * chunk;
-                size_t to = i == (numThreads -1) ? listSize : from + chunk;
-                d->threads.create_thread([this, blockTime, delegateSize, from, to]{SloveBlock(blockTime, delegateSize, from, to);});
+                size_t to = i == (numChunks -1) ? listSize : from + chunk;
+                vChecks.emplace_back(*d->kernelBatch, from, to, blockTime, chunkSolved[i]);
+            }
+            CCheckQueueControl<CStakeKernelCheck> control(d->kernelQueue.get());
+            control.Add(std::move(vChecks));
+            control.Wait();
+            for(const auto& items : chunkSolved)
+            {
+                solved.insert(solved.end(), items.begin(), items.end());
+            }
+        }
+
+        for(const std::pair<size_t, uint256>& item : solved)
+        {
+            // Solutions are rare, confirm them with the reference kernel check
+            const COutPoint& prevoutStake = d->kernelBatch->GetPrevout(item.first);
+            uint256 hashProofOfStake;
+            if (CheckKernelCache(d->pindexPrev, d->pblock->nBits, blockTime, prevoutStake, d->pwallet->minerStakeCache, hashProofOfStake))
+            {
+                d->mapSolveBlockTime[blockTime] = true;
+                d->mapSolvedBlock.insert(std::make_pair(hashProofOfStake, SolveItem(prevoutStake, blockTime, d->kernelDelegate[item.first])));
             }
-            d->threads.join_all();
         }
 
         // Populate the list with the potential solwed blocks
@@ -1916,6 +2148,12 @@ protected:
         if (!SignBlock(d->pblock, *(d->pwallet), d->nTotalFees, blockTime, d->setCoins, d->mapSolveSelectedCoins[blockTime], d->mapSolveDelegateCoins[blockTime], true, true))
             return false;
 
+        // Use the speculative block when its contracts are valid for this block
+        const CScript& author = d->pblock->vtx[1]->vout[1].scriptPubKey;
+        d->lastAuthor = author;
+        if (UseSpeculativeBlock(blockTime, author))
+            return true;
+
         // Create a block that's properly populated with transactions
         d->pblocktemplatefilled = std::unique_ptr<CBlockTemplate>(
                 BlockAssembler(d->pwallet->chain().chainman().ActiveChainstate(), &(d->pwallet->chain().mempool()), d->pwallet).CreateNewBlock(d->pblock->vtx[1]->vout[1].scriptPubKey, true, &(d->nTotalFees),
@@ -1937,6 +2175,60 @@ protected:
         return true;
     }
 
+    void UpdateSpeculativeBlock()
+    {
+        // IsReady() also fails when the staker is interrupted, stop straight away then
+        if(!Next())
+            return;
+
+        if(!d->fSpeculativeStaking || d->fSpeculativeTimeLimitReached || d->lastAuthor.empty() || !HaveCoinsForStake() || IsCachedDataOld())
+            return;
+
+        // Rebuild the block when the mempool changed, but not more often than the period
+        unsigned int nMempoolUpdated = d->pwallet->chain().mempool().GetTransactionsUpdated();
+        if(d->pblocktemplatespeculative && (nMempoolUpdated == d->nSpeculativeMempoolUpdated ||
+                                            SteadyClock::now() < d->speculativeBuildTime + std::chrono::milliseconds{STAKER_SPECULATIVE_BLOCK_PERIOD}))
+            return;
+
+        // Execute the contracts for the next timeslot on a snapshot of the tip state, without holding cs_main,
+        // and only for a small part of the time limit for a found kernel
+        int64_t nNow = GetAdjustedTimeSeconds();
+        uint32_t blockTime = (nNow & ~d->stakeTimestampMask) + d->stakeTimestampMask + 1;
+        int64_t nTotalFees = 0;
+        std::unique_ptr<CBlockTemplate> pblocktemplate = BlockAssembler(d->pwallet->chain().chainman().ActiveChainstate(), &(d->pwallet->chain().mempool()), d->pwallet).CreateNewBlock(d->lastAuthor, true, &nTotalFees,
+                                                        blockTime, SpeculativeBlockTimeLimit(nNow, FutureDrift(nNow, d->nHeight, d->consensusParams) - nStakeTimeBuffer), /*fSnapshot=*/true);
+        d->nSpeculativeMempoolUpdated = nMempoolUpdated;
+        d->speculativeBuildTime = SteadyClock::now();
+        if(!pblocktemplate || pblocktemplate->block.hashPrevBlock != d->pblock->hashPrevBlock)
+            return;
+
+        // The mempool does not fit in the time of the speculative block, the block is built for the kernel
+        if(pblocktemplate->fTimeLimitReached)
+        {
+            LogPrint(BCLog::COINSTAKE, "ThreadStakeMiner(): Stop the speculative blocks until the next tip, the time limit was reached\n");
+            d->fSpeculativeTimeLimitReached = true;
+            d->pblocktemplatespeculative.reset();
+            return;
+        }
+
+        d->pblocktemplatespeculative = std::move(pblocktemplate);
+        d->nSpeculativeFees = nTotalFees;
+    }
+
+    bool UseSpeculativeBlock(const uint32_t& blockTime, const CScript& author)
+    {
+        if(!d->pblocktemplatespeculative || !CanUseSpeculativeBlock(*d->pblocktemplatespeculative, *d->pblock, blockTime, author))
+            return false;
+
+        // Only the coinstake is replaced when signing the block, the refund outputs are kept
+        d->pblocktemplatefilled = std::move(d->pblocktemplatespeculative);
+        d->nTotalFees = d->nSpeculativeFees;
+        d->pblockfilled = std::make_shared<CBlock>(d->pblocktemplatefilled->block);
+        LogPrint(BCLog::COINSTAKE, "ThreadStakeMiner(): Use the speculative block with %u txs\n", d->pblockfilled->vtx.size());
+
+        return true;
+    }
+
     bool SignNewBlock(const uint32_t& blockTime)
     {
         // Try to sign the block once at specific time with the same cached data
@@ -72,6 +72,15 @@ static const int32_t STAKER_WAIT_FOR_BEST_BLOCK_HEADER = 250;
 //How much max time to wait for best block header to be downloaded to the blockchain
 static const int32_t DEFAULT_MAX_STAKER_WAIT_FOR_BEST_BLOCK_HEADER = 4000;
 
+//Keep a block with the mempool transactions ready while waiting for a kernel
+static const bool DEFAULT_SPECULATIVE_STAKE = true;
+
+//How often at most to rebuild the speculative block when the mempool changes in milliseconds
+static const int32_t STAKER_SPECULATIVE_BLOCK_PERIOD = 2000;
+
+//How many seconds at most the speculative block executes contracts, it holds cs_main like a found kernel
+static const int32_t STAKER_SPECULATIVE_BLOCK_TIME = 1;
+
 //How much time to spend trying to process transactions when using the generate RPC call
 static const int32_t POW_MINER_MAX_TIME = 60;
 
@@ -81,6 +90,10 @@ struct CBlockTemplate
     std::vector<CAmount> vTxFees;
     std::vector<int64_t> vTxSigOpsCost;
     std::vector<unsigned char> vchCoinbaseCommitment;
+    // A contract of the block read its time or author, so they cannot be changed without executing it again
+    bool fBlockContextRead{false};
+    // The time limit stopped adding the mempool transactions before the block was full
+    bool fTimeLimitReached{false};
 };
 
 // Container for tracking updates to ancestor feerate as we include (parent)
@@ -286,8 +299,9 @@ public:
     //When GetAdjustedTime() exceeds this, no more transactions will attempt to be added
     int32_t nTimeLimit;
 
-    /** Construct a new block template with coinbase to scriptPubKeyIn */
-    std::unique_ptr<CBlockTemplate> CreateNewBlock(const CScript& scriptPubKeyIn, bool fProofOfStake=false, int64_t* pTotalFees = 0, int32_t nTime=0, int32_t nTimeLimit=0);
+    /** Construct a new block template with coinbase to scriptPubKeyIn, with fSnapshot the mempool transactions
+      * are added without cs_main on a private copy of globalState taken at the tip */
+    std::unique_ptr<CBlockTemplate> CreateNewBlock(const CScript& scriptPubKeyIn, bool fProofOfStake=false, int64_t* pTotalFees = 0, int32_t nTime=0, int32_t nTimeLimit=0, bool fSnapshot=false);
     std::unique_ptr<CBlockTemplate> CreateEmptyBlock(const CScript& scriptPubKeyIn, bool fProofOfStake=false, int64_t* pTotalFees = 0, int32_t nTime=0);
 
     inline static std::optional<int64_t> m_last_block_num_txs{};
@@ -296,6 +310,14 @@ public:
 private:
     const Options m_options;
 
+    // odan
+    // The block is built on top of pindexPrev and its contracts are executed on m_state,
+    // either globalState or m_snapshotState with its own seal engine
+    CBlockIndex* m_pindexPrev{nullptr};
+    OdanState* m_state{nullptr};
+    std::unique_ptr<OdanState> m_snapshotState;
+    std::unique_ptr<dev::eth::SealEngineFace> m_snapshotSealEngine;
+
     // utility functions
     /** Clear the block's state and prepare for assembling a new block */
     void resetBlock();
@@ -334,6 +356,12 @@ void RefreshDelegates(wallet::CWallet *pwallet, bool myDelegates, bool stakerDel
 
 int64_t UpdateTime(CBlockHeader* pblock, const Consensus::Params& consensusParams, const CBlockIndex* pindexPrev);
 
+/** Time limit of the block built while the staker waits for a kernel, a small part of the time limit for a found kernel */
+int32_t SpeculativeBlockTimeLimit(int64_t nNow, int32_t nTimeLimit);
+
+/** Whether the block built while waiting for a kernel can be signed for the kernel found at blockTime with the header */
+bool CanUseSpeculativeBlock(const CBlockTemplate& speculative, const CBlockHeader& header, uint32_t blockTime, const CScript& author);
+
 /** Update an old GenerateCoinbaseCommitment from CreateNewBlock after the block txs have changed */
 void RegenerateCommitments(CBlock& block, ChainstateManager& chainman);
 
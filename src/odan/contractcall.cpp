@@ -0,0 +1,157 @@
+#include <odan/contractcall.h>
+#include <odan/odanDGP.h>
+#include <timedata.h>
+
+static Mutex g_snapshot_mutex;
+static std::shared_ptr<const ContractCallSnapshot> g_snapshot GUARDED_BY(g_snapshot_mutex);
+
+static CBlock ReadTipBlock(Chainstate& chainstate) EXCLUSIVE_LOCKS_REQUIRED(cs_main)
+{
+    CBlock block;
+    chainstate.m_blockman.ReadBlockFromDisk(block, *chainstate.m_chain.Tip());
+    if(block.IsProofOfStake())
+        block.vtx.erase(block.vtx.begin()+2,block.vtx.end());
+    else
+        block.vtx.erase(block.vtx.begin()+1,block.vtx.end());
+    return block;
+}
+
+static uint64_t GetCallBlockGasLimit(Chainstate& chainstate) EXCLUSIVE_LOCKS_REQUIRED(cs_main)
+{
+    OdanDGP odanDGP(globalState.get(), chainstate, fGettingValuesDGP);
+    return odanDGP.getBlockGasLimit(chainstate.m_chain.Tip()->nHeight + 1);
+}
+
+ContractCallSnapshot::ContractCallSnapshot(Chainstate& chainstate) :
+    block(ReadTipBlock(chainstate)),
+    pindex(chainstate.m_chain.Tip()),
+    blockGasLimit(GetCallBlockGasLimit(chainstate)),
+    envExec(block, std::vector<OdanTransaction>(), blockGasLimit, chainstate.m_chain.Tip(), chainstate.m_chain),
+    envInfo(envExec.BuildEVMEnvironment()),
+    chainParams(globalSealEngine->chainParams()),
+    schedule(globalSealEngine->getOdanSchedule()),
+    base(new OdanState(*globalState))
+{
+    base->clearTransientStorage();
+}
+
+static dev::eth::EnvInfo NextBlockEnvInfo(const dev::eth::EnvInfo& envInfo)
+{
+    // The call is executed in a block on top of the tip with the current time
+    dev::eth::BlockHeader header(envInfo.header());
+    header.setTimestamp(GetAdjustedTimeSeconds());
+    return dev::eth::EnvInfo(header, envInfo.lastHashes(), dev::u256(), envInfo.chainID());
+}
+
+std::vector<ResultExecute> ContractCallSnapshot::Call(const dev::Address& addrContract, const std::vector<unsigned char>& opcode, const dev::Address& sender, uint64_t gasLimit, CAmount nAmount) const
+{
+    OdanState state(*base);
+    dev::eth::EnvInfo callEnvInfo(NextBlockEnvInfo(envInfo));
+
+    if(gasLimit == 0){
+        gasLimit = blockGasLimit - 1;
+    }
+    dev::Address senderAddress = sender == dev::Address() ? dev::Address("ffffffffffffffffffffffffffffffffffffffff") : sender;
+    dev::u256 nonce = state.getNonce(senderAddress);
+
+    OdanTransaction callTransaction;
+    if(addrContract == dev::Address())
+    {
+        callTransaction = OdanTransaction(nAmount, 1, dev::u256(gasLimit), opcode, nonce);
+    }
+    else
+    {
+        callTransaction = OdanTransaction(nAmount, 1, dev::u256(gasLimit), addrContract, opcode, nonce);
+    }
+    callTransaction.forceSender(senderAddress);
+    callTransaction.setVersion(VersionVM::GetEVMDefault());
+
+    std::vector<ResultExecute> result;
+    if(!callTransaction.isCreation() && !state.addressInUse(callTransaction.receiveAddress())){
+        dev::eth::ExecutionResult execRes;
+        execRes.excepted = dev::eth::TransactionException::Unknown;
+        result.push_back(ResultExecute{execRes, OdanTransactionReceipt(dev::h256(), dev::h256(), dev::u256(), dev::eth::LogEntries()), CTransaction()});
+        return result;
+    }
+
+    // deleteAddresses is modified during the execution, every call needs its own seal engine
+    std::unique_ptr<dev::eth::SealEngineFace> sealEngine(dev::eth::SealEngineRegistrar::create(chainParams));
+    sealEngine->setOdanSchedule(schedule);
+    result.push_back(state.execute(callEnvInfo, *sealEngine, callTransaction, pindex->nHeight, dev::eth::Permanence::Reverted));
+    return result;
+}
+
+bool ContractCallSnapshot::AddressInUse(const dev::Address& address) const
+{
+    OdanState state(*base);
+    return state.addressInUse(address);
+}
+
+void ContractCallSnapshot::Simulate(const std::vector<OdanTransaction>& txs, ContractSimulation& simulation) const
+{
+    OdanState state(*base);
+    dev::eth::EnvInfo simEnvInfo(NextBlockEnvInfo(envInfo));
+    std::atomic<bool> contextRead{false};
+    simEnvInfo.setBlockContextFlag(&contextRead);
+    std::unique_ptr<dev::eth::SealEngineFace> sealEngine(dev::eth::SealEngineRegistrar::create(chainParams));
+    sealEngine->setOdanSchedule(schedule);
+
+    // The outputs are committed to the private state, each one sees the changes of the previous ones
+    state.setAccessRecorder(&simulation.keys);
+    for(const OdanTransaction& tx : txs){
+        if(tx.getVersion().toRaw() != VersionVM::GetEVMDefault().toRaw() || (!tx.isCreation() && !state.addressInUse(tx.receiveAddress()))){
+            simulation.failed = true;
+            continue;
+        }
+        ResultExecute result = state.execute(simEnvInfo, *sealEngine, tx, pindex->nHeight, dev::eth::Permanence::Committed);
+        simulation.gasUsed += (uint64_t)result.execRes.gasUsed;
+        simulation.failed |= result.execRes.excepted != dev::eth::TransactionException::None;
+    }
+    state.setAccessRecorder(nullptr);
+    simulation.blockContextRead = contextRead;
+}
+
+static bool UnchangedKeys(OdanState& state, const OdanStateKeys& keys, const dev::h256& root, const dev::h256& rootUTXO)
+{
+    OdanStateDiff diff = state.diff(keys, root, rootUTXO);
+    if(!diff.vins.empty())
+        return false;
+    // The other slots of the accessed contracts do not matter, so resetStorage is ignored
+    for(auto const& i : diff.accounts){
+        if(i.second.fieldsChanged || !i.second.storage.empty())
+            return false;
+    }
+    return true;
+}
+
+bool ContractCallSnapshot::Unchanged(const ContractCallSnapshot& since, const OdanStateKeys& keys) const
+{
+    OdanState state(*base);
+    return UnchangedKeys(state, keys, since.base->rootHash(), since.base->rootHashUTXO());
+}
+
+bool ContractCallSnapshot::UnchangedInGlobalState(const OdanStateKeys& keys) const
+{
+    return UnchangedInState(*globalState, keys);
+}
+
+bool ContractCallSnapshot::UnchangedInState(OdanState& state, const OdanStateKeys& keys) const
+{
+    if(base->rootHash() == state.rootHash() && base->rootHashUTXO() == state.rootHashUTXO())
+        return true;
+    return UnchangedKeys(state, keys, base->rootHash(), base->rootHashUTXO());
+}
+
+bool ContractCallSnapshot::IsCurrent(const CBlockIndex* tip) const
+{
+    return pindex == tip && base->rootHash() == globalState->rootHash() && base->rootHashUTXO() == globalState->rootHashUTXO();
+}
+
+std::shared_ptr<const ContractCallSnapshot> GetContractCallSnapshot(Chainstate& chainstate)
+{
+    LOCK2(cs_main, g_snapshot_mutex);
+    if(!g_snapshot || !g_snapshot->IsCurrent(chainstate.m_chain.Tip())){
+        g_snapshot = std::make_shared<const ContractCallSnapshot>(chainstate);
+    }
+    return g_snapshot;
+}
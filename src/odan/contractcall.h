@@ -0,0 +1,91 @@
+#ifndef ODANCONTRACTCALL_H
+#define ODANCONTRACTCALL_H
+
+#include <odan/odanstate.h>
+#include <sync.h>
+#include <validation.h>
+
+#include <memory>
+#include <vector>
+
+class ContractCallSnapshot;
+
+/** Outcome of the contract outputs of a mempool transaction executed on a snapshot of the tip */
+struct ContractSimulation {
+    std::shared_ptr<const ContractCallSnapshot> snapshot;
+    uint64_t gasUsed = 0;
+    /** An output reverted, ran out of gas or called a missing contract */
+    bool failed = false;
+    /** A contract read the block context, the outcome can change with any new tip */
+    bool blockContextRead = false;
+    /** Everything the outputs read or wrote */
+    OdanStateKeys keys;
+};
+
+/**
+ * Read-only contract calls against the state of the chain tip.
+ *
+ * The snapshot keeps its own copy of globalState pinned to the tip roots, the tip block
+ * and the LastHashes, so the calls neither read the block from disk nor hold cs_main.
+ * Every call executes on a private copy of the snapshot state with a private seal engine,
+ * which lets any number of RPC threads call contracts at the same time.
+ */
+class ContractCallSnapshot {
+
+public:
+
+    /** Capture the tip of the chainstate and the current globalState */
+    ContractCallSnapshot(Chainstate& chainstate) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
+
+    ContractCallSnapshot(const ContractCallSnapshot&) = delete;
+    ContractCallSnapshot& operator=(const ContractCallSnapshot&) = delete;
+
+    /** Same as CallContract(), without changing globalState */
+    std::vector<ResultExecute> Call(const dev::Address& addrContract, const std::vector<unsigned char>& opcode, const dev::Address& sender = dev::Address(), uint64_t gasLimit = 0, CAmount nAmount = 0) const;
+
+    bool AddressInUse(const dev::Address& address) const;
+
+    /** Execute the outputs of a transaction in order on a private copy of the state */
+    void Simulate(const std::vector<OdanTransaction>& txs, ContractSimulation& simulation) const;
+
+    /** None of the keys changed value between the state of an older snapshot and this one */
+    bool Unchanged(const ContractCallSnapshot& since, const OdanStateKeys& keys) const;
+
+    /** None of the keys changed value between the state of this snapshot and globalState, e.g. the block being assembled */
+    bool UnchangedInGlobalState(const OdanStateKeys& keys) const EXCLUSIVE_LOCKS_REQUIRED(cs_main);
+
+    /** Same as UnchangedInGlobalState() for a private copy of the state, e.g. the block being assembled without cs_main */
+    bool UnchangedInState(OdanState& state, const OdanStateKeys& keys) const;
+
+    /** The snapshot is still up to date with the chain tip and globalState */
+    bool IsCurrent(const CBlockIndex* tip) const EXCLUSIVE_LOCKS_REQUIRED(cs_main);
+
+    uint64_t GetBlockGasLimit() const { return blockGasLimit; }
+
+    const CBlockIndex* GetTip() const { return pindex; }
+
+private:
+
+    CBlock block;
+
+    const CBlockIndex* pindex;
+
+    uint64_t blockGasLimit;
+
+    /** Keeps the LastHashes referenced by envInfo alive */
+    ByteCodeExec envExec;
+
+    dev::eth::EnvInfo envInfo;
+
+    dev::eth::ChainOperationParams chainParams;
+
+    dev::eth::EVMSchedule schedule;
+
+    /** globalState at the tip, copied by every call */
+    std::unique_ptr<OdanState> base;
+};
+
+/** Snapshot of the active chain tip, shared by the callers until the tip or globalState change */
+std::shared_ptr<const ContractCallSnapshot> GetContractCallSnapshot(Chainstate& chainstate) LOCKS_EXCLUDED(cs_main);
+
+#endif
@@ -0,0 +1,285 @@
+#include <odan/contractsnapshot.h>
+#include <odan/stateprune.h>
+#include <hash.h>
+#include <logging.h>
+#include <streams.h>
+#include <util/convert.h>
+#include <util/thread.h>
+
+#include <libdevcore/RLP.h>
+#include <libdevcore/SHA3.h>
+#include <libdevcore/TrieCommon.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <unordered_set>
+
+using namespace dev;
+
+static db::Slice toSlice(const std::vector<unsigned char>& data)
+{
+    return db::Slice(reinterpret_cast<const char*>(data.data()), data.size());
+}
+
+static bytes auxKey(const h256& hash)
+{
+    bytes key = hash.asBytes();
+    key.push_back(255);
+    return key;
+}
+
+uint256 ContractSnapshotChunk::GetHash() const
+{
+    return (HashWriter{} << trie << nodes << preimages).GetHash();
+}
+
+/** Writes the items of one trie in chunks of CONTRACT_SNAPSHOT_CHUNK_SIZE */
+class ContractSnapshotWriter
+{
+public:
+    ContractSnapshotWriter(AutoFile& _file, const std::function<void()>& _interruption_point) :
+        file(_file), interruption_point(_interruption_point) { }
+
+    void Begin(uint8_t trie)
+    {
+        chunk.trie = trie;
+    }
+
+    void AddNode(bytesConstRef node)
+    {
+        chunk.nodes.emplace_back(node.begin(), node.end());
+        nSize += node.size();
+        nNodes++;
+        if (nSize >= CONTRACT_SNAPSHOT_CHUNK_SIZE)
+            Flush();
+    }
+
+    void AddPreimage(const std::string& preimage)
+    {
+        chunk.preimages.emplace_back(preimage.begin(), preimage.end());
+        nSize += preimage.size();
+    }
+
+    void Flush()
+    {
+        if (chunk.nodes.empty() && chunk.preimages.empty())
+            return;
+        interruption_point();
+        chunk.hash = chunk.GetHash();
+        file << chunk;
+        chunk.nodes.clear();
+        chunk.preimages.clear();
+        nSize = 0;
+    }
+
+    void End()
+    {
+        Flush();
+        ContractSnapshotChunk end;
+        end.hash = end.GetHash();
+        file << end;
+    }
+
+    uint64_t nNodes{0};
+
+private:
+    AutoFile& file;
+    const std::function<void()>& interruption_point;
+    ContractSnapshotChunk chunk;
+    size_t nSize{0};
+};
+
+/** Walk the trie at root, and the storage and code of the accounts when db is the state database */
+static bool walkContractState(const db::DatabaseFace& db, const h256& root, bool fAccounts,
+                              const std::function<void(bytesConstRef)>& onNode,
+                              const std::function<void(const h256&)>& onKey)
+{
+    // Storage tries and code shared by several contracts are visited once
+    std::unordered_set<h256> seen;
+    std::function<bool(const h256&, const std::string&)> node = [&](const h256&, const std::string& data) {
+        onNode(bytesConstRef(data));
+        return true;
+    };
+    std::function<bool(const bytes&, bytesConstRef)> slot = [&](const bytes& path, bytesConstRef) {
+        h256 key;
+        if (TriePathToHash(path, key))
+            onKey(key);
+        return true;
+    };
+    std::function<bool(const bytes&, bytesConstRef)> account = [&](const bytes& path, bytesConstRef value) {
+        slot(path, value);
+        if (!fAccounts)
+            return true;
+
+        RLP r(value);
+        h256 storageRoot = r[2].toHash<h256>();
+        h256 codeHash = r[3].toHash<h256>();
+        if (codeHash != EmptySHA3 && seen.insert(codeHash).second) {
+            std::string code = db.lookup(db::Slice(reinterpret_cast<const char*>(codeHash.data()), h256::size));
+            if (code.empty())
+                return false;
+            onNode(bytesConstRef(code));
+        }
+        if (storageRoot != EmptyTrie && seen.insert(storageRoot).second)
+            return WalkTrie(db, storageRoot, node, slot);
+        return true;
+    };
+    return WalkTrie(db, root, node, account);
+}
+
+static bool writeTrie(ContractSnapshotWriter& writer, const db::DatabaseFace& db, const uint256& root, uint8_t trie)
+{
+    writer.Begin(trie);
+    bool ret = walkContractState(db, uintToh256(root), trie == CONTRACT_SNAPSHOT_STATE,
+        [&](bytesConstRef node) { writer.AddNode(node); },
+        [&](const h256& key) {
+            // The keys of the secure tries are hashed, the preimages are the keys of the fat tries
+            std::string preimage = db.lookup(toSlice(auxKey(key)));
+            if (!preimage.empty())
+                writer.AddPreimage(preimage);
+        });
+    writer.Flush();
+    return ret;
+}
+
+bool WriteContractSnapshot(const db::DatabaseFace& stateDB, const db::DatabaseFace& utxoDB,
+                           const ContractSnapshotMetadata& metadata, AutoFile& file,
+                           const std::function<void()>& interruption_point, uint64_t& nNodes)
+{
+    file << metadata;
+    ContractSnapshotWriter writer(file, interruption_point);
+    if (!writeTrie(writer, stateDB, metadata.m_state_root, CONTRACT_SNAPSHOT_STATE) ||
+        !writeTrie(writer, utxoDB, metadata.m_utxo_root, CONTRACT_SNAPSHOT_UTXO)) {
+        LogPrintf("[snapshot] missing node in the contract state of %s\n", metadata.m_base_blockhash.ToString());
+        return false;
+    }
+    writer.End();
+    nNodes = writer.nNodes;
+    return true;
+}
+
+/** Verify one chunk and write it to its database */
+static bool importChunk(db::DatabaseFace& stateDB, db::DatabaseFace& utxoDB, const ContractSnapshotChunk& chunk)
+{
+    if (chunk.hash != chunk.GetHash())
+        return false;
+    db::DatabaseFace& db = chunk.trie == CONTRACT_SNAPSHOT_STATE ? stateDB : utxoDB;
+    auto batch = db.createWriteBatch();
+    for (const auto& node : chunk.nodes) {
+        h256 hash = sha3(node);
+        batch->insert(db::Slice(reinterpret_cast<const char*>(hash.data()), h256::size), toSlice(node));
+    }
+    for (const auto& preimage : chunk.preimages)
+        batch->insert(toSlice(auxKey(sha3(preimage))), toSlice(preimage));
+    db.commit(std::move(batch));
+    return true;
+}
+
+bool LoadContractSnapshot(db::DatabaseFace& stateDB, db::DatabaseFace& utxoDB,
+                          const ContractSnapshotMetadata& expected, AutoFile& file,
+                          int nThreads, uint64_t& nNodes)
+{
+    ContractSnapshotMetadata metadata;
+    try {
+        file >> metadata;
+    } catch (const std::ios_base::failure& e) {
+        LogPrintf("[snapshot] bad contract state snapshot metadata: %s\n", e.what());
+        return false;
+    }
+    if (!(metadata == expected)) {
+        LogPrintf("[snapshot] contract state snapshot of block %s does not match the UTXO snapshot\n", metadata.m_base_blockhash.ToString());
+        return false;
+    }
+
+    // The file is read in order, the chunks are hashed and written by the workers
+    std::mutex mutex;
+    std::condition_variable cond;
+    std::deque<ContractSnapshotChunk> queue;
+    bool fDone = false;
+    std::atomic<bool> fFailed{false};
+    std::atomic<uint64_t> nImported{0};
+    const size_t nMaxQueue = 2 * nThreads;
+
+    std::vector<std::thread> workers;
+    for (int i = 0; i < nThreads; i++) {
+        workers.emplace_back(&util::TraceThread, "loadcontract", [&] {
+            while (true) {
+                ContractSnapshotChunk chunk;
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    cond.wait(lock, [&] { return !queue.empty() || fDone || fFailed; });
+                    if (queue.empty() || fFailed)
+                        return;
+                    chunk = std::move(queue.front());
+                    queue.pop_front();
+                }
+                cond.notify_all();
+                if (!importChunk(stateDB, utxoDB, chunk)) {
+                    {
+                        std::unique_lock<std::mutex> lock(mutex);
+                        fFailed = true;
+                    }
+                    cond.notify_all();
+                    return;
+                }
+                nImported += chunk.nodes.size();
+            }
+        });
+    }
+
+    size_t nChunks = 0;
+    uint8_t trie = CONTRACT_SNAPSHOT_STATE;
+    while (!fFailed) {
+        ContractSnapshotChunk chunk;
+        try {
+            file >> chunk;
+        } catch (const std::ios_base::failure&) {
+            LogPrintf("[snapshot] truncated contract state snapshot after %u chunks\n", nChunks);
+            fFailed = true;
+            break;
+        }
+        // The state trie comes first, then the UTXO trie
+        if (chunk.trie == CONTRACT_SNAPSHOT_END)
+            break;
+        if (chunk.trie < trie || chunk.trie > CONTRACT_SNAPSHOT_UTXO) {
+            fFailed = true;
+            break;
+        }
+        trie = chunk.trie;
+        nChunks++;
+        if (nChunks % 100 == 0)
+            LogPrintf("[snapshot] %u contract state chunks loaded\n", nChunks);
+
+        std::unique_lock<std::mutex> lock(mutex);
+        cond.wait(lock, [&] { return queue.size() < nMaxQueue || fFailed; });
+        queue.push_back(std::move(chunk));
+        cond.notify_all();
+    }
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        fDone = true;
+    }
+    cond.notify_all();
+    for (auto& worker : workers)
+        worker.join();
+
+    if (fFailed) {
+        LogPrintf("[snapshot] bad contract state snapshot after %u chunks\n", nChunks);
+        return false;
+    }
+    nNodes = nImported;
+    LogPrintf("[snapshot] loaded %u contract state nodes in %u chunks\n", nNodes, nChunks);
+    return true;
+}
+
+bool CheckContractState(const db::DatabaseFace& stateDB, const db::DatabaseFace& utxoDB,
+                        const uint256& stateRoot, const uint256& utxoRoot)
+{
+    auto noNode = [](bytesConstRef) {};
+    auto noKey = [](const h256&) {};
+    return walkContractState(stateDB, uintToh256(stateRoot), true, noNode, noKey) &&
+           walkContractState(utxoDB, uintToh256(utxoRoot), false, noNode, noKey);
+}
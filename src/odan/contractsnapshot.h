@@ -0,0 +1,104 @@
+#ifndef ODANCONTRACTSNAPSHOT_H
+#define ODANCONTRACTSNAPSHOT_H
+
+#include <serialize.h>
+#include <uint256.h>
+#include <libdevcore/db.h>
+
+#include <array>
+#include <functional>
+#include <vector>
+
+class AutoFile;
+
+/** Suffix of the contract state file written next to the UTXO snapshot by dumptxoutset */
+static const std::string CONTRACT_SNAPSHOT_SUFFIX = ".contract";
+
+static const std::array<uint8_t, 5> CONTRACT_SNAPSHOT_MAGIC = {'o', 'd', 'c', 's', 0xff};
+static const uint16_t CONTRACT_SNAPSHOT_VERSION = 1;
+
+/** Trie of a chunk of the contract state snapshot */
+enum ContractSnapshotTrie : uint8_t {
+    CONTRACT_SNAPSHOT_STATE = 0,
+    CONTRACT_SNAPSHOT_UTXO = 1,
+    CONTRACT_SNAPSHOT_END = 0xff,
+};
+
+/** Contract state tries at the roots of the base block of a UTXO snapshot */
+class ContractSnapshotMetadata
+{
+public:
+    uint256 m_base_blockhash;
+    uint256 m_state_root;
+    uint256 m_utxo_root;
+
+    ContractSnapshotMetadata() { }
+    ContractSnapshotMetadata(const uint256& base_blockhash, const uint256& state_root, const uint256& utxo_root) :
+        m_base_blockhash(base_blockhash), m_state_root(state_root), m_utxo_root(utxo_root) { }
+
+    bool operator==(const ContractSnapshotMetadata& other) const
+    {
+        return m_base_blockhash == other.m_base_blockhash && m_state_root == other.m_state_root && m_utxo_root == other.m_utxo_root;
+    }
+
+    template <typename Stream>
+    void Serialize(Stream& s) const
+    {
+        s << CONTRACT_SNAPSHOT_MAGIC << CONTRACT_SNAPSHOT_VERSION;
+        s << m_base_blockhash << m_state_root << m_utxo_root;
+    }
+
+    template <typename Stream>
+    void Unserialize(Stream& s)
+    {
+        std::array<uint8_t, 5> magic;
+        uint16_t version;
+        s >> magic >> version;
+        if (magic != CONTRACT_SNAPSHOT_MAGIC || version != CONTRACT_SNAPSHOT_VERSION)
+            throw std::ios_base::failure("Unknown contract state snapshot format");
+        s >> m_base_blockhash >> m_state_root >> m_utxo_root;
+    }
+};
+
+/**
+ * Trie nodes, contract code and key preimages of one trie. The nodes and the code are stored
+ * under their hash and the preimages under the hash followed by 0xff, so every item is
+ * verified by hashing it; the chunk hash detects a damaged file before anything is written.
+ */
+class ContractSnapshotChunk
+{
+public:
+    uint8_t trie{CONTRACT_SNAPSHOT_END};
+    std::vector<std::vector<unsigned char>> nodes;
+    std::vector<std::vector<unsigned char>> preimages;
+    uint256 hash;
+
+    uint256 GetHash() const;
+
+    SERIALIZE_METHODS(ContractSnapshotChunk, obj) { READWRITE(obj.trie, obj.nodes, obj.preimages, obj.hash); }
+};
+
+/** Size of the nodes of a chunk */
+static const size_t CONTRACT_SNAPSHOT_CHUNK_SIZE = 4 << 20;
+
+/**
+ * Stream the contract state and the UTXO trie at the roots of metadata to file, walking the tries.
+ * Returns false when a node is missing. interruption_point is called between the chunks.
+ */
+bool WriteContractSnapshot(const dev::db::DatabaseFace& stateDB, const dev::db::DatabaseFace& utxoDB,
+                           const ContractSnapshotMetadata& metadata, AutoFile& file,
+                           const std::function<void()>& interruption_point, uint64_t& nNodes);
+
+/**
+ * Import a contract state snapshot written for expected into the state databases. The chunks
+ * are read in order and verified and written by nThreads threads.
+ */
+bool LoadContractSnapshot(dev::db::DatabaseFace& stateDB, dev::db::DatabaseFace& utxoDB,
+                          const ContractSnapshotMetadata& expected, AutoFile& file,
+                          int nThreads, uint64_t& nNodes);
+
+/** Check that every node of the tries at the roots, and the code of the contracts, is in the databases */
+bool CheckContractState(const dev::db::DatabaseFace& stateDB, const dev::db::DatabaseFace& utxoDB,
+                        const uint256& stateRoot, const uint256& utxoRoot);
+
+#endif
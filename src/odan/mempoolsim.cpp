@@ -0,0 +1,129 @@
+#include <odan/mempoolsim.h>
+#include <logging.h>
+#include <txmempool.h>
+#include <util/thread.h>
+#include <validation.h>
+
+MempoolSimulator::MempoolSimulator(CTxMemPool& _mempool, ChainstateManager& _chainman, int nThreads) :
+    mempool(_mempool),
+    chainman(_chainman)
+{
+    for(int i = 0; i < nThreads; i++){
+        workers.emplace_back(&util::TraceThread, strprintf("mempoolsim.%i", i), [this] { ThreadSimulate(); });
+    }
+}
+
+MempoolSimulator::~MempoolSimulator()
+{
+    {
+        LOCK(cs);
+        fStop = true;
+    }
+    condWorker.notify_all();
+    condFlush.notify_all();
+    for(std::thread& worker : workers){
+        if(worker.joinable())
+            worker.join();
+    }
+}
+
+void MempoolSimulator::Push(const uint256& hash, std::vector<OdanTransaction> txs)
+{
+    {
+        LOCK(cs);
+        transactions[hash] = std::make_shared<const std::vector<OdanTransaction>>(std::move(txs));
+        if(queued.insert(hash).second)
+            queue.push_back(hash);
+    }
+    condWorker.notify_one();
+}
+
+void MempoolSimulator::Flush()
+{
+    WAIT_LOCK(cs, lock);
+    condFlush.wait(lock, [this]() EXCLUSIVE_LOCKS_REQUIRED(cs) { return (queue.empty() && nBusy == 0) || fStop; });
+}
+
+void MempoolSimulator::UpdatedBlockTip(const CBlockIndex *pindexNew, const CBlockIndex *pindexFork, bool fInitialDownload)
+{
+    {
+        LOCK(cs);
+        for(const auto& i : transactions){
+            if(queued.insert(i.first).second)
+                queue.push_back(i.first);
+        }
+    }
+    condWorker.notify_all();
+}
+
+void MempoolSimulator::ThreadSimulate()
+{
+    while(true){
+        uint256 hash;
+        std::shared_ptr<const std::vector<OdanTransaction>> txs;
+        {
+            WAIT_LOCK(cs, lock);
+            condWorker.wait(lock, [this]() EXCLUSIVE_LOCKS_REQUIRED(cs) { return !queue.empty() || fStop; });
+            if(fStop)
+                return;
+            hash = queue.front();
+            queue.pop_front();
+            queued.erase(hash);
+            auto it = transactions.find(hash);
+            if(it == transactions.end())
+                continue;
+            txs = it->second;
+            nBusy++;
+        }
+
+        try{
+            Simulate(hash, *txs);
+        }
+        catch(const std::exception& e){
+            LogPrint(BCLog::MEMPOOL, "%s: simulation of %s failed: %s\n", __func__, hash.ToString(), e.what());
+        }
+
+        {
+            LOCK(cs);
+            nBusy--;
+        }
+        condFlush.notify_all();
+    }
+}
+
+void MempoolSimulator::Simulate(const uint256& hash, const std::vector<OdanTransaction>& txs)
+{
+    std::shared_ptr<const ContractCallSnapshot> snapshot = GetContractCallSnapshot(chainman.ActiveChainstate());
+    std::shared_ptr<const ContractSimulation> previous;
+    {
+        LOCK(mempool.cs);
+        std::optional<CTxMemPool::txiter> it = mempool.GetIter(hash);
+        if(!it){
+            // Mined, replaced or evicted since it was queued
+            LOCK(cs);
+            transactions.erase(hash);
+            return;
+        }
+        previous = (*it)->GetContractSimulation();
+    }
+    if(previous && previous->snapshot == snapshot)
+        return;
+
+    auto simulation = std::make_shared<ContractSimulation>();
+    if(previous && !previous->blockContextRead && snapshot->Unchanged(*previous->snapshot, previous->keys)){
+        *simulation = *previous;
+        nKept++;
+    } else {
+        snapshot->Simulate(txs, *simulation);
+        nSimulated++;
+    }
+    simulation->snapshot = snapshot;
+
+    LOCK(mempool.cs);
+    std::optional<CTxMemPool::txiter> it = mempool.GetIter(hash);
+    if(it){
+        // A failed tx is not mined on this state, its gas limit stays reserved
+        uint64_t gas = simulation->failed ? (*it)->GetGasLimit() : simulation->gasUsed;
+        mempool.UpdateContractSimulation(*it, std::move(simulation), gas);
+    }
+}
@@ -0,0 +1,81 @@
+#ifndef ODANMEMPOOLSIM_H
+#define ODANMEMPOOLSIM_H
+
+#include <odan/contractcall.h>
+#include <sync.h>
+#include <validationinterface.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <memory>
+#include <set>
+#include <thread>
+#include <vector>
+
+class CTxMemPool;
+class ChainstateManager;
+
+/** Default number of mempool simulation threads, 0 disables the simulation */
+static const int DEFAULT_MEMPOOL_SIMULATION = 0;
+
+/**
+ * Execution of the mempool contract transactions against the state of the tip.
+ *
+ * A transaction accepted to the mempool is queued with its contract outputs and executed by
+ * the worker threads on a ContractCallSnapshot of the tip, without cs_main. The gas used, the
+ * failure and the accessed keys are stored on the mempool entry, where the block assembly uses
+ * them. When a new tip arrives, an entry keeps its outcome if none of the keys it accessed
+ * changed value and no contract read the block context, otherwise it is executed again.
+ */
+class MempoolSimulator final : public CValidationInterface {
+
+public:
+
+    MempoolSimulator(CTxMemPool& _mempool, ChainstateManager& _chainman, int nThreads);
+
+    ~MempoolSimulator();
+
+    /** Queue the contract outputs of a transaction added to the mempool */
+    void Push(const uint256& hash, std::vector<OdanTransaction> txs) EXCLUSIVE_LOCKS_REQUIRED(!cs);
+
+    /** Wait until the queue is empty and the workers are idle */
+    void Flush() EXCLUSIVE_LOCKS_REQUIRED(!cs);
+
+    unsigned int GetSimulated() const { return nSimulated; }
+
+    unsigned int GetKept() const { return nKept; }
+
+protected:
+
+    void UpdatedBlockTip(const CBlockIndex *pindexNew, const CBlockIndex *pindexFork, bool fInitialDownload) override EXCLUSIVE_LOCKS_REQUIRED(!cs);
+
+private:
+
+    void ThreadSimulate() EXCLUSIVE_LOCKS_REQUIRED(!cs);
+
+    void Simulate(const uint256& hash, const std::vector<OdanTransaction>& txs) EXCLUSIVE_LOCKS_REQUIRED(!cs);
+
+    CTxMemPool& mempool;
+
+    ChainstateManager& chainman;
+
+    std::atomic<unsigned int> nSimulated{0};
+
+    std::atomic<unsigned int> nKept{0};
+
+    mutable Mutex cs;
+    std::condition_variable condWorker;
+    std::condition_variable condFlush;
+    /** Contract outputs of the transactions still in the mempool as far as the simulator knows */
+    std::map<uint256, std::shared_ptr<const std::vector<OdanTransaction>>> transactions GUARDED_BY(cs);
+    std::deque<uint256> queue GUARDED_BY(cs);
+    std::set<uint256> queued GUARDED_BY(cs);
+    int nBusy GUARDED_BY(cs){0};
+    bool fStop GUARDED_BY(cs){false};
+
+    std::vector<std::thread> workers;
+};
+
+#endif
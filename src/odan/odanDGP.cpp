@@ -1,5 +1,10 @@
 #include <odan/odanDGP.h>
 #include <chainparams.h>
+#include <sync.h>
+
+static Mutex cs_dgpcache;
+static std::map<std::pair<dev::Address, bool>, std::shared_ptr<const DGPCacheEntry>> dgpCache GUARDED_BY(cs_dgpcache);
+static std::map<std::pair<dev::Address, std::vector<unsigned char>>, std::shared_ptr<const DGPTemplateCall>> dgpCallCache GUARDED_BY(cs_dgpcache);
 
 std::vector<uint32_t> createDataSchedule(const dev::eth::EVMSchedule& schedule)
 {
@@ -100,20 +105,75 @@ uint64_t OdanDGP::getBlockGasLimit(unsigned int blockHeight){
 
 
 bool OdanDGP::initStorages(const dev::Address& addr, unsigned int blockHeight, std::vector<unsigned char> data){
-    initStorageDGP(addr);
-    createParamsInstance();
+    std::shared_ptr<const DGPCacheEntry> entry = getCacheEntry(addr);
+    paramsInstance = entry->paramsInstance;
     dev::Address address = getAddressForBlock(blockHeight);
     if(address != dev::Address()){
-        if(!dgpevm){
-            initStorageTemplate(address);
-        } else {
+        if(dgpevm){
             initDataTemplate(address, data);
+        } else if(!getCachedTemplate(*entry, address)){
+            initStorageTemplate(address);
+            addCachedTemplate(addr, *entry, address);
         }
         return true;
     }
     return false;
 }
 
+std::shared_ptr<const DGPCacheEntry> OdanDGP::getCacheEntry(const dev::Address& addr){
+    const std::pair<dev::Address, bool> key(addr, dgpevm);
+    const dev::h256 stateRoot = state->rootHash();
+    std::shared_ptr<const DGPCacheEntry> entry;
+    {
+        LOCK(cs_dgpcache);
+        auto it = dgpCache.find(key);
+        if(it != dgpCache.end())
+            entry = it->second;
+    }
+    if(entry && entry->stateRoot == stateRoot)
+        return entry;
+
+    // The contracts are read again only when a block changed their storage
+    bool fValid = entry != nullptr;
+    for(size_t i = 0; fValid && i < entry->storageRoots.size(); i++){
+        fValid = state->storageRoot(entry->storageRoots[i].first) == entry->storageRoots[i].second;
+    }
+
+    std::shared_ptr<DGPCacheEntry> newEntry;
+    if(fValid){
+        newEntry = std::make_shared<DGPCacheEntry>(*entry);
+    } else {
+        initStorageDGP(addr);
+        createParamsInstance();
+        newEntry = std::make_shared<DGPCacheEntry>();
+        newEntry->storageRoots.emplace_back(addr, state->storageRoot(addr));
+        newEntry->paramsInstance = paramsInstance;
+        paramsInstance.clear();
+    }
+    newEntry->stateRoot = stateRoot;
+
+    LOCK(cs_dgpcache);
+    dgpCache[key] = newEntry;
+    return newEntry;
+}
+
+bool OdanDGP::getCachedTemplate(const DGPCacheEntry& entry, const dev::Address& address){
+    auto it = entry.storageTemplates.find(address);
+    if(it == entry.storageTemplates.end())
+        return false;
+    storageTemplate = it->second;
+    return true;
+}
+
+void OdanDGP::addCachedTemplate(const dev::Address& addr, const DGPCacheEntry& entry, const dev::Address& address){
+    std::shared_ptr<DGPCacheEntry> newEntry = std::make_shared<DGPCacheEntry>(entry);
+    newEntry->storageRoots.emplace_back(address, state->storageRoot(address));
+    newEntry->storageTemplates[address] = storageTemplate;
+
+    LOCK(cs_dgpcache);
+    dgpCache[std::make_pair(addr, dgpevm)] = newEntry;
+}
+
 void OdanDGP::initStorageDGP(const dev::Address& addr){
     storageDGP = state->storage(addr);
 }
@@ -123,7 +183,72 @@ void OdanDGP::initStorageTemplate(const dev::Address& addr){
 }
 
 void OdanDGP::initDataTemplate(const dev::Address& addr, std::vector<unsigned char>& data){
-    dataTemplate = CallContract(addr, data, chainstate)[0].execRes.output;
+    // A caller already recording the accesses of globalState needs the ones of the call too
+    if(globalState->hasAccessRecorder()){
+        dataTemplate = CallContract(addr, data, chainstate)[0].execRes.output;
+        return;
+    }
+    if(getCachedCall(addr, data))
+        return;
+
+    OdanStateKeys keys;
+    bool blockContextRead = false;
+    globalState->setAccessRecorder(&keys);
+    try{
+        dataTemplate = CallContract(addr, data, chainstate, dev::Address(), 0, 0, &blockContextRead)[0].execRes.output;
+    }
+    catch(...){
+        globalState->setAccessRecorder(nullptr);
+        throw;
+    }
+    globalState->setAccessRecorder(nullptr);
+
+    // The output of a template that read the block context changes with every block
+    if(!blockContextRead)
+        addCachedCall(addr, data, keys.state.accounts);
+}
+
+bool OdanDGP::getCachedCall(const dev::Address& addr, const std::vector<unsigned char>& data){
+    const std::pair<dev::Address, std::vector<unsigned char>> key(addr, data);
+    std::shared_ptr<const DGPTemplateCall> entry;
+    {
+        LOCK(cs_dgpcache);
+        auto it = dgpCallCache.find(key);
+        if(it == dgpCallCache.end())
+            return false;
+        entry = it->second;
+    }
+
+    const dev::h256 stateRoot = globalState->rootHash();
+    if(entry->stateRoot != stateRoot){
+        for(const auto& [address, hash] : entry->accounts){
+            if(accountHash(address) != hash)
+                return false;
+        }
+        std::shared_ptr<DGPTemplateCall> newEntry = std::make_shared<DGPTemplateCall>(*entry);
+        newEntry->stateRoot = stateRoot;
+        LOCK(cs_dgpcache);
+        dgpCallCache[key] = newEntry;
+    }
+    dataTemplate = entry->output;
+    return true;
+}
+
+void OdanDGP::addCachedCall(const dev::Address& addr, const std::vector<unsigned char>& data, const dev::AddressHash& accessed){
+    std::shared_ptr<DGPTemplateCall> newEntry = std::make_shared<DGPTemplateCall>();
+    newEntry->stateRoot = globalState->rootHash();
+    for(const dev::Address& address : accessed)
+        newEntry->accounts.emplace_back(address, accountHash(address));
+    newEntry->output = dataTemplate;
+
+    LOCK(cs_dgpcache);
+    dgpCallCache[std::make_pair(addr, data)] = newEntry;
+}
+
+dev::h256 OdanDGP::accountHash(const dev::Address& addr) const{
+    dev::RLPStream stream(4);
+    stream << globalState->getNonce(addr) << globalState->balance(addr) << globalState->storageRoot(addr) << globalState->codeHash(addr);
+    return dev::sha3(stream.out());
 }
 
 void OdanDGP::createParamsInstance(){
@@ -24,6 +24,30 @@ static const uint64_t MIN_BLOCK_GAS_LIMIT_DGP = 1000000;
 static const uint64_t MAX_BLOCK_GAS_LIMIT_DGP = 1000000000;
 static const uint64_t DEFAULT_BLOCK_GAS_LIMIT_DGP = 40000000;
 
+/**
+ * Parameter instances of a DGP contract and the template storages read so far, shared by every OdanDGP.
+ * An entry stays valid while the storage roots of the contracts it was read from are unchanged,
+ * they are compared once for every new state root.
+ */
+struct DGPCacheEntry{
+    dev::h256 stateRoot;
+    std::vector<std::pair<dev::Address, dev::h256>> storageRoots;
+    std::vector<std::pair<unsigned int, dev::Address>> paramsInstance;
+    std::map<dev::Address, std::map<dev::h256, std::pair<dev::u256, dev::u256>>> storageTemplates;
+};
+
+/**
+ * Output of a template call of the dgpevm mode, shared by every OdanDGP.
+ * The call can read any contract, so the entry keeps a hash of every account it accessed,
+ * the template itself included, over the code hash, storage root, balance and nonce.
+ * It stays valid while these accounts are unchanged, they are compared once for every new state root.
+ */
+struct DGPTemplateCall{
+    dev::h256 stateRoot;
+    std::vector<std::pair<dev::Address, dev::h256>> accounts;
+    std::vector<unsigned char> output;
+};
+
 class OdanDGP {
     
 public:
@@ -42,12 +66,27 @@ private:
 
     bool initStorages(const dev::Address& addr, unsigned int blockHeight, std::vector<unsigned char> data = std::vector<unsigned char>());
 
+    /** Cache entry of the DGP contract valid for the state, read from the contract storage when needed */
+    std::shared_ptr<const DGPCacheEntry> getCacheEntry(const dev::Address& addr);
+
+    /** Copy the template storage from the cache entry, returns false when it was not read yet */
+    bool getCachedTemplate(const DGPCacheEntry& entry, const dev::Address& address);
+
+    void addCachedTemplate(const dev::Address& addr, const DGPCacheEntry& entry, const dev::Address& address);
+
     void initStorageDGP(const dev::Address& addr);
 
     void initStorageTemplate(const dev::Address& addr);
 
     void initDataTemplate(const dev::Address& addr, std::vector<unsigned char>& data);
 
+    /** Copy the output of the template call from the cache, returns false when it is not valid for the state */
+    bool getCachedCall(const dev::Address& addr, const std::vector<unsigned char>& data);
+
+    void addCachedCall(const dev::Address& addr, const std::vector<unsigned char>& data, const dev::AddressHash& accessed);
+
+    dev::h256 accountHash(const dev::Address& addr) const;
+
     void initDataSchedule();
 
     bool checkLimitSchedule(const std::vector<uint32_t>& defaultData, const std::vector<uint32_t>& checkData, int blockHeight);
@@ -169,8 +169,22 @@ OdanDelegation::~OdanDelegation()
     priv = 0;
 }
 
-bool OdanDelegation::GetDelegation(const uint160 &address, Delegation &delegation, Chainstate& chainstate) const
+bool OdanDelegation::GetDelegation(const uint160 &address, Delegation &delegation, Chainstate& chainstate, const uint256& stateRoot) const
 {
+    // The delegation index is read when it is at the state the contract would be called on,
+    // a missing entry is an address without delegation
+    if(fDelegationIndex)
+    {
+        node::BlockTreeDB& blocktree = *chainstate.m_blockman.m_block_tree_db;
+        CIndexBestBlock best;
+        if(blocktree.ReadDelegationIndexBest(best) && !best.IsNull() && best.stateRoot == stateRoot)
+        {
+            delegation = Delegation();
+            blocktree.ReadDelegationIndex(address, delegation);
+            return true;
+        }
+    }
+
     // Contract exist check
     if(!ExistDelegationContract())
         return error("Delegation contract address does not exist");
@@ -280,7 +294,8 @@ bool OdanDelegation::FilterDelegationEvents(std::vector<DelegationEvent> &events
     std::set<dev::h160> addresses;
     addresses.insert(priv->delegationsAddress);
     std::vector<std::vector<uint256>> hashesToBlock;
-    curheight = chainman.m_blockman.m_block_tree_db->ReadHeightIndex(fromBlock, toBlock, minconf, hashesToBlock, addresses, chainman);
+    LogBloomFilter bloomFilter{{LogBloomOf(priv->delegationsAddress)}};
+    curheight = chainman.m_blockman.m_block_tree_db->ReadHeightIndex(fromBlock, toBlock, minconf, hashesToBlock, addresses, chainman, bloomFilter);
 
     if (curheight == -1) {
         return error("Incorrect params");
@@ -298,13 +313,14 @@ bool OdanDelegation::FilterDelegationEvents(std::vector<DelegationEvent> &events
             }
             dupes.insert(e);
 
-            std::vector<TransactionReceiptInfo> receipts = pstorageresult->getResult(uintToh256(e));
-            for(const auto& receipt : receipts) {
-                if(receipt.logs.empty()) {
+            std::vector<dev::eth::LogEntries> receiptsLogs;
+            pstorageresult->getResultLogs(uintToh256(e), receiptsLogs);
+            for(const auto& logs : receiptsLogs) {
+                if(logs.empty()) {
                     continue;
                 }
 
-                for(const dev::eth::LogEntry& log : receipt.logs)
+                for(const dev::eth::LogEntry& log : logs)
                 {
                     DelegationEvent event;
                     if(priv->GetDelegationEvent(log, event) && filter.Match(event))
@@ -319,6 +335,74 @@ bool OdanDelegation::FilterDelegationEvents(std::vector<DelegationEvent> &events
     return true;
 }
 
+bool OdanDelegation::GetDelegationEvent(const dev::eth::LogEntry &log, DelegationEvent &event) const
+{
+    return priv->GetDelegationEvent(log, event);
+}
+
+bool OdanDelegation::BuildDelegationIndex(ChainstateManager &chainman) const
+{
+    // The delegation changes are taken from the stored logs
+    if(!fLogEvents)
+        return error("Events indexing disabled");
+
+    LOCK(cs_main);
+    node::BlockTreeDB& blocktree = *chainman.m_blockman.m_block_tree_db;
+    // The best block stays null while the index is built
+    if(!blocktree.WipeDelegationIndex(CIndexBestBlock()))
+        return error("Failed to wipe the delegation index");
+
+    std::set<dev::h160> addresses;
+    addresses.insert(priv->delegationsAddress);
+    std::vector<std::vector<uint256>> hashesToBlock;
+    LogBloomFilter bloomFilter{{LogBloomOf(priv->delegationsAddress)}};
+    if(blocktree.ReadHeightIndex(0, -1, 0, hashesToBlock, addresses, chainman, bloomFilter) == -1)
+        return error("Failed to read the height index");
+
+    // Collect the delegation changes per block, in the order of the transactions
+    std::map<uint32_t, std::vector<std::pair<uint160, Delegation>>> changes;
+    std::set<uint256> dupes;
+    CChain& active_chain = chainman.ActiveChain();
+    for(const auto& hashesTx : hashesToBlock)
+    {
+        for(const auto& e : hashesTx)
+        {
+            if(!dupes.insert(e).second)
+                continue;
+
+            for(const TransactionReceiptInfo& receipt : pstorageresult->getResult(uintToh256(e)))
+            {
+                // Only the receipts of the blocks in the active chain are applied
+                const CBlockIndex* pindex = active_chain[receipt.blockNumber];
+                if(!pindex || pindex->GetBlockHash() != receipt.blockHash)
+                    continue;
+
+                for(const dev::eth::LogEntry& log : receipt.logs)
+                {
+                    DelegationEvent event;
+                    if(!priv->GetDelegationEvent(log, event))
+                        continue;
+                    Delegation delegation;
+                    if(event.type == DELEGATION_ADD)
+                        delegation = event.item;
+                    changes[receipt.blockNumber].emplace_back(event.item.delegate, delegation);
+                }
+            }
+        }
+    }
+
+    for(const auto& [height, vect] : changes)
+    {
+        if(!blocktree.UpdateDelegationIndex(height, vect, CIndexBestBlock()))
+            return error("Failed to write the delegation index");
+    }
+
+    if(active_chain.Tip() && !blocktree.WriteDelegationIndexBest(CIndexBestBlock(active_chain.Tip())))
+        return error("Failed to write the delegation index best block");
+
+    return true;
+}
+
 std::map<uint160, Delegation> OdanDelegation::DelegationsFromEvents(const std::vector<DelegationEvent> &events)
 {
     std::map<uint160, Delegation> delegations;
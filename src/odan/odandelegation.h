@@ -11,6 +11,7 @@ class OdanDelegationPriv;
 class ContractABI;
 class ChainstateManager;
 class Chainstate;
+namespace dev { namespace eth { struct LogEntry; } }
 
 extern const std::string strDelegationsABI;
 const ContractABI &DelegationABI();
@@ -75,9 +76,10 @@ public:
      * @brief GetDelegation Get delegation for an address
      * @param address Public key hash address
      * @param delegation Delegation information for an address
+     * @param stateRoot State root of globalState read by the caller, the index is used when it is at that state
      * @return true/false
      */
-    bool GetDelegation(const uint160& address, Delegation& delegation, Chainstate& chainstate) const;
+    bool GetDelegation(const uint160& address, Delegation& delegation, Chainstate& chainstate, const uint256& stateRoot) const;
 
     /**
      * @brief VerifyDelegation Verify delegation for an address
@@ -99,6 +101,21 @@ public:
      */
     bool FilterDelegationEvents(std::vector<DelegationEvent>& events, const IDelegationFilter& filter, ChainstateManager &chainman, int fromBlock = 0, int toBlock = -1, int minconf = 0) const;
 
+    /**
+     * @brief GetDelegationEvent Parse a log of the delegation contract
+     * @param log Log entry of a contract execution
+     * @param event Output delegation event
+     * @return true when the log is an AddDelegation or RemoveDelegation event
+     */
+    bool GetDelegationEvent(const dev::eth::LogEntry& log, DelegationEvent& event) const;
+
+    /**
+     * @brief BuildDelegationIndex Build the delegation index from the stored logs of the delegation contract
+     * @param chainman Chain state manager
+     * @return true/false
+     */
+    bool BuildDelegationIndex(ChainstateManager &chainman) const;
+
     /**
      * @brief DelegationsFromEvents Get the delegations from the events
      * @param events Delegation event list
@@ -22,7 +22,19 @@ OdanState::OdanState() : dev::eth::State(dev::Invalid256, dev::OverlayDB(), dev:
     stateUTXO = SecureTrieDB<Address, OverlayDB>(&dbUTXO);
 }
 
+OdanState::OdanState(OdanState const& _s) :
+        State(_s),
+        dbUTXO(_s.dbUTXO),
+        stateUTXO(&dbUTXO, _s.stateUTXO.root(), Verification::Skip),
+        cacheUTXO(_s.cacheUTXO),
+        snapshotUTXO(_s.snapshotUTXO) {
+}
+
 ResultExecute OdanState::execute(EnvInfo const& _envInfo, SealEngineFace const& _sealEngine, OdanTransaction const& _t, CChain& _chain, Permanence _p, OnOpFunc const& _onOp){
+    return execute(_envInfo, _sealEngine, _t, _chain.Height(), _p, _onOp);
+}
+
+ResultExecute OdanState::execute(EnvInfo const& _envInfo, SealEngineFace const& _sealEngine, OdanTransaction const& _t, int _chainHeight, Permanence _p, OnOpFunc const& _onOp){
 
     assert(_t.getVersion().toRaw() == VersionVM::GetEVMDefault().toRaw());
 
@@ -58,7 +70,7 @@ ResultExecute OdanState::execute(EnvInfo const& _envInfo, SealEngineFace const&
         startGasUsed = _envInfo.gasUsed();
         if (!e.execute()){
             e.go(onOp);
-            if(_chain.Height() >= consensusParams.QIP7Height){
+            if(_chainHeight >= consensusParams.QIP7Height){
             	validateTransfersWithChangeLog();
             }
         } else {
@@ -87,8 +99,7 @@ ResultExecute OdanState::execute(EnvInfo const& _envInfo, SealEngineFace const&
                 printfErrorLog(res.excepted);
             }
 
-            odan::commit(cacheUTXO, stateUTXO, m_cache);
-            cacheUTXO.clear();
+            commitUTXO();
             bool removeEmptyAccounts = _envInfo.number() >= _sealEngine.chainParams().EIP158ForkBlock;
             commit(removeEmptyAccounts ? State::CommitBehaviour::RemoveEmptyAccounts : State::CommitBehaviour::KeepEmptyAccounts);
         }
@@ -97,7 +108,7 @@ ResultExecute OdanState::execute(EnvInfo const& _envInfo, SealEngineFace const&
         printfErrorLog(dev::eth::toTransactionException(_e));
         res.excepted = dev::eth::toTransactionException(_e);
         res.gasUsed = _t.gas();
-        if(_chain.Height() < consensusParams.nFixUTXOCacheHFHeight  && _p != Permanence::Reverted){
+        if(_chainHeight < consensusParams.nFixUTXOCacheHFHeight  && _p != Permanence::Reverted){
             deleteAccounts(_sealEngine.deleteAddresses);
             commit(CommitBehaviour::RemoveEmptyAccounts);
         } else {
@@ -161,9 +172,16 @@ Vin const* OdanState::vin(dev::Address const& _a) const
 
 Vin* OdanState::vin(dev::Address const& _addr)
 {
+    if (utxoRecorder)
+        utxoRecorder->insert(_addr);
     auto it = cacheUTXO.find(_addr);
     if (it == cacheUTXO.end()){
-        std::string stateBack = stateUTXO.at(_addr);
+        std::string stateBack;
+        dev::bytes snapshotBack;
+        if (snapshotUTXO.entry(stateUTXO.root(), dev::sha3(_addr), snapshotBack))
+            stateBack = dev::asString(snapshotBack);
+        else
+            stateBack = stateUTXO.at(_addr);
         if (stateBack.empty())
             return nullptr;
             
@@ -291,6 +309,128 @@ void OdanState::validateTransfersWithChangeLog(){
 	transfers=validatedTransfers;
 }
 
+void OdanState::setSnapshotProviders(dev::eth::SnapshotProvider const* _state, dev::eth::SnapshotProvider const* _utxo){
+    setSnapshotProvider(_state);
+    snapshotUTXO.setProvider(_utxo);
+}
+
+void OdanState::commitUTXO(){
+    dev::eth::SnapshotDiff* diff = snapshotUTXO.beginCommit(stateUTXO.root());
+    odan::commit(cacheUTXO, stateUTXO, m_cache, diff);
+    snapshotUTXO.endCommit(stateUTXO.root());
+    cacheUTXO.clear();
+}
+
+void OdanState::setAccessRecorder(OdanStateKeys* _keys){
+    State::setAccessRecorder(_keys ? &_keys->state : nullptr);
+    utxoRecorder = _keys ? &_keys->utxos : nullptr;
+}
+
+static u256 storageValueAt(SecureTrieDB<h256, OverlayDB> const& _storage, u256 const& _key){
+    std::string const value = _storage.at(h256(_key));
+    return value.empty() ? u256(0) : RLP(value).toInt<u256>();
+}
+
+OdanStateDiff OdanState::diff(OdanStateKeys const& _keys, h256 const& _root, h256 const& _rootUTXO){
+    OdanStateDiff ret;
+    SecureTrieDB<Address, OverlayDB> before(&m_db, _root, Verification::Skip);
+    for(Address const& addr : _keys.state.accounts){
+        std::string const pre = before.at(addr);
+        std::string const post = m_state.at(addr);
+        if(pre == post)
+            continue;
+
+        OdanAccountDiff& d = ret.accounts[addr];
+        if(post.empty()){
+            d.fieldsChanged = true;
+            continue;
+        }
+
+        // [nonce, balance, storageRoot, codeHash(, version)], see dev::eth::commit
+        RLP postState(post);
+        d.alive = true;
+        d.nonce = postState[0].toInt<u256>();
+        d.balance = postState[1].toInt<u256>();
+        h256 const storageRoot = postState[2].toHash<h256>();
+        d.codeHash = postState[3].toHash<h256>();
+        d.version = postState[4] ? postState[4].toInt<u256>() : 0;
+
+        h256 preStorageRoot = EmptyTrie;
+        h256 preCodeHash = EmptySHA3;
+        if(pre.empty()){
+            d.fieldsChanged = true;
+        } else {
+            RLP preState(pre);
+            preStorageRoot = preState[2].toHash<h256>();
+            preCodeHash = preState[3].toHash<h256>();
+            d.fieldsChanged = d.nonce != preState[0].toInt<u256>() || d.balance != preState[1].toInt<u256>() ||
+                    d.codeHash != preCodeHash || d.version != (preState[4] ? preState[4].toInt<u256>() : 0);
+        }
+        if(d.codeHash != preCodeHash && d.codeHash != EmptySHA3)
+            d.code = asBytes(m_db.lookup(d.codeHash));
+
+        if(storageRoot != preStorageRoot){
+            SecureTrieDB<h256, OverlayDB> preStorage(&m_db, preStorageRoot, Verification::Skip);
+            SecureTrieDB<h256, OverlayDB> postStorage(&m_db, storageRoot, Verification::Skip);
+            for(auto it = _keys.state.storage.lower_bound(std::make_pair(addr, u256(0))); it != _keys.state.storage.end() && it->first == addr; ++it){
+                u256 const value = storageValueAt(postStorage, it->second);
+                if(value != storageValueAt(preStorage, it->second))
+                    d.storage[it->second] = value;
+            }
+            // Make sure the accessed slots account for the whole change of the storage root
+            for(auto const& slot : d.storage){
+                if(slot.second)
+                    preStorage.insert(h256(slot.first), rlp(slot.second));
+                else
+                    preStorage.remove(h256(slot.first));
+            }
+            d.resetStorage = preStorage.root() != storageRoot;
+        }
+    }
+
+    SecureTrieDB<Address, OverlayDB> beforeUTXO(&dbUTXO, _rootUTXO, Verification::Skip);
+    for(Address const& addr : _keys.utxos){
+        std::string const pre = beforeUTXO.at(addr);
+        std::string const post = stateUTXO.at(addr);
+        if(pre == post)
+            continue;
+
+        if(post.empty()){
+            ret.vins[addr] = Vin{h256(), 0, 0, 0};
+        } else {
+            RLP state(post);
+            ret.vins[addr] = Vin{state[0].toHash<h256>(), state[1].toInt<uint32_t>(), state[2].toInt<u256>(), state[3].toInt<uint8_t>()};
+        }
+    }
+    return ret;
+}
+
+void OdanState::applyDiff(OdanStateDiff const& _diff){
+    for(auto const& i : _diff.accounts){
+        OdanAccountDiff const& d = i.second;
+        assert(!d.resetStorage);
+        if(d.alive){
+            // Rebase the changed slots on the current storage of the account
+            Account a(d.nonce, d.balance, storageRoot(i.first), d.codeHash, d.version, Account::Changed);
+            for(auto const& slot : d.storage)
+                a.setStorage(slot.first, slot.second);
+            if(!d.code.empty())
+                m_db.insert(d.codeHash, &d.code);
+            m_cache[i.first] = std::move(a);
+        } else {
+            Account a;
+            a.kill();
+            m_cache[i.first] = std::move(a);
+        }
+        m_nonExistingAccountsCache.erase(i.first);
+    }
+    for(auto const& i : _diff.vins)
+        cacheUTXO[i.first] = i.second;
+
+    commitUTXO();
+    commit(CommitBehaviour::KeepEmptyAccounts);
+}
+
 void OdanState::deployDelegationsContract(){
     dev::Address delegationsAddress = uintToh160(Params().GetConsensus().delegationsAddress);
     if(!OdanState::addressInUse(delegationsAddress)){
@@ -301,6 +441,39 @@ void OdanState::deployDelegationsContract(){
     }
 }
 ///////////////////////////////////////////////////////////////////////////////////////////
+bool OdanStateKeys::intersects(OdanStateKeys const& _written) const{
+    for(Address const& addr : state.accounts)
+        if(_written.state.accounts.count(addr))
+            return true;
+    for(auto const& slot : state.storage)
+        if(_written.state.storage.count(slot))
+            return true;
+    for(Address const& addr : utxos)
+        if(_written.utxos.count(addr))
+            return true;
+    return false;
+}
+
+void OdanStateKeys::insert(OdanStateKeys const& _keys){
+    state.accounts.insert(_keys.state.accounts.begin(), _keys.state.accounts.end());
+    state.storage.insert(_keys.state.storage.begin(), _keys.state.storage.end());
+    utxos.insert(_keys.utxos.begin(), _keys.utxos.end());
+}
+
+OdanStateKeys OdanStateDiff::writtenKeys() const{
+    OdanStateKeys ret;
+    for(auto const& i : accounts){
+        // A storage change without known slots can only be tracked at account level
+        if(i.second.fieldsChanged || i.second.resetStorage)
+            ret.state.accounts.insert(i.first);
+        for(auto const& slot : i.second.storage)
+            ret.state.storage.emplace(i.first, slot.first);
+    }
+    for(auto const& i : vins)
+        ret.utxos.insert(i.first);
+    return ret;
+}
+///////////////////////////////////////////////////////////////////////////////////////////
 CTransaction CondensingTX::createCondensingTX(){
     selectionVin();
     calculatePlusAndMinus();
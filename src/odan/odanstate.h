@@ -50,18 +50,55 @@ struct ResultExecute{
     CTransaction tx;
 };
 
+/// Accounts, storage slots and UTXO-trie entries accessed by a contract execution
+struct OdanStateKeys{
+    dev::eth::StateAccess state;
+    dev::AddressHash utxos;
+
+    /// @returns true if any of these keys was written in @p _written
+    bool intersects(OdanStateKeys const& _written) const;
+
+    void insert(OdanStateKeys const& _keys);
+};
+
+struct OdanAccountDiff{
+    bool alive = false;
+    /// Nonce, balance, code or existence of the account changed
+    bool fieldsChanged = false;
+    /// The storage root changed in a way the accessed slots do not explain (e.g. cleared storage)
+    bool resetStorage = false;
+    dev::u256 nonce;
+    dev::u256 balance;
+    dev::h256 codeHash;
+    dev::u256 version;
+    dev::bytes code;
+    std::map<dev::u256, dev::u256> storage;
+};
+
+/// Changes made to the account and UTXO tries, as produced by OdanState::diff
+struct OdanStateDiff{
+    std::unordered_map<dev::Address, OdanAccountDiff> accounts;
+    std::unordered_map<dev::Address, Vin> vins;
+
+    OdanStateKeys writtenKeys() const;
+};
+
 namespace odan{
     template <class DB>
-    dev::AddressHash commit(std::unordered_map<dev::Address, Vin> const& _cache, dev::eth::SecureTrieDB<dev::Address, DB>& _state, std::unordered_map<dev::Address, dev::eth::Account> const& _cacheAcc)
+    dev::AddressHash commit(std::unordered_map<dev::Address, Vin> const& _cache, dev::eth::SecureTrieDB<dev::Address, DB>& _state, std::unordered_map<dev::Address, dev::eth::Account> const& _cacheAcc, dev::eth::SnapshotDiff* _diff = nullptr)
     {
         dev::AddressHash ret;
         for (auto const& i: _cache){
             if(i.second.alive == 0){
                  _state.remove(i.first);
+                 if(_diff)
+                     _diff->entries[dev::sha3(i.first)].clear();
             } else {
                 dev::RLPStream s(4);
                 s << i.second.hash << i.second.nVout << i.second.value << i.second.alive;
                 _state.insert(i.first, &s.out());
+                if(_diff)
+                    _diff->entries[dev::sha3(i.first)] = s.out();
             }
             ret.insert(i.first);
         }
@@ -79,8 +116,13 @@ public:
 
     OdanState(dev::u256 const& _accountStartNonce, dev::OverlayDB const& _db, const std::string& _path, dev::eth::BaseState _bs = dev::eth::BaseState::PreExisting);
 
+    OdanState(OdanState const& _s);
+
     ResultExecute execute(dev::eth::EnvInfo const& _envInfo, dev::eth::SealEngineFace const& _sealEngine, OdanTransaction const& _t, CChain& _chain, dev::eth::Permanence _p = dev::eth::Permanence::Committed, dev::eth::OnOpFunc const& _onOp = OnOpFunc());
 
+    /// Same as above without accessing the chain, @p _chainHeight is the height of its tip
+    ResultExecute execute(dev::eth::EnvInfo const& _envInfo, dev::eth::SealEngineFace const& _sealEngine, OdanTransaction const& _t, int _chainHeight, dev::eth::Permanence _p = dev::eth::Permanence::Committed, dev::eth::OnOpFunc const& _onOp = OnOpFunc());
+
     void setRootUTXO(dev::h256 const& _r) { cacheUTXO.clear(); stateUTXO.setRoot(_r); }
 
     void setCacheUTXO(dev::Address const& address, Vin const& vin) { cacheUTXO.insert(std::make_pair(address, vin)); }
@@ -112,6 +154,20 @@ public:
 
     void deployDelegationsContract();
 
+    /// Record the accounts, storage slots and UTXO entries accessed from now on into @p _keys (nullptr to stop)
+    void setAccessRecorder(OdanStateKeys* _keys);
+
+    /// @returns the changes of the recorded @p _keys since the state had the roots @p _root and @p _rootUTXO
+    OdanStateDiff diff(OdanStateKeys const& _keys, dev::h256 const& _root, dev::h256 const& _rootUTXO);
+
+    /// Apply and commit changes computed by diff() on another state with the same base
+    void applyDiff(OdanStateDiff const& _diff);
+
+    /// Read the state and the UTXO trie from the snapshot layers of the providers when they have their roots
+    void setSnapshotProviders(dev::eth::SnapshotProvider const* _state, dev::eth::SnapshotProvider const* _utxo);
+
+    dev::eth::SnapshotView& snapshotViewUTXO() { return snapshotUTXO; }
+
     virtual ~OdanState(){}
 
     friend CondensingTX;
@@ -134,6 +190,9 @@ private:
 
     void updateUTXO(const std::unordered_map<dev::Address, Vin>& vins);
 
+    /// Commit the UTXO cache to the UTXO trie
+    void commitUTXO();
+
     void printfErrorLog(const dev::eth::TransactionException er);
 
     dev::Address newAddress;
@@ -146,6 +205,10 @@ private:
 
 	std::unordered_map<dev::Address, Vin> cacheUTXO;
 
+	dev::eth::SnapshotView snapshotUTXO;
+
+	dev::AddressHash* utxoRecorder = nullptr;
+
 	void validateTransfersWithChangeLog();
 };
 
@@ -0,0 +1,153 @@
+#include <odan/parallelexec.h>
+#include <logging.h>
+
+#include <atomic>
+
+static bool SameOdanTransactions(const std::vector<OdanTransaction>& a, const std::vector<OdanTransaction>& b)
+{
+    if(a.size() != b.size())
+        return false;
+    for(size_t i = 0; i < a.size(); i++){
+        if(a[i].getVersion().toRaw() != b[i].getVersion().toRaw() || a[i].isCreation() != b[i].isCreation() ||
+           a[i].sender() != b[i].sender() || a[i].receiveAddress() != b[i].receiveAddress() ||
+           a[i].value() != b[i].value() || a[i].gas() != b[i].gas() || a[i].gasPrice() != b[i].gasPrice() ||
+           a[i].data() != b[i].data() || a[i].getHashWith() != b[i].getHashWith() ||
+           a[i].getNVout() != b[i].getNVout() || a[i].getRefundSender() != b[i].getRefundSender())
+            return false;
+    }
+    return true;
+}
+
+bool CContractExecCheck::operator()()
+{
+    exec->ExecuteJob(*job);
+    // A failed speculation is not an error, the transaction is executed again in block order
+    return true;
+}
+
+ParallelContractExec::ParallelContractExec(const CBlock& _block, CBlockIndex* _pindexPrev, const uint64_t _blockGasLimit, CChain& _chain) :
+    envExec(_block, std::vector<OdanTransaction>(), _blockGasLimit, _pindexPrev, _chain),
+    envInfo(envExec.BuildEVMEnvironment()),
+    chain(_chain),
+    base(new OdanState(*globalState)) {}
+
+void ParallelContractExec::Add(unsigned int nTx, std::vector<OdanTransaction> txs)
+{
+    ContractExecJob& job = jobs[nTx];
+    job.txs = std::move(txs);
+    // Every job needs its own seal engine as deleteAddresses is modified during the execution
+    job.sealEngine.reset(dev::eth::SealEngineRegistrar::create(globalSealEngine->chainParams()));
+    job.sealEngine->setOdanSchedule(globalSealEngine->getOdanSchedule());
+}
+
+void ParallelContractExec::Run(CCheckQueue<CContractExecCheck>& queue)
+{
+    // Nothing can run in parallel with a single contract transaction
+    if(jobs.size() < 2)
+        return;
+
+    std::vector<CContractExecCheck> vChecks;
+    vChecks.reserve(jobs.size());
+    for(auto& job : jobs)
+        vChecks.emplace_back(*this, job.second);
+
+    CCheckQueueControl<CContractExecCheck> control(&queue);
+    control.Add(std::move(vChecks));
+    control.Wait();
+}
+
+void ParallelContractExec::ExecuteJob(ContractExecJob& job) const
+{
+    std::atomic<bool> contextRead{false};
+    dev::eth::EnvInfo jobEnvInfo(envInfo);
+    jobEnvInfo.setBlockContextFlag(&contextRead);
+    try{
+        OdanState state(*base);
+        state.clearTransientStorage();
+        for(const OdanTransaction& tx : job.txs){
+            if(tx.getVersion().toRaw() != VersionVM::GetEVMDefault().toRaw()){
+                return;
+            }
+
+            OdanStateKeys keys;
+            dev::h256 oldHashStateRoot(state.rootHash());
+            dev::h256 oldHashUTXORoot(state.rootHashUTXO());
+            state.setAccessRecorder(&keys);
+            if(!tx.isCreation() && !state.addressInUse(tx.receiveAddress())){
+                dev::eth::ExecutionResult execRes;
+                execRes.excepted = dev::eth::TransactionException::Unknown;
+                job.result.push_back(ResultExecute{execRes, OdanTransactionReceipt(dev::h256(), dev::h256(), dev::u256(), dev::eth::LogEntries()), CTransaction()});
+                job.executed.push_back(false);
+            } else {
+                job.result.push_back(state.execute(jobEnvInfo, *job.sealEngine, tx, chain, dev::eth::Permanence::Committed, OnOpFunc()));
+                job.executed.push_back(true);
+            }
+            state.setAccessRecorder(nullptr);
+
+            OdanStateDiff diff = state.diff(keys, oldHashStateRoot, oldHashUTXORoot);
+            for(auto const& i : diff.accounts){
+                // The new storage root can not be rebuilt on top of another state
+                if(i.second.resetStorage)
+                    return;
+            }
+            job.keys.insert(keys);
+            job.diffs.push_back(std::move(diff));
+        }
+
+        // Leftovers of a failed execution are seen by the next transaction when executed serially
+        if(!state.changeLog().empty())
+            return;
+
+        job.valid = state.unrevertablyTouched() == base->unrevertablyTouched();
+    }
+    catch(const std::exception& e){
+        LogPrint(BCLog::BENCH, "%s: speculative contract execution failed: %s\n", __func__, e.what());
+    }
+    job.blockContextRead = contextRead.load();
+}
+
+bool ParallelContractExec::Execute(unsigned int nTx, const std::vector<OdanTransaction>& txs, ByteCodeExec& exec)
+{
+    auto it = jobs.find(nTx);
+    if(it != jobs.end() && it->second.valid && SameOdanTransactions(it->second.txs, txs) &&
+       globalState->changeLog().empty() && globalState->unrevertablyTouched() == base->unrevertablyTouched() &&
+       !it->second.keys.intersects(written)){
+        ContractExecJob& job = it->second;
+        std::vector<ResultExecute>& result = exec.getResult();
+        for(size_t i = 0; i < job.result.size(); i++){
+            ResultExecute& res = job.result[i];
+            if(job.executed[i]){
+                globalState->applyDiff(job.diffs[i]);
+                res.txRec = OdanTransactionReceipt(globalState->rootHash(), globalState->rootHashUTXO(), res.txRec.cumulativeGasUsed(), res.txRec.log());
+            }
+            written.insert(job.diffs[i].writtenKeys());
+            result.push_back(std::move(res));
+        }
+        globalState->db().commit();
+        globalState->dbUtxo().commit();
+        exec.addBlockContextRead(job.blockContextRead);
+        jobs.erase(it);
+        nApplied++;
+        return true;
+    }
+
+    // Conflicting or not executed speculatively, execute it on the current state
+    OdanStateKeys keys;
+    dev::h256 oldHashStateRoot(globalState->rootHash());
+    dev::h256 oldHashUTXORoot(globalState->rootHashUTXO());
+    globalState->setAccessRecorder(&keys);
+    bool ret = false;
+    try{
+        ret = exec.performByteCode();
+    }
+    catch(...){
+        globalState->setAccessRecorder(nullptr);
+        throw;
+    }
+    globalState->setAccessRecorder(nullptr);
+    written.insert(globalState->diff(keys, oldHashStateRoot, oldHashUTXORoot).writtenKeys());
+    if(it != jobs.end())
+        jobs.erase(it);
+    nReexecuted++;
+    return ret;
+}
@@ -0,0 +1,85 @@
+#ifndef ODANPARALLELEXEC_H
+#define ODANPARALLELEXEC_H
+
+#include <checkqueue.h>
+#include <odan/odanstate.h>
+#include <validation.h>
+
+#include <map>
+#include <memory>
+#include <vector>
+
+/** Speculative execution of the contract outputs of one block transaction */
+struct ContractExecJob{
+    std::vector<OdanTransaction> txs;
+    std::unique_ptr<dev::eth::SealEngineFace> sealEngine;
+    std::vector<ResultExecute> result;
+    /** Changes made by each output, empty for outputs that were not executed */
+    std::vector<OdanStateDiff> diffs;
+    std::vector<bool> executed;
+    /** Everything the outputs read or wrote */
+    OdanStateKeys keys;
+    /** Whether an output read the block context, merged into the ByteCodeExec when the job is applied */
+    bool blockContextRead = false;
+    bool valid = false;
+};
+
+/**
+ * Optimistic parallel execution of the contract transactions of a block.
+ *
+ * Every contract transaction is executed on a worker thread against its own copy of the
+ * state at the start of the block, recording the accounts, storage slots and UTXO-trie
+ * entries it accesses. Execute() is then called in block order: a speculative result is
+ * applied to globalState when none of the keys it accessed was written by an earlier
+ * transaction of the block, otherwise the transaction is executed again on globalState.
+ * The resulting state, receipts and condensing transactions are identical to the serial ones.
+ */
+class ParallelContractExec {
+
+public:
+
+    ParallelContractExec(const CBlock& _block, CBlockIndex* _pindexPrev, const uint64_t _blockGasLimit, CChain& _chain);
+
+    ParallelContractExec(const ParallelContractExec&) = delete;
+    ParallelContractExec& operator=(const ParallelContractExec&) = delete;
+
+    /** Queue the contract outputs of the block transaction at index nTx */
+    void Add(unsigned int nTx, std::vector<OdanTransaction> txs);
+
+    /** Speculatively execute the queued transactions, blocks until all of them are done */
+    void Run(CCheckQueue<CContractExecCheck>& queue);
+
+    /** Execute the outputs of the block transaction at index nTx on globalState in place of exec.performByteCode() */
+    bool Execute(unsigned int nTx, const std::vector<OdanTransaction>& txs, ByteCodeExec& exec);
+
+    /** Worker side of Run() */
+    void ExecuteJob(ContractExecJob& job) const;
+
+    unsigned int GetApplied() const { return nApplied; }
+
+    unsigned int GetReexecuted() const { return nReexecuted; }
+
+private:
+
+    /** Keeps the LastHashes referenced by envInfo alive */
+    ByteCodeExec envExec;
+
+    /** Copied by every job, each copy points to the block context flag of its job */
+    dev::eth::EnvInfo envInfo;
+
+    CChain& chain;
+
+    /** globalState at the start of the block, copied by every job */
+    std::unique_ptr<OdanState> base;
+
+    std::map<unsigned int, ContractExecJob> jobs;
+
+    /** Keys written so far by the transactions of the block */
+    OdanStateKeys written;
+
+    unsigned int nApplied = 0;
+
+    unsigned int nReexecuted = 0;
+};
+
+#endif
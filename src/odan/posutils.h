@@ -3,6 +3,7 @@
 
 #include <uint256.h>
 #include <consensus/amount.h>
+#include <serialize.h>
 
 struct CStakeCache{
     CStakeCache(uint32_t blockFromTime_, CAmount amount_) : blockFromTime(blockFromTime_), amount(amount_){
@@ -29,6 +30,8 @@ struct Delegation
     uint8_t fee;
     uint32_t blockHeight;
     std::vector<unsigned char> PoD; //Proof Of Delegation
+
+    SERIALIZE_METHODS(Delegation, obj) { READWRITE(obj.staker, obj.fee, obj.blockHeight, obj.PoD); }
 };
 
 inline bool operator==(const Delegation& lhs, const Delegation& rhs)
@@ -0,0 +1,223 @@
+#include <odan/receiptfeed.h>
+#include <chain.h>
+#include <serialize.h>
+#include <streams.h>
+#include <validation.h>
+
+#include <algorithm>
+
+namespace {
+
+template <typename Stream, unsigned N>
+void WriteHash(Stream& s, const dev::FixedHash<N>& hash)
+{
+    s.write(MakeByteSpan(hash.asArray()));
+}
+
+template <typename Stream>
+void WriteLog(Stream& s, const dev::eth::LogEntry& log)
+{
+    WriteHash(s, log.address);
+    WriteCompactSize(s, log.topics.size());
+    for (const dev::h256& topic : log.topics)
+        WriteHash(s, topic);
+    s << log.data;
+}
+
+template <typename Stream>
+void WriteReceipt(Stream& s, const TransactionReceiptInfo& receipt)
+{
+    s << receipt.transactionHash << receipt.transactionIndex << receipt.outputIndex;
+    WriteHash(s, receipt.from);
+    WriteHash(s, receipt.to);
+    WriteHash(s, receipt.contractAddress);
+    s << receipt.cumulativeGasUsed << receipt.gasUsed << uint32_t(receipt.excepted) << receipt.exceptedMessage;
+    WriteHash(s, receipt.stateRoot);
+    WriteHash(s, receipt.utxoRoot);
+    WriteCompactSize(s, receipt.logs.size());
+    for (const dev::eth::LogEntry& log : receipt.logs)
+        WriteLog(s, log);
+}
+
+std::string Header(const BlockReceiptsRecord& block, bool connected)
+{
+    DataStream ss;
+    ss << block.blockHash << block.height << uint8_t(connected ? 'C' : 'D');
+    return ss.str();
+}
+
+}
+
+bool ContractLogFilter::Match(const ContractLogRecord& log) const
+{
+    if(!addresses.empty() && !addresses.count(log.address))
+        return false;
+    for(size_t i = 0; i < topics.size(); i++){
+        if(!topics[i])
+            continue;
+        if(i >= log.topics.size() || log.topics[i] != *topics[i])
+            return false;
+    }
+    return true;
+}
+
+ReceiptFeed::ReceiptFeed(size_t _nBlocks, int tipHeight) :
+    nBlocks(std::max<size_t>(_nBlocks, 1)),
+    nTipHeight(tipHeight)
+{}
+
+void ReceiptFeed::AddBlock(const uint256& hash, uint32_t height, const std::vector<TransactionReceiptInfo>& receipts)
+{
+    auto block = std::make_shared<BlockReceiptsRecord>();
+    block->blockHash = hash;
+    block->height = height;
+    DataStream ss;
+    WriteCompactSize(ss, receipts.size());
+    for(const TransactionReceiptInfo& receipt : receipts){
+        WriteReceipt(ss, receipt);
+        for(size_t i = 0; i < receipt.logs.size(); i++){
+            DataStream log;
+            log << receipt.transactionHash << receipt.transactionIndex << receipt.outputIndex << uint32_t(i);
+            WriteLog(log, receipt.logs[i]);
+            block->logs.push_back(ContractLogRecord{receipt.logs[i].address, receipt.logs[i].topics, log.str()});
+        }
+    }
+    block->receipts = ss.str();
+
+    LOCK(cs);
+    if(!blocks.count(hash))
+        blockOrder.push_back(hash);
+    blocks[hash] = std::move(block);
+    while(blockOrder.size() > nBlocks){
+        blocks.erase(blockOrder.front());
+        blockOrder.pop_front();
+    }
+}
+
+std::shared_ptr<const BlockReceiptsRecord> ReceiptFeed::GetBlock(const uint256& hash) const
+{
+    LOCK(cs);
+    auto it = blocks.find(hash);
+    return it != blocks.end() ? it->second : nullptr;
+}
+
+std::optional<uint64_t> ReceiptFeed::GetCursor(uint32_t height) const
+{
+    LOCK(cs);
+    if(int64_t(height) > nTipHeight)
+        return nSequence;
+    // The latest connection at that height is the one of the active chain
+    for(auto it = events.rbegin(); it != events.rend(); ++it){
+        if(it->connected && it->block->height == height)
+            return it->sequence - 1;
+    }
+    return std::nullopt;
+}
+
+bool ReceiptFeed::Wait(uint64_t& cursor, std::vector<ReceiptFeedEvent>& out, std::chrono::milliseconds timeout)
+{
+    WAIT_LOCK(cs, lock);
+    cond.wait_for(lock, timeout, [&]() EXCLUSIVE_LOCKS_REQUIRED(cs) { return fInterrupted || nSequence > cursor; });
+    if(fInterrupted)
+        return false;
+    if(nSequence == cursor)
+        return true;
+    if(events.empty() || events.front().sequence > cursor + 1)
+        return false;
+    for(const ReceiptFeedEvent& event : events){
+        if(event.sequence > cursor)
+            out.push_back(event);
+    }
+    cursor = nSequence;
+    return true;
+}
+
+void ReceiptFeed::Interrupt()
+{
+    {
+        LOCK(cs);
+        fInterrupted = true;
+    }
+    cond.notify_all();
+}
+
+std::optional<std::string> ReceiptFeed::GetReceiptsMessage(const uint256& hash, bool connected) const
+{
+    std::shared_ptr<const BlockReceiptsRecord> block = GetBlock(hash);
+    if(!block)
+        return std::nullopt;
+    return ReceiptsMessage(ReceiptFeedEvent{0, connected, block});
+}
+
+std::vector<std::pair<std::string, std::string>> ReceiptFeed::GetContractLogMessages(const uint256& hash, bool connected) const
+{
+    std::vector<std::pair<std::string, std::string>> messages;
+    std::shared_ptr<const BlockReceiptsRecord> block = GetBlock(hash);
+    if(!block)
+        return messages;
+    const std::string header = Header(*block, connected);
+    for(const ContractLogRecord& log : block->logs){
+        DataStream subtopic;
+        WriteHash(subtopic, log.address);
+        if(!log.topics.empty())
+            WriteHash(subtopic, log.topics[0]);
+        messages.emplace_back(subtopic.str(), header + log.serialized);
+    }
+    return messages;
+}
+
+void ReceiptFeed::BlockConnected(ChainstateRole role, const std::shared_ptr<const CBlock>& block, const CBlockIndex* pindex)
+{
+    if(role == ChainstateRole::BACKGROUND)
+        return;
+    Push(true, pindex->GetBlockHash(), pindex->nHeight);
+}
+
+void ReceiptFeed::BlockDisconnected(const std::shared_ptr<const CBlock>& block, const CBlockIndex* pindex)
+{
+    Push(false, pindex->GetBlockHash(), pindex->nHeight);
+}
+
+void ReceiptFeed::Push(bool connected, const uint256& hash, uint32_t height)
+{
+    {
+        LOCK(cs);
+        std::shared_ptr<const BlockReceiptsRecord> block;
+        auto it = blocks.find(hash);
+        if(it != blocks.end()){
+            block = it->second;
+        } else {
+            // Connected before the feed started or no longer kept, the receipts are not known
+            auto empty = std::make_shared<BlockReceiptsRecord>();
+            empty->blockHash = hash;
+            empty->height = height;
+            empty->receipts = std::string(1, '\0');
+            block = std::move(empty);
+        }
+        events.push_back(ReceiptFeedEvent{++nSequence, connected, std::move(block)});
+        nTipHeight = connected ? int(height) : int(height) - 1;
+        while(events.size() > nBlocks)
+            events.pop_front();
+    }
+    cond.notify_all();
+}
+
+std::string ReceiptsMessage(const ReceiptFeedEvent& event)
+{
+    return Header(*event.block, event.connected) + event.block->receipts;
+}
+
+std::string ContractLogsMessage(const ReceiptFeedEvent& event, const ContractLogFilter& filter)
+{
+    std::vector<const ContractLogRecord*> logs;
+    for(const ContractLogRecord& log : event.block->logs){
+        if(filter.Match(log))
+            logs.push_back(&log);
+    }
+    DataStream ss;
+    WriteCompactSize(ss, logs.size());
+    std::string message = Header(*event.block, event.connected) + ss.str();
+    for(const ContractLogRecord* log : logs)
+        message += log->serialized;
+    return message;
+}
@@ -0,0 +1,130 @@
+#ifndef ODANRECEIPTFEED_H
+#define ODANRECEIPTFEED_H
+
+#include <libdevcore/Address.h>
+#include <libdevcore/FixedHash.h>
+#include <sync.h>
+#include <uint256.h>
+#include <validationinterface.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <memory>
+#include <optional>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+struct TransactionReceiptInfo;
+
+/** Default for -receiptfeed, number of blocks kept for the receipt streams, 0 disables the feed */
+static const int DEFAULT_RECEIPT_FEED = 0;
+/** Number of blocks kept when the feed is enabled by a ZMQ receipt topic */
+static const int DEFAULT_RECEIPT_FEED_ZMQ = 100;
+
+/** A log entry of a block, serialized once for all the subscribers */
+struct ContractLogRecord {
+    dev::Address address;
+    dev::h256s topics;
+    /** Tx hash, tx index, output index, log index, address, topics and data */
+    std::string serialized;
+};
+
+/** The receipts of a block, serialized once for all the subscribers */
+struct BlockReceiptsRecord {
+    uint256 blockHash;
+    uint32_t height{0};
+    /** Number of receipts followed by the receipts of the contract outputs with their logs */
+    std::string receipts;
+    std::vector<ContractLogRecord> logs;
+};
+
+/** A block connected to or disconnected from the active chain */
+struct ReceiptFeedEvent {
+    uint64_t sequence{0};
+    bool connected{true};
+    std::shared_ptr<const BlockReceiptsRecord> block;
+};
+
+/** Address and positional topic filter of a subscriber, with the semantics of the waitforlogs filter */
+struct ContractLogFilter {
+    std::set<dev::Address> addresses;
+    std::vector<std::optional<dev::h256>> topics;
+
+    bool Match(const ContractLogRecord& log) const;
+};
+
+/**
+ * Push based stream of the contract receipts of the active chain.
+ *
+ * ConnectBlock hands over the receipts of a block, which are serialized once in a record shared
+ * by every subscriber. The connection and disconnection of the blocks are then appended to a
+ * bounded sequence of events, which the REST streams follow with a cursor and the ZMQ notifiers
+ * publish. A subscriber that falls behind the kept events has to reconnect.
+ *
+ * Messages start with the block hash, the height as a 32 bit little endian integer and 'C' for a
+ * connected block or 'D' for a disconnected one. The receipts message follows with the receipts
+ * of the block, the contract log messages with the number of logs and the logs.
+ */
+class ReceiptFeed final : public CValidationInterface {
+
+public:
+
+    ReceiptFeed(size_t _nBlocks, int tipHeight);
+
+    /** Serialize the receipts of a block, called by ConnectBlock */
+    void AddBlock(const uint256& hash, uint32_t height, const std::vector<TransactionReceiptInfo>& receipts) EXCLUSIVE_LOCKS_REQUIRED(!cs);
+
+    /** The record of a recently connected block */
+    std::shared_ptr<const BlockReceiptsRecord> GetBlock(const uint256& hash) const EXCLUSIVE_LOCKS_REQUIRED(!cs);
+
+    /** The cursor to follow the events of the blocks from height, nullopt when that height is no longer kept */
+    std::optional<uint64_t> GetCursor(uint32_t height) const EXCLUSIVE_LOCKS_REQUIRED(!cs);
+
+    /**
+     * Append the events after the cursor and advance it, waiting up to timeout for one.
+     * Returns false when the feed is interrupted or the cursor fell behind the kept events.
+     */
+    bool Wait(uint64_t& cursor, std::vector<ReceiptFeedEvent>& out, std::chrono::milliseconds timeout) EXCLUSIVE_LOCKS_REQUIRED(!cs);
+
+    void Interrupt() EXCLUSIVE_LOCKS_REQUIRED(!cs);
+
+    /** The receipts message of a block, nullopt when the block is not kept */
+    std::optional<std::string> GetReceiptsMessage(const uint256& hash, bool connected) const EXCLUSIVE_LOCKS_REQUIRED(!cs);
+
+    /** One message per log entry of a block, with the contract address and the first topic as subtopic */
+    std::vector<std::pair<std::string, std::string>> GetContractLogMessages(const uint256& hash, bool connected) const EXCLUSIVE_LOCKS_REQUIRED(!cs);
+
+protected:
+
+    void BlockConnected(ChainstateRole role, const std::shared_ptr<const CBlock>& block, const CBlockIndex* pindex) override EXCLUSIVE_LOCKS_REQUIRED(!cs);
+
+    void BlockDisconnected(const std::shared_ptr<const CBlock>& block, const CBlockIndex* pindex) override EXCLUSIVE_LOCKS_REQUIRED(!cs);
+
+private:
+
+    void Push(bool connected, const uint256& hash, uint32_t height) EXCLUSIVE_LOCKS_REQUIRED(!cs);
+
+    const size_t nBlocks;
+
+    mutable Mutex cs;
+    std::condition_variable cond;
+    /** Records of the recent blocks, by hash and in the order they were added */
+    std::map<uint256, std::shared_ptr<const BlockReceiptsRecord>> blocks GUARDED_BY(cs);
+    std::deque<uint256> blockOrder GUARDED_BY(cs);
+    std::deque<ReceiptFeedEvent> events GUARDED_BY(cs);
+    uint64_t nSequence GUARDED_BY(cs){0};
+    int nTipHeight GUARDED_BY(cs);
+    bool fInterrupted GUARDED_BY(cs){false};
+};
+
+/** The receipts message of an event */
+std::string ReceiptsMessage(const ReceiptFeedEvent& event);
+
+/** The message of the logs of an event that match the filter */
+std::string ContractLogsMessage(const ReceiptFeedEvent& event, const ContractLogFilter& filter);
+
+#endif
@@ -0,0 +1,600 @@
+#include <odan/stateprune.h>
+#include <odan/odanstate.h>
+#include <crypto/common.h>
+#include <logging.h>
+
+#include <libdevcore/DBFactory.h>
+#include <libdevcore/SHA3.h>
+
+#include <boost/filesystem.hpp>
+
+#include <set>
+#include <unordered_set>
+
+using namespace dev;
+
+static const std::string PRUNE_META_KEY = "prunestate";
+static const std::string PRUNE_JOURNAL_KEY = "prunejournal";
+static const char NODE_REF_SUFFIX = char(0xfe);
+static const char NODE_AUX_SUFFIX = char(0xff);
+
+/** Number of counts kept in memory while the counts are built */
+static const size_t PRUNE_BUILD_COUNTS = 1000000;
+/** Number of writes in one batch of the long running operations */
+static const size_t PRUNE_BATCH_SIZE = 10000;
+
+static db::Slice toSlice(const std::string& str)
+{
+    return db::Slice(str.data(), str.size());
+}
+
+static db::Slice toSlice(const h256& hash)
+{
+    return db::Slice(reinterpret_cast<const char*>(hash.data()), hash.size);
+}
+
+static std::string refKey(const h256& hash)
+{
+    std::string key(reinterpret_cast<const char*>(hash.data()), hash.size);
+    key.push_back(NODE_REF_SUFFIX);
+    return key;
+}
+
+static std::string journalKey(int nHeight)
+{
+    unsigned char height[4];
+    WriteBE32(height, nHeight);
+    return PRUNE_JOURNAL_KEY + std::string(reinterpret_cast<const char*>(height), sizeof(height));
+}
+
+static bool readRef(const db::DatabaseFace& db, const h256& hash, StateNodeRef& ref)
+{
+    std::string value = db.lookup(toSlice(refKey(hash)));
+    if(value.empty())
+        return false;
+    RLP r(value);
+    ref.count = r[0].toInt<uint32_t>();
+    ref.released = r[1].toInt<int64_t>();
+    return true;
+}
+
+static void writeRef(db::WriteBatchFace& batch, const h256& hash, const StateNodeRef& ref)
+{
+    RLPStream s(2);
+    s << ref.count << ref.released;
+    batch.insert(toSlice(refKey(hash)), db::Slice(reinterpret_cast<const char*>(s.out().data()), s.out().size()));
+}
+
+/** The counts read and changed by one operation, written with its batch */
+class StateRefCache{
+
+public:
+
+    explicit StateRefCache(const db::DatabaseFace& _db) : db(_db) {}
+
+    StateNodeRef& Get(const h256& hash){
+        auto it = refs.find(hash);
+        if(it == refs.end()){
+            StateNodeRef ref;
+            readRef(db, hash, ref);
+            it = refs.emplace(hash, ref).first;
+        }
+        erased.erase(hash);
+        return it->second;
+    }
+
+    void Erase(const h256& hash){
+        refs.erase(hash);
+        erased.insert(hash);
+    }
+
+    void Write(db::WriteBatchFace& batch) const{
+        for(const auto& item : refs)
+            writeRef(batch, item.first, item.second);
+        for(const h256& hash : erased)
+            batch.kill(toSlice(refKey(hash)));
+    }
+
+private:
+
+    const db::DatabaseFace& db;
+    std::map<h256, StateNodeRef> refs;
+    std::set<h256> erased;
+};
+
+static bool walkNode(const db::DatabaseFace& db, const RLP& node, bytes& path,
+                     const std::function<bool(const h256&, const std::string&)>& onNode,
+                     const std::function<bool(const bytes&, bytesConstRef)>& onLeaf);
+
+static bool walkHash(const db::DatabaseFace& db, const h256& hash, bytes& path,
+                     const std::function<bool(const h256&, const std::string&)>& onNode,
+                     const std::function<bool(const bytes&, bytesConstRef)>& onLeaf)
+{
+    // The empty trie is not reference counted by the trie and is never pruned
+    if(hash == EmptyTrie)
+        return true;
+    std::string node = db.lookup(toSlice(hash));
+    if(node.empty())
+        return false;
+    if(!onNode(hash, node))
+        return true;
+    return walkNode(db, RLP(node), path, onNode, onLeaf);
+}
+
+static bool walkRef(const db::DatabaseFace& db, const RLP& ref, bytes& path,
+                    const std::function<bool(const h256&, const std::string&)>& onNode,
+                    const std::function<bool(const bytes&, bytesConstRef)>& onLeaf)
+{
+    // Nodes shorter than 32 bytes are stored in their parent
+    if(ref.isList())
+        return walkNode(db, ref, path, onNode, onLeaf);
+    if(ref.isData() && ref.size() == h256::size)
+        return walkHash(db, ref.toHash<h256>(), path, onNode, onLeaf);
+    return true;
+}
+
+static bool walkNode(const db::DatabaseFace& db, const RLP& node, bytes& path,
+                     const std::function<bool(const h256&, const std::string&)>& onNode,
+                     const std::function<bool(const bytes&, bytesConstRef)>& onLeaf)
+{
+    if(node.itemCount() == 17){
+        for(byte i = 0; i < 16; i++){
+            path.push_back(i);
+            bool ret = walkRef(db, node[i], path, onNode, onLeaf);
+            path.pop_back();
+            if(!ret)
+                return false;
+        }
+        return node[16].isEmpty() || onLeaf(path, node[16].payload());
+    }
+    if(node.itemCount() != 2)
+        return true;
+
+    // Hex prefix encoding of the key: the first nibble holds the leaf and odd length flags
+    bytesConstRef hexPrefix = node[0].payload();
+    if(hexPrefix.empty())
+        return true;
+    size_t size = path.size();
+    if(hexPrefix[0] & 0x10)
+        path.push_back(hexPrefix[0] & 0x0f);
+    for(size_t i = 1; i < hexPrefix.size(); i++){
+        path.push_back(hexPrefix[i] >> 4);
+        path.push_back(hexPrefix[i] & 0x0f);
+    }
+    bool ret = (hexPrefix[0] & 0x20) ? onLeaf(path, node[1].payload()) : walkRef(db, node[1], path, onNode, onLeaf);
+    path.resize(size);
+    return ret;
+}
+
+bool WalkTrie(const db::DatabaseFace& db, const h256& root,
+              const std::function<bool(const h256&, const std::string&)>& onNode,
+              const std::function<bool(const bytes&, bytesConstRef)>& onLeaf)
+{
+    bytes path;
+    return walkHash(db, root, path, onNode, onLeaf);
+}
+
+bool TriePathToHash(const bytes& path, h256& hash)
+{
+    if(path.size() != h256::size * 2)
+        return false;
+    for(size_t i = 0; i < h256::size; i++)
+        hash[i] = (path[2 * i] << 4) | path[2 * i + 1];
+    return true;
+}
+
+/** Storage root and code hash of an account leaf, [nonce, balance, storageRoot, codeHash(, version)] */
+static void accountRefs(bytesConstRef value, h256& storageRoot, h256& codeHash)
+{
+    RLP account(value);
+    storageRoot = account[2].toHash<h256>();
+    codeHash = account[3].toHash<h256>();
+}
+
+bool StatePruner::ReadJournal(const db::DatabaseFace& db, int nHeight, Journal& journal) const
+{
+    std::string value = db.lookup(toSlice(journalKey(nHeight)));
+    if(value.empty())
+        return false;
+    RLP r(value);
+    for(const RLP& item : r[0])
+        journal.added.emplace_back(item[0].toHash<h256>(), item[1].toInt<uint32_t>());
+    for(const RLP& item : r[1])
+        journal.removed.emplace_back(item[0].toHash<h256>(), item[1].toInt<uint32_t>());
+    for(const RLP& item : r[2])
+        journal.released.push_back(item.toHash<h256>());
+    return true;
+}
+
+static void writeJournal(db::WriteBatchFace& batch, int nHeight, const std::vector<std::pair<h256, uint32_t>>& added,
+                         const std::vector<std::pair<h256, uint32_t>>& removed, const std::vector<h256>& released)
+{
+    RLPStream s(3);
+    s.appendList(added.size());
+    for(const auto& item : added)
+        s.appendList(2) << item.first << item.second;
+    s.appendList(removed.size());
+    for(const auto& item : removed)
+        s.appendList(2) << item.first << item.second;
+    s.appendVector(released);
+    std::string key = journalKey(nHeight);
+    batch.insert(toSlice(key), db::Slice(reinterpret_cast<const char*>(s.out().data()), s.out().size()));
+}
+
+void StatePruner::WriteMeta(db::WriteBatchFace& batch) const
+{
+    RLPStream s(3);
+    s << nBase << nOldest << nTip;
+    batch.insert(toSlice(PRUNE_META_KEY), db::Slice(reinterpret_cast<const char*>(s.out().data()), s.out().size()));
+}
+
+bool StatePruner::Load(OverlayDB& db, int nTipHeight)
+{
+    fValid = false;
+    std::string value = db.backend()->lookup(toSlice(PRUNE_META_KEY));
+    if(value.empty())
+        return false;
+    RLP r(value);
+    nBase = r[0].toInt<int>();
+    nOldest = r[1].toInt<int>();
+    nTip = r[2].toInt<int>();
+
+    // The blocks after the tip are connected again, their journals must be there to be undone
+    nTipHeight = std::max(nTipHeight, 0);
+    fValid = nBase <= nTipHeight && nTipHeight <= nTip && nTipHeight + 1 >= nOldest;
+    return fValid;
+}
+
+bool StatePruner::Build(OverlayDB& db, const std::vector<h256>& roots, int nTipHeight)
+{
+    db::DatabaseFace& backend = *db.backend();
+    fValid = false;
+    nTipHeight = std::max(nTipHeight, 0);
+    if(roots.empty())
+        return false;
+
+    // Remove the counts and the journals left by an earlier pruning
+    {
+        auto batch = backend.createWriteBatch();
+        size_t nBatch = 0;
+        backend.forEach([&](db::Slice key, db::Slice) {
+            bool ref = key.size() == h256::size + 1 && key[h256::size] == NODE_REF_SUFFIX;
+            bool journal = key.size() == PRUNE_JOURNAL_KEY.size() + 4 && key.toString().compare(0, PRUNE_JOURNAL_KEY.size(), PRUNE_JOURNAL_KEY) == 0;
+            if(ref || journal){
+                batch->kill(key);
+                if(++nBatch >= PRUNE_BATCH_SIZE){
+                    backend.commit(std::move(batch));
+                    batch = backend.createWriteBatch();
+                    nBatch = 0;
+                }
+            }
+            return true;
+        });
+        batch->kill(toSlice(PRUNE_META_KEY));
+        backend.commit(std::move(batch));
+    }
+
+    // Count every reference of the tip, in the same way the trie counts its inserts
+    std::unordered_map<h256, uint32_t> counts;
+    auto flushCounts = [&]() {
+        auto batch = backend.createWriteBatch();
+        for(const auto& item : counts){
+            StateNodeRef ref;
+            readRef(backend, item.first, ref);
+            ref.count += item.second;
+            writeRef(*batch, item.first, ref);
+        }
+        backend.commit(std::move(batch));
+        counts.clear();
+    };
+    std::function<bool(const h256&, const std::string&)> countNode = [&](const h256& hash, const std::string&) {
+        counts[hash]++;
+        if(counts.size() >= PRUNE_BUILD_COUNTS)
+            flushCounts();
+        return true;
+    };
+    std::function<bool(const bytes&, bytesConstRef)> countAccount = [&](const bytes&, bytesConstRef value) {
+        if(!fAccounts)
+            return true;
+        h256 storageRoot, codeHash;
+        accountRefs(value, storageRoot, codeHash);
+        if(codeHash != EmptySHA3)
+            counts[codeHash]++;
+        return WalkTrie(backend, storageRoot, countNode, [](const bytes&, bytesConstRef) { return true; });
+    };
+    if(!WalkTrie(backend, roots.back(), countNode, countAccount)){
+        LogPrintf("Missing node in the state of the tip, the state is not pruned\n");
+        return false;
+    }
+    flushCounts();
+
+    // The nodes of the older roots of the reorg window are released at the tip
+    std::unordered_set<h256> released;
+    std::function<bool(const h256&, const std::string&)> releaseNode = [&](const h256& hash, const std::string&) {
+        StateNodeRef ref;
+        if(released.count(hash) || (readRef(backend, hash, ref) && ref.count > 0))
+            return false;
+        released.insert(hash);
+        return true;
+    };
+    std::function<bool(const bytes&, bytesConstRef)> releaseAccount = [&](const bytes&, bytesConstRef value) {
+        if(!fAccounts)
+            return true;
+        h256 storageRoot, codeHash;
+        accountRefs(value, storageRoot, codeHash);
+        StateNodeRef ref;
+        if(codeHash != EmptySHA3 && !(readRef(backend, codeHash, ref) && ref.count > 0))
+            released.insert(codeHash);
+        return WalkTrie(backend, storageRoot, releaseNode, [](const bytes&, bytesConstRef) { return true; });
+    };
+    for(size_t i = 0; i + 1 < roots.size(); i++){
+        // Older states may have been pruned already, what is left is released
+        WalkTrie(backend, roots[i], releaseNode, releaseAccount);
+    }
+
+    nBase = nOldest = nTip = nTipHeight;
+    auto batch = backend.createWriteBatch();
+    writeJournal(*batch, nTip, {}, {}, std::vector<h256>(released.begin(), released.end()));
+    WriteMeta(*batch);
+    backend.commit(std::move(batch));
+    fValid = true;
+    return true;
+}
+
+void StatePruner::Commit(OverlayDB& db, int nHeight, int nKeepHeight)
+{
+    std::unordered_map<h256, int64_t> deltas = db.takeRefDeltas();
+    if(!fValid)
+        return;
+
+    // The journals needed to connect this block again are gone
+    if(nHeight <= nBase || (nHeight <= nTip && nHeight < nOldest)){
+        Invalidate(db);
+        return;
+    }
+
+    db::DatabaseFace& backend = *db.backend();
+    StateRefCache refs(backend);
+    auto batch = backend.createWriteBatch();
+    std::set<h256> released;
+
+    // Undo the blocks disconnected by a reorg or replayed after a crash
+    for(int height = nTip; height >= nHeight; height--){
+        Journal journal;
+        if(ReadJournal(backend, height, journal)){
+            for(const auto& item : journal.added){
+                StateNodeRef& ref = refs.Get(item.first);
+                ref.count = ref.count > item.second ? ref.count - item.second : 0;
+                if(ref.count == 0)
+                    released.insert(item.first);
+            }
+            for(const auto& item : journal.removed)
+                refs.Get(item.first).count += item.second;
+        }
+        batch->kill(toSlice(journalKey(height)));
+    }
+
+    std::vector<std::pair<h256, uint32_t>> added;
+    std::vector<std::pair<h256, uint32_t>> removed;
+    for(const auto& item : deltas){
+        if(item.second == 0 || item.first == EmptyTrie)
+            continue;
+        StateNodeRef& ref = refs.Get(item.first);
+        if(item.second > 0){
+            ref.count += item.second;
+            added.emplace_back(item.first, item.second);
+        } else {
+            // Nodes written before the counts were built may be released more than counted
+            uint32_t count = std::min<uint64_t>(ref.count, -item.second);
+            ref.count -= count;
+            if(count > 0)
+                removed.emplace_back(item.first, count);
+            if(ref.count == 0)
+                released.insert(item.first);
+        }
+    }
+
+    // Referenced by the roots up to the previous block, deleted when they are out of the reorg window
+    std::vector<h256> releasedNow;
+    for(const h256& hash : released){
+        StateNodeRef& ref = refs.Get(hash);
+        if(ref.count == 0){
+            ref.released = nHeight;
+            releasedNow.push_back(hash);
+        }
+    }
+    writeJournal(*batch, nHeight, added, removed, releasedNow);
+
+    std::vector<h256> deleted;
+    for(int height = nOldest; height <= std::min(nHeight - nDepth, nKeepHeight); height++){
+        Journal journal;
+        if(ReadJournal(backend, height, journal)){
+            for(const h256& hash : journal.released){
+                StateNodeRef& ref = refs.Get(hash);
+                if(ref.count == 0 && ref.released <= height){
+                    batch->kill(toSlice(hash));
+                    refs.Erase(hash);
+                    deleted.push_back(hash);
+                }
+            }
+        }
+        batch->kill(toSlice(journalKey(height)));
+        nOldest = height + 1;
+    }
+
+    nTip = nHeight;
+    refs.Write(*batch);
+    WriteMeta(*batch);
+    backend.commit(std::move(batch));
+    if(db.nodeCache()){
+        for(const h256& hash : deleted)
+            db.nodeCache()->remove(hash);
+    }
+    if(deleted.size() > 0)
+        LogPrint(BCLog::COINDB, "Pruned %u state nodes at height %d\n", deleted.size(), nHeight);
+}
+
+void StatePruner::Discard(OverlayDB& db, int nTipHeight)
+{
+    std::unordered_map<h256, int64_t> deltas = db.takeRefDeltas();
+    if(!fValid || nTipHeight != nTip || deltas.empty())
+        return;
+
+    // The nodes written for nothing are released at the tip, unless a block references them
+    db::DatabaseFace& backend = *db.backend();
+    Journal journal;
+    ReadJournal(backend, nTip, journal);
+    auto batch = backend.createWriteBatch();
+    bool fChanged = false;
+    for(const auto& item : deltas){
+        StateNodeRef ref;
+        if(item.second <= 0 || item.first == EmptyTrie || (readRef(backend, item.first, ref) && ref.count > 0))
+            continue;
+        ref.released = std::max<int64_t>(ref.released, nTip);
+        writeRef(*batch, item.first, ref);
+        journal.released.push_back(item.first);
+        fChanged = true;
+    }
+    if(fChanged){
+        writeJournal(*batch, nTip, journal.added, journal.removed, journal.released);
+        backend.commit(std::move(batch));
+    }
+}
+
+void StatePruner::Disable(OverlayDB& db)
+{
+    if(db.backend() && db.backend()->exists(toSlice(PRUNE_META_KEY)))
+        db.backend()->kill(toSlice(PRUNE_META_KEY));
+    db.setTrackRefs(false);
+}
+
+void StatePruner::Invalidate(OverlayDB& db)
+{
+    LogPrintf("Reorganization below the state pruning journal at height %d, the state is not pruned until the next restart\n", nOldest);
+    fValid = false;
+    Disable(db);
+}
+
+bool OdanStatePruner::Init(OdanState& state, const std::vector<h256>& rootsState, const std::vector<h256>& rootsUTXO, int nTipHeight)
+{
+    if(!statePruner.Load(state.db(), nTipHeight)){
+        LogPrintf("Building the reference counts of the contract state...\n");
+        if(!statePruner.Build(state.db(), rootsState, nTipHeight))
+            return false;
+    }
+    if(!utxoPruner.Load(state.dbUtxo(), nTipHeight)){
+        LogPrintf("Building the reference counts of the UTXO trie...\n");
+        if(!utxoPruner.Build(state.dbUtxo(), rootsUTXO, nTipHeight))
+            return false;
+    }
+    state.db().setTrackRefs(true);
+    state.dbUtxo().setTrackRefs(true);
+    return true;
+}
+
+void OdanStatePruner::Commit(OdanState& state, int nHeight, int nKeepHeight)
+{
+    statePruner.Commit(state.db(), nHeight, nKeepHeight);
+    utxoPruner.Commit(state.dbUtxo(), nHeight, nKeepHeight);
+}
+
+void OdanStatePruner::Discard(OdanState& state, int nTipHeight)
+{
+    statePruner.Discard(state.db(), nTipHeight);
+    utxoPruner.Discard(state.dbUtxo(), nTipHeight);
+}
+
+void OdanStatePruner::Disable(OdanState& state)
+{
+    StatePruner::Disable(state.db());
+    StatePruner::Disable(state.dbUtxo());
+}
+
+bool CompactStateDB(const std::string& path, bool fAccounts, const std::vector<h256>& roots)
+{
+    namespace bfs = boost::filesystem;
+    bfs::path source(path);
+    bfs::path target(path + ".compact");
+    bfs::path old(path + ".old");
+    if(!bfs::exists(source))
+        return true;
+    bfs::remove_all(target);
+
+    size_t nNodes = 0;
+    {
+        std::unique_ptr<db::DatabaseFace> src = db::DBFactory::create(source);
+        std::unique_ptr<db::DatabaseFace> dst = db::DBFactory::create(target);
+        auto batch = dst->createWriteBatch();
+        size_t nBatch = 0;
+        std::unordered_set<h256> pending;
+        auto copy = [&](db::Slice key, const std::string& value) {
+            batch->insert(key, toSlice(value));
+            if(++nBatch >= PRUNE_BATCH_SIZE){
+                dst->commit(std::move(batch));
+                batch = dst->createWriteBatch();
+                nBatch = 0;
+                pending.clear();
+            }
+        };
+        auto copied = [&](const h256& hash) {
+            return pending.count(hash) || dst->exists(toSlice(hash));
+        };
+
+        // The secure tries keep the preimage of every key, read back by the RPC calls listing them
+        auto copyPreimage = [&](const bytes& path) {
+            if(path.size() != h256::size * 2)
+                return;
+            std::string key;
+            for(size_t i = 0; i < path.size(); i += 2)
+                key.push_back(char((path[i] << 4) | path[i + 1]));
+            key.push_back(NODE_AUX_SUFFIX);
+            std::string value = src->lookup(toSlice(key));
+            if(!value.empty())
+                copy(toSlice(key), value);
+        };
+
+        std::function<bool(const h256&, const std::string&)> copyNode = [&](const h256& hash, const std::string& node) {
+            if(copied(hash))
+                return false;
+            pending.insert(hash);
+            copy(toSlice(hash), node);
+            nNodes++;
+            return true;
+        };
+        std::function<bool(const bytes&, bytesConstRef)> copyStorageLeaf = [&](const bytes& path, bytesConstRef) {
+            copyPreimage(path);
+            return true;
+        };
+        std::function<bool(const bytes&, bytesConstRef)> copyLeaf = [&](const bytes& path, bytesConstRef value) {
+            copyPreimage(path);
+            if(!fAccounts)
+                return true;
+            h256 storageRoot, codeHash;
+            accountRefs(value, storageRoot, codeHash);
+            if(codeHash != EmptySHA3 && !copied(codeHash)){
+                std::string code = src->lookup(toSlice(codeHash));
+                if(!code.empty()){
+                    pending.insert(codeHash);
+                    copy(toSlice(codeHash), code);
+                }
+            }
+            return WalkTrie(*src, storageRoot, copyNode, copyStorageLeaf);
+        };
+
+        copy(toSlice(EmptyTrie), std::string(1, char(0x80)));
+        for(const h256& root : roots){
+            if(!WalkTrie(*src, root, copyNode, copyLeaf)){
+                LogPrintf("%s: Missing node in the state %s of %s\n", __func__, root.hex(), path);
+                return false;
+            }
+        }
+        dst->commit(std::move(batch));
+    }
+
+    bfs::remove_all(old);
+    bfs::rename(source, old);
+    bfs::rename(target, source);
+    bfs::remove_all(old);
+    LogPrintf("Compacted the state database %s to %u nodes\n", path, nNodes);
+    return true;
+}
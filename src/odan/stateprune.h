@@ -0,0 +1,133 @@
+#ifndef ODANSTATEPRUNE_H
+#define ODANSTATEPRUNE_H
+
+#include <libdevcore/OverlayDB.h>
+
+#include <functional>
+#include <limits>
+#include <map>
+#include <string>
+#include <vector>
+
+class OdanState;
+
+/** Default for -prunestate, 0 keeps every trie node */
+static const int DEFAULT_PRUNESTATE = 0;
+
+/** Reference count of a trie node, with the height of the block that last released it */
+struct StateNodeRef{
+    uint32_t count{0};
+    int64_t released{0};
+};
+
+/**
+ * Walk the nodes of a trie stored in db. onNode is called with every stored node, in the
+ * expanded form of the trie: a node referenced twice is visited twice unless onNode returns
+ * false to skip its children. onLeaf is called with the nibble path and the value of every leaf.
+ * Returns false when a node is missing.
+ */
+bool WalkTrie(const dev::db::DatabaseFace& db, const dev::h256& root,
+              const std::function<bool(const dev::h256&, const std::string&)>& onNode,
+              const std::function<bool(const dev::bytes&, dev::bytesConstRef)>& onLeaf);
+
+/** Hashed key of a leaf of a secure trie from the nibble path given to onLeaf by WalkTrie */
+bool TriePathToHash(const dev::bytes& path, dev::h256& hash);
+
+/**
+ * Reference counted pruning of one trie database.
+ *
+ * The trie counts its node references in OverlayDB, the count changes of every connected block
+ * are added to the counts stored next to the nodes (the node hash followed by 0xfe) and written
+ * to a journal of the block. Connecting a block first undoes the journals of the blocks at the
+ * same height and above, so the blocks of a reorg and the blocks replayed after a crash are
+ * counted once. The nodes released by a block are deleted depth blocks later when nothing
+ * references them again, so the roots of the last depth blocks stay readable for reorgs.
+ *
+ * The counts are built from the tip roots when the pruning is enabled, and are dropped when
+ * the node runs without -prunestate or is reorganized below the oldest journal.
+ */
+class StatePruner{
+
+public:
+
+    StatePruner(bool _fAccounts, int _nDepth) : fAccounts(_fAccounts), nDepth(_nDepth) {}
+
+    /** Load the journal state, returns false when the counts must be built for the tip */
+    bool Load(dev::OverlayDB& db, int nTipHeight);
+
+    /**
+     * Count the references of the tip root, the last of roots. The nodes only referenced by
+     * the other roots of the reorg window are released at the tip.
+     */
+    bool Build(dev::OverlayDB& db, const std::vector<dev::h256>& roots, int nTipHeight);
+
+    /**
+     * Write the count changes of the block at nHeight and delete the nodes released depth blocks before.
+     * The nodes released after nKeepHeight are kept, with the journals to connect the blocks after it again.
+     */
+    void Commit(dev::OverlayDB& db, int nHeight, int nKeepHeight = std::numeric_limits<int>::max());
+
+    /** Drop the count changes of a block template or of a block that failed to connect */
+    void Discard(dev::OverlayDB& db, int nTipHeight);
+
+    /** Remove the journal state, the counts are not kept up to date any more */
+    static void Disable(dev::OverlayDB& db);
+
+    bool IsValid() const { return fValid; }
+
+private:
+
+    struct Journal{
+        std::vector<std::pair<dev::h256, uint32_t>> added;
+        std::vector<std::pair<dev::h256, uint32_t>> removed;
+        std::vector<dev::h256> released;
+    };
+
+    bool ReadJournal(const dev::db::DatabaseFace& db, int nHeight, Journal& journal) const;
+    void WriteMeta(dev::db::WriteBatchFace& batch) const;
+    void Invalidate(dev::OverlayDB& db);
+
+    /** Count and visit the account storage and code when the trie holds accounts */
+    bool fAccounts;
+    int nDepth;
+
+    bool fValid{false};
+    /** Height of the state the counts were built from */
+    int nBase{0};
+    /** Lowest height with a journal */
+    int nOldest{0};
+    /** Height of the last committed block */
+    int nTip{0};
+};
+
+/** Prunes the contract state and the UTXO trie of globalState with -prunestate */
+class OdanStatePruner{
+
+public:
+
+    explicit OdanStatePruner(int _nDepth) : statePruner(true, _nDepth), utxoPruner(false, _nDepth) {}
+
+    /** Start tracking the references, rootsState and rootsUTXO are the roots of the reorg window */
+    bool Init(OdanState& state, const std::vector<dev::h256>& rootsState, const std::vector<dev::h256>& rootsUTXO, int nTipHeight);
+
+    /** nKeepHeight is the height of the coins flushed to disk, where the node starts again after a crash */
+    void Commit(OdanState& state, int nHeight, int nKeepHeight);
+
+    void Discard(OdanState& state, int nTipHeight);
+
+    static void Disable(OdanState& state);
+
+private:
+
+    StatePruner statePruner;
+    StatePruner utxoPruner;
+};
+
+/**
+ * Offline compaction: copy the nodes reachable from the roots into a new database, then replace
+ * the database at path with it. The code and the key preimages of the reachable accounts are
+ * copied with the nodes. Must run before the database is opened.
+ */
+bool CompactStateDB(const std::string& path, bool fAccounts, const std::vector<dev::h256>& roots);
+
+#endif
@@ -0,0 +1,489 @@
+#include <odan/statesnapshot.h>
+#include <odan/odanstate.h>
+#include <odan/stateprune.h>
+#include <logging.h>
+#include <util/convert.h>
+
+#include <libdevcore/RLP.h>
+
+#include <algorithm>
+#include <vector>
+
+using namespace dev;
+using namespace dev::eth;
+
+static const uint8_t DB_SNAPSHOT_ROOT = 'r';
+static const uint8_t DB_SNAPSHOT_ENTRY = 'e';
+static const uint8_t DB_SNAPSHOT_STORAGE = 's';
+static const uint8_t DB_SNAPSHOT_JOURNAL = 'j';
+
+/** Size of the batches written while the snapshot is generated */
+static const size_t SNAPSHOT_BATCH_SIZE = 16 << 20;
+
+/** Layer of a StateSnapshotTree, the disk layer or the changes of one block on top of its parent */
+class StateSnapshotLayer : public SnapshotLayer{
+
+public:
+
+    StateSnapshotLayer(const StateSnapshotTree& _tree, const h256& _root, int _nHeight, bool _fDisk) :
+        tree(_tree), root(_root), nHeight(_nHeight), fDisk(_fDisk) {}
+
+    bool entry(const h256& key, bytes& value) const override { return tree.ReadEntry(*this, key, value); }
+    bool storage(const h256& key, const h256& slot, bytes& value) const override { return tree.ReadStorage(*this, key, slot, value); }
+
+    const StateSnapshotTree& tree;
+    const h256 root;
+    const int nHeight;
+    const bool fDisk;
+    /** Changes from the parent, not modified after the layer is added */
+    SnapshotDiff diff;
+
+    /** Guarded by the mutex of the tree */
+    std::shared_ptr<StateSnapshotLayer> parent;
+    bool fStale{false};
+};
+
+/** Add the changes of diff on top of the changes of merged */
+static void mergeDiff(SnapshotDiff& merged, const SnapshotDiff& diff)
+{
+    for(const auto& entry : diff.entries)
+        merged.entries[entry.first] = entry.second;
+    for(const auto& storage : diff.storage){
+        SnapshotStorageDiff& s = merged.storage[storage.first];
+        if(storage.second.wiped){
+            s.wiped = true;
+            s.slots.clear();
+        }
+        for(const auto& slot : storage.second.slots)
+            s.slots[slot.first] = slot.second;
+    }
+}
+
+StateSnapshotTree::StateSnapshotTree(const fs::path& _path, bool _fAccounts) :
+    path(_path),
+    fAccounts(_fAccounts)
+{
+}
+
+StateSnapshotTree::~StateSnapshotTree()
+{
+}
+
+void StateSnapshotTree::OpenDB(bool fWipe)
+{
+    db.reset();
+    fs::create_directories(path);
+    db = std::make_unique<CDBWrapper>(DBParams{
+        .path = path,
+        .cache_bytes = STATE_SNAPSHOT_DB_CACHE,
+        .wipe_data = fWipe});
+}
+
+std::shared_ptr<SnapshotLayer const> StateSnapshotTree::layer(const h256& root) const
+{
+    std::shared_lock lock(mutex);
+    auto it = layers.find(root);
+    if(it != layers.end())
+        return it->second;
+    if(disk && disk->root == root)
+        return disk;
+    return nullptr;
+}
+
+bool StateSnapshotTree::ReadEntry(const StateSnapshotLayer& from, const h256& key, bytes& value) const
+{
+    std::shared_lock lock(mutex);
+    if(from.fStale)
+        return false;
+    const StateSnapshotLayer* layer = entryLayers.count(key) ? &from : disk.get();
+    for(; !layer->fDisk; layer = layer->parent.get()){
+        auto it = layer->diff.entries.find(key);
+        if(it != layer->diff.entries.end()){
+            value = it->second;
+            return true;
+        }
+    }
+    if(!db->Read(std::make_pair(DB_SNAPSHOT_ENTRY, h256Touint(key)), value))
+        value.clear();
+    return true;
+}
+
+bool StateSnapshotTree::ReadStorage(const StateSnapshotLayer& from, const h256& key, const h256& slot, bytes& value) const
+{
+    std::shared_lock lock(mutex);
+    if(from.fStale)
+        return false;
+    const StateSnapshotLayer* layer = storageLayers.count(key) ? &from : disk.get();
+    for(; !layer->fDisk; layer = layer->parent.get()){
+        auto it = layer->diff.storage.find(key);
+        if(it == layer->diff.storage.end())
+            continue;
+        auto itSlot = it->second.slots.find(slot);
+        if(itSlot != it->second.slots.end()){
+            value = itSlot->second;
+            return true;
+        }
+        if(it->second.wiped){
+            value.clear();
+            return true;
+        }
+    }
+    if(!db->Read(std::make_pair(DB_SNAPSHOT_STORAGE, std::make_pair(h256Touint(key), h256Touint(slot))), value))
+        value.clear();
+    return true;
+}
+
+void StateSnapshotTree::AddLayer(const std::shared_ptr<StateSnapshotLayer>& layer)
+{
+    layers[layer->root] = layer;
+    for(const auto& entry : layer->diff.entries)
+        entryLayers[entry.first]++;
+    for(const auto& storage : layer->diff.storage)
+        storageLayers[storage.first]++;
+}
+
+void StateSnapshotTree::DropLayer(StateSnapshotLayer& layer)
+{
+    layer.fStale = true;
+    for(const auto& entry : layer.diff.entries){
+        auto it = entryLayers.find(entry.first);
+        if(--it->second == 0)
+            entryLayers.erase(it);
+    }
+    for(const auto& storage : layer.diff.storage){
+        auto it = storageLayers.find(storage.first);
+        if(--it->second == 0)
+            storageLayers.erase(it);
+    }
+}
+
+std::shared_ptr<SnapshotLayer const> StateSnapshotTree::Update(const h256& baseRoot, const h256& root, int nHeight, const SnapshotDiff& diff)
+{
+    std::unique_lock lock(mutex);
+    auto it = layers.find(root);
+    if(it != layers.end())
+        return it->second;
+    if(disk && disk->root == root)
+        return disk;
+
+    std::shared_ptr<StateSnapshotLayer> parent;
+    auto itParent = layers.find(baseRoot);
+    if(itParent != layers.end())
+        parent = itParent->second;
+    else if(disk && disk->root == baseRoot)
+        parent = disk;
+    else
+        return nullptr;
+
+    auto layer = std::make_shared<StateSnapshotLayer>(*this, root, nHeight, false);
+    layer->parent = parent;
+    layer->diff = diff;
+    AddLayer(layer);
+    return layer;
+}
+
+void StateSnapshotTree::Cap(const h256& root, int nHeight)
+{
+    std::unique_lock lock(mutex);
+    auto it = layers.find(root);
+    if(it == layers.end())
+        return;
+
+    // The heights decrease from the layer of root to the disk layer
+    std::vector<StateSnapshotLayer*> chain;
+    for(StateSnapshotLayer* layer = it->second.get(); !layer->fDisk; layer = layer->parent.get()){
+        if(layer->nHeight <= nHeight)
+            chain.push_back(layer);
+    }
+    if(chain.empty())
+        return;
+    StateSnapshotLayer* flattened = chain.front();
+
+    SnapshotDiff merged;
+    for(auto itLayer = chain.rbegin(); itLayer != chain.rend(); ++itLayer)
+        mergeDiff(merged, (*itLayer)->diff);
+
+    CDBBatch batch(*db);
+    for(const auto& entry : merged.entries){
+        auto key = std::make_pair(DB_SNAPSHOT_ENTRY, h256Touint(entry.first));
+        if(entry.second.empty())
+            batch.Erase(key);
+        else
+            batch.Write(key, entry.second);
+    }
+    for(const auto& storage : merged.storage){
+        uint256 key = h256Touint(storage.first);
+        if(storage.second.wiped){
+            std::unique_ptr<CDBIterator> pcursor(db->NewIterator());
+            pcursor->Seek(std::make_pair(DB_SNAPSHOT_STORAGE, std::make_pair(key, uint256())));
+            for(; pcursor->Valid(); pcursor->Next()){
+                std::pair<uint8_t, std::pair<uint256, uint256>> slotKey;
+                if(!pcursor->GetKey(slotKey) || slotKey.first != DB_SNAPSHOT_STORAGE || slotKey.second.first != key)
+                    break;
+                batch.Erase(slotKey);
+            }
+        }
+        for(const auto& slot : storage.second.slots){
+            auto slotKey = std::make_pair(DB_SNAPSHOT_STORAGE, std::make_pair(key, h256Touint(slot.first)));
+            if(slot.second.empty())
+                batch.Erase(slotKey);
+            else
+                batch.Write(slotKey, slot.second);
+        }
+    }
+    batch.Write(DB_SNAPSHOT_ROOT, h256Touint(flattened->root));
+    db->WriteBatch(batch);
+
+    auto newDisk = std::make_shared<StateSnapshotLayer>(*this, flattened->root, flattened->nHeight, true);
+    disk->fStale = true;
+    disk = newDisk;
+
+    // The flattened layers and the forks below them are stale, the children of the flattened layer
+    // are on top of the new disk layer and the layers descending from a stale layer are stale
+    std::vector<std::shared_ptr<StateSnapshotLayer>> sorted;
+    for(const auto& item : layers)
+        sorted.push_back(item.second);
+    std::sort(sorted.begin(), sorted.end(), [](const std::shared_ptr<StateSnapshotLayer>& a, const std::shared_ptr<StateSnapshotLayer>& b) {
+        return a->nHeight < b->nHeight;
+    });
+    for(const auto& layer : sorted){
+        if(layer->nHeight <= flattened->nHeight)
+            DropLayer(*layer);
+    }
+    for(const auto& layer : sorted){
+        if(layer->fStale)
+            continue;
+        if(layer->parent.get() == flattened)
+            layer->parent = disk;
+        else if(layer->parent->fStale)
+            DropLayer(*layer);
+    }
+    for(auto itLayer = layers.begin(); itLayer != layers.end();){
+        if(itLayer->second->fStale)
+            itLayer = layers.erase(itLayer);
+        else
+            ++itLayer;
+    }
+}
+
+void StateSnapshotTree::Journal()
+{
+    std::unique_lock lock(mutex);
+    if(!db)
+        return;
+
+    CDBBatch batch(*db);
+    std::unique_ptr<CDBIterator> pcursor(db->NewIterator());
+    pcursor->Seek(std::make_pair(DB_SNAPSHOT_JOURNAL, uint256()));
+    for(; pcursor->Valid(); pcursor->Next()){
+        std::pair<uint8_t, uint256> key;
+        if(!pcursor->GetKey(key) || key.first != DB_SNAPSHOT_JOURNAL)
+            break;
+        batch.Erase(key);
+    }
+
+    // [parent, height, [[key, value]], [[key, wiped, [[slot, value]]]]]
+    for(const auto& item : layers){
+        const StateSnapshotLayer& layer = *item.second;
+        RLPStream s(4);
+        s << layer.parent->root << unsigned(layer.nHeight);
+        s.appendList(layer.diff.entries.size());
+        for(const auto& entry : layer.diff.entries)
+            s.appendList(2) << entry.first << entry.second;
+        s.appendList(layer.diff.storage.size());
+        for(const auto& storage : layer.diff.storage){
+            s.appendList(3) << storage.first << unsigned(storage.second.wiped);
+            s.appendList(storage.second.slots.size());
+            for(const auto& slot : storage.second.slots)
+                s.appendList(2) << slot.first << slot.second;
+        }
+        batch.Write(std::make_pair(DB_SNAPSHOT_JOURNAL, h256Touint(layer.root)), s.out());
+    }
+    db->WriteBatch(batch, true);
+    LogPrint(BCLog::COINDB, "Saved %u snapshot layers to %s\n", layers.size(), fs::PathToString(path));
+}
+
+bool StateSnapshotTree::Load(const h256& root)
+{
+    std::unique_lock lock(mutex);
+    OpenDB(false);
+    layers.clear();
+    entryLayers.clear();
+    storageLayers.clear();
+    disk.reset();
+
+    uint256 diskRoot;
+    if(!db->Read(DB_SNAPSHOT_ROOT, diskRoot))
+        return false;
+    disk = std::make_shared<StateSnapshotLayer>(*this, uintToh256(diskRoot), 0, true);
+
+    struct SavedLayer{
+        h256 root;
+        h256 parent;
+        int nHeight;
+        bytes data;
+    };
+    std::vector<SavedLayer> saved;
+    CDBBatch batch(*db);
+    std::unique_ptr<CDBIterator> pcursor(db->NewIterator());
+    pcursor->Seek(std::make_pair(DB_SNAPSHOT_JOURNAL, uint256()));
+    for(; pcursor->Valid(); pcursor->Next()){
+        std::pair<uint8_t, uint256> key;
+        if(!pcursor->GetKey(key) || key.first != DB_SNAPSHOT_JOURNAL)
+            break;
+        batch.Erase(key);
+        SavedLayer layer;
+        if(!pcursor->GetValue(layer.data))
+            continue;
+        RLP r(layer.data);
+        layer.root = uintToh256(key.second);
+        layer.parent = r[0].toHash<h256>();
+        layer.nHeight = r[1].toInt<unsigned>();
+        saved.push_back(std::move(layer));
+    }
+    std::sort(saved.begin(), saved.end(), [](const SavedLayer& a, const SavedLayer& b) {
+        return a.nHeight < b.nHeight;
+    });
+
+    // The layers that are not on top of the disk layer were saved by an older version of the snapshot
+    for(const SavedLayer& item : saved){
+        std::shared_ptr<StateSnapshotLayer> parent;
+        auto it = layers.find(item.parent);
+        if(it != layers.end())
+            parent = it->second;
+        else if(item.parent == disk->root)
+            parent = disk;
+        else
+            continue;
+
+        RLP r(item.data);
+        auto layer = std::make_shared<StateSnapshotLayer>(*this, item.root, item.nHeight, false);
+        layer->parent = parent;
+        for(const RLP& entry : r[2])
+            layer->diff.entries[entry[0].toHash<h256>()] = entry[1].toBytes();
+        for(const RLP& storage : r[3]){
+            SnapshotStorageDiff& s = layer->diff.storage[storage[0].toHash<h256>()];
+            s.wiped = storage[1].toInt<unsigned>() != 0;
+            for(const RLP& slot : storage[2])
+                s.slots[slot[0].toHash<h256>()] = slot[1].toBytes();
+        }
+        AddLayer(layer);
+    }
+    // The layers are saved again on shutdown, a crash before regenerates the snapshot
+    db->WriteBatch(batch, true);
+
+    LogPrintf("Loaded the snapshot of %s with %u layers\n", fs::PathToString(path), layers.size());
+    return disk->root == root || layers.count(root);
+}
+
+bool StateSnapshotTree::Generate(const db::DatabaseFace& trieDB, const h256& root)
+{
+    std::unique_lock lock(mutex);
+    for(const auto& item : layers)
+        item.second->fStale = true;
+    layers.clear();
+    entryLayers.clear();
+    storageLayers.clear();
+    if(disk)
+        disk->fStale = true;
+    disk.reset();
+    OpenDB(true);
+
+    CDBBatch batch(*db);
+    size_t nEntries = 0, nSlots = 0;
+    auto flush = [&]() {
+        if(batch.SizeEstimate() > SNAPSHOT_BATCH_SIZE){
+            db->WriteBatch(batch);
+            batch.Clear();
+        }
+    };
+    auto onNode = [](const h256&, const std::string&) { return true; };
+    std::function<bool(const bytes&, bytesConstRef)> onEntry = [&](const bytes& keyPath, bytesConstRef value) {
+        h256 key;
+        if(!TriePathToHash(keyPath, key))
+            return true;
+        batch.Write(std::make_pair(DB_SNAPSHOT_ENTRY, h256Touint(key)), value.toBytes());
+        nEntries++;
+        flush();
+        if(!fAccounts)
+            return true;
+
+        uint256 account = h256Touint(key);
+        h256 storageRoot = RLP(value)[2].toHash<h256>();
+        return WalkTrie(trieDB, storageRoot, onNode, [&](const bytes& slotPath, bytesConstRef slotValue) {
+            h256 slot;
+            if(!TriePathToHash(slotPath, slot))
+                return true;
+            batch.Write(std::make_pair(DB_SNAPSHOT_STORAGE, std::make_pair(account, h256Touint(slot))), slotValue.toBytes());
+            nSlots++;
+            flush();
+            return true;
+        });
+    };
+    if(!WalkTrie(trieDB, root, onNode, onEntry)){
+        LogPrintf("Missing node in the trie of %s, the snapshot is not generated\n", fs::PathToString(path));
+        return false;
+    }
+
+    // The root is written last, an interrupted generation starts again
+    batch.Write(DB_SNAPSHOT_ROOT, h256Touint(root));
+    db->WriteBatch(batch, true);
+    disk = std::make_shared<StateSnapshotLayer>(*this, root, 0, true);
+    LogPrintf("Generated the snapshot of %s with %u entries and %u storage slots\n", fs::PathToString(path), nEntries, nSlots);
+    return true;
+}
+
+h256 StateSnapshotTree::DiskRoot() const
+{
+    std::shared_lock lock(mutex);
+    return disk ? disk->root : h256();
+}
+
+size_t StateSnapshotTree::LayerCount() const
+{
+    std::shared_lock lock(mutex);
+    return layers.size();
+}
+
+OdanStateSnapshot::OdanStateSnapshot(const fs::path& path) :
+    stateTree(path / "state", true),
+    utxoTree(path / "utxo", false)
+{
+}
+
+bool OdanStateSnapshot::Init(OdanState& state)
+{
+    if(!stateTree.Load(state.rootHash())){
+        LogPrintf("Generating the snapshot of the contract state, this may take a while...\n");
+        if(!stateTree.Generate(*state.db().backend(), state.rootHash()))
+            return false;
+    }
+    if(!utxoTree.Load(state.rootHashUTXO())){
+        LogPrintf("Generating the snapshot of the contract UTXO trie...\n");
+        if(!utxoTree.Generate(*state.dbUtxo().backend(), state.rootHashUTXO()))
+            return false;
+    }
+    state.setSnapshotProviders(&stateTree, &utxoTree);
+    return true;
+}
+
+/** Add the changes of the view to the tree and follow the new layer */
+static void updateTree(StateSnapshotTree& tree, SnapshotView& view, const h256& root, int nHeight)
+{
+    if(view.sync(root) && view.baseRoot() != root)
+        tree.Update(view.baseRoot(), root, nHeight, view.diff());
+    tree.Cap(root, nHeight - STATE_SNAPSHOT_LAYERS);
+    view.reset(root, tree.layer(root));
+}
+
+void OdanStateSnapshot::Update(OdanState& state, int nHeight)
+{
+    updateTree(stateTree, state.snapshotView(), state.rootHash(), nHeight);
+    updateTree(utxoTree, state.snapshotViewUTXO(), state.rootHashUTXO(), nHeight);
+}
+
+void OdanStateSnapshot::Journal()
+{
+    stateTree.Journal();
+    utxoTree.Journal();
+}
@@ -0,0 +1,108 @@
+#ifndef ODANSTATESNAPSHOT_H
+#define ODANSTATESNAPSHOT_H
+
+#include <dbwrapper.h>
+#include <util/fs.h>
+#include <libdevcore/db.h>
+#include <libethereum/StateSnapshot.h>
+
+#include <memory>
+#include <shared_mutex>
+#include <unordered_map>
+
+class OdanState;
+class StateSnapshotLayer;
+
+/** Default for -statesnapshot */
+static const bool DEFAULT_STATESNAPSHOT = false;
+/** Number of blocks kept as diff layers in memory, the snapshot is used by the reorganizations up to this depth */
+static const int STATE_SNAPSHOT_LAYERS = 128;
+/** Cache of the snapshot databases */
+static const size_t STATE_SNAPSHOT_DB_CACHE = 16 << 20;
+
+/**
+ * Flat snapshot of one secure trie, the contract state or the UTXO trie, keyed by hashed key.
+ *
+ * The disk layer holds the entries of the trie at one root. The blocks connected on top of it are
+ * kept in memory as diff layers, one per state root, so the states of the recent blocks and of their
+ * forks can be read without walking the trie. The layers older than STATE_SNAPSHOT_LAYERS blocks
+ * are written to the disk layer, the layers that do not descend from it any more are stale and
+ * their reads go to the trie. The diff layers are saved to the database on shutdown.
+ */
+class StateSnapshotTree : public dev::eth::SnapshotProvider{
+
+public:
+
+    StateSnapshotTree(const fs::path& path, bool fAccounts);
+    ~StateSnapshotTree();
+
+    std::shared_ptr<dev::eth::SnapshotLayer const> layer(const dev::h256& root) const override;
+
+    /** Load the disk layer and the saved diff layers, returns false when root has no layer */
+    bool Load(const dev::h256& root);
+
+    /** Replace the snapshot with the entries of the trie at root, read from db */
+    bool Generate(const dev::db::DatabaseFace& db, const dev::h256& root);
+
+    /** Add the layer of root, the changes diff on top of the layer of baseRoot, returns nullptr when baseRoot has no layer */
+    std::shared_ptr<dev::eth::SnapshotLayer const> Update(const dev::h256& baseRoot, const dev::h256& root, int nHeight, const dev::eth::SnapshotDiff& diff);
+
+    /** Write the layers of the chain of root up to nHeight to the disk layer */
+    void Cap(const dev::h256& root, int nHeight);
+
+    /** Save the diff layers in the database for the next start */
+    void Journal();
+
+    dev::h256 DiskRoot() const;
+
+    /** Number of diff layers in memory */
+    size_t LayerCount() const;
+
+    bool ReadEntry(const StateSnapshotLayer& from, const dev::h256& key, dev::bytes& value) const;
+    bool ReadStorage(const StateSnapshotLayer& from, const dev::h256& key, const dev::h256& slot, dev::bytes& value) const;
+
+private:
+
+    void OpenDB(bool fWipe);
+    void AddLayer(const std::shared_ptr<StateSnapshotLayer>& layer);
+    void DropLayer(StateSnapshotLayer& layer);
+
+    const fs::path path;
+    /** Storage of the accounts is in the snapshot */
+    const bool fAccounts;
+    std::unique_ptr<CDBWrapper> db;
+
+    /** Guards the layer links, the disk layer and the database content against the cap */
+    mutable std::shared_mutex mutex;
+    std::shared_ptr<StateSnapshotLayer> disk;
+    std::unordered_map<dev::h256, std::shared_ptr<StateSnapshotLayer>> layers;
+    /** Number of diff layers changing each entry and each account storage, the others are read from the disk */
+    std::unordered_map<dev::h256, uint32_t> entryLayers;
+    std::unordered_map<dev::h256, uint32_t> storageLayers;
+};
+
+/** Snapshots of the contract state and of the UTXO trie of globalState with -statesnapshot */
+class OdanStateSnapshot{
+
+public:
+
+    explicit OdanStateSnapshot(const fs::path& path);
+
+    /** Load the snapshots of the state roots, or generate them, and read the state through them */
+    bool Init(OdanState& state);
+
+    /** Add the changes of the block connected at nHeight */
+    void Update(OdanState& state, int nHeight);
+
+    void Journal();
+
+    StateSnapshotTree& State() { return stateTree; }
+    StateSnapshotTree& UTXO() { return utxoTree; }
+
+private:
+
+    StateSnapshotTree stateTree;
+    StateSnapshotTree utxoTree;
+};
+
+#endif
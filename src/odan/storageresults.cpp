@@ -1,6 +1,215 @@
 #include <odan/storageresults.h>
+#include <crypto/common.h>
 #include <util/convert.h>
 #include <logging.h>
+#include <util/strencodings.h>
+
+#include <cstring>
+#include <memory>
+
+/** Number of converted transactions written per batch when upgrading the receipt store */
+static const size_t UPGRADE_BATCH_SIZE = 10000;
+
+static std::string ReceiptKey(ReceiptColumn column, dev::h256 const& hashTx)
+{
+    std::string key(1, static_cast<char>(column));
+    key.append(reinterpret_cast<const char*>(hashTx.data()), dev::h256::size);
+    return key;
+}
+
+static void AppendBytes(std::string& out, const unsigned char* data, size_t size)
+{
+    out.append(reinterpret_cast<const char*>(data), size);
+}
+
+static void AppendLE32(std::string& out, uint32_t x)
+{
+    unsigned char buf[4];
+    WriteLE32(buf, x);
+    AppendBytes(out, buf, sizeof(buf));
+}
+
+static void AppendLE64(std::string& out, uint64_t x)
+{
+    unsigned char buf[8];
+    WriteLE64(buf, x);
+    AppendBytes(out, buf, sizeof(buf));
+}
+
+/** Bounds checked reader of a column value, the fields are decoded in place */
+class ColumnReader
+{
+public:
+    explicit ColumnReader(std::string const& value) :
+        pos(reinterpret_cast<const unsigned char*>(value.data())),
+        end(pos + value.size()) {}
+
+    /** Returns nullptr when the value is shorter than expected */
+    const unsigned char* Read(size_t size)
+    {
+        if(size_t(end - pos) < size)
+            return nullptr;
+        const unsigned char* ret = pos;
+        pos += size;
+        return ret;
+    }
+
+    bool ReadU32(uint32_t& x)
+    {
+        const unsigned char* p = Read(4);
+        if(!p)
+            return false;
+        x = ReadLE32(p);
+        return true;
+    }
+
+    /** Read a count of items that are at least itemSize bytes each */
+    bool ReadCount(uint32_t& count, size_t itemSize)
+    {
+        return ReadU32(count) && uint64_t(count) * itemSize <= uint64_t(end - pos);
+    }
+
+    bool Empty() const { return pos == end; }
+
+private:
+    const unsigned char* pos;
+    const unsigned char* end;
+};
+
+static std::string EncodeInfo(std::vector<TransactionReceiptInfo> const& result)
+{
+    std::string out;
+    out.reserve(4 + result.size() * (RECEIPT_INFO_SIZE + 4));
+    AppendLE32(out, result.size());
+    for(TransactionReceiptInfo const& tri : result){
+        AppendBytes(out, tri.blockHash.begin(), 32);
+        AppendLE32(out, tri.blockNumber);
+        AppendBytes(out, tri.transactionHash.begin(), 32);
+        AppendLE32(out, tri.transactionIndex);
+        AppendBytes(out, tri.from.data(), 20);
+        AppendBytes(out, tri.to.data(), 20);
+        AppendLE64(out, tri.cumulativeGasUsed);
+        AppendLE64(out, tri.gasUsed);
+        AppendBytes(out, tri.contractAddress.data(), 20);
+        AppendLE32(out, uint32_t(static_cast<int>(tri.excepted)));
+        AppendLE32(out, tri.outputIndex);
+        AppendBytes(out, tri.stateRoot.data(), 32);
+        AppendBytes(out, tri.utxoRoot.data(), 32);
+    }
+    for(TransactionReceiptInfo const& tri : result){
+        AppendLE32(out, tri.exceptedMessage.size());
+        out.append(tri.exceptedMessage);
+    }
+    return out;
+}
+
+static bool DecodeInfo(std::string const& value, std::vector<TransactionReceiptInfo>& result)
+{
+    ColumnReader reader(value);
+    uint32_t count;
+    if(!reader.ReadCount(count, RECEIPT_INFO_SIZE))
+        return false;
+
+    const unsigned char* p = reader.Read(count * RECEIPT_INFO_SIZE);
+    result.resize(count);
+    for(TransactionReceiptInfo& tri : result){
+        std::memcpy(tri.blockHash.begin(), p, 32);
+        tri.blockNumber = ReadLE32(p + 32);
+        std::memcpy(tri.transactionHash.begin(), p + 36, 32);
+        tri.transactionIndex = ReadLE32(p + 68);
+        tri.from = dev::Address(p + 72, dev::Address::ConstructFromPointer);
+        tri.to = dev::Address(p + 92, dev::Address::ConstructFromPointer);
+        tri.cumulativeGasUsed = ReadLE64(p + 112);
+        tri.gasUsed = ReadLE64(p + 120);
+        tri.contractAddress = dev::Address(p + 128, dev::Address::ConstructFromPointer);
+        tri.excepted = static_cast<dev::eth::TransactionException>(ReadLE32(p + 148));
+        tri.outputIndex = ReadLE32(p + 152);
+        tri.stateRoot = dev::h256(p + 156, dev::h256::ConstructFromPointer);
+        tri.utxoRoot = dev::h256(p + 188, dev::h256::ConstructFromPointer);
+        p += RECEIPT_INFO_SIZE;
+    }
+    for(TransactionReceiptInfo& tri : result){
+        uint32_t size;
+        const unsigned char* message;
+        if(!reader.ReadU32(size) || !(message = reader.Read(size)))
+            return false;
+        tri.exceptedMessage.assign(reinterpret_cast<const char*>(message), size);
+    }
+    return reader.Empty();
+}
+
+static std::string EncodeBlooms(std::vector<TransactionReceiptInfo> const& result)
+{
+    std::string out;
+    out.reserve(4 + result.size() * dev::eth::LogBloom::size);
+    AppendLE32(out, result.size());
+    for(TransactionReceiptInfo const& tri : result)
+        AppendBytes(out, tri.bloom.data(), dev::eth::LogBloom::size);
+    return out;
+}
+
+static bool DecodeBlooms(std::string const& value, std::vector<dev::eth::LogBloom>& blooms)
+{
+    ColumnReader reader(value);
+    uint32_t count;
+    if(!reader.ReadCount(count, dev::eth::LogBloom::size))
+        return false;
+
+    blooms.reserve(count);
+    for(uint32_t i = 0; i < count; i++)
+        blooms.emplace_back(reader.Read(dev::eth::LogBloom::size), dev::eth::LogBloom::ConstructFromPointer);
+    return reader.Empty();
+}
+
+static std::string EncodeLogs(std::vector<TransactionReceiptInfo> const& result)
+{
+    std::string out;
+    AppendLE32(out, result.size());
+    for(TransactionReceiptInfo const& tri : result){
+        AppendLE32(out, tri.logs.size());
+        for(dev::eth::LogEntry const& log : tri.logs){
+            AppendBytes(out, log.address.data(), 20);
+            AppendLE32(out, log.topics.size());
+            for(dev::h256 const& topic : log.topics)
+                AppendBytes(out, topic.data(), 32);
+            AppendLE32(out, log.data.size());
+            AppendBytes(out, log.data.data(), log.data.size());
+        }
+    }
+    return out;
+}
+
+static bool DecodeLogs(std::string const& value, std::vector<dev::eth::LogEntries>& logs)
+{
+    ColumnReader reader(value);
+    uint32_t count;
+    if(!reader.ReadCount(count, 4))
+        return false;
+
+    logs.resize(count);
+    for(dev::eth::LogEntries& entries : logs){
+        uint32_t nLogs;
+        if(!reader.ReadCount(nLogs, 28))
+            return false;
+        entries.reserve(nLogs);
+        for(uint32_t i = 0; i < nLogs; i++){
+            const unsigned char* address = reader.Read(20);
+            uint32_t nTopics;
+            if(!address || !reader.ReadCount(nTopics, 32))
+                return false;
+            dev::h256s topics;
+            topics.reserve(nTopics);
+            for(uint32_t j = 0; j < nTopics; j++)
+                topics.emplace_back(reader.Read(32), dev::h256::ConstructFromPointer);
+            uint32_t size;
+            const unsigned char* data;
+            if(!reader.ReadU32(size) || !(data = reader.Read(size)))
+                return false;
+            entries.push_back(dev::eth::LogEntry(dev::Address(address, dev::Address::ConstructFromPointer), topics, dev::bytes(data, data + size)));
+        }
+    }
+    return reader.Empty();
+}
 
 StorageResults::StorageResults(std::string const& _path){
 	path = _path + "/resultsDB";
@@ -9,6 +218,7 @@ StorageResults::StorageResults(std::string const& _path){
     leveldb::Status status = leveldb::DB::Open(options, path, &db);
     assert(status.ok());
     LogPrintf("Opened LevelDB successfully\n");
+    upgradeResults();
 }
 
 StorageResults::~StorageResults()
@@ -37,90 +247,162 @@ void StorageResults::wipeResults(){
         options.create_if_missing = true;
         leveldb::Status status = leveldb::DB::Open(options, path, &db);
         assert(status.ok());
+        upgradeResults();
     }
 }
 
 void StorageResults::deleteResults(std::vector<CTransactionRef> const& txs){
 
+    leveldb::WriteBatch batch;
     for(CTransactionRef tx : txs){
         dev::h256 hashTx = uintToh256(tx->GetHash());
         m_cache_result.erase(hashTx);
 
-        std::string keyTemp = hashTx.hex();
-	    leveldb::Slice key(keyTemp);
-        leveldb::Status status = db->Delete(leveldb::WriteOptions(), key);
-        assert(status.ok());
+        batch.Delete(ReceiptKey(ReceiptColumn::INFO, hashTx));
+        batch.Delete(ReceiptKey(ReceiptColumn::BLOOM, hashTx));
+        batch.Delete(ReceiptKey(ReceiptColumn::LOGS, hashTx));
     }
+    leveldb::Status status = db->Write(leveldb::WriteOptions(), &batch);
+    assert(status.ok());
 }
 
 std::vector<TransactionReceiptInfo> StorageResults::getResult(dev::h256 const& hashTx){
     std::vector<TransactionReceiptInfo> result;
 	auto it = m_cache_result.find(hashTx);
 	if (it == m_cache_result.end()){
-		if(readResult(hashTx, result))
-			m_cache_result.insert(std::make_pair(hashTx, result));
+		readResult(hashTx, result);
     } else {
 		result = it->second;
     }
 	return result;
 }
 
+bool StorageResults::getResultLogs(dev::h256 const& hashTx, std::vector<dev::eth::LogEntries>& logs){
+    logs.clear();
+	auto it = m_cache_result.find(hashTx);
+	if (it != m_cache_result.end()){
+        for(TransactionReceiptInfo const& tri : it->second)
+            logs.push_back(tri.logs);
+        return true;
+    }
+
+    std::string value;
+    leveldb::Status s = db->Get(leveldb::ReadOptions(), ReceiptKey(ReceiptColumn::LOGS, hashTx), &value);
+    if(!s.ok() || !DecodeLogs(value, logs)){
+        logs.clear();
+        return false;
+    }
+    return true;
+}
+
+bool StorageResults::getResultBlooms(dev::h256 const& hashTx, std::vector<dev::eth::LogBloom>& blooms){
+    blooms.clear();
+	auto it = m_cache_result.find(hashTx);
+	if (it != m_cache_result.end()){
+        for(TransactionReceiptInfo const& tri : it->second)
+            blooms.push_back(tri.bloom);
+        return true;
+    }
+
+    std::string value;
+    leveldb::Status s = db->Get(leveldb::ReadOptions(), ReceiptKey(ReceiptColumn::BLOOM, hashTx), &value);
+    if(!s.ok() || !DecodeBlooms(value, blooms)){
+        blooms.clear();
+        return false;
+    }
+    return true;
+}
+
 void StorageResults::commitResults(){
     if(m_cache_result.size()){
 
+        // The receipts of a transaction are removed by deleteResults when its block is
+        // disconnected, so the cached receipts are written without reading the old ones
+        leveldb::WriteBatch batch;
         for (auto const& i: m_cache_result){
-            std::string valueTemp;
-            std::string keyTemp = i.first.hex();
-            leveldb::Slice key(keyTemp);
-            leveldb::Status status = db->Get(leveldb::ReadOptions(), key, &valueTemp);
-
-            if(status.IsNotFound()){
-
-                TransactionReceiptInfoSerialized tris;
-
-                for(size_t j = 0; j < i.second.size(); j++){
-                    tris.blockHashes.push_back(uintToh256(i.second[j].blockHash));
-                    tris.blockNumbers.push_back(i.second[j].blockNumber);
-                    tris.transactionHashes.push_back(uintToh256(i.second[j].transactionHash));
-                    tris.transactionIndexes.push_back(i.second[j].transactionIndex);
-                    tris.senders.push_back(i.second[j].from);
-                    tris.receivers.push_back(i.second[j].to);
-                    tris.cumulativeGasUsed.push_back(dev::u256(i.second[j].cumulativeGasUsed));
-                    tris.gasUsed.push_back(dev::u256(i.second[j].gasUsed));
-                    tris.contractAddresses.push_back(i.second[j].contractAddress);
-                    tris.logs.push_back(logEntriesSerialization(i.second[j].logs));
-                    tris.excepted.push_back(uint32_t(static_cast<int>(i.second[j].excepted)));
-                    tris.exceptedMessage.push_back(i.second[j].exceptedMessage);
-                    tris.outputIndexes.push_back(i.second[j].outputIndex);
-                    tris.blooms.push_back(i.second[j].bloom);
-                    tris.stateRoots.push_back(i.second[j].stateRoot);
-                    tris.utxoRoots.push_back(i.second[j].utxoRoot);
-                }
-
-                dev::RLPStream streamRLP(16);
-                streamRLP << tris.blockHashes << tris.blockNumbers << tris.transactionHashes << tris.transactionIndexes << tris.senders;
-                streamRLP << tris.receivers << tris.cumulativeGasUsed << tris.gasUsed << tris.contractAddresses << tris.logs << tris.excepted << tris.exceptedMessage << tris.outputIndexes << tris.blooms << tris.stateRoots << tris.utxoRoots;
-
-                dev::bytes data = streamRLP.out();
-                std::string stringData(data.begin(), data.end());
-                leveldb::Slice value(stringData);
-                status = db->Put(leveldb::WriteOptions(), key, value);
-                assert(status.ok());
-            }
+            writeResult(batch, i.first, i.second);
         }
+        leveldb::Status status = db->Write(leveldb::WriteOptions(), &batch);
+        assert(status.ok());
         m_cache_result.clear();
     }
 }
 
+void StorageResults::writeResult(leveldb::WriteBatch& batch, dev::h256 const& hashTx, std::vector<TransactionReceiptInfo> const& result){
+    batch.Put(ReceiptKey(ReceiptColumn::INFO, hashTx), EncodeInfo(result));
+    batch.Put(ReceiptKey(ReceiptColumn::BLOOM, hashTx), EncodeBlooms(result));
+    batch.Put(ReceiptKey(ReceiptColumn::LOGS, hashTx), EncodeLogs(result));
+}
+
 bool StorageResults::readResult(dev::h256 const& _key, std::vector<TransactionReceiptInfo>& _result){
 
-    std::string value;
-    std::string keyTemp = _key.hex();;
-    leveldb::Slice key(keyTemp);
-    leveldb::Status s = db->Get(leveldb::ReadOptions(), key, &value);
+    std::string info, blooms, logs;
+    if(!db->Get(leveldb::ReadOptions(), ReceiptKey(ReceiptColumn::INFO, _key), &info).ok() ||
+       !db->Get(leveldb::ReadOptions(), ReceiptKey(ReceiptColumn::BLOOM, _key), &blooms).ok() ||
+       !db->Get(leveldb::ReadOptions(), ReceiptKey(ReceiptColumn::LOGS, _key), &logs).ok())
+        return false;
+
+    std::vector<TransactionReceiptInfo> result;
+    std::vector<dev::eth::LogBloom> resultBlooms;
+    std::vector<dev::eth::LogEntries> resultLogs;
+    if(!DecodeInfo(info, result) || !DecodeBlooms(blooms, resultBlooms) || !DecodeLogs(logs, resultLogs) ||
+       resultBlooms.size() != result.size() || resultLogs.size() != result.size()){
+        LogPrintf("%s: Corrupted receipts of %s\n", __func__, _key.hex());
+        return false;
+    }
+
+    for(size_t j = 0; j < result.size(); j++){
+        result[j].bloom = resultBlooms[j];
+        result[j].logs = std::move(resultLogs[j]);
+        _result.push_back(std::move(result[j]));
+    }
+    return true;
+}
+
+void StorageResults::upgradeResults(){
+    std::string version;
+    leveldb::Status s = db->Get(leveldb::ReadOptions(), std::string(1, RECEIPTS_VERSION_KEY), &version);
+    if(s.ok() && version.size() == 1 && uint8_t(version[0]) >= RECEIPTS_DB_VERSION)
+        return;
 
-	if(!s.IsNotFound() && s.ok()){
-        
+    // Receipts before version 1 are RLP encoded and keyed by the hex string of the transaction hash
+    size_t upgraded = 0;
+    leveldb::WriteBatch batch;
+    std::unique_ptr<leveldb::Iterator> it(db->NewIterator(leveldb::ReadOptions()));
+    for(it->SeekToFirst(); it->Valid(); it->Next()){
+        std::string key = it->key().ToString();
+        if(key.size() != 64 || !IsHex(key))
+            continue;
+
+        std::vector<TransactionReceiptInfo> result;
+        if(readLegacyResult(it->value().ToString(), result))
+            writeResult(batch, dev::h256(key), result);
+        else
+            LogPrintf("%s: Dropping corrupted receipts of %s\n", __func__, key);
+        batch.Delete(key);
+
+        if(++upgraded % UPGRADE_BATCH_SIZE == 0){
+            leveldb::Status status = db->Write(leveldb::WriteOptions(), &batch);
+            assert(status.ok());
+            batch.Clear();
+            LogPrintf("Upgrading receipts database... [%u transactions]\n", upgraded);
+        }
+    }
+    assert(it->status().ok());
+    it.reset();
+
+    batch.Put(std::string(1, RECEIPTS_VERSION_KEY), std::string(1, char(RECEIPTS_DB_VERSION)));
+    leveldb::WriteOptions options;
+    options.sync = true;
+    leveldb::Status status = db->Write(options, &batch);
+    assert(status.ok());
+    if(upgraded)
+        LogPrintf("Upgraded receipts database to version %u, %u transactions converted\n", RECEIPTS_DB_VERSION, upgraded);
+}
+
+bool StorageResults::readLegacyResult(std::string const& value, std::vector<TransactionReceiptInfo>& _result){
+
+    try{
         TransactionReceiptInfoSerialized tris;
 
 		dev::RLP state(value);
@@ -168,17 +450,12 @@ bool StorageResults::readResult(dev::h256 const& _key, std::vector<TransactionRe
             };
             _result.push_back(tri);
         }
-		return true;
 	}
-	return false;
-}
-
-logEntriesSerialize StorageResults::logEntriesSerialization(dev::eth::LogEntries const& _logs){
-	logEntriesSerialize result;
-	for(dev::eth::LogEntry i : _logs){
-		result.push_back(std::make_pair(i.address, std::make_pair(i.topics, i.data)));
-	}
-	return result;
+    catch(const std::exception&){
+        _result.clear();
+        return false;
+    }
+	return true;
 }
 
 dev::eth::LogEntries StorageResults::logEntriesDeserialize(logEntriesSerialize const& _logs){
@@ -3,6 +3,7 @@
 #include <libethereum/State.h>
 #include <libethereum/Transaction.h>
 #include <leveldb/db.h>
+#include <leveldb/write_batch.h>
 #include <common/system.h>
 
 using logEntriesSerialize = std::vector<std::pair<dev::Address, std::pair<dev::h256s, dev::bytes>>>;
@@ -26,6 +27,7 @@ struct TransactionReceiptInfo{
     dev::h256 utxoRoot;
 };
 
+/** RLP encoding of the receipts of a transaction in resultsDB before RECEIPTS_DB_VERSION 1 */
 struct TransactionReceiptInfoSerialized{
     std::vector<dev::h256> blockHashes;
     std::vector<uint32_t> blockNumbers;
@@ -45,6 +47,33 @@ struct TransactionReceiptInfoSerialized{
     std::vector<dev::h256> utxoRoots;
 };
 
+/**
+ * Receipt store version, written under the key RECEIPTS_VERSION_KEY.
+ * Version 1 keys the receipts by the binary transaction hash, prefixed by the column.
+ */
+static const uint8_t RECEIPTS_DB_VERSION = 1;
+
+/**
+ * Columns of the receipt store, the first byte of every key.
+ *
+ * Every column holds the receipts of one transaction (one per contract output) and starts
+ * with the number of receipts as a 32 bit little endian integer:
+ * - INFO: fixed width records of RECEIPT_INFO_SIZE bytes followed by the exception messages
+ * - BLOOM: the 256 byte log blooms
+ * - LOGS: the log entries of every receipt
+ * The fixed width fields are decoded in place, so the RPC calls only read the columns they use.
+ */
+enum class ReceiptColumn : char {
+    INFO = 'R',
+    BLOOM = 'B',
+    LOGS = 'L',
+};
+
+static const char RECEIPTS_VERSION_KEY = 'V';
+
+/** Size of a receipt in the INFO column, without the exception message */
+static const size_t RECEIPT_INFO_SIZE = 220;
+
 class StorageResults{
 
 public:
@@ -58,6 +87,13 @@ public:
 
     std::vector<TransactionReceiptInfo> getResult(dev::h256 const& hashTx);
 
+    /** Read only the logs of the receipts of a transaction, one entry per receipt */
+    bool getResultLogs(dev::h256 const& hashTx, std::vector<dev::eth::LogEntries>& logs);
+
+    /** Read only the log blooms of the receipts of a transaction, one entry per receipt */
+    bool getResultBlooms(dev::h256 const& hashTx, std::vector<dev::eth::LogBloom>& blooms);
+
+    /** Write the cached receipts in a single batch */
 	void commitResults();
 
     void clearCacheResult();
@@ -68,7 +104,12 @@ private:
 
 	bool readResult(dev::h256 const& _key, std::vector<TransactionReceiptInfo>& _result);
 
-	logEntriesSerialize logEntriesSerialization(dev::eth::LogEntries const& _logs);
+    void writeResult(leveldb::WriteBatch& batch, dev::h256 const& hashTx, std::vector<TransactionReceiptInfo> const& result);
+
+    /** Convert the receipts stored by an older version in place */
+    void upgradeResults();
+
+	bool readLegacyResult(std::string const& value, std::vector<TransactionReceiptInfo>& _result);
 
 	dev::eth::LogEntries logEntriesDeserialize(logEntriesSerialize const& _logs);
 
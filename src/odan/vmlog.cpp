@@ -0,0 +1,274 @@
+#include <odan/vmlog.h>
+#include <crypto/common.h>
+#include <logging.h>
+#include <streams.h>
+#include <util/fs_helpers.h>
+#include <util/strencodings.h>
+#include <util/thread.h>
+
+#include <map>
+#include <optional>
+
+static const uint8_t DB_VMLOG_BLOCK = 'b';
+static const uint8_t DB_VMLOG_TX = 't';
+
+VMLogWriter::VMLogWriter(const fs::path& _dir, bool fWipe, uint64_t _nSegmentSize) :
+    dir(_dir),
+    nSegmentSize(_nSegmentSize)
+{
+    fs::create_directories(dir);
+    index = std::make_unique<CDBWrapper>(DBParams{
+        .path = dir / "index",
+        .cache_bytes = 8 << 20,
+        .wipe_data = fWipe});
+
+    uint32_t segment = 0;
+    if(fWipe){
+        for(; fs::exists(GetSegmentPath(segment)); segment++)
+            fs::remove(GetSegmentPath(segment));
+        segment = 0;
+    } else {
+        while(fs::exists(GetSegmentPath(segment + 1)))
+            segment++;
+    }
+    nSegment = segment;
+
+    if(!OpenSegment())
+        throw std::runtime_error("Failed to open the VM log segment " + fs::PathToString(GetSegmentPath(segment)));
+
+    threadWrite = std::thread(&util::TraceThread, "vmlog", [this] { ThreadWrite(); });
+}
+
+VMLogWriter::~VMLogWriter()
+{
+    {
+        LOCK(cs);
+        fStop = true;
+    }
+    condWriter.notify_all();
+    condProducer.notify_all();
+    if(threadWrite.joinable())
+        threadWrite.join();
+    if(file){
+        FileCommit(file);
+        fclose(file);
+    }
+}
+
+fs::path VMLogWriter::GetSegmentPath(uint32_t segment) const
+{
+    return dir / fs::u8path(strprintf("vmlog_%05u.dat", segment));
+}
+
+void VMLogWriter::Push(VMLogRecord&& record)
+{
+    {
+        WAIT_LOCK(cs, lock);
+        condProducer.wait(lock, [this]() EXCLUSIVE_LOCKS_REQUIRED(cs) { return queue.size() < VMLOG_QUEUE_SIZE || fStop; });
+        queue.push_back(std::move(record));
+    }
+    condWriter.notify_one();
+}
+
+void VMLogWriter::Flush()
+{
+    WAIT_LOCK(cs, lock);
+    condProducer.wait(lock, [this]() EXCLUSIVE_LOCKS_REQUIRED(cs) { return (queue.empty() && !fWriting) || fStop; });
+}
+
+void VMLogWriter::ThreadWrite()
+{
+    while(true){
+        std::vector<VMLogRecord> records;
+        {
+            WAIT_LOCK(cs, lock);
+            condWriter.wait(lock, [this]() EXCLUSIVE_LOCKS_REQUIRED(cs) { return !queue.empty() || fStop; });
+            // The queued records are written before stopping
+            if(queue.empty())
+                return;
+            records.assign(std::make_move_iterator(queue.begin()), std::make_move_iterator(queue.end()));
+            queue.clear();
+            fWriting = true;
+        }
+        condProducer.notify_all();
+
+        if(!WriteRecords(records))
+            LogPrintf("Failed to write %u VM log records to %s\n", records.size(), fs::PathToString(dir));
+
+        {
+            LOCK(cs);
+            fWriting = false;
+        }
+        condProducer.notify_all();
+    }
+}
+
+bool VMLogWriter::OpenSegment()
+{
+    fs::path path = GetSegmentPath(nSegment);
+    uint64_t size = 0;
+
+    // Find the end of the last complete record
+    AutoFile filein{fsbridge::fopen(path, "rb")};
+    if(!filein.IsNull()){
+        uint64_t fileEnd = fs::file_size(path);
+        unsigned char buf[4];
+        while(size + sizeof(buf) <= fileEnd &&
+              std::fseek(filein.Get(), size, SEEK_SET) == 0 &&
+              std::fread(buf, 1, sizeof(buf), filein.Get()) == sizeof(buf)){
+            uint32_t length = ReadLE32(buf);
+            if(length > VMLOG_MAX_RECORD_SIZE || size + sizeof(buf) + length > fileEnd)
+                break;
+            size += sizeof(buf) + length;
+        }
+        if(size != fileEnd)
+            LogPrintf("Dropping an incomplete record from the VM log segment %s\n", fs::PathToString(path));
+    }
+    filein.fclose();
+
+    file = fsbridge::fopen(path, "ab");
+    if(!file || !TruncateFile(file, size))
+        return false;
+    fileSize = size;
+    return true;
+}
+
+bool VMLogWriter::WriteRecords(const std::vector<VMLogRecord>& records)
+{
+    std::map<std::pair<uint8_t, uint256>, std::vector<VMLogPos>> positions;
+    for(const VMLogRecord& record : records){
+        DataStream ss{};
+        ss << record;
+        uint64_t size = sizeof(uint32_t) + ss.size();
+
+        // Start a new segment when the record does not fit
+        if(fileSize > 0 && fileSize + size > nSegmentSize){
+            FileCommit(file);
+            fclose(file);
+            file = nullptr;
+            nSegment++;
+            if(!OpenSegment())
+                return false;
+        }
+
+        unsigned char length[4];
+        WriteLE32(length, ss.size());
+        if(std::fwrite(length, 1, sizeof(length), file) != sizeof(length) ||
+           std::fwrite(ss.data(), 1, ss.size(), file) != ss.size())
+            return false;
+
+        VMLogPos pos{nSegment, fileSize};
+        fileSize += size;
+        if(!record.blockHash.IsNull())
+            positions[std::make_pair(DB_VMLOG_BLOCK, record.blockHash)].push_back(pos);
+        if(!record.txid.IsNull())
+            positions[std::make_pair(DB_VMLOG_TX, record.txid)].push_back(pos);
+    }
+    if(std::fflush(file) != 0)
+        return false;
+
+    // The records of a block are queued one transaction at a time, append to the stored positions
+    CDBBatch batch(*index);
+    for(const auto& item : positions){
+        std::vector<VMLogPos> stored;
+        index->Read(item.first, stored);
+        stored.insert(stored.end(), item.second.begin(), item.second.end());
+        batch.Write(item.first, stored);
+    }
+    return index->WriteBatch(batch);
+}
+
+bool VMLogWriter::ReadRecord(std::FILE* in, VMLogRecord& record)
+{
+    unsigned char buf[4];
+    if(std::fread(buf, 1, sizeof(buf), in) != sizeof(buf))
+        return false;
+    uint32_t length = ReadLE32(buf);
+    if(length > VMLOG_MAX_RECORD_SIZE)
+        return false;
+    std::vector<unsigned char> data(length);
+    if(std::fread(data.data(), 1, length, in) != length)
+        return false;
+    try{
+        DataStream ss{data};
+        ss >> record;
+    } catch(const std::exception&){
+        return false;
+    }
+    return true;
+}
+
+bool VMLogWriter::ReadPositions(const std::pair<uint8_t, uint256>& key, std::vector<VMLogRecord>& records)
+{
+    std::vector<VMLogPos> positions;
+    if(!index->Read(key, positions))
+        return false;
+
+    // The positions are in the order of the segments
+    std::optional<AutoFile> filein;
+    uint32_t segment = 0;
+    for(const VMLogPos& pos : positions){
+        if(!filein || pos.segment != segment){
+            filein.emplace(fsbridge::fopen(GetSegmentPath(pos.segment), "rb"));
+            segment = pos.segment;
+        }
+        VMLogRecord record;
+        if(filein->IsNull() || std::fseek(filein->Get(), pos.offset, SEEK_SET) != 0 || !ReadRecord(filein->Get(), record))
+            return error("%s: Failed to read the VM log record at %u:%u", __func__, pos.segment, pos.offset);
+        records.push_back(std::move(record));
+    }
+    return true;
+}
+
+bool VMLogWriter::ReadBlock(const uint256& blockHash, std::vector<VMLogRecord>& records)
+{
+    return ReadPositions(std::make_pair(DB_VMLOG_BLOCK, blockHash), records);
+}
+
+bool VMLogWriter::ReadTx(const uint256& txid, std::vector<VMLogRecord>& records)
+{
+    return ReadPositions(std::make_pair(DB_VMLOG_TX, txid), records);
+}
+
+bool VMLogWriter::ReadSegment(uint32_t segment, std::vector<VMLogRecord>& records)
+{
+    AutoFile filein{fsbridge::fopen(GetSegmentPath(segment), "rb")};
+    if(filein.IsNull())
+        return false;
+
+    // A record that is still being written is not complete yet
+    VMLogRecord record;
+    while(ReadRecord(filein.Get(), record))
+        records.push_back(std::move(record));
+    return true;
+}
+
+UniValue VMLogRecordToJSON(const VMLogRecord& record)
+{
+    UniValue result(UniValue::VOBJ);
+    if(!record.txid.IsNull())
+        result.pushKV("txid", record.txid.GetHex());
+    result.pushKV("address", HexStr(record.address));
+    result.pushKV("time", record.time);
+    if(!record.blockHash.IsNull())
+        result.pushKV("blockhash", record.blockHash.GetHex());
+    result.pushKV("blockheight", record.blockHeight);
+    UniValue logEntries(UniValue::VARR);
+    for(const VMLogEntry& log : record.entries){
+        UniValue logEntrie(UniValue::VOBJ);
+        logEntrie.pushKV("address", HexStr(log.address));
+        UniValue topics(UniValue::VARR);
+        for(const uint256& topic : log.topics){
+            UniValue topicPair(UniValue::VOBJ);
+            topicPair.pushKV("raw", HexStr(topic));
+            topics.push_back(topicPair);
+        }
+        UniValue dataPair(UniValue::VOBJ);
+        dataPair.pushKV("raw", HexStr(log.data));
+        logEntrie.pushKV("data", dataPair);
+        logEntrie.pushKV("topics", topics);
+        logEntries.push_back(logEntrie);
+    }
+    result.pushKV("entries", logEntries);
+    return result;
+}
@@ -0,0 +1,135 @@
+#ifndef ODANVMLOG_H
+#define ODANVMLOG_H
+
+#include <dbwrapper.h>
+#include <serialize.h>
+#include <sync.h>
+#include <uint256.h>
+#include <univalue.h>
+#include <util/fs.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <vector>
+
+/** One EVM LOG operation */
+struct VMLogEntry{
+    uint160 address;
+    std::vector<uint256> topics;
+    std::vector<unsigned char> data;
+
+    SERIALIZE_METHODS(VMLogEntry, obj) { READWRITE(obj.address, obj.topics, obj.data); }
+};
+
+/**
+ * The LOG operations of one contract execution.
+ * Transactions executed by callcontract have no txid and no block hash.
+ * The addresses and topics keep the byte order of the EVM.
+ */
+struct VMLogRecord{
+    uint256 txid;
+    uint256 blockHash;
+    int32_t blockHeight{0};
+    int64_t time{0};
+    uint160 address;
+    std::vector<VMLogEntry> entries;
+
+    SERIALIZE_METHODS(VMLogRecord, obj) { READWRITE(obj.txid, obj.blockHash, obj.blockHeight, obj.time, obj.address, obj.entries); }
+};
+
+/** Position of a record in the segments */
+struct VMLogPos{
+    uint32_t segment{0};
+    uint64_t offset{0};
+
+    SERIALIZE_METHODS(VMLogPos, obj) { READWRITE(obj.segment, obj.offset); }
+};
+
+/** Maximum size of a segment file, a new segment is started when a record does not fit */
+static const uint64_t VMLOG_SEGMENT_SIZE = 128 << 20;
+
+/** Number of records waiting for the writer thread before the validation thread blocks */
+static const size_t VMLOG_QUEUE_SIZE = 10000;
+
+/** Maximum size of a record, larger lengths are corrupted data */
+static const uint32_t VMLOG_MAX_RECORD_SIZE = 64 << 20;
+
+/**
+ * Append-only binary log of the EVM LOG operations recorded with -record-log-opcodes.
+ *
+ * The records are stored in the segments vmlogs/vmlog_NNNNN.dat as a 32 bit little endian
+ * length followed by the serialized VMLogRecord. Push() only queues the record, the segments
+ * and the index are written by a background thread. The index vmlogs/index maps the block
+ * hashes and the txids to the positions of their records, so the records of one block or
+ * transaction are read without scanning the segments.
+ */
+class VMLogWriter{
+
+public:
+
+    VMLogWriter(const fs::path& _dir, bool fWipe = false, uint64_t _nSegmentSize = VMLOG_SEGMENT_SIZE);
+    ~VMLogWriter();
+
+    VMLogWriter(const VMLogWriter&) = delete;
+    VMLogWriter& operator=(const VMLogWriter&) = delete;
+
+    /** Queue a record for the writer thread, blocks while the queue is full */
+    void Push(VMLogRecord&& record) EXCLUSIVE_LOCKS_REQUIRED(!cs);
+
+    /** Wait until every queued record is written */
+    void Flush() EXCLUSIVE_LOCKS_REQUIRED(!cs);
+
+    bool ReadBlock(const uint256& blockHash, std::vector<VMLogRecord>& records);
+
+    bool ReadTx(const uint256& txid, std::vector<VMLogRecord>& records);
+
+    /** Read every record of a segment, returns false when the segment does not exist */
+    bool ReadSegment(uint32_t segment, std::vector<VMLogRecord>& records);
+
+    uint32_t GetLastSegment() const { return nSegment; }
+
+    fs::path GetSegmentPath(uint32_t segment) const;
+
+private:
+
+    void ThreadWrite() EXCLUSIVE_LOCKS_REQUIRED(!cs);
+
+    /** Append the records to the segments and write their positions to the index */
+    bool WriteRecords(const std::vector<VMLogRecord>& records);
+
+    /** Open the last segment for appending, dropping a record left incomplete by a crash */
+    bool OpenSegment();
+
+    bool ReadPositions(const std::pair<uint8_t, uint256>& key, std::vector<VMLogRecord>& records);
+
+    static bool ReadRecord(std::FILE* in, VMLogRecord& record);
+
+    fs::path dir;
+
+    uint64_t nSegmentSize;
+
+    std::unique_ptr<CDBWrapper> index;
+
+    /** Segment appended by the writer thread */
+    std::atomic<uint32_t> nSegment{0};
+
+    /** Used by the writer thread only */
+    std::FILE* file{nullptr};
+    uint64_t fileSize{0};
+
+    mutable Mutex cs;
+    std::condition_variable condWriter;
+    std::condition_variable condProducer;
+    std::deque<VMLogRecord> queue GUARDED_BY(cs);
+    bool fWriting GUARDED_BY(cs){false};
+    bool fStop GUARDED_BY(cs){false};
+
+    std::thread threadWrite;
+};
+
+UniValue VMLogRecordToJSON(const VMLogRecord& record);
+
+#endif
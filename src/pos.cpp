@@ -10,6 +10,7 @@
 #include <validation.h>
 #include <arith_uint256.h>
 #include <hash.h>
+#include <crypto/common.h>
 #include <timedata.h>
 #include <chainparams.h>
 #include <script/sign.h>
@@ -211,7 +212,8 @@ bool CheckProofOfStake(CBlockIndex* pindexPrev, BlockValidationState& state, con
         // Get the delegation from the contract
         uint160 address = uint160(ExtractPublicKeyHash(coinHeaderPrev.out.scriptPubKey));
         Delegation delegation;
-        if(!odanDelegation.GetDelegation(address, delegation, chainstate)) {
+        AssertLockHeld(cs_main);
+        if(!odanDelegation.GetDelegation(address, delegation, chainstate, h256Touint(globalState->rootHash()))) {
             return state.Invalid(BlockValidationResult::BLOCK_HEADER_REJECT, "stake-get-delegation-failed", strprintf("CheckProofOfStake() : Failed to get delegation from the delegation contract")); // Internal error, get delegation from the delegation contract
         }
 
@@ -452,6 +454,93 @@ bool CheckKernelCache(CBlockIndex *pindexPrev, unsigned int nBits, uint32_t nTim
     return false;
 }
 
+StakeKernelBatch::StakeKernelBatch(CBlockIndex *_pindexPrev, unsigned int _nBits) :
+    pindexPrev(_pindexPrev),
+    nBits(_nBits)
+{
+    fNoBNOverflow = pindexPrev->nHeight + 1 >= Params().GetConsensus().QIP9Height;
+    bnTarget.SetCompact(nBits);
+}
+
+bool StakeKernelBatch::Add(const COutPoint &prevout, const std::map<COutPoint, CStakeCache> &cache)
+{
+    auto it = cache.find(prevout);
+    if(it != cache.end()) {
+        return Add(prevout, it->second);
+    }
+    return false;
+}
+
+bool StakeKernelBatch::Add(const COutPoint &prevout, const CStakeCache &stake)
+{
+    // A coin without value can not meet the target
+    if(stake.amount <= 0)
+        return false;
+
+    StakeKernel kernel;
+    kernel.prevout = prevout;
+    kernel.blockFromTime = stake.blockFromTime;
+
+    // Same serialization as in CheckStakeKernelHash(), without nTimeBlock
+    unsigned char data[4];
+    const uint256& nStakeModifier = pindexPrev->nStakeModifier;
+    kernel.hasher.Write(nStakeModifier.begin(), nStakeModifier.size());
+    WriteLE32(data, stake.blockFromTime);
+    kernel.hasher.Write(data, sizeof(data));
+    kernel.hasher.Write(prevout.hash.ToUint256().data(), prevout.hash.size());
+    WriteLE32(data, prevout.n);
+    kernel.hasher.Write(data, sizeof(data));
+
+    // Weighted target, the hash meets it when it is at most bnLimit
+    arith_uint256 bnWeight = arith_uint256(stake.amount);
+    kernel.fNoLimit = false;
+    if(fNoBNOverflow) {
+        // hash / weight <= target is hash < (target + 1) * weight
+        arith_uint256 bnTargetNext = bnTarget + 1;
+        if(bnTargetNext == 0 || bnTargetNext > ~arith_uint256() / bnWeight) {
+            kernel.fNoLimit = true;
+        } else {
+            kernel.bnLimit = bnTargetNext * bnWeight - 1;
+        }
+    } else {
+        kernel.bnLimit = bnTarget * bnWeight;
+    }
+
+    kernels.push_back(kernel);
+    return true;
+}
+
+bool StakeKernelBatch::Check(size_t i, uint32_t nTimeBlock, uint256 &hashProofOfStake) const
+{
+    const StakeKernel& kernel = kernels[i];
+    if(nTimeBlock < kernel.blockFromTime)
+        return false;
+
+    unsigned char data[4];
+    WriteLE32(data, nTimeBlock);
+    CSHA256 hasher(kernel.hasher);
+    hasher.Write(data, sizeof(data)).Finalize(hashProofOfStake.begin());
+    CSHA256().Write(hashProofOfStake.begin(), hashProofOfStake.size()).Finalize(hashProofOfStake.begin());
+
+    return kernel.fNoLimit || UintToArith256(hashProofOfStake) <= kernel.bnLimit;
+}
+
+void StakeKernelBatch::Check(size_t from, size_t to, uint32_t nTimeBlock, std::vector<std::pair<size_t, uint256>> &solved) const
+{
+    uint256 hashProofOfStake;
+    for(size_t i = from; i < to; i++) {
+        if(Check(i, nTimeBlock, hashProofOfStake)) {
+            solved.emplace_back(i, hashProofOfStake);
+        }
+    }
+}
+
+bool CStakeKernelCheck::operator()()
+{
+    batch->Check(from, to, nTimeBlock, *solved);
+    return true;
+}
+
 void CacheKernel(std::map<COutPoint, CStakeCache>& cache, const COutPoint& prevout, CBlockIndex* pindexPrev, CCoinsViewCache& view){
     if(cache.find(prevout) != cache.end()){
         //already in cache
@@ -545,7 +634,8 @@ bool GetDelegationFeeFromContract(const uint160& address, uint8_t& fee, Chainsta
 {
     Delegation delegation;
     OdanDelegation& odanDelegation = GetOdanDelegation();
-    bool ret = odanDelegation.GetDelegation(address, delegation, chainstate);
+    AssertLockHeld(cs_main);
+    bool ret = odanDelegation.GetDelegation(address, delegation, chainstate, h256Touint(globalState->rootHash()));
     if(ret) ret &= odanDelegation.VerifyDelegation(address, delegation);
     if(ret)
     {
@@ -17,6 +17,8 @@
 #include <consensus/consensus.h>
 #include <odan/posutils.h>
 
+class OdanDelegation;
+
 void CacheKernel(std::map<COutPoint, CStakeCache>& cache, const COutPoint& prevout, CBlockIndex* pindexPrev, CCoinsViewCache& view);
 
 // Compute the hash modifier for proof-of-stake
@@ -50,6 +52,70 @@ bool CheckKernel(CBlockIndex* pindexPrev, unsigned int nBits, uint32_t nTimeBloc
 bool CheckKernel(CBlockIndex* pindexPrev, unsigned int nBits, uint32_t nTimeBlock, const COutPoint& prevout, CCoinsViewCache& view, const std::map<COutPoint, CStakeCache>& cache, Chainstate& chainstate);
 bool CheckKernelCache(CBlockIndex* pindexPrev, unsigned int nBits, uint32_t nTimeBlock, const COutPoint& prevout, const std::map<COutPoint, CStakeCache>& cache, uint256& hashProofOfStake);
 
+// Kernel of one prevout prepared for the stake kernel search
+struct StakeKernel
+{
+    COutPoint prevout;
+    uint32_t blockFromTime;
+    // Hash state after nStakeModifier, blockFromTime, prevout.hash and prevout.n
+    CSHA256 hasher;
+    // The kernel meets the weighted target when its hash is at most bnLimit
+    arith_uint256 bnLimit;
+    // The weighted target overflows, every hash meets it
+    bool fNoLimit;
+};
+
+// Stake kernel search over many prevouts and block times
+// Only nTimeBlock changes between the kernels of a prevout, so the hash state of the
+// other 72 bytes and the weighted target are computed once when the prevout is added.
+// A check then costs two SHA256 compressions and a 256 bit comparison.
+// Gives the same result as CheckKernelCache()
+class StakeKernelBatch
+{
+public:
+    StakeKernelBatch(CBlockIndex* pindexPrev, unsigned int nBits);
+
+    // Add the kernel of the prevout, returns false when it is skipped
+    // Prevouts missing from the cache are skipped, as in CheckKernelCache()
+    bool Add(const COutPoint& prevout, const std::map<COutPoint, CStakeCache>& cache);
+    bool Add(const COutPoint& prevout, const CStakeCache& stake);
+
+    // Check the kernel of the prevout at index i for the block time
+    // Sets hashProofOfStake on success return
+    bool Check(size_t i, uint32_t nTimeBlock, uint256& hashProofOfStake) const;
+
+    // Check the kernels in [from, to) and append the index and the hash of the ones that meet the target
+    void Check(size_t from, size_t to, uint32_t nTimeBlock, std::vector<std::pair<size_t, uint256>>& solved) const;
+
+    size_t Size() const { return kernels.size(); }
+    const COutPoint& GetPrevout(size_t i) const { return kernels[i].prevout; }
+    bool IsFor(const CBlockIndex* pindex, unsigned int bits) const { return pindex == pindexPrev && bits == nBits; }
+
+private:
+    CBlockIndex* pindexPrev;
+    unsigned int nBits;
+    bool fNoBNOverflow;
+    arith_uint256 bnTarget;
+    std::vector<StakeKernel> kernels;
+};
+
+// Closure representing the stake kernel search of a range of prevouts for one block time
+class CStakeKernelCheck
+{
+private:
+    const StakeKernelBatch* batch;
+    size_t from;
+    size_t to;
+    uint32_t nTimeBlock;
+    std::vector<std::pair<size_t, uint256>>* solved;
+
+public:
+    CStakeKernelCheck(const StakeKernelBatch& batchIn, size_t fromIn, size_t toIn, uint32_t nTimeBlockIn, std::vector<std::pair<size_t, uint256>>& solvedIn) :
+        batch(&batchIn), from(fromIn), to(toIn), nTimeBlock(nTimeBlockIn), solved(&solvedIn) { }
+
+    bool operator()();
+};
+
 unsigned int GetStakeMaxCombineInputs();
 
 int64_t GetStakeCombineThreshold();
@@ -62,6 +128,9 @@ int GetDelegationFeeTx(const CTransaction& tx, const Coin& coin, bool delegateOu
 
 bool GetDelegationFeeFromContract(const uint160& address, uint8_t& fee, Chainstate& chainstate);
 
+// Delegation contract function
+OdanDelegation& GetOdanDelegation();
+
 unsigned int GetStakeSplitOutputs();
 
 int64_t GetStakeSplitThreshold();
@@ -139,6 +139,10 @@ bool Token::exec(const bool &sendTo, const std::map<std::string, std::string> &l
 
 bool Token::execEvents(const int64_t &fromBlock, const int64_t &toBlock, const int64_t &minconf, const std::string &eventName, const std::string &contractAddress, const std::string &senderAddress, const int &numTopics, std::vector<TokenEvent> &result)
 {
+    // Read the events from the token index of the node when it is enabled
+    if(d->model->node().getTokenEvents(fromBlock, toBlock, minconf, eventName, contractAddress, senderAddress, numTopics, result))
+        return true;
+
     QVariant resultVar;
     if(!(d->eventLog->searchTokenTx(d->model->node(), d->model, fromBlock, toBlock, minconf, eventName, contractAddress, senderAddress, numTopics, resultVar)))
         return false;
@@ -151,15 +155,17 @@ bool Token::execEvents(const int64_t &fromBlock, const int64_t &toBlock, const i
         QList<QVariant> listLog = variantMap.value("log").toList();
         for(int i = 0; i < listLog.size(); i++)
         {
-            // Skip the not needed events
+            // Skip the not needed events, the other logs of the transaction are not events of the holder
             QVariantMap variantLog = listLog[i].toMap();
             QList<QVariant> topicsList = variantLog.value("topics").toList();
-            if(topicsList.count() < numTopics) continue;
-            if(topicsList[0].toString().toStdString() != eventName) continue;
+            std::vector<std::string> topics;
+            for(const QVariant& topic : topicsList)
+                topics.push_back(topic.toString().toStdString());
+            if(!d->model->node().isHolderTokenEvent(variantLog.value("address").toString().toStdString(), topics, eventName, contractAddress, senderAddress, numTopics)) continue;
 
             // Create new event
             TokenEvent tokenEvent;
-            tokenEvent.address = variantMap.value("contractAddress").toString().toStdString();
+            tokenEvent.address = contractAddress;
             if(numTopics > 1)
             {
                 tokenEvent.sender = topicsList[1].toString().toStdString().substr(24);
@@ -12,12 +12,14 @@
 #include <blockfilter.h>
 #include <chain.h>
 #include <chainparams.h>
+#include <common/args.h>
 #include <core_io.h>
 #include <httpserver.h>
 #include <index/blockfilterindex.h>
 #include <index/txindex.h>
 #include <node/blockstorage.h>
 #include <node/context.h>
+#include <odan/receiptfeed.h>
 #include <primitives/block.h>
 #include <primitives/transaction.h>
 #include <rpc/blockchain.h>
@@ -31,10 +33,18 @@
 #include <util/any.h>
 #include <util/check.h>
 #include <util/strencodings.h>
+#include <util/thread.h>
+#include <util/time.h>
 #include <validation.h>
 
 #include <any>
+#include <condition_variable>
+#include <functional>
+#include <limits>
+#include <memory>
 #include <string>
+#include <thread>
+#include <vector>
 
 #include <univalue.h>
 
@@ -1001,6 +1011,195 @@ static bool rest_blockhash_by_height(const std::any& context, HTTPRequest* req,
     }
 }
 
+/** A receipt stream, written by the stream thread once its handler returned */
+struct ReceiptStream {
+    RESTResponseFormat rf;
+    uint64_t cursor;
+    std::function<std::string(const ReceiptFeedEvent&)> message;
+    SteadyClock::time_point lastWrite;
+    std::unique_ptr<HTTPRequest> req;
+};
+
+static int g_rest_streams{DEFAULT_REST_STREAMS};
+static Mutex g_receipt_streams_mutex;
+static std::condition_variable g_receipt_streams_cond;
+static std::vector<ReceiptStream> g_receipt_streams GUARDED_BY(g_receipt_streams_mutex);
+/** Streams written by the thread or still in their handler, at most -reststreams */
+static int g_receipt_streams_count GUARDED_BY(g_receipt_streams_mutex){0};
+static bool g_receipt_streams_stop GUARDED_BY(g_receipt_streams_mutex){false};
+static std::thread g_receipt_streams_thread;
+
+/**
+ * Write the events after the cursor of the stream, or an empty frame when it was idle for a second.
+ * Returns false when the connection is closed or the cursor fell behind the kept events.
+ */
+static bool WriteReceiptStream(HTTPRequest& req, ReceiptStream& stream, ReceiptFeed& feed)
+{
+    if (req.isConnClosed()) return false;
+    std::vector<ReceiptFeedEvent> events;
+    if (!feed.Wait(stream.cursor, events, std::chrono::milliseconds{0})) return false;
+    const SteadyClock::time_point now = SteadyClock::now();
+    if (events.empty() && req.isChunkMode() && now < stream.lastWrite + std::chrono::seconds{1}) return true;
+
+    std::string chunk;
+    if (events.empty()) {
+        chunk = stream.rf == RESTResponseFormat::BINARY ? std::string(4, '\0') : "\n";
+    }
+    for (const ReceiptFeedEvent& event : events) {
+        const std::string frame = stream.message(event);
+        if (stream.rf == RESTResponseFormat::BINARY) {
+            DataStream ss;
+            ss << uint32_t(frame.size());
+            chunk += ss.str() + frame;
+        } else {
+            chunk += HexStr(frame) + "\n";
+        }
+    }
+    // The chunk is sent by the libevent loop
+    req.Chunk(chunk);
+    stream.lastWrite = now;
+    return true;
+}
+
+static void EndReceiptStream(HTTPRequest& req) EXCLUSIVE_LOCKS_REQUIRED(!g_receipt_streams_mutex)
+{
+    if (!req.isChunkMode()) req.Chunk(std::string{});
+    req.ChunkEnd();
+    LOCK(g_receipt_streams_mutex);
+    --g_receipt_streams_count;
+}
+
+/** Write every stream when the feed has new events, and at least every second for the empty frames */
+static void ThreadReceiptStreams(ReceiptFeed* feed) EXCLUSIVE_LOCKS_REQUIRED(!g_receipt_streams_mutex)
+{
+    while (true) {
+        // Any event after this cursor wakes the thread, also the ones added while the streams are written
+        uint64_t cursor = *feed->GetCursor(std::numeric_limits<uint32_t>::max());
+        std::vector<ReceiptStream> ended;
+        {
+            LOCK(g_receipt_streams_mutex);
+            if (g_receipt_streams_stop) {
+                ended = std::move(g_receipt_streams);
+                g_receipt_streams.clear();
+            }
+            for (auto it = g_receipt_streams.begin(); it != g_receipt_streams.end();) {
+                if (WriteReceiptStream(*it->req, *it, *feed)) {
+                    ++it;
+                } else {
+                    ended.push_back(std::move(*it));
+                    it = g_receipt_streams.erase(it);
+                }
+            }
+        }
+        // Ending a stream can wait for the client to close the connection
+        for (ReceiptStream& stream : ended) {
+            EndReceiptStream(*stream.req);
+        }
+        if (WITH_LOCK(g_receipt_streams_mutex, return g_receipt_streams_stop)) break;
+
+        std::vector<ReceiptFeedEvent> events;
+        if (!feed->Wait(cursor, events, std::chrono::seconds{1})) {
+            WAIT_LOCK(g_receipt_streams_mutex, lock);
+            g_receipt_streams_cond.wait_for(lock, std::chrono::seconds{1}, []() EXCLUSIVE_LOCKS_REQUIRED(g_receipt_streams_mutex) { return g_receipt_streams_stop; });
+        }
+    }
+}
+
+/**
+ * Stream the messages of the blocks connected and disconnected from the height in the URI.
+ * Frames are a 32 bit little endian length followed by the message in binary format, and a
+ * line in hex format. An empty frame is sent every second to detect the closed connections.
+ * The handler writes the kept events and hands the request over to the stream thread, so a
+ * stream does not hold an HTTP worker thread.
+ */
+static bool rest_receipt_stream(HTTPRequest* req, const std::string& str_uri_part,
+                                std::function<std::string(const ReceiptFeedEvent&)> message)
+{
+    if (!CheckWarmup(req)) return false;
+    std::string height_str;
+    const RESTResponseFormat rf = ParseDataFormat(height_str, str_uri_part);
+    if (rf != RESTResponseFormat::BINARY && rf != RESTResponseFormat::HEX) {
+        return RESTERR(req, HTTP_NOT_FOUND, "output format not found (available: .bin, .hex)");
+    }
+
+    int32_t height{-1};
+    if (!ParseInt32(height_str, &height) || height < 0) {
+        return RESTERR(req, HTTP_BAD_REQUEST, "Invalid height: " + SanitizeString(height_str));
+    }
+    ReceiptFeed* feed = preceiptfeed.get();
+    if (!feed) {
+        return RESTERR(req, HTTP_NOT_FOUND, "Receipt feed disabled, start with -receiptfeed=<n>");
+    }
+    std::optional<uint64_t> cursor = feed->GetCursor(height);
+    if (!cursor) {
+        return RESTERR(req, HTTP_NOT_FOUND, "Block height no longer kept by the receipt feed");
+    }
+    {
+        LOCK(g_receipt_streams_mutex);
+        if (g_receipt_streams_stop || g_receipt_streams_count >= g_rest_streams) {
+            return RESTERR(req, HTTP_SERVICE_UNAVAILABLE, strprintf("Too many receipt streams (-reststreams=%d)", g_rest_streams));
+        }
+        ++g_receipt_streams_count;
+    }
+
+    req->WriteHeader("Content-Type", rf == RESTResponseFormat::BINARY ? "application/octet-stream" : "text/plain");
+    ReceiptStream stream{rf, *cursor, std::move(message), SteadyClock::now(), nullptr};
+    if (!WriteReceiptStream(*req, stream, *feed)) {
+        EndReceiptStream(*req);
+        return true;
+    }
+    req->Detach([rf, cursor = stream.cursor, message = std::move(stream.message), lastWrite = stream.lastWrite, feed](std::unique_ptr<HTTPRequest> detached) {
+        {
+            LOCK(g_receipt_streams_mutex);
+            if (!g_receipt_streams_stop) {
+                g_receipt_streams.push_back(ReceiptStream{rf, cursor, message, lastWrite, std::move(detached)});
+                if (!g_receipt_streams_thread.joinable()) {
+                    g_receipt_streams_thread = std::thread(&util::TraceThread, "reststream", [feed] { ThreadReceiptStreams(feed); });
+                }
+                return;
+            }
+        }
+        EndReceiptStream(*detached);
+    });
+    return true;
+}
+
+static bool rest_receipts(const std::any& context, HTTPRequest* req, const std::string& str_uri_part)
+{
+    return rest_receipt_stream(req, str_uri_part, ReceiptsMessage);
+}
+
+static bool rest_contract_logs(const std::any& context, HTTPRequest* req, const std::string& str_uri_part)
+{
+    ContractLogFilter filter;
+    try {
+        // Comma separated contract addresses, and topics by position with an empty one matching any
+        for (const std::string& address : SplitString(req->GetQueryParameter("address").value_or(""), ',')) {
+            if (address.empty()) continue;
+            if (address.size() != 40 || !IsHex(address)) {
+                return RESTERR(req, HTTP_BAD_REQUEST, "Invalid address: " + SanitizeString(address));
+            }
+            filter.addresses.insert(dev::Address(ParseHex(address)));
+        }
+        if (std::optional<std::string> topics = req->GetQueryParameter("topics")) {
+            for (const std::string& topic : SplitString(*topics, ',')) {
+                if (topic.empty()) {
+                    filter.topics.emplace_back(std::nullopt);
+                } else if (topic.size() != 64 || !IsHex(topic)) {
+                    return RESTERR(req, HTTP_BAD_REQUEST, "Invalid topic: " + SanitizeString(topic));
+                } else {
+                    filter.topics.emplace_back(dev::h256(ParseHex(topic)));
+                }
+            }
+        }
+    } catch (const std::runtime_error& e) {
+        return RESTERR(req, HTTP_BAD_REQUEST, e.what());
+    }
+    return rest_receipt_stream(req, str_uri_part, [filter](const ReceiptFeedEvent& event) {
+        return ContractLogsMessage(event, filter);
+    });
+}
+
 static const struct {
     const char* prefix;
     bool (*handler)(const std::any& context, HTTPRequest* req, const std::string& strReq);
@@ -1017,10 +1216,14 @@ static const struct {
       {"/rest/deploymentinfo/", rest_deploymentinfo},
       {"/rest/deploymentinfo", rest_deploymentinfo},
       {"/rest/blockhashbyheight/", rest_blockhash_by_height},
+      {"/rest/receipts/", rest_receipts},
+      {"/rest/contractlogs/", rest_contract_logs},
 };
 
 void StartREST(const std::any& context)
 {
+    g_rest_streams = gArgs.GetIntArg("-reststreams", DEFAULT_REST_STREAMS);
+    WITH_LOCK(g_receipt_streams_mutex, g_receipt_streams_stop = false);
     for (const auto& up : uri_prefixes) {
         auto handler = [context, up](HTTPRequest* req, const std::string& prefix) { return up.handler(context, req, prefix); };
         RegisterHTTPHandler(up.prefix, false, handler);
@@ -1029,6 +1232,8 @@ void StartREST(const std::any& context)
 
 void InterruptREST()
 {
+    WITH_LOCK(g_receipt_streams_mutex, g_receipt_streams_stop = true);
+    g_receipt_streams_cond.notify_all();
 }
 
 void StopREST()
@@ -1036,4 +1241,6 @@ void StopREST()
     for (const auto& up : uri_prefixes) {
         UnregisterHTTPHandler(up.prefix, false);
     }
+    InterruptREST();
+    if (g_receipt_streams_thread.joinable()) g_receipt_streams_thread.join();
 }
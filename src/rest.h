@@ -7,6 +7,9 @@
 
 #include <string>
 
+/** Default for -reststreams, the maximum number of REST receipt and contract log streams */
+static const int DEFAULT_REST_STREAMS = 16;
+
 enum class RESTResponseFormat {
     UNDEF,
     BINARY,
@@ -49,11 +49,15 @@
 #include <versionbits.h>
 #include <warnings.h>
 #include <libdevcore/CommonData.h>
+#include <libevm/CodeCache.h>
+#include <libdevcore/TrieNodeCache.h>
 #include <pow.h>
 #include <pos.h>
 #include <txdb.h>
 #include <util/convert.h>
 #include <odan/odandelegation.h>
+#include <odan/contractsnapshot.h>
+#include <common/system.h>
 #include <util/tokenstr.h>
 #include <rpc/contract_util.h>
 
@@ -1277,7 +1281,7 @@ RPCHelpMan waitforlogs()
         {
             LOCK(cs_main);
             curheight = chainman.m_blockman.m_block_tree_db->ReadHeightIndex(params.fromBlock, params.toBlock, params.minconf,
-                    hashesToBlock, addresses, chainman);
+                    hashesToBlock, addresses, chainman, logBloomFilter(addresses, filterTopics, true));
         }
 
         // if curheight >= fromBlock. Blockchain extended with new log entries. Return next block height to client.
@@ -1528,6 +1532,108 @@ RPCHelpMan gettransactionreceipt()
     };
 }
 
+RPCHelpMan getvmlogs()
+{
+    return RPCHelpMan{"getvmlogs",
+                "\nGet the EVM LOG operations recorded with -record-log-opcodes.\n"
+                "Without a hash the records of a segment are returned, by default the last one.\n",
+                {
+                    {"hash", RPCArg::Type::STR_HEX, RPCArg::Optional::OMITTED, "The block hash or the transaction hash"},
+                    {"segment", RPCArg::Type::NUM, RPCArg::Optional::OMITTED, "The segment number, when no hash is given"},
+                },
+               RPCResult{
+            RPCResult::Type::ARR, "", "",
+                {
+                    {RPCResult::Type::OBJ, "", "",
+                        {
+                            {RPCResult::Type::STR_HEX, "txid", /*optional=*/true, "The transaction hash"},
+                            {RPCResult::Type::STR_HEX, "address", "The created contract address"},
+                            {RPCResult::Type::NUM_TIME, "time", "The block time or the time of the call"},
+                            {RPCResult::Type::STR_HEX, "blockhash", /*optional=*/true, "The block hash"},
+                            {RPCResult::Type::NUM, "blockheight", "The block height"},
+                            {RPCResult::Type::ARR, "entries", "The LOG operations",
+                                {
+                                    {RPCResult::Type::OBJ, "", "",
+                                        {
+                                            {RPCResult::Type::STR_HEX, "address", "The contract address"},
+                                            {RPCResult::Type::OBJ, "data", "The logged data",
+                                                {{RPCResult::Type::STR_HEX, "raw", "The raw data"}}},
+                                            {RPCResult::Type::ARR, "topics", "The topics",
+                                                {{RPCResult::Type::OBJ, "", "",
+                                                    {{RPCResult::Type::STR_HEX, "raw", "The raw topic"}}}}},
+                                        }
+                                    }
+                                }
+                            },
+                        }}
+                }},
+                RPCExamples{
+                    HelpExampleCli("getvmlogs", "3b04bc73afbbcf02cfef2ca1127b60fb0baf5f8946a42df67f1659671a2ec53c")
+            + HelpExampleCli("getvmlogs", "\"\" 0")
+            + HelpExampleRpc("getvmlogs", "3b04bc73afbbcf02cfef2ca1127b60fb0baf5f8946a42df67f1659671a2ec53c")
+                },
+        [&](const RPCHelpMan& self, const JSONRPCRequest& request) -> UniValue
+{
+    if(!pvmlogwriter)
+        throw JSONRPCError(RPC_MISC_ERROR, "VM log recording disabled, start the node with -record-log-opcodes");
+
+    // Records still queued for the writer thread are not readable yet
+    pvmlogwriter->Flush();
+
+    std::vector<VMLogRecord> records;
+    if(!request.params[0].isNull() && !request.params[0].get_str().empty()){
+        uint256 hash = ParseHashV(request.params[0], "hash");
+        if(!pvmlogwriter->ReadBlock(hash, records))
+            pvmlogwriter->ReadTx(hash, records);
+    } else {
+        uint32_t segment = request.params[1].isNull() ? pvmlogwriter->GetLastSegment() : request.params[1].getInt<int>();
+        if(!pvmlogwriter->ReadSegment(segment, records))
+            throw JSONRPCError(RPC_INVALID_PARAMETER, "Segment not found");
+    }
+
+    UniValue result(UniValue::VARR);
+    for(const VMLogRecord& record : records){
+        result.push_back(VMLogRecordToJSON(record));
+    }
+    return result;
+},
+    };
+}
+
+RPCHelpMan getcodecacheinfo()
+{
+    return RPCHelpMan{"getcodecacheinfo",
+                "\nGet the state of the contract code cache, shared by the block validation, the contract calls and the staker.\n",
+                {},
+                RPCResult{
+                    RPCResult::Type::OBJ, "", "",
+                    {
+                        {RPCResult::Type::NUM, "entries", "The number of cached contract codes"},
+                        {RPCResult::Type::NUM, "bytes", "The estimated memory used by the code and its analysis"},
+                        {RPCResult::Type::NUM, "maxbytes", "The memory budget, set with -contractcodecache"},
+                        {RPCResult::Type::NUM, "hits", "The number of lookups of the code or its analysis found in the cache"},
+                        {RPCResult::Type::NUM, "misses", "The number of lookups loaded from the state database"},
+                        {RPCResult::Type::NUM, "evictions", "The number of codes evicted to stay under the budget"},
+                    }},
+                RPCExamples{
+                    HelpExampleCli("getcodecacheinfo", "")
+            + HelpExampleRpc("getcodecacheinfo", "")
+                },
+        [&](const RPCHelpMan& self, const JSONRPCRequest& request) -> UniValue
+{
+    dev::eth::CodeCache::Stats stats = dev::eth::CodeCache::instance().stats();
+    UniValue result(UniValue::VOBJ);
+    result.pushKV("entries", (uint64_t)stats.entries);
+    result.pushKV("bytes", (uint64_t)stats.bytes);
+    result.pushKV("maxbytes", (uint64_t)stats.maxBytes);
+    result.pushKV("hits", stats.hits);
+    result.pushKV("misses", stats.misses);
+    result.pushKV("evictions", stats.evictions);
+    return result;
+},
+    };
+}
+
 RPCHelpMan getdelegationinfoforaddress()
 {
     return RPCHelpMan{"getdelegationinfoforaddress",
@@ -1571,7 +1677,8 @@ RPCHelpMan getdelegationinfoforaddress()
     Delegation delegation;
     PKHash pkhash = std::get<PKHash>(dest);
     uint160 address = uint160(pkhash);
-    if(!odanDelegation.GetDelegation(address, delegation, chainman.ActiveChainstate())) {
+    const uint256 stateRoot = WITH_LOCK(::cs_main, return h256Touint(globalState->rootHash()));
+    if(!odanDelegation.GetDelegation(address, delegation, chainman.ActiveChainstate(), stateRoot)) {
         throw JSONRPCError(RPC_INTERNAL_ERROR, "Failed to get delegation");
     }
     bool verified = odanDelegation.VerifyDelegation(address, delegation);
@@ -2246,6 +2353,16 @@ RPCHelpMan getblockchaininfo()
                 {RPCResult::Type::NUM, "pruneheight", /*optional=*/true, "height of the last block pruned, plus one (only present if pruning is enabled)"},
                 {RPCResult::Type::BOOL, "automatic_pruning", /*optional=*/true, "whether automatic pruning is enabled (only present if pruning is enabled)"},
                 {RPCResult::Type::NUM, "prune_target_size", /*optional=*/true, "the target size used by pruning (only present if automatic pruning is enabled)"},
+                {RPCResult::Type::OBJ, "statetriecache", "the cache of the contract state and UTXO trie nodes",
+                {
+                    {RPCResult::Type::NUM, "entries", "the number of cached trie nodes"},
+                    {RPCResult::Type::NUM, "bytes", "the estimated memory used by the cached nodes"},
+                    {RPCResult::Type::NUM, "maxbytes", "the memory budget, part of -dbcache"},
+                    {RPCResult::Type::NUM, "hits", "the number of node lookups found in the cache"},
+                    {RPCResult::Type::NUM, "misses", "the number of node lookups read from the state database"},
+                    {RPCResult::Type::NUM, "evictions", "the number of nodes evicted to stay under the budget"},
+                    {RPCResult::Type::NUM, "hitrate", "the fraction of the node lookups found in the cache [0..1]"},
+                }},
                 {RPCResult::Type::STR, "warnings", "any network and blockchain warnings"},
             }},
         RPCExamples{
@@ -2285,6 +2402,17 @@ RPCHelpMan getblockchaininfo()
         }
     }
 
+    dev::TrieNodeCache::Stats trieCache = dev::TrieNodeCache::instance().stats();
+    UniValue trieCacheObj(UniValue::VOBJ);
+    trieCacheObj.pushKV("entries", (uint64_t)trieCache.entries);
+    trieCacheObj.pushKV("bytes", (uint64_t)trieCache.bytes);
+    trieCacheObj.pushKV("maxbytes", (uint64_t)trieCache.maxBytes);
+    trieCacheObj.pushKV("hits", trieCache.hits);
+    trieCacheObj.pushKV("misses", trieCache.misses);
+    trieCacheObj.pushKV("evictions", trieCache.evictions);
+    uint64_t trieCacheLookups = trieCache.hits + trieCache.misses;
+    trieCacheObj.pushKV("hitrate", trieCacheLookups ? (double)trieCache.hits / trieCacheLookups : 0.0);
+    obj.pushKV("statetriecache", trieCacheObj);
     obj.pushKV("warnings", GetWarnings(false).original);
     return obj;
 },
@@ -3584,7 +3712,7 @@ static RPCHelpMan dumptxoutset()
 {
     return RPCHelpMan{
         "dumptxoutset",
-        "Write the serialized UTXO set to a file.",
+        "Write the serialized UTXO set to a file, and the contract state at the same block to the file with the .contract suffix.",
         {
             {"path", RPCArg::Type::STR, RPCArg::Optional::NO, "Path to the output file. If relative, will be prefixed by datadir."},
         },
@@ -3597,6 +3725,8 @@ static RPCHelpMan dumptxoutset()
                     {RPCResult::Type::STR, "path", "the absolute path that the snapshot was written to"},
                     {RPCResult::Type::STR_HEX, "txoutset_hash", "the hash of the UTXO set contents"},
                     {RPCResult::Type::NUM, "nchaintx", "the number of transactions in the chain up to and including the base block"},
+                    {RPCResult::Type::NUM, "contract_nodes_written", "the number of contract state trie nodes and contract codes written"},
+                    {RPCResult::Type::STR, "contract_path", "the absolute path that the contract state was written to"},
                 }
         },
         RPCExamples{
@@ -3625,12 +3755,57 @@ static RPCHelpMan dumptxoutset()
             "Couldn't open file " + temppath.utf8string() + " for writing.");
     }
 
+    const fs::path contractpath = fs::u8path(path.utf8string() + CONTRACT_SNAPSHOT_SUFFIX);
+    const fs::path contracttemppath = fs::u8path(temppath.utf8string() + CONTRACT_SNAPSHOT_SUFFIX);
+    if (fs::exists(contractpath)) {
+        throw JSONRPCError(
+            RPC_INVALID_PARAMETER,
+            contractpath.utf8string() + " already exists. If you are sure this is what you want, "
+            "move it out of the way first");
+    }
+
     NodeContext& node = EnsureAnyNodeContext(request.context);
     UniValue result = CreateUTXOSnapshot(
         node, node.chainman->ActiveChainstate(), afile, path, temppath);
+
+    ///////////////////////////////////////////////////////////////// // odan
+    // The contract state is needed to execute the blocks after the base block of the snapshot
+    AutoFile contractfile{fsbridge::fopen(contracttemppath, "wb")};
+    if (contractfile.IsNull()) {
+        fs::remove(temppath);
+        throw JSONRPCError(
+            RPC_INVALID_PARAMETER,
+            "Couldn't open file " + contracttemppath.utf8string() + " for writing.");
+    }
+    const uint256 base_hash{uint256S(result["base_hash"].get_str())};
+    ContractSnapshotMetadata contract_metadata;
+    {
+        LOCK(cs_main);
+        const CBlockIndex* base = CHECK_NONFATAL(node.chainman->m_blockman.LookupBlockIndex(base_hash));
+        contract_metadata = ContractSnapshotMetadata{base_hash, base->hashStateRoot, base->hashUTXORoot};
+    }
+    uint64_t contract_nodes{0};
+    try {
+        if (!WriteContractSnapshot(*globalState->db().backend(), *globalState->dbUtxo().backend(), contract_metadata,
+                                   contractfile, node.rpc_interruption_point, contract_nodes)) {
+            throw JSONRPCError(RPC_INTERNAL_ERROR, "Unable to read the contract state of block " + base_hash.ToString());
+        }
+    } catch (...) {
+        // Neither snapshot is complete, also when interrupted
+        contractfile.fclose();
+        fs::remove(contracttemppath);
+        fs::remove(temppath);
+        throw;
+    }
+    contractfile.fclose();
+    fs::rename(contracttemppath, contractpath);
+    /////////////////////////////////////////////////////////////////
+
     fs::rename(temppath, path);
 
     result.pushKV("path", path.utf8string());
+    result.pushKV("contract_nodes_written", contract_nodes);
+    result.pushKV("contract_path", contractpath.utf8string());
     return result;
 },
     };
@@ -3731,11 +3906,16 @@ static RPCHelpMan loadtxoutset()
                 RPCArg::Type::STR,
                 RPCArg::Optional::NO,
                 "path to the snapshot file. If relative, will be prefixed by datadir."},
+            {"contract_path",
+                RPCArg::Type::STR,
+                RPCArg::DefaultHint{"path with the .contract suffix"},
+                "path to the contract state written by dumptxoutset with the snapshot. It can be omitted when the contract state of the base block is already in the state databases."},
         },
         RPCResult{
             RPCResult::Type::OBJ, "", "",
                 {
                     {RPCResult::Type::NUM, "coins_loaded", "the number of coins loaded from the snapshot"},
+                    {RPCResult::Type::NUM, "contract_nodes_loaded", "the number of contract state trie nodes and contract codes loaded"},
                     {RPCResult::Type::STR_HEX, "tip_hash", "the hash of the base of the snapshot"},
                     {RPCResult::Type::NUM, "base_height", "the height of the base of the snapshot"},
                     {RPCResult::Type::STR, "path", "the absolute path that the snapshot was loaded from"},
@@ -3775,12 +3955,44 @@ static RPCHelpMan loadtxoutset()
             strprintf("The base block header (%s) must appear in the headers chain. Make sure all headers are syncing, and call this RPC again.",
                       base_blockhash.ToString()));
     }
+
+    ///////////////////////////////////////////////////////////////// // odan
+    // The contract state of the base block is imported first, the blocks after it execute contracts
+    if (WITH_LOCK(::cs_main, return pstatepruner != nullptr)) {
+        throw JSONRPCError(RPC_MISC_ERROR, "Unable to load the contract state with -prunestate enabled, restart without it to load the snapshot");
+    }
+    const ContractSnapshotMetadata contract_metadata{base_blockhash, snapshot_start_block->hashStateRoot, snapshot_start_block->hashUTXORoot};
+    fs::path contract_path{request.params[1].isNull() ? fs::u8path(path.utf8string() + CONTRACT_SNAPSHOT_SUFFIX) :
+                           AbsPathForConfigVal(EnsureArgsman(node), fs::u8path(request.params[1].get_str()))};
+    uint64_t contract_nodes{0};
+    if (fs::exists(contract_path)) {
+        AutoFile contractfile{fsbridge::fopen(contract_path, "rb")};
+        if (contractfile.IsNull()) {
+            throw JSONRPCError(
+                RPC_INVALID_PARAMETER,
+                "Couldn't open file " + contract_path.utf8string() + " for reading.");
+        }
+        const int threads{std::clamp(GetNumCores(), 1, 8)};
+        if (!LoadContractSnapshot(*globalState->db().backend(), *globalState->dbUtxo().backend(), contract_metadata,
+                                  contractfile, threads, contract_nodes)) {
+            throw JSONRPCError(RPC_INTERNAL_ERROR, "Unable to load the contract state " + fs::PathToString(contract_path));
+        }
+    } else if (!request.params[1].isNull()) {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "Couldn't open file " + contract_path.utf8string() + " for reading.");
+    }
+    if (!CheckContractState(*globalState->db().backend(), *globalState->dbUtxo().backend(),
+                            contract_metadata.m_state_root, contract_metadata.m_utxo_root)) {
+        throw JSONRPCError(RPC_INTERNAL_ERROR, strprintf("Unable to load UTXO snapshot, the contract state of block %s is incomplete", base_blockhash.ToString()));
+    }
+    /////////////////////////////////////////////////////////////////
+
     if (!chainman.ActivateSnapshot(afile, metadata, false)) {
         throw JSONRPCError(RPC_INTERNAL_ERROR, "Unable to load UTXO snapshot " + fs::PathToString(path));
     }
 
     UniValue result(UniValue::VOBJ);
     result.pushKV("coins_loaded", metadata.m_coins_count);
+    result.pushKV("contract_nodes_loaded", contract_nodes);
     result.pushKV("tip_hash", snapshot_start_block->GetBlockHash().ToString());
     result.pushKV("base_height", snapshot_start_block->nHeight);
     result.pushKV("path", fs::PathToString(path));
@@ -4203,6 +4415,8 @@ void RegisterBlockchainRPCCommands(CRPCTable& t)
         {"blockchain", &oasFlisttransactions},
         {"blockchain", &listcontracts},
         {"blockchain", &gettransactionreceipt},
+        {"blockchain", &getvmlogs},
+        {"blockchain", &getcodecacheinfo},
         {"blockchain", &searchlogs},
         {"blockchain", &waitforlogs},
         {"blockchain", &getestimatedannualroi},
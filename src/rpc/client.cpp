@@ -117,6 +117,7 @@ static const CRPCConvertParam vRPCConvertParams[] =
     { "getblockhashes", 1, "low"},
     { "getblockhashes", 2, "options"},
     { "getspentinfo", 0, "argument"},
+    { "getvmlogs", 1, "segment"},
     { "searchlogs", 0, "fromblock"},
     { "searchlogs", 1, "toblock"},
     { "searchlogs", 2, "addressfilter"},
@@ -2,6 +2,7 @@
 #include <rpc/util.h>
 #include <common/system.h>
 #include <key_io.h>
+#include <odan/contractcall.h>
 #include <rpc/server.h>
 #include <txdb.h>
 
@@ -48,14 +49,15 @@ UniValue transactionReceiptToJSON(const OdanTransactionReceipt& txRec)
 
 UniValue CallToContract(const UniValue& params, ChainstateManager &chainman)
 {
-    LOCK(cs_main);
-
     std::string strAddr = params[0].get_str();
     std::string data = params[1].get_str();
 
     if(data.size() % 2 != 0 || !CheckHex(data))
         throw JSONRPCError(RPC_TYPE_ERROR, "Invalid data (data not hex)");
 
+    // The call runs on a snapshot of the tip, without holding cs_main
+    std::shared_ptr<const ContractCallSnapshot> snapshot = GetContractCallSnapshot(chainman.ActiveChainstate());
+
     dev::Address addrAccount;
     if(strAddr.size() > 0)
     {
@@ -63,7 +65,7 @@ UniValue CallToContract(const UniValue& params, ChainstateManager &chainman)
             throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Incorrect address");
 
         addrAccount = dev::Address(strAddr);
-        if(!globalState->addressInUse(addrAccount))
+        if(!snapshot->AddressInUse(addrAccount))
             throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Address does not exist");
     }
 
@@ -91,9 +93,10 @@ UniValue CallToContract(const UniValue& params, ChainstateManager &chainman)
     }
 
 
-    std::vector<ResultExecute> execResults = CallContract(addrAccount, ParseHex(data), chainman.ActiveChainstate(), senderAddress, gasLimit, nAmount);
+    std::vector<ResultExecute> execResults = snapshot->Call(addrAccount, ParseHex(data), senderAddress, gasLimit, nAmount);
 
     if(fRecordLogOpcodes){
+        LOCK(cs_main);
         writeVMlog(execResults, chainman.ActiveChain());
     }
 
@@ -270,6 +273,34 @@ void parseParam(const UniValue& val, std::vector<boost::optional<dev::h256>> &h2
     });
 }
 
+LogBloomFilter logBloomFilter(const std::set<dev::h160>& addresses, const std::vector<boost::optional<dev::h256>>& topics, bool allTopics)
+{
+    LogBloomFilter filter;
+    if (!addresses.empty()) {
+        std::vector<dev::h2048> group;
+        for (const dev::h160& address : addresses) {
+            group.push_back(LogBloomOf(address));
+        }
+        filter.push_back(group);
+    }
+
+    std::vector<dev::h2048> group;
+    for (const auto& topic : topics) {
+        if (!topic) {
+            continue;
+        }
+        if (allTopics) {
+            filter.push_back({LogBloomOf(topic.get())});
+        } else {
+            group.push_back(LogBloomOf(topic.get()));
+        }
+    }
+    if (!group.empty()) {
+        filter.push_back(group);
+    }
+    return filter;
+}
+
 class SearchLogsParams {
 public:
     size_t fromBlock;
@@ -323,7 +354,8 @@ UniValue SearchLogs(const UniValue& _params, ChainstateManager &chainman)
 
     std::vector<std::vector<uint256>> hashesToBlock;
 
-    curheight = chainman.m_blockman.m_block_tree_db->ReadHeightIndex(params.fromBlock, params.toBlock, params.minconf, hashesToBlock, params.addresses, chainman);
+    curheight = chainman.m_blockman.m_block_tree_db->ReadHeightIndex(params.fromBlock, params.toBlock, params.minconf, hashesToBlock, params.addresses, chainman,
+                                                                     logBloomFilter(params.addresses, params.topics, false));
 
     if (curheight == -1) {
         throw JSONRPCError(RPC_INVALID_PARAMETER, "Incorrect params");
@@ -345,10 +377,16 @@ UniValue SearchLogs(const UniValue& _params, ChainstateManager &chainman)
             }
             dupes.insert(e);
 
-            std::vector<TransactionReceiptInfo> receipts = pstorageresult->getResult(uintToh256(e));
+            // Match the topics on the logs column, the full receipts are read only when needed
+            std::vector<dev::eth::LogEntries> receiptsLogs;
+            if(!pstorageresult->getResultLogs(uintToh256(e), receiptsLogs)) {
+                continue;
+            }
 
-            for(const auto& receipt : receipts) {
-                if(receipt.logs.empty()) {
+            std::vector<size_t> matches;
+            for(size_t j = 0; j < receiptsLogs.size(); j++) {
+                const dev::eth::LogEntries& logs = receiptsLogs[j];
+                if(logs.empty()) {
                     continue;
                 }
 
@@ -360,7 +398,7 @@ UniValue SearchLogs(const UniValue& _params, ChainstateManager &chainman)
                             continue;
                         }
 
-                        for (const auto& log: receipt.logs) {
+                        for (const auto& log: logs) {
                             auto filterTopicContent = tc.get();
 
                             if (i >= log.topics.size()) {
@@ -379,8 +417,21 @@ UniValue SearchLogs(const UniValue& _params, ChainstateManager &chainman)
 
             push:
 
+                matches.push_back(j);
+            }
+
+            if(matches.empty()) {
+                continue;
+            }
+
+            std::vector<TransactionReceiptInfo> receipts = pstorageresult->getResult(uintToh256(e));
+            for(size_t j : matches) {
+                if(j >= receipts.size()) {
+                    break;
+                }
+
                 UniValue tri(UniValue::VOBJ);
-                transactionReceiptInfoToJSON(receipt, tri);
+                transactionReceiptInfoToJSON(receipts[j], tri);
                 result.push_back(tri);
             }
         }
@@ -472,8 +523,75 @@ bool CallToken::exec(const bool &sendTo, const std::map<std::string, std::string
     return true;
 }
 
+bool ReadTokenEvents(ChainstateManager &chainman, const int64_t &fromBlock, const int64_t &toBlock, const int64_t &minconf, const std::string &eventName, const std::string &contractAddress, const std::string &senderAddress, const int &numTopics, std::vector<TokenEvent> &result)
+{
+    if(!fTokenIndex)
+        return false;
+
+    // The index has Transfer(address indexed, address indexed, uint256) and Burn(address indexed, uint256)
+    uint8_t type;
+    if(eventName == TokenTransferTopic().hex() && numTopics == 3)
+        type = TOKEN_TRANSFER;
+    else if(eventName == TokenBurnTopic().hex() && numTopics == 2)
+        type = TOKEN_BURN;
+    else
+        return false;
+
+    // The sender is a topic, the address is in its last 20 bytes
+    if(contractAddress.size() != 40 || !IsHex(contractAddress) || senderAddress.size() < 40 || !IsHex(senderAddress))
+        return false;
+    uint160 contract(ParseHex(contractAddress));
+    uint160 holder(ParseHex(senderAddress.substr(senderAddress.size() - 40)));
+
+    LOCK(cs_main);
+    const CChain& active = chainman.ActiveChain();
+    int64_t high = toBlock < 0 ? active.Height() : std::min<int64_t>(toBlock, active.Height());
+    if(minconf > 0)
+        high = std::min<int64_t>(high, active.Height() - minconf);
+    if(high < fromBlock)
+        return true;
+
+    std::vector<std::pair<CTokenIndexKey, CTokenIndexValue>> entries;
+    if(!chainman.m_blockman.m_block_tree_db->ReadTokenIndex(contract, holder, fromBlock, high, entries))
+        return false;
+
+    for(const auto& [key, value] : entries)
+    {
+        if(value.type != type) continue;
+
+        TokenEvent tokenEvent;
+        tokenEvent.address = HexStr(key.contract);
+        OdanToken::ToOdanAddress(HexStr(value.sender), tokenEvent.sender);
+        if(type == TOKEN_TRANSFER)
+            OdanToken::ToOdanAddress(HexStr(value.receiver), tokenEvent.receiver);
+        tokenEvent.blockHash = active[key.blockHeight]->GetBlockHash();
+        tokenEvent.blockNumber = key.blockHeight;
+        tokenEvent.transactionHash = value.txhash;
+        tokenEvent.value = value.value;
+        result.push_back(tokenEvent);
+    }
+
+    return true;
+}
+
+bool IsHolderTokenEvent(const std::string &logAddress, const std::vector<std::string> &topics, const std::string &eventName, const std::string &contractAddress, const std::string &senderAddress, const int &numTopics)
+{
+    if(ToLower(logAddress) != ToLower(contractAddress)) return false;
+    if(topics.size() < (size_t)numTopics) return false;
+    if(topics.empty() || topics[0] != eventName) return false;
+    for(int i = 1; i < numTopics; i++)
+    {
+        if(ToLower(topics[i]) == ToLower(senderAddress)) return true;
+    }
+    return false;
+}
+
 bool CallToken::execEvents(const int64_t &fromBlock, const int64_t &toBlock, const int64_t& minconf, const std::string &eventName, const std::string &contractAddress, const std::string &senderAddress, const int &numTopics, std::vector<TokenEvent> &result)
 {
+    // The token index has the typed events, the logs are searched without it
+    if(ReadTokenEvents(chainman, fromBlock, toBlock, minconf, eventName, contractAddress, senderAddress, numTopics, result))
+        return true;
+
     UniValue resultVar;
     if(!searchTokenTx(fromBlock, toBlock, minconf, eventName, contractAddress, senderAddress, numTopics, resultVar))
         return false;
@@ -486,15 +604,17 @@ bool CallToken::execEvents(const int64_t &fromBlock, const int64_t &toBlock, con
         const UniValue& listLog = eventMap["log"].get_array();
         for(size_t i = 0; i < listLog.size(); i++)
         {
-            // Skip the not needed events
+            // Skip the not needed events, the other logs of the transaction are not events of the holder
             const UniValue& eventLog = listLog[i].get_obj();
             const UniValue& topicsList = eventLog["topics"].get_array();
-            if(topicsList.size() < (size_t)numTopics) continue;
-            if(topicsList[0].get_str() != eventName) continue;
+            std::vector<std::string> topics;
+            for(size_t j = 0; j < topicsList.size(); j++)
+                topics.push_back(topicsList[j].get_str());
+            if(!IsHolderTokenEvent(eventLog["address"].get_str(), topics, eventName, contractAddress, senderAddress, numTopics)) continue;
 
             // Create new event
             TokenEvent tokenEvent;
-            tokenEvent.address = eventMap["contractAddress"].get_str();
+            tokenEvent.address = contractAddress;
             if(numTopics > 1)
             {
                 tokenEvent.sender = topicsList[1].get_str().substr(24);
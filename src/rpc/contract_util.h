@@ -26,6 +26,26 @@ void parseParam(const UniValue& val, std::set<dev::h160> &h160s);
 
 void parseParam(const UniValue& val, std::vector<boost::optional<dev::h256>> &h256s);
 
+/**
+ * Log bloom filter for BlockTreeDB::ReadHeightIndex matching one of the addresses and, when
+ * allTopics is set, every topic, otherwise one of the topics.
+ */
+LogBloomFilter logBloomFilter(const std::set<dev::h160>& addresses, const std::vector<boost::optional<dev::h256>>& topics, bool allTopics);
+
+/**
+ * Read the Transfer or Burn events of a token holder from the token index, in the format of the
+ * OdanTokenExec::execEvents results. Return false when the token index is disabled, or does not
+ * index the events with numTopics topics.
+ */
+bool ReadTokenEvents(ChainstateManager &chainman, const int64_t &fromBlock, const int64_t &toBlock, const int64_t &minconf, const std::string &eventName, const std::string &contractAddress, const std::string &senderAddress, const int &numTopics, std::vector<TokenEvent> &result);
+
+/**
+ * The logs of a search result that are token events of the holder, like the ones of the token index:
+ * emitted by the token contract, with the event name and numTopics topics, and the holder among the
+ * indexed addresses.
+ */
+bool IsHolderTokenEvent(const std::string &logAddress, const std::vector<std::string> &topics, const std::string &eventName, const std::string &contractAddress, const std::string &senderAddress, const int &numTopics);
+
 /**
  * @brief The CallToken class Read available token data
  */
@@ -801,28 +801,31 @@ static RPCHelpMan getaddressbalance()
         throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Invalid address");
     }
 
-    std::vector<std::pair<CAddressIndexKey, CAmount> > addressIndex;
-
-    for (std::vector<std::pair<uint256, int> >::iterator it = addresses.begin(); it != addresses.end(); it++) {
-        if (!GetAddressIndex((*it).first, (*it).second, addressIndex, chainman.m_blockman)) {
-            throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "No information available for address");
-        }
-    }
-
     CAmount balance = 0;
     CAmount received = 0;
     CAmount immature = 0;
 
     LOCK(cs_main);
     CChain& active_chain = chainman.ActiveChain();
-    for (std::vector<std::pair<CAddressIndexKey, CAmount> >::const_iterator it=addressIndex.begin(); it!=addressIndex.end(); it++) {
-        if (it->second > 0) {
-            received += it->second;
+    int nHeight = active_chain.Height();
+    int nMaturity = Params().GetConsensus().CoinbaseMaturity(nHeight);
+    for (std::vector<std::pair<uint256, int> >::iterator it = addresses.begin(); it != addresses.end(); it++) {
+        CAddressWeightValue balanceValue;
+        if (!GetAddressBalance((*it).first, (*it).second, balanceValue, chainman.m_blockman)) {
+            throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "No information available for address");
+        }
+        balance += balanceValue.balance;
+        received += balanceValue.received;
+
+        // Only the activity of the last blocks can be immature
+        std::vector<std::pair<CAddressIndexKey, CAmount> > addressIndex;
+        if (!GetAddressIndex((*it).first, (*it).second, addressIndex, chainman.m_blockman, std::max(nHeight - nMaturity + 1, 1), std::max(nHeight, 1))) {
+            throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "No information available for address");
+        }
+        for (std::vector<std::pair<CAddressIndexKey, CAmount> >::const_iterator itIndex=addressIndex.begin(); itIndex!=addressIndex.end(); itIndex++) {
+            if (itIndex->first.txindex == 1 && ((nHeight - itIndex->first.blockHeight) < nMaturity))
+                immature += itIndex->second; //immature stake outputs
         }
-        balance += it->second;
-        int nHeight = active_chain.Height();
-        if (it->first.txindex == 1 && ((nHeight - it->first.blockHeight) < Params().GetConsensus().CoinbaseMaturity(nHeight)))
-            immature += it->second; //immature stake outputs
     }
 
     UniValue result(UniValue::VOBJ);
@@ -0,0 +1,91 @@
+#include <test/fuzz/FuzzedDataProvider.h>
+#include <test/fuzz/fuzz.h>
+#include <test/fuzz/util.h>
+#include <util/strencodings.h>
+
+#include <libdevcore/FixedHash.h>
+#include <libdevcrypto/AltBn128.h>
+#include <libdevcrypto/LibSnark.h>
+
+#include <cassert>
+#include <vector>
+
+namespace {
+const std::vector<unsigned char> G1 = ParseHex("0000000000000000000000000000000000000000000000000000000000000001"
+                                               "0000000000000000000000000000000000000000000000000000000000000002");
+// The generator of G2, 123456789 times the generator, and a point of the twist that is not in G2
+const std::vector<std::vector<unsigned char>> G2_POINTS = {
+    ParseHex("198e9393920d483a7260bfb731fb5d25f1aa493335a9e71297e485b7aef312c21800deef121f1e76426a00665e5c4479674322d4f75edadd46debd5cd992f6ed"
+             "090689d0585ff075ec9e99ad690c3395bc4b313370b38ef355acdadcd122975b12c85ea5db8c6deb4aab71808dcb408fe3d1e7690c43d37b4ce6cc0166fa7daa"),
+    ParseHex("1c15df6dc9bd529991343f0a78d9a0d355b1b648567c7ee58d02664c8e2d463100506c3def7620270716e18bfc554f9f5380ce2b3b425f0a6625d73afb204fff"
+             "302e3e5b6b93a75d13b0a899163155f0a57b5e721277d2c718f2300d10a2989917397d778e1a5422e54482feb4199a5249a7a4dbfb3f2bf319520234b3137e06"),
+    ParseHex("0b0f3247f88374b5a8ee0ee48b858f310277839f05a94730a5de58858e35f0ae0b090ae608e587a20ac03da2f7f6483c5365e82d2b028a488c1b0a538c31f460"
+             "2eb96709c2ee6871c7c31200521432d8525d4009c8b7115550d56555cca7457b2834f71e793d9f6c9551d3918c1f9380f7109948101428c40117f5e03c0424d5"),
+    std::vector<unsigned char>(128, 0),
+};
+
+void Append(std::vector<unsigned char>& input, const std::vector<unsigned char>& part)
+{
+    input.insert(input.end(), part.begin(), part.end());
+}
+
+/** A multiple of the generator of G1 most of the time, so that the inputs are valid points */
+std::vector<unsigned char> ConsumeG1(FuzzedDataProvider& fuzzed_data_provider)
+{
+    if (fuzzed_data_provider.ConsumeBool())
+        return ConsumeFixedLengthByteVector(fuzzed_data_provider, 64);
+    std::vector<unsigned char> input = G1;
+    Append(input, ConsumeFixedLengthByteVector(fuzzed_data_provider, 32));
+    auto point = dev::crypto::libff_alt_bn128_G1_mul(dev::bytesConstRef(input.data(), input.size()));
+    assert(point.first);
+    return point.second;
+}
+
+std::vector<unsigned char> ConsumeG2(FuzzedDataProvider& fuzzed_data_provider)
+{
+    if (fuzzed_data_provider.ConsumeBool())
+        return ConsumeFixedLengthByteVector(fuzzed_data_provider, 128);
+    return G2_POINTS[fuzzed_data_provider.ConsumeIntegralInRange<size_t>(0, G2_POINTS.size() - 1)];
+}
+} // namespace
+
+FUZZ_TARGET(altbn128)
+{
+    FuzzedDataProvider fuzzed_data_provider{buffer.data(), buffer.size()};
+    std::vector<unsigned char> input;
+    int precompile = fuzzed_data_provider.ConsumeIntegralInRange<int>(0, 2);
+    switch (precompile) {
+    case 0:
+        Append(input, ConsumeG1(fuzzed_data_provider));
+        Append(input, ConsumeG1(fuzzed_data_provider));
+        break;
+    case 1:
+        Append(input, ConsumeG1(fuzzed_data_provider));
+        Append(input, ConsumeFixedLengthByteVector(fuzzed_data_provider, 32));
+        break;
+    case 2:
+        LIMITED_WHILE(fuzzed_data_provider.ConsumeBool(), 4) {
+            Append(input, ConsumeG1(fuzzed_data_provider));
+            Append(input, ConsumeG2(fuzzed_data_provider));
+        }
+        break;
+    }
+    // Truncated inputs and damaged points
+    if (fuzzed_data_provider.ConsumeBool() && !input.empty())
+        input.resize(fuzzed_data_provider.ConsumeIntegralInRange<size_t>(0, input.size() - 1));
+    if (fuzzed_data_provider.ConsumeBool() && !input.empty())
+        input[fuzzed_data_provider.ConsumeIntegralInRange<size_t>(0, input.size() - 1)] ^= fuzzed_data_provider.ConsumeIntegral<uint8_t>();
+
+    const dev::bytesConstRef in(input.data(), input.size());
+    switch (precompile) {
+    case 0:
+        assert(dev::crypto::bn254::g1Add(in) == dev::crypto::libff_alt_bn128_G1_add(in));
+        break;
+    case 1:
+        assert(dev::crypto::bn254::g1Mul(in) == dev::crypto::libff_alt_bn128_G1_mul(in));
+        break;
+    case 2:
+        assert(dev::crypto::bn254::pairingProduct(in) == dev::crypto::libff_alt_bn128_pairing_product(in));
+        break;
+    }
+}
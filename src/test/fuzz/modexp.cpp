@@ -0,0 +1,25 @@
+#include <test/fuzz/FuzzedDataProvider.h>
+#include <test/fuzz/fuzz.h>
+#include <test/fuzz/util.h>
+
+#include <libdevcore/CommonData.h>
+#include <libdevcrypto/ModExp.h>
+
+#include <cassert>
+#include <vector>
+
+FUZZ_TARGET(modexp)
+{
+    FuzzedDataProvider fuzzed_data_provider{buffer.data(), buffer.size()};
+    // Up to 4160 bits, so that the moduli just above the biggest specialization use boost too
+    std::vector<unsigned char> mod_bytes = fuzzed_data_provider.ConsumeBytes<unsigned char>(fuzzed_data_provider.ConsumeIntegralInRange<size_t>(0, 520));
+    if (!mod_bytes.empty() && fuzzed_data_provider.ConsumeBool())
+        mod_bytes.back() |= 1;
+    const std::vector<unsigned char> base_bytes = fuzzed_data_provider.ConsumeBytes<unsigned char>(fuzzed_data_provider.ConsumeIntegralInRange<size_t>(0, 600));
+    const std::vector<unsigned char> exp = fuzzed_data_provider.ConsumeRemainingBytes<unsigned char>();
+
+    const dev::bigint mod = dev::fromBigEndian<dev::bigint>(mod_bytes);
+    const dev::bigint base = dev::fromBigEndian<dev::bigint>(base_bytes);
+    const dev::bytesConstRef exp_ref(exp.data(), exp.size());
+    assert(dev::crypto::modexp(base, exp_ref, mod) == dev::crypto::modexpReference(base, exp_ref, mod));
+}
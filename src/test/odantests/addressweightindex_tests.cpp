@@ -0,0 +1,108 @@
+#include <boost/test/unit_test.hpp>
+#include <test/util/setup_common.h>
+#include <node/blockstorage.h>
+#include <validation.h>
+
+namespace AddressWeightIndexTest{
+
+const uint256 ADDRESS_A = uint256S("aa");
+const uint256 ADDRESS_B = uint256S("bb");
+const int ADDRESS_TYPE = 1;
+
+std::pair<CAddressIndexIteratorKey, CAddressWeightDelta> delta(const uint256& address, int height, CAmount satoshis, CAmount received = 0){
+    return std::make_pair(CAddressIndexIteratorKey(ADDRESS_TYPE, address), CAddressWeightDelta(height, satoshis, received));
+}
+
+CAmount matureAmount(kernel::BlockTreeDB& db, const uint256& address, int maxHeight){
+    CAddressWeightValue value;
+    CAmount amount = -1;
+    BOOST_REQUIRE(db.ReadAddressWeightIndex(address, ADDRESS_TYPE, value));
+    BOOST_REQUIRE(value.GetAmount(maxHeight, amount));
+    return amount;
+}
+
+BOOST_FIXTURE_TEST_SUITE(addressweightindex_tests, TestingSetup)
+
+BOOST_AUTO_TEST_CASE(addressweightindex_connect_disconnect){
+    kernel::BlockTreeDB& db = *m_node.chainman->m_blockman.m_block_tree_db;
+
+    // Receive at heights 10 and 20, spend the output of height 10 at height 30
+    BOOST_CHECK(db.UpdateAddressWeightIndex({delta(ADDRESS_A, 10, 100, 100), delta(ADDRESS_B, 10, 5, 5)}, 0));
+    BOOST_CHECK(db.UpdateAddressWeightIndex({delta(ADDRESS_A, 20, 50, 50)}, 0));
+    BOOST_CHECK(db.UpdateAddressWeightIndex({delta(ADDRESS_A, 10, -100), delta(ADDRESS_A, 30, 80, 80)}, 0));
+
+    CAddressWeightValue value;
+    BOOST_REQUIRE(db.ReadAddressWeightIndex(ADDRESS_A, ADDRESS_TYPE, value));
+    BOOST_CHECK_EQUAL(value.balance, 130);
+    BOOST_CHECK_EQUAL(value.received, 230);
+    BOOST_CHECK_EQUAL(value.heightAmounts.size(), 2U);
+    BOOST_CHECK_EQUAL(matureAmount(db, ADDRESS_A, 19), 0);
+    BOOST_CHECK_EQUAL(matureAmount(db, ADDRESS_A, 20), 50);
+    BOOST_CHECK_EQUAL(matureAmount(db, ADDRESS_A, 30), 130);
+
+    // Disconnect the block at height 30
+    BOOST_CHECK(db.UpdateAddressWeightIndex({delta(ADDRESS_A, 30, -80, -80), delta(ADDRESS_A, 10, 100)}, 0));
+    BOOST_CHECK_EQUAL(matureAmount(db, ADDRESS_A, 10), 100);
+    BOOST_CHECK_EQUAL(matureAmount(db, ADDRESS_A, 30), 150);
+
+    // Spending everything keeps the received amount
+    BOOST_CHECK(db.UpdateAddressWeightIndex({delta(ADDRESS_B, 10, -5)}, 0));
+    BOOST_REQUIRE(db.ReadAddressWeightIndex(ADDRESS_B, ADDRESS_TYPE, value));
+    BOOST_CHECK_EQUAL(value.balance, 0);
+    BOOST_CHECK_EQUAL(value.received, 5);
+    BOOST_CHECK(value.heightAmounts.empty());
+}
+
+BOOST_AUTO_TEST_CASE(addressweightindex_compact){
+    kernel::BlockTreeDB& db = *m_node.chainman->m_blockman.m_block_tree_db;
+
+    BOOST_CHECK(db.UpdateAddressWeightIndex({delta(ADDRESS_A, 10, 100, 100), delta(ADDRESS_A, 20, 50, 50)}, 0));
+    BOOST_CHECK(db.UpdateAddressWeightIndex({delta(ADDRESS_A, 40, 70, 70)}, 15));
+
+    CAddressWeightValue value;
+    BOOST_REQUIRE(db.ReadAddressWeightIndex(ADDRESS_A, ADDRESS_TYPE, value));
+    BOOST_CHECK_EQUAL(value.compactHeight, 15);
+    BOOST_CHECK_EQUAL(value.compactedAmount, 100);
+    BOOST_CHECK_EQUAL(value.heightAmounts.size(), 2U);
+    CAmount amount = 0;
+    BOOST_CHECK(!value.GetAmount(13, amount));
+    BOOST_CHECK_EQUAL(matureAmount(db, ADDRESS_A, 14), 100);
+    BOOST_CHECK_EQUAL(matureAmount(db, ADDRESS_A, 39), 150);
+    BOOST_CHECK_EQUAL(matureAmount(db, ADDRESS_A, 40), 220);
+
+    // Spending a compacted output
+    BOOST_CHECK(db.UpdateAddressWeightIndex({delta(ADDRESS_A, 10, -100)}, 15));
+    BOOST_CHECK_EQUAL(matureAmount(db, ADDRESS_A, 20), 50);
+}
+
+BOOST_AUTO_TEST_CASE(addressweightindex_build){
+    kernel::BlockTreeDB& db = *m_node.chainman->m_blockman.m_block_tree_db;
+    CScript script;
+
+    BOOST_CHECK(db.WriteAddressIndex({std::make_pair(CAddressIndexKey(ADDRESS_TYPE, ADDRESS_A, 10, 1, uint256S("01"), 0, false), 100),
+                                      std::make_pair(CAddressIndexKey(ADDRESS_TYPE, ADDRESS_A, 20, 1, uint256S("02"), 0, false), 50),
+                                      std::make_pair(CAddressIndexKey(ADDRESS_TYPE, ADDRESS_A, 30, 1, uint256S("03"), 0, true), -100),
+                                      std::make_pair(CAddressIndexKey(ADDRESS_TYPE, ADDRESS_B, 30, 2, uint256S("04"), 0, false), 7)}));
+    BOOST_CHECK(db.UpdateAddressUnspentIndex({std::make_pair(CAddressUnspentKey(ADDRESS_TYPE, ADDRESS_A, uint256S("02"), 0), CAddressUnspentValue(50, script, 20, false)),
+                                              std::make_pair(CAddressUnspentKey(ADDRESS_TYPE, ADDRESS_B, uint256S("04"), 0), CAddressUnspentValue(7, script, 30, false))}));
+    BOOST_CHECK(db.BuildAddressWeightIndex(25));
+
+    bool fAddressWeightIndex = false;
+    BOOST_CHECK(db.ReadFlag("addrweightindex", fAddressWeightIndex));
+    BOOST_CHECK(fAddressWeightIndex);
+
+    CAddressWeightValue value;
+    BOOST_REQUIRE(db.ReadAddressWeightIndex(ADDRESS_A, ADDRESS_TYPE, value));
+    BOOST_CHECK_EQUAL(value.balance, 50);
+    BOOST_CHECK_EQUAL(value.received, 150);
+    BOOST_CHECK_EQUAL(value.compactedAmount, 50);
+    BOOST_REQUIRE(db.ReadAddressWeightIndex(ADDRESS_B, ADDRESS_TYPE, value));
+    BOOST_CHECK_EQUAL(value.balance, 7);
+    BOOST_CHECK_EQUAL(value.received, 7);
+    BOOST_CHECK_EQUAL(matureAmount(db, ADDRESS_B, 29), 0);
+    BOOST_CHECK_EQUAL(matureAmount(db, ADDRESS_B, 30), 7);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+}
@@ -0,0 +1,156 @@
+#include <boost/test/unit_test.hpp>
+#include <test/util/random.h>
+#include <test/util/setup_common.h>
+#include <util/strencodings.h>
+#include <libdevcore/FixedHash.h>
+#include <libdevcrypto/AltBn128.h>
+#include <libdevcrypto/LibSnark.h>
+
+namespace AltBn128Test{
+
+using Precompile = std::pair<bool, dev::bytes> (*)(dev::bytesConstRef);
+
+static const dev::bytes G1 = ParseHex("0000000000000000000000000000000000000000000000000000000000000001"
+                                      "0000000000000000000000000000000000000000000000000000000000000002");
+static const dev::bytes G2 = ParseHex("198e9393920d483a7260bfb731fb5d25f1aa493335a9e71297e485b7aef312c21800deef121f1e76426a00665e5c4479674322d4f75edadd46debd5cd992f6ed"
+                                      "090689d0585ff075ec9e99ad690c3395bc4b313370b38ef355acdadcd122975b12c85ea5db8c6deb4aab71808dcb408fe3d1e7690c43d37b4ce6cc0166fa7daa");
+// 123456789 * G2
+static const dev::bytes KG2 = ParseHex("1c15df6dc9bd529991343f0a78d9a0d355b1b648567c7ee58d02664c8e2d463100506c3def7620270716e18bfc554f9f5380ce2b3b425f0a6625d73afb204fff"
+                                       "302e3e5b6b93a75d13b0a899163155f0a57b5e721277d2c718f2300d10a2989917397d778e1a5422e54482feb4199a5249a7a4dbfb3f2bf319520234b3137e06");
+// A point of the twist that is not in G2
+static const dev::bytes NOT_G2 = ParseHex("0b0f3247f88374b5a8ee0ee48b858f310277839f05a94730a5de58858e35f0ae0b090ae608e587a20ac03da2f7f6483c5365e82d2b028a488c1b0a538c31f460"
+                                          "2eb96709c2ee6871c7c31200521432d8525d4009c8b7115550d56555cca7457b2834f71e793d9f6c9551d3918c1f9380f7109948101428c40117f5e03c0424d5");
+// G2 plus a point of order 10069 of the twist
+static const dev::bytes SMALL_ORDER_G2 = ParseHex("261cd4394b8effdaeb527da54f8db11fe24b5fadf48b260c615f5abe30e910af29e302da7247ee2e40abdd0d8a4f6e8f1a905dee84407ace0c9a41e1daefb4d7"
+                                                  "22ac51eb36c132a2a10df69e47bab49e385d04c86ea5d5ffa30de3f0cc052a8f1578750db8839d61a8f28b1731dcf151decb5922c44167dedca5a6a148b589a7");
+static const dev::h256 ORDER("30644e72e131a029b85045b68181585d2833e84879b9709143e1f593f0000001");
+static const dev::h256 ORDER_MINUS_ONE("30644e72e131a029b85045b68181585d2833e84879b9709143e1f593f0000000");
+static const dev::h256 FIELD_MODULUS("30644e72e131a029b85045b68181585d97816a916871ca8d3c208c16d87cfd47");
+
+static dev::bytes concat(const std::vector<dev::bytes>& parts)
+{
+    dev::bytes out;
+    for (const dev::bytes& part : parts)
+        out.insert(out.end(), part.begin(), part.end());
+    return out;
+}
+
+static dev::bytes mulG1(const dev::bytes& point, const dev::h256& k)
+{
+    const dev::bytes input = concat({point, k.asBytes()});
+    auto result = dev::crypto::libff_alt_bn128_G1_mul(&input);
+    BOOST_REQUIRE(result.first);
+    return result.second;
+}
+
+/** Run input on the native backend and on libff, the results must be the same */
+static std::pair<bool, dev::bytes> checkSame(Precompile native, Precompile reference, const dev::bytes& input)
+{
+    auto result = native(&input);
+    BOOST_CHECK(result == reference(&input));
+    return result;
+}
+
+static std::pair<bool, dev::bytes> add(const dev::bytes& input)
+{
+    return checkSame(dev::crypto::bn254::g1Add, dev::crypto::libff_alt_bn128_G1_add, input);
+}
+
+static std::pair<bool, dev::bytes> mul(const dev::bytes& input)
+{
+    return checkSame(dev::crypto::bn254::g1Mul, dev::crypto::libff_alt_bn128_G1_mul, input);
+}
+
+static std::pair<bool, dev::bytes> pairing(const dev::bytes& input)
+{
+    return checkSame(dev::crypto::bn254::pairingProduct, dev::crypto::libff_alt_bn128_pairing_product, input);
+}
+
+static dev::h256 randomScalar()
+{
+    uint256 k = InsecureRand256();
+    return dev::h256(k.begin(), dev::h256::ConstructFromPointer);
+}
+
+BOOST_FIXTURE_TEST_SUITE(altbn128_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(altbn128_g1_add_and_mul){
+    const dev::bytes zero(64, 0);
+    for (int i = 0; i < 20; i++) {
+        dev::bytes p = mulG1(G1, randomScalar());
+        dev::bytes q = mulG1(G1, randomScalar());
+        dev::bytes negP = mulG1(p, ORDER_MINUS_ONE);
+
+        BOOST_CHECK(add(concat({p, q})).first);
+        BOOST_CHECK(add(concat({p, p})).second == mulG1(p, dev::h256(2)));
+        BOOST_CHECK(add(concat({p, negP})).second == zero);
+        BOOST_CHECK(add(concat({zero, q})).second == q);
+        // Short inputs are padded with zeros
+        BOOST_CHECK(add(p).second == p);
+        add(dev::bytes(p.begin(), p.begin() + InsecureRandRange(p.size())));
+
+        BOOST_CHECK(mul(concat({p, randomScalar().asBytes()})).first);
+        BOOST_CHECK(mul(concat({p, ORDER.asBytes()})).second == zero);
+        BOOST_CHECK(mul(concat({zero, randomScalar().asBytes()})).second == zero);
+        // The scalar is not reduced modulo the order
+        mul(concat({p, dev::h256(~dev::u256(0)).asBytes()}));
+        mul(concat({q, dev::bytes(InsecureRandRange(32), 0xff)}));
+
+        // Damaged points are refused
+        dev::bytes bad = concat({p, q});
+        bad[InsecureRandRange(bad.size())] ^= 1 + InsecureRandRange(255);
+        BOOST_CHECK(!add(bad).first);
+    }
+
+    // Coordinates are below the field modulus
+    BOOST_CHECK(!add(concat({FIELD_MODULUS.asBytes(), dev::bytes(32, 0), G1})).first);
+    BOOST_CHECK(!mul(concat({dev::bytes(G1.begin(), G1.begin() + 32), FIELD_MODULUS.asBytes(), dev::h256(1).asBytes()})).first);
+}
+
+BOOST_AUTO_TEST_CASE(altbn128_pairing){
+    const dev::bytes one = dev::h256(1).asBytes();
+    const dev::bytes zero = dev::h256(0).asBytes();
+
+    // The empty product is one
+    BOOST_CHECK(pairing({}).second == one);
+    BOOST_CHECK(!pairing(dev::bytes(191, 0)).first);
+
+    for (int i = 0; i < 4; i++) {
+        dev::h256 a = randomScalar();
+        dev::bytes p = mulG1(G1, a);
+        dev::bytes negP = mulG1(p, ORDER_MINUS_ONE);
+
+        // e(aP, Q) * e(-aP, Q) == 1 for a multi pairing of 2 and 3 pairs
+        BOOST_CHECK(pairing(concat({p, G2, negP, G2})).second == one);
+        BOOST_CHECK(pairing(concat({p, KG2, negP, KG2, G1, dev::bytes(128, 0)})).second == one);
+        // e(123456789 * aP, G2) == e(aP, 123456789 * G2)
+        dev::bytes kp = mulG1(p, dev::h256(123456789));
+        BOOST_CHECK(pairing(concat({kp, G2, negP, KG2})).second == one);
+        BOOST_CHECK(pairing(concat({kp, G2, p, KG2})).second == zero);
+        BOOST_CHECK(pairing(concat({p, G2})).second == zero);
+
+        // Points of the twist outside of G2 are refused
+        BOOST_CHECK(!pairing(concat({p, G2, negP, NOT_G2})).first);
+        BOOST_CHECK(!pairing(concat({p, SMALL_ORDER_G2})).first);
+        BOOST_CHECK(!pairing(concat({zero, zero, SMALL_ORDER_G2})).first);
+
+        dev::bytes bad = concat({p, KG2});
+        bad[InsecureRandRange(bad.size())] ^= 1 + InsecureRandRange(255);
+        pairing(bad);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(altbn128_backend){
+    const dev::bytes input = concat({G1, G1});
+    BOOST_CHECK(dev::crypto::altBn128Backend() == dev::crypto::AltBn128Backend::Native);
+    auto native = dev::crypto::alt_bn128_G1_add(&input);
+    dev::crypto::setAltBn128Backend(dev::crypto::AltBn128Backend::LibFF);
+    BOOST_CHECK(dev::crypto::altBn128Backend() == dev::crypto::AltBn128Backend::LibFF);
+    BOOST_CHECK(dev::crypto::alt_bn128_G1_add(&input) == native);
+    dev::crypto::setAltBn128Backend(dev::crypto::AltBn128Backend::Native);
+    BOOST_CHECK(native.second == mulG1(G1, dev::h256(2)));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+}
@@ -387,6 +387,27 @@ BOOST_AUTO_TEST_CASE(bytecodeexec_contract_create_contracts){
     BOOST_CHECK(result.second.valueTransfers.size() == 0);
 }
 
+BOOST_AUTO_TEST_CASE(bytecodeexec_block_context){
+    genesisLoading();
+    CBlock block(generateBlock());
+    uint64_t blockGasLimit = GASLIMIT.convert_to<uint64_t>() * 2;
+
+    // A contract creation that does not read the block context
+    std::vector<OdanTransaction> txs(1, createOdanTransaction(CODE[0], 0, GASLIMIT, dev::u256(1), HASHTX, dev::Address()));
+    ByteCodeExec exec(block, txs, blockGasLimit, m_node.chainman->ActiveChain().Tip(), m_node.chainman->ActiveChain());
+    BOOST_CHECK(exec.performByteCode());
+    BOOST_CHECK(!exec.readBlockContext());
+
+    // COINBASE, TIMESTAMP, NUMBER, GASLIMIT and PUSH1 0 BLOCKHASH, each followed by POP STOP, then the same creation
+    for(const char* code : {"415000", "425000", "435000", "455000", "6000405000"}){
+        std::vector<OdanTransaction> txsContext(txs);
+        txsContext.insert(txsContext.begin(), createOdanTransaction(valtype(ParseHex(code)), 0, GASLIMIT, dev::u256(1), HASHTX, dev::Address(), 1));
+        ByteCodeExec execContext(block, txsContext, blockGasLimit, m_node.chainman->ActiveChain().Tip(), m_node.chainman->ActiveChain());
+        BOOST_CHECK(execContext.performByteCode());
+        BOOST_CHECK_MESSAGE(execContext.readBlockContext(), code);
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 }
@@ -0,0 +1,82 @@
+#include <boost/test/unit_test.hpp>
+#include <test/util/setup_common.h>
+#include <libdevcore/SHA3.h>
+#include <libevm/CodeCache.h>
+
+#include <optional>
+#include <vector>
+
+namespace CodeCacheTest{
+
+dev::bytes createCode(size_t size, uint8_t n){
+    dev::bytes code(size, 0x5b);
+    code[0] = n;
+    return code;
+}
+
+// Codes of the same size whose hashes are in the same shard of the cache, the shard is the first byte of the hash modulo 16
+std::vector<dev::bytes> createSameShardCodes(size_t size, size_t count){
+    std::vector<dev::bytes> codes;
+    std::optional<uint8_t> shard;
+    for(uint32_t n = 0; codes.size() < count; n++){
+        dev::bytes code = createCode(size, uint8_t(n));
+        code[1] = uint8_t(n >> 8);
+        uint8_t codeShard = dev::sha3(code)[0] % 16;
+        if(!shard)
+            shard = codeShard;
+        if(codeShard == *shard)
+            codes.push_back(code);
+    }
+    return codes;
+}
+
+BOOST_FIXTURE_TEST_SUITE(codecache_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(codecache_lookup_and_eviction){
+    dev::eth::CodeCache cache;
+    size_t shardBytes = dev::eth::CodeCache::entrySize(1000) * 2;
+    cache.setMaxBytes(shardBytes * 16);
+
+    std::vector<dev::bytes> codes = createSameShardCodes(1000, 3);
+    const dev::bytes &codeA = codes[0], &codeB = codes[1], &codeC = codes[2];
+    dev::h256 hashA = dev::sha3(codeA), hashB = dev::sha3(codeB), hashC = dev::sha3(codeC);
+
+    BOOST_CHECK(!cache.get(hashA));
+    cache.insert(hashA, &codeA);
+    cache.insert(hashB, &codeB);
+    auto entry = cache.get(hashA);
+    BOOST_REQUIRE(entry);
+    BOOST_CHECK(entry->code == codeA);
+
+    // The least recently used code is evicted
+    cache.insert(hashC, &codeC);
+    BOOST_CHECK(cache.get(hashA));
+    BOOST_CHECK(!cache.get(hashB));
+    BOOST_CHECK(cache.get(hashC));
+
+    dev::eth::CodeCache::Stats stats = cache.stats();
+    BOOST_CHECK_EQUAL(stats.entries, 2U);
+    BOOST_CHECK_EQUAL(stats.bytes, shardBytes);
+    BOOST_CHECK_EQUAL(stats.hits, 3U);
+    BOOST_CHECK_EQUAL(stats.misses, 2U);
+    BOOST_CHECK_EQUAL(stats.evictions, 1U);
+
+    // The evicted entries stay valid for their users
+    cache.setMaxBytes(0);
+    BOOST_CHECK_EQUAL(cache.stats().entries, 0U);
+    BOOST_CHECK(entry->code == codeA);
+}
+
+BOOST_AUTO_TEST_CASE(codecache_analysis_shared){
+    dev::eth::CodeCache cache;
+    dev::bytes code = createCode(100, 0x60);
+    dev::h256 hash = dev::sha3(code);
+    auto analysis = cache.analysis(hash, &code);
+    BOOST_REQUIRE(analysis);
+    BOOST_CHECK(cache.analysis(hash, &code) == analysis);
+    BOOST_CHECK_EQUAL(cache.stats().entries, 1U);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+}
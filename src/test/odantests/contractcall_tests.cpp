@@ -0,0 +1,89 @@
+#include <boost/test/unit_test.hpp>
+#include <test/util/setup_common.h>
+#include <odantests/test_utils.h>
+#include <odan/contractcall.h>
+
+#include <thread>
+
+namespace ContractCallTest{
+
+const dev::u256 GASLIMIT = dev::u256(500000);
+const dev::h256 HASHTX = dev::h256(ParseHex("cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc"));
+// Init code storing 42 in slot 1 and returning the runtime code SLOAD(calldata[0])
+const valtype CODE = valtype(ParseHex("602a6001556b6000355460005260206000f3600052600c6014f3"));
+
+dev::Address deployContract(ChainstateManager& chainman){
+    initState();
+    std::vector<OdanTransaction> txs = {createOdanTransaction(CODE, 0, GASLIMIT, dev::u256(1), HASHTX, dev::Address())};
+    executeBC(txs, chainman);
+    return createOdanAddress(HASHTX, 0);
+}
+
+BOOST_FIXTURE_TEST_SUITE(contractcall_tests, TestingSetup)
+
+BOOST_AUTO_TEST_CASE(contractcall_same_as_callcontract){
+    dev::Address contract = deployContract(*m_node.chainman);
+    dev::h256 hashStateRoot(globalState->rootHash());
+    valtype data = dev::h256(1).asBytes();
+
+    std::shared_ptr<const ContractCallSnapshot> snapshot = GetContractCallSnapshot(m_node.chainman->ActiveChainstate());
+    BOOST_CHECK(snapshot->AddressInUse(contract));
+    BOOST_CHECK(!snapshot->AddressInUse(dev::Address(1)));
+    std::vector<ResultExecute> result = snapshot->Call(contract, data);
+    BOOST_REQUIRE_EQUAL(result.size(), 1U);
+    BOOST_CHECK(result[0].execRes.excepted == dev::eth::TransactionException::None);
+    BOOST_CHECK(dev::h256(result[0].execRes.output) == dev::h256(42));
+
+    std::vector<ResultExecute> expected;
+    {
+        LOCK(cs_main);
+        expected = CallContract(contract, data, m_node.chainman->ActiveChainstate());
+    }
+    BOOST_REQUIRE_EQUAL(expected.size(), 1U);
+    BOOST_CHECK(result[0].execRes.output == expected[0].execRes.output);
+    BOOST_CHECK(result[0].execRes.gasUsed == expected[0].execRes.gasUsed);
+    BOOST_CHECK(globalState->rootHash() == hashStateRoot);
+
+    // Calling a missing contract
+    result = snapshot->Call(dev::Address(1), data);
+    BOOST_REQUIRE_EQUAL(result.size(), 1U);
+    BOOST_CHECK(result[0].execRes.excepted == dev::eth::TransactionException::Unknown);
+}
+
+BOOST_AUTO_TEST_CASE(contractcall_snapshot_reuse){
+    deployContract(*m_node.chainman);
+    Chainstate& chainstate = m_node.chainman->ActiveChainstate();
+    std::shared_ptr<const ContractCallSnapshot> snapshot = GetContractCallSnapshot(chainstate);
+    BOOST_CHECK(GetContractCallSnapshot(chainstate) == snapshot);
+
+    // A new snapshot is taken when the state changes
+    dev::Address contract = deployContract(*m_node.chainman);
+    std::shared_ptr<const ContractCallSnapshot> newSnapshot = GetContractCallSnapshot(chainstate);
+    BOOST_CHECK(newSnapshot != snapshot);
+    BOOST_CHECK(newSnapshot->AddressInUse(contract));
+}
+
+BOOST_AUTO_TEST_CASE(contractcall_concurrent){
+    dev::Address contract = deployContract(*m_node.chainman);
+    std::shared_ptr<const ContractCallSnapshot> snapshot = GetContractCallSnapshot(m_node.chainman->ActiveChainstate());
+
+    std::atomic<int> matches{0};
+    std::vector<std::thread> threads;
+    for(int i = 0; i < 4; i++){
+        threads.emplace_back([&]{
+            for(int j = 0; j < 25; j++){
+                std::vector<ResultExecute> result = snapshot->Call(contract, dev::h256(j % 2).asBytes());
+                dev::h256 expected = j % 2 ? dev::h256(42) : dev::h256();
+                if(result.size() == 1 && dev::h256(result[0].execRes.output) == expected)
+                    matches++;
+            }
+        });
+    }
+    for(std::thread& thread : threads)
+        thread.join();
+    BOOST_CHECK_EQUAL(matches.load(), 100);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+}
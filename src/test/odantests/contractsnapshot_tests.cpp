@@ -0,0 +1,129 @@
+#include <boost/test/unit_test.hpp>
+#include <test/util/setup_common.h>
+#include <odan/contractsnapshot.h>
+#include <streams.h>
+#include <util/convert.h>
+#include <libdevcore/Address.h>
+#include <libdevcore/DBFactory.h>
+#include <libdevcore/OverlayDB.h>
+#include <libdevcore/RLP.h>
+#include <libdevcore/SHA3.h>
+#include <libethereum/SecureTrieDB.h>
+
+namespace ContractSnapshotTest{
+
+struct ContractStateDBs{
+    dev::OverlayDB state;
+    dev::OverlayDB utxo;
+
+    explicit ContractStateDBs(const fs::path& path) :
+        state(dev::db::DBFactory::create(fs::PathToString(path / "state"))),
+        utxo(dev::db::DBFactory::create(fs::PathToString(path / "utxo"))) {}
+};
+
+/** Contracts with code and storage, and UTXO trie entries */
+static void fillContractState(ContractStateDBs& dbs, uint256& stateRoot, uint256& utxoRoot)
+{
+    dev::eth::SecureTrieDB<dev::Address, dev::OverlayDB> accounts(&dbs.state);
+    accounts.init();
+    dev::eth::SecureTrieDB<dev::Address, dev::OverlayDB> vins(&dbs.utxo);
+    vins.init();
+    dev::bytes code(200, 0x60);
+    dev::h256 codeHash = dev::sha3(code);
+    dbs.state.insert(codeHash, &code);
+    for(size_t i = 0; i < 10; i++){
+        dev::eth::SecureTrieDB<dev::h256, dev::OverlayDB> storage(&dbs.state);
+        storage.init();
+        for(size_t j = 0; j < 5; j++)
+            storage.insert(dev::h256(j + 1), dev::rlp(dev::u256(i * 100 + j + 1)));
+
+        dev::RLPStream account(4);
+        account << dev::u256(1) << dev::u256(i) << storage.root() << codeHash;
+        accounts.insert(dev::Address(dev::u160(i + 1)), &account.out());
+
+        dev::RLPStream vin(4);
+        vin << dev::h256(i) << uint32_t(0) << dev::u256(i) << uint8_t(1);
+        vins.insert(dev::Address(dev::u160(i + 1)), &vin.out());
+    }
+    dbs.state.commit();
+    dbs.utxo.commit();
+    stateRoot = h256Touint(accounts.root());
+    utxoRoot = h256Touint(vins.root());
+}
+
+BOOST_FIXTURE_TEST_SUITE(contractsnapshot_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(contractsnapshot_write_and_load){
+    ContractStateDBs source(m_path_root / "source");
+    uint256 stateRoot, utxoRoot;
+    fillContractState(source, stateRoot, utxoRoot);
+    BOOST_CHECK(CheckContractState(*source.state.backend(), *source.utxo.backend(), stateRoot, utxoRoot));
+
+    const fs::path path = m_path_root / "contract.dat";
+    const ContractSnapshotMetadata metadata{uint256::ONE, stateRoot, utxoRoot};
+    uint64_t nWritten = 0;
+    {
+        AutoFile file{fsbridge::fopen(path, "wb")};
+        BOOST_CHECK(WriteContractSnapshot(*source.state.backend(), *source.utxo.backend(), metadata, file, [] {}, nWritten));
+    }
+    // The account and UTXO tries, the storage tries and the code shared by the contracts
+    BOOST_CHECK(nWritten > 20);
+
+    ContractStateDBs target(m_path_root / "target");
+    BOOST_CHECK(!CheckContractState(*target.state.backend(), *target.utxo.backend(), stateRoot, utxoRoot));
+
+    // The snapshot of another block is refused
+    {
+        AutoFile file{fsbridge::fopen(path, "rb")};
+        uint64_t nLoaded = 0;
+        BOOST_CHECK(!LoadContractSnapshot(*target.state.backend(), *target.utxo.backend(),
+                                          ContractSnapshotMetadata{uint256::ZERO, stateRoot, utxoRoot}, file, 2, nLoaded));
+    }
+
+    AutoFile file{fsbridge::fopen(path, "rb")};
+    uint64_t nLoaded = 0;
+    BOOST_CHECK(LoadContractSnapshot(*target.state.backend(), *target.utxo.backend(), metadata, file, 4, nLoaded));
+    BOOST_CHECK_EQUAL(nLoaded, nWritten);
+    BOOST_CHECK(CheckContractState(*target.state.backend(), *target.utxo.backend(), stateRoot, utxoRoot));
+
+    // The keys of the fat tries are loaded with the nodes
+    dev::Address address(dev::u160(3));
+    BOOST_CHECK(target.state.lookupAux(dev::sha3(address)) == address.asBytes());
+    BOOST_CHECK(target.utxo.lookupAux(dev::sha3(address)) == address.asBytes());
+    dev::eth::SecureTrieDB<dev::Address, dev::OverlayDB> accounts(&target.state, uintToh256(stateRoot));
+    BOOST_CHECK(dev::RLP(accounts.at(address))[1].toInt<dev::u256>() == 2);
+}
+
+BOOST_AUTO_TEST_CASE(contractsnapshot_damaged_chunk){
+    ContractStateDBs target(m_path_root / "target");
+    const fs::path path = m_path_root / "damaged.dat";
+    const ContractSnapshotMetadata metadata{uint256::ONE, uint256::ONE, uint256::ONE};
+    {
+        AutoFile file{fsbridge::fopen(path, "wb")};
+        ContractSnapshotChunk chunk;
+        chunk.trie = CONTRACT_SNAPSHOT_STATE;
+        chunk.nodes.push_back(dev::bytes(40, 1));
+        chunk.hash = chunk.GetHash();
+        chunk.nodes.push_back(dev::bytes(40, 2));
+        ContractSnapshotChunk end;
+        end.hash = end.GetHash();
+        file << metadata << chunk << end;
+    }
+
+    AutoFile file{fsbridge::fopen(path, "rb")};
+    uint64_t nLoaded = 0;
+    BOOST_CHECK(!LoadContractSnapshot(*target.state.backend(), *target.utxo.backend(), metadata, file, 2, nLoaded));
+    BOOST_CHECK(target.state.lookup(dev::sha3(dev::bytes(40, 1))).empty());
+
+    // A truncated file is refused
+    {
+        AutoFile truncated{fsbridge::fopen(path, "wb")};
+        truncated << metadata;
+    }
+    AutoFile truncated{fsbridge::fopen(path, "rb")};
+    BOOST_CHECK(!LoadContractSnapshot(*target.state.backend(), *target.utxo.backend(), metadata, truncated, 2, nLoaded));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+}
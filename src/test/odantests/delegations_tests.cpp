@@ -3,6 +3,7 @@
 #include <script/solver.h>
 #include <chainparams.h>
 #include <odan/odandelegation.h>
+#include <arith_uint256.h>
 
 namespace DelegationTest{
 
@@ -38,6 +39,28 @@ void createNewBlocks(TestChain100Setup* testChain100Setup, size_t n){
 
     generateBlocks(n);
 }
+
+// The index is at the global state, the block hash only marks the height
+CIndexBestBlock indexBest(unsigned int height){
+    return CIndexBestBlock(ArithToUint256(arith_uint256(height)), h256Touint(globalState->rootHash()));
+}
+
+CIndexBestBlock updateDelegationIndex(const OdanDelegation& odanDelegation, const std::vector<ResultExecute>& results, unsigned int height, ChainstateManager& chainman){
+    std::vector<std::pair<uint160, Delegation>> vect;
+    for(const ResultExecute& result : results){
+        for(const dev::eth::LogEntry& log : result.txRec.log()){
+            DelegationEvent event;
+            if(odanDelegation.GetDelegationEvent(log, event)){
+                vect.push_back(std::make_pair(event.item.delegate, event.type == DELEGATION_ADD ? Delegation(event.item) : Delegation()));
+            }
+        }
+    }
+    BOOST_CHECK(vect.size() > 0);
+    LOCK(cs_main);
+    CIndexBestBlock best = indexBest(height);
+    BOOST_CHECK(chainman.m_blockman.m_block_tree_db->UpdateDelegationIndex(height, vect, best));
+    return best;
+}
 BOOST_FIXTURE_TEST_SUITE(delegations_tests, TestChain100Setup)
 
 BOOST_AUTO_TEST_CASE(checking_remove_bytecode_delegation){
@@ -103,6 +126,7 @@ BOOST_AUTO_TEST_CASE(checking_delegations_from_events){
 BOOST_AUTO_TEST_CASE(checking_delegations_contract){
     // Initialize
 //    initState();
+    fDelegationIndex = false;
     genesisLoading();
     createNewBlocks(this, 1000);
     dev::h256 hashTx(HASHTX);
@@ -128,7 +152,7 @@ BOOST_AUTO_TEST_CASE(checking_delegations_contract){
     // Get delegation for address
     Delegation delegation;
     uint160 address(ParseHex(DELEGATE_ADDRESS_HEX));
-    bool contractRet = odanDelegation.GetDelegation(address, delegation, m_node.chainman->ActiveChainstate());
+    bool contractRet = odanDelegation.GetDelegation(address, delegation, m_node.chainman->ActiveChainstate(), h256Touint(globalState->rootHash()));
     BOOST_CHECK(contractRet == true);
 
     // Verify delegation is valid
@@ -146,11 +170,133 @@ BOOST_AUTO_TEST_CASE(checking_delegations_contract){
 
     // Get delegation for address
     delegation = Delegation();
-    contractRet = odanDelegation.GetDelegation(address, delegation, m_node.chainman->ActiveChainstate());
+    contractRet = odanDelegation.GetDelegation(address, delegation, m_node.chainman->ActiveChainstate(), h256Touint(globalState->rootHash()));
     BOOST_CHECK(contractRet == true);
 
     // Verify delegation is valid
     BOOST_CHECK(OdanDelegation::VerifyDelegation(address, delegation) == false);
+    fDelegationIndex = true;
+}
+
+BOOST_AUTO_TEST_CASE(checking_delegations_index){
+    // Initialize
+    genesisLoading();
+    createNewBlocks(this, 1000);
+    dev::h256 hashTx(HASHTX);
+    BOOST_CHECK(fDelegationIndex == true);
+
+    // Create contracts
+    std::vector<OdanTransaction> txs;
+    txs.push_back(createOdanTransaction(DELEGATION_CODE, 0, GASLIMIT, dev::u256(1), hashTx, dev::Address()));
+    executeBC(txs, *m_node.chainman);
+
+    // Set delegation contract address
+    dev::Address contractAddress = createOdanAddress(txs[0].getHashWith(), txs[0].getNVout());
+    UpdateDelegationsAddress(h160Touint(contractAddress));
+    OdanDelegation odanDelegation;
+    unsigned int height = WITH_LOCK(cs_main, return m_node.chainman->ActiveChain().Height() + 1);
+    CIndexBestBlock createBest = indexBest(height - 1);
+    dev::h256 createRoot = globalState->rootHash();
+    dev::h256 createRootUTXO = globalState->rootHashUTXO();
+    BOOST_CHECK(WITH_LOCK(cs_main, return m_node.chainman->m_blockman.m_block_tree_db->WriteDelegationIndexBest(createBest)));
+
+    // Add delegation, the index gets the changes of the block
+    std::vector<OdanTransaction> txsAdd;
+    OdanTransaction txAdd = createOdanTransaction(ParseHex(ADD_BYTECODE_HEX), 0, GASLIMIT, dev::u256(1), ++hashTx, contractAddress);
+    txAdd.forceSender(dev::Address(DELEGATE_ADDRESS_HEX));
+    txsAdd.push_back(txAdd);
+    std::vector<ResultExecute> resultsAdd = executeBC(txsAdd, *m_node.chainman).first;
+    CIndexBestBlock addBest = updateDelegationIndex(odanDelegation, resultsAdd, height, *m_node.chainman);
+    dev::h256 addRoot = globalState->rootHash();
+    dev::h256 addRootUTXO = globalState->rootHashUTXO();
+
+    // The index has the same delegation as the contract
+    Delegation delegation;
+    uint160 address(ParseHex(DELEGATE_ADDRESS_HEX));
+    BOOST_CHECK(odanDelegation.GetDelegation(address, delegation, m_node.chainman->ActiveChainstate(), h256Touint(globalState->rootHash())) == true);
+    BOOST_CHECK(OdanDelegation::VerifyDelegation(address, delegation) == true);
+    BOOST_CHECK(delegation.fee == STAKER_FEE);
+    BOOST_CHECK(delegation.staker == uint160(ParseHex(STAKER_ADDRESS_HEX)));
+
+    Delegation contractDelegation;
+    fDelegationIndex = false;
+    BOOST_CHECK(odanDelegation.GetDelegation(address, contractDelegation, m_node.chainman->ActiveChainstate(), h256Touint(globalState->rootHash())) == true);
+    fDelegationIndex = true;
+    BOOST_CHECK(delegation == contractDelegation);
+
+    // The stakers load all delegations of the index, and the delegations replaced by the block
+    node::BlockTreeDB& blocktree = *WITH_LOCK(cs_main, return m_node.chainman->m_blockman.m_block_tree_db.get());
+    std::map<uint160, Delegation> delegations;
+    BOOST_CHECK(blocktree.ReadDelegationIndex(delegations));
+    BOOST_CHECK(delegations.size() == 1);
+    BOOST_CHECK(delegations[address] == delegation);
+    std::vector<std::pair<uint160, Delegation>> undo;
+    BOOST_CHECK(blocktree.ReadDelegationUndo(height, undo));
+    BOOST_CHECK(undo.size() == 1);
+    BOOST_CHECK(undo[0].first == address && undo[0].second.IsNull());
+
+    // Remove delegation
+    std::vector<OdanTransaction> txsRemove;
+    OdanTransaction txRemove = createOdanTransaction(ParseHex(REMOVE_BYTECODE_HEX), 0, GASLIMIT, dev::u256(1), ++hashTx, contractAddress);
+    txRemove.forceSender(dev::Address(DELEGATE_ADDRESS_HEX));
+    txsRemove.push_back(txRemove);
+    std::vector<ResultExecute> resultsRemove = executeBC(txsRemove, *m_node.chainman).first;
+    CIndexBestBlock removeBest = updateDelegationIndex(odanDelegation, resultsRemove, height + 1, *m_node.chainman);
+
+    BOOST_CHECK(odanDelegation.GetDelegation(address, delegation, m_node.chainman->ActiveChainstate(), h256Touint(globalState->rootHash())) == true);
+    BOOST_CHECK(delegation.IsNull());
+
+    delegations.clear();
+    BOOST_CHECK(blocktree.ReadDelegationIndex(delegations));
+    BOOST_CHECK(delegations.empty());
+
+    // Disconnecting the blocks restores the previous delegations
+    BOOST_CHECK(blocktree.EraseDelegationIndex(height + 1, addBest));
+    globalState->setRoot(addRoot);
+    globalState->setRootUTXO(addRootUTXO);
+    BOOST_CHECK(odanDelegation.GetDelegation(address, delegation, m_node.chainman->ActiveChainstate(), h256Touint(globalState->rootHash())) == true);
+    BOOST_CHECK(delegation == contractDelegation);
+
+    BOOST_CHECK(blocktree.EraseDelegationIndex(height, createBest));
+    globalState->setRoot(createRoot);
+    globalState->setRootUTXO(createRootUTXO);
+    BOOST_CHECK(odanDelegation.GetDelegation(address, delegation, m_node.chainman->ActiveChainstate(), h256Touint(globalState->rootHash())) == true);
+    BOOST_CHECK(delegation.IsNull());
+    BOOST_CHECK(!blocktree.ReadDelegationUndo(height, undo));
+
+    // The index ahead of the coins tip is rewound to it with the undo records
+    globalState->setRoot(addRoot);
+    globalState->setRootUTXO(addRootUTXO);
+    updateDelegationIndex(odanDelegation, resultsAdd, height, *m_node.chainman);
+    BOOST_CHECK(blocktree.UpdateDelegationIndex(height + 1, {{address, Delegation()}}, removeBest));
+    uint256 createHash = createBest.blockHash, addHash = addBest.blockHash, removeHash = removeBest.blockHash;
+    CBlockIndex indexCreate, indexAdd, indexRemove;
+    indexCreate.phashBlock = &createHash;
+    indexCreate.nHeight = height - 1;
+    indexCreate.hashStateRoot = createBest.stateRoot;
+    indexAdd.phashBlock = &addHash;
+    indexAdd.nHeight = height;
+    indexAdd.hashStateRoot = addBest.stateRoot;
+    indexAdd.pprev = &indexCreate;
+    indexRemove.phashBlock = &removeHash;
+    indexRemove.nHeight = height + 1;
+    indexRemove.hashStateRoot = removeBest.stateRoot;
+    indexRemove.pprev = &indexAdd;
+
+    BOOST_CHECK(blocktree.RewindDelegationIndex(&indexRemove, &indexAdd));
+    CIndexBestBlock best;
+    BOOST_CHECK(blocktree.ReadDelegationIndexBest(best));
+    BOOST_CHECK(best.blockHash == addHash && best.stateRoot == addBest.stateRoot);
+    BOOST_CHECK(odanDelegation.GetDelegation(address, delegation, m_node.chainman->ActiveChainstate(), h256Touint(globalState->rootHash())) == true);
+    BOOST_CHECK(delegation == contractDelegation);
+
+    // The contract is called when the index is not at the global state
+    BOOST_CHECK(blocktree.RewindDelegationIndex(&indexAdd, &indexCreate));
+    BOOST_CHECK(odanDelegation.GetDelegation(address, delegation, m_node.chainman->ActiveChainstate(), h256Touint(globalState->rootHash())) == true);
+    BOOST_CHECK(delegation == contractDelegation);
+    delegations.clear();
+    BOOST_CHECK(blocktree.ReadDelegationIndex(delegations));
+    BOOST_CHECK(delegations.empty());
 }
 
 BOOST_AUTO_TEST_SUITE_END()
@@ -607,6 +607,80 @@ BOOST_AUTO_TEST_CASE(min_gas_price_passage_from_130_to_0_three_paramsInstance_te
     }
 }
 
+BOOST_AUTO_TEST_CASE(min_gas_price_cache_test){
+    initState();
+    contractLoading();
+    int coinbaseMaturity = Params().GetConsensus().CoinbaseMaturity(0);
+    OdanDGP odanDGP(globalState.get(), m_node.chainman->ActiveChainstate());
+    BOOST_CHECK(odanDGP.getMinGasPrice(coinbaseMaturity + 2) == DEFAULT_MIN_GAS_PRICE_DGP);
+
+    // The cached parameters are read again when the storage of the DGP contract changes
+    dev::h256 oldHashStateRoot = globalState->rootHash();
+    dev::h256 hashTemp(hash);
+    std::vector<OdanTransaction> txs;
+    txs.push_back(createOdanTransaction(code[0], 0, dev::u256(500000), dev::u256(1), hashTemp, GasPriceDGP, 0));
+    txs.push_back(createOdanTransaction(code[10], 0, dev::u256(500000), dev::u256(1), ++hashTemp, dev::Address(), 0));
+    txs.push_back(createOdanTransaction(code[2], 0, dev::u256(500000), dev::u256(1), ++hashTemp, GasPriceDGP, 0));
+    auto result = executeBC(txs, *m_node.chainman);
+    BOOST_CHECK(odanDGP.getMinGasPrice(coinbaseMaturity + 2) == 13);
+    BOOST_CHECK(odanDGP.getMinGasPrice(0) == DEFAULT_MIN_GAS_PRICE_DGP);
+
+    // Other contracts do not change the parameters
+    dev::h256 dgpHashStateRoot = globalState->rootHash();
+    txs.clear();
+    txs.push_back(createOdanTransaction(code[11], 0, dev::u256(500000), dev::u256(1), ++hashTemp, dev::Address(), 0));
+    result = executeBC(txs, *m_node.chainman);
+    BOOST_CHECK(globalState->rootHash() != dgpHashStateRoot);
+    BOOST_CHECK(odanDGP.getMinGasPrice(coinbaseMaturity + 2) == 13);
+
+    // Back to the state before the DGP update, as after a reorg
+    globalState->setRoot(oldHashStateRoot);
+    BOOST_CHECK(odanDGP.getMinGasPrice(coinbaseMaturity + 2) == DEFAULT_MIN_GAS_PRICE_DGP);
+    globalState->setRoot(dgpHashStateRoot);
+    BOOST_CHECK(odanDGP.getMinGasPrice(coinbaseMaturity + 2) == 13);
+}
+
+BOOST_AUTO_TEST_CASE(min_gas_price_storage_cache_test){
+    initState();
+    contractLoading();
+    int coinbaseMaturity = Params().GetConsensus().CoinbaseMaturity(0);
+    OdanDGP odanDGP(globalState.get(), m_node.chainman->ActiveChainstate(), false);
+    BOOST_CHECK(odanDGP.getMinGasPrice(coinbaseMaturity + 2) == DEFAULT_MIN_GAS_PRICE_DGP);
+
+    // The template storage is read on the first call and taken from the cache entry on the next ones
+    dev::h256 oldHashStateRoot = globalState->rootHash();
+    dev::h256 hashTemp(hash);
+    std::vector<OdanTransaction> txs;
+    txs.push_back(createOdanTransaction(code[0], 0, dev::u256(500000), dev::u256(1), hashTemp, GasPriceDGP, 0));
+    txs.push_back(createOdanTransaction(code[10], 0, dev::u256(500000), dev::u256(1), ++hashTemp, dev::Address(), 0));
+    txs.push_back(createOdanTransaction(code[2], 0, dev::u256(500000), dev::u256(1), ++hashTemp, GasPriceDGP, 0));
+    auto result = executeBC(txs, *m_node.chainman);
+    BOOST_CHECK(odanDGP.getMinGasPrice(coinbaseMaturity + 2) == 13);
+    BOOST_CHECK(odanDGP.getMinGasPrice(coinbaseMaturity + 2) == 13);
+    BOOST_CHECK(odanDGP.getMinGasPrice(0) == DEFAULT_MIN_GAS_PRICE_DGP);
+
+    // Other contracts do not change the cached template
+    dev::h256 dgpHashStateRoot = globalState->rootHash();
+    txs.clear();
+    txs.push_back(createOdanTransaction(code[11], 0, dev::u256(500000), dev::u256(1), ++hashTemp, dev::Address(), 0));
+    result = executeBC(txs, *m_node.chainman);
+    BOOST_CHECK(globalState->rootHash() != dgpHashStateRoot);
+    BOOST_CHECK(odanDGP.getMinGasPrice(coinbaseMaturity + 2) == 13);
+
+    // The dgpevm mode keeps its own entries with the outputs of the template calls
+    OdanDGP odanDGPEVM(globalState.get(), m_node.chainman->ActiveChainstate(), true);
+    BOOST_CHECK(odanDGPEVM.getMinGasPrice(coinbaseMaturity + 2) == 13);
+    BOOST_CHECK(odanDGPEVM.getMinGasPrice(coinbaseMaturity + 2) == 13);
+
+    // Back to the state before the DGP update, as after a reorg
+    globalState->setRoot(oldHashStateRoot);
+    BOOST_CHECK(odanDGP.getMinGasPrice(coinbaseMaturity + 2) == DEFAULT_MIN_GAS_PRICE_DGP);
+    BOOST_CHECK(odanDGPEVM.getMinGasPrice(coinbaseMaturity + 2) == DEFAULT_MIN_GAS_PRICE_DGP);
+    globalState->setRoot(dgpHashStateRoot);
+    BOOST_CHECK(odanDGP.getMinGasPrice(coinbaseMaturity + 2) == 13);
+    BOOST_CHECK(odanDGPEVM.getMinGasPrice(coinbaseMaturity + 2) == 13);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 }
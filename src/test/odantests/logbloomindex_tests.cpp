@@ -0,0 +1,89 @@
+#include <boost/test/unit_test.hpp>
+#include <test/util/setup_common.h>
+#include <node/blockstorage.h>
+#include <validation.h>
+#include <libethcore/LogEntry.h>
+
+namespace LogBloomIndexTest{
+
+const dev::h160 ADDRESS_A = dev::h160(1);
+const dev::h160 ADDRESS_B = dev::h160(2);
+const dev::h256 TOPIC_A = dev::h256(3);
+const dev::h256 TOPIC_B = dev::h256(4);
+
+dev::h2048 logBloom(const dev::h160& address, const dev::h256& topic){
+    return dev::eth::LogEntry(address, {topic}, dev::bytes()).bloom();
+}
+
+std::vector<std::vector<uint256>> readHeightIndex(kernel::BlockTreeDB& db, ChainstateManager& chainman, const std::set<dev::h160>& addresses, const LogBloomFilter& filter){
+    std::vector<std::vector<uint256>> hashes;
+    LOCK(cs_main);
+    db.ReadHeightIndex(1, -1, 0, hashes, addresses, chainman, filter);
+    return hashes;
+}
+
+BOOST_FIXTURE_TEST_SUITE(logbloomindex_tests, TestingSetup)
+
+BOOST_AUTO_TEST_CASE(logbloomindex_filter){
+    kernel::BlockTreeDB& db = *m_node.chainman->m_blockman.m_block_tree_db;
+    ChainstateManager& chainman = *m_node.chainman;
+    uint256 hashA = uint256S("aa");
+    uint256 hashB = uint256S("bb");
+    uint256 hashC = uint256S("cc");
+
+    // Height 3 is indexed before the log bloom index, it is never skipped
+    BOOST_CHECK(db.WriteHeightIndex(CHeightTxIndexKey(3, ADDRESS_B), {hashC}));
+    BOOST_CHECK(db.WriteLogBloomIndex(10, logBloom(ADDRESS_A, TOPIC_A)));
+    BOOST_CHECK(db.WriteHeightIndex(CHeightTxIndexKey(10, ADDRESS_A), {hashA}));
+    BOOST_CHECK(db.WriteLogBloomIndex(LOG_BLOOM_SECTION_SIZE + 10, logBloom(ADDRESS_B, TOPIC_B)));
+    BOOST_CHECK(db.WriteHeightIndex(CHeightTxIndexKey(LOG_BLOOM_SECTION_SIZE + 10, ADDRESS_B), {hashB}));
+
+    BOOST_CHECK_EQUAL(readHeightIndex(db, chainman, {}, {}).size(), 3U);
+
+    std::vector<std::vector<uint256>> hashes = readHeightIndex(db, chainman, {}, {{LogBloomOf(TOPIC_A)}});
+    BOOST_REQUIRE_EQUAL(hashes.size(), 2U);
+    BOOST_CHECK(hashes[0][0] == hashC);
+    BOOST_CHECK(hashes[1][0] == hashA);
+
+    hashes = readHeightIndex(db, chainman, {ADDRESS_B}, {{LogBloomOf(ADDRESS_B)}, {LogBloomOf(TOPIC_B)}});
+    BOOST_REQUIRE_EQUAL(hashes.size(), 2U);
+    BOOST_CHECK(hashes[0][0] == hashC);
+    BOOST_CHECK(hashes[1][0] == hashB);
+
+    // Both groups must match
+    hashes = readHeightIndex(db, chainman, {}, {{LogBloomOf(ADDRESS_B)}, {LogBloomOf(TOPIC_A)}});
+    BOOST_REQUIRE_EQUAL(hashes.size(), 1U);
+    BOOST_CHECK(hashes[0][0] == hashC);
+
+    // One bloom of a group is enough
+    hashes = readHeightIndex(db, chainman, {}, {{LogBloomOf(TOPIC_A), LogBloomOf(TOPIC_B)}});
+    BOOST_CHECK_EQUAL(hashes.size(), 3U);
+}
+
+BOOST_AUTO_TEST_CASE(logbloomindex_erase){
+    kernel::BlockTreeDB& db = *m_node.chainman->m_blockman.m_block_tree_db;
+    ChainstateManager& chainman = *m_node.chainman;
+    uint256 hashA = uint256S("aa");
+    uint256 hashB = uint256S("bb");
+
+    BOOST_CHECK(db.WriteLogBloomIndex(20, logBloom(ADDRESS_A, TOPIC_A)));
+    BOOST_CHECK(db.WriteHeightIndex(CHeightTxIndexKey(20, ADDRESS_A), {hashA}));
+    BOOST_CHECK(db.WriteLogBloomIndex(21, logBloom(ADDRESS_B, TOPIC_B)));
+    BOOST_CHECK(db.WriteHeightIndex(CHeightTxIndexKey(21, ADDRESS_B), {hashB}));
+
+    // Disconnect block 21 and connect another block at the same height
+    BOOST_CHECK(db.EraseHeightIndex(21));
+    BOOST_CHECK(readHeightIndex(db, chainman, {}, {{LogBloomOf(TOPIC_B)}}).empty());
+    BOOST_CHECK_EQUAL(readHeightIndex(db, chainman, {}, {{LogBloomOf(TOPIC_A)}}).size(), 1U);
+
+    BOOST_CHECK(db.WriteLogBloomIndex(21, logBloom(ADDRESS_A, TOPIC_B)));
+    BOOST_CHECK(db.WriteHeightIndex(CHeightTxIndexKey(21, ADDRESS_A), {hashB}));
+    BOOST_CHECK_EQUAL(readHeightIndex(db, chainman, {ADDRESS_A}, {{LogBloomOf(ADDRESS_A)}}).size(), 2U);
+
+    BOOST_CHECK(db.WipeHeightIndex());
+    BOOST_CHECK(readHeightIndex(db, chainman, {}, {}).empty());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+}
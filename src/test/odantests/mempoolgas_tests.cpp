@@ -0,0 +1,145 @@
+#include <boost/test/unit_test.hpp>
+#include <test/util/random.h>
+#include <test/util/setup_common.h>
+#include <test/util/txmempool.h>
+#include <txmempool.h>
+
+namespace MempoolGasTest{
+
+const std::vector<unsigned char> SENDER_A(20, 0xaa);
+const std::vector<unsigned char> SENDER_B(20, 0xbb);
+
+CMutableTransaction spendTx(const Txid& prevout){
+    CMutableTransaction tx;
+    tx.vin.resize(1);
+    tx.vin[0].prevout = COutPoint(prevout, 0);
+    tx.vout.resize(1);
+    tx.vout[0].nValue = 1;
+    return tx;
+}
+
+CMutableTransaction spendTx(){
+    return spendTx(Txid::FromUint256(InsecureRand256()));
+}
+
+// A contract tx paying for its gas limit at the gas price plus a fixed fee
+void addContractTx(CTxMemPool& pool, const CMutableTransaction& tx, const std::vector<unsigned char>& sender, uint64_t gasLimit, CAmount gasPrice) EXCLUSIVE_LOCKS_REQUIRED(pool.cs){
+    pool.addUnchecked(TestMemPoolEntryHelper().Fee(gasLimit * gasPrice + 1000).MinGasPrice(gasPrice).Sender(sender).GasLimit(gasLimit).FromTx(tx));
+}
+
+BOOST_FIXTURE_TEST_SUITE(mempoolgas_tests, TestingSetup)
+
+BOOST_AUTO_TEST_CASE(mempoolgas_track){
+    CTxMemPool& pool = *Assert(m_node.mempool);
+    LOCK2(cs_main, pool.cs);
+    CMutableTransaction txA = spendTx();
+    CMutableTransaction txB = spendTx();
+    CMutableTransaction txC = spendTx();
+    addContractTx(pool, txA, SENDER_A, 100000, 40);
+    addContractTx(pool, txB, SENDER_A, 200000, 40);
+    addContractTx(pool, txC, SENDER_B, 50000, 40);
+    pool.addUnchecked(TestMemPoolEntryHelper().Fee(1000).FromTx(spendTx()));
+
+    BOOST_CHECK_EQUAL(pool.GetTotalGasLimit(), 350000U);
+    BOOST_CHECK_EQUAL(pool.GetTotalGas(), 350000U);
+    BOOST_CHECK_EQUAL(pool.GetSenderGas(SENDER_A), 300000U);
+    BOOST_CHECK_EQUAL(pool.GetSenderGas(SENDER_B), 50000U);
+
+    pool.removeRecursive(CTransaction(txA), MemPoolRemovalReason::REPLACED);
+    pool.removeRecursive(CTransaction(txC), MemPoolRemovalReason::REPLACED);
+    BOOST_CHECK_EQUAL(pool.GetTotalGasLimit(), 200000U);
+    BOOST_CHECK_EQUAL(pool.GetSenderGas(SENDER_A), 200000U);
+    BOOST_CHECK_EQUAL(pool.GetSenderGas(SENDER_B), 0U);
+}
+
+BOOST_AUTO_TEST_CASE(mempoolgas_trim){
+    CTxMemPool& pool = *Assert(m_node.mempool);
+    LOCK2(cs_main, pool.cs);
+    CMutableTransaction txLow = spendTx();
+    CMutableTransaction txHigh = spendTx();
+    CMutableTransaction txChild = spendTx(txLow.GetHash());
+    CMutableTransaction txPlain = spendTx();
+    addContractTx(pool, txLow, SENDER_A, 100000, 40);
+    addContractTx(pool, txHigh, SENDER_B, 100000, 100);
+    pool.addUnchecked(TestMemPoolEntryHelper().Fee(1000000).FromTx(txChild));
+    pool.addUnchecked(TestMemPoolEntryHelper().Fee(1000).FromTx(txPlain));
+
+    // Within the budget nothing is removed
+    pool.TrimToGas(200000);
+    BOOST_CHECK_EQUAL(pool.size(), 4U);
+
+    // The lowest fee per gas goes first with its descendants, whatever their fee
+    std::vector<COutPoint> vNoSpendsRemaining;
+    pool.TrimToGas(150000, &vNoSpendsRemaining);
+    BOOST_CHECK(!pool.exists(GenTxid::Txid(txLow.GetHash())));
+    BOOST_CHECK(!pool.exists(GenTxid::Txid(txChild.GetHash())));
+    BOOST_CHECK(pool.exists(GenTxid::Txid(txHigh.GetHash())));
+    BOOST_CHECK_EQUAL(vNoSpendsRemaining.size(), 2U);
+    BOOST_CHECK_EQUAL(pool.GetTotalGas(), 100000U);
+
+    // The txs without gas are left to the size limit
+    pool.TrimToGas(0);
+    BOOST_CHECK_EQUAL(pool.size(), 1U);
+    BOOST_CHECK(pool.exists(GenTxid::Txid(txPlain.GetHash())));
+    BOOST_CHECK_EQUAL(pool.GetTotalGas(), 0U);
+}
+
+BOOST_AUTO_TEST_CASE(mempoolgas_simulation){
+    CTxMemPool& pool = *Assert(m_node.mempool);
+    LOCK2(cs_main, pool.cs);
+    CMutableTransaction txA = spendTx();
+    CMutableTransaction txB = spendTx();
+    addContractTx(pool, txA, SENDER_A, 200000, 40);
+    addContractTx(pool, txB, SENDER_A, 100000, 60);
+
+    // The simulated gas is counted against the budget, the declared gas against the sender quota
+    pool.UpdateContractSimulation(*pool.GetIter(txA.GetHash()), nullptr, 50000);
+    BOOST_CHECK_EQUAL((*pool.GetIter(txA.GetHash()))->GetGas(), 50000U);
+    BOOST_CHECK_EQUAL(pool.GetTotalGas(), 150000U);
+    BOOST_CHECK_EQUAL(pool.GetTotalGasLimit(), 300000U);
+    BOOST_CHECK_EQUAL(pool.GetSenderGas(SENDER_A), 300000U);
+    pool.TrimToGas(150000);
+    BOOST_CHECK_EQUAL(pool.size(), 2U);
+
+    // The refund of the unused gas is not counted in the score
+    BOOST_CHECK_EQUAL((*pool.GetIter(txA.GetHash()))->GetModifiedFeeForGas(), 50000 * 40 + 1000);
+    pool.TrimToGas(100000);
+    BOOST_CHECK(!pool.exists(GenTxid::Txid(txA.GetHash())));
+
+    // The gas used can not exceed the gas limit
+    pool.UpdateContractSimulation(*pool.GetIter(txB.GetHash()), nullptr, 1000000);
+    BOOST_CHECK_EQUAL(pool.GetTotalGas(), 100000U);
+}
+
+BOOST_AUTO_TEST_CASE(mempoolgas_replace){
+    CTxMemPool& pool = *Assert(m_node.mempool);
+    LOCK2(cs_main, pool.cs);
+    CMutableTransaction txParent = spendTx();
+    CMutableTransaction txChild = spendTx(txParent.GetHash());
+    CMutableTransaction txGrandChild = spendTx(txChild.GetHash());
+    CMutableTransaction txOther = spendTx();
+    addContractTx(pool, txParent, SENDER_A, 100000, 40);
+    pool.addUnchecked(TestMemPoolEntryHelper().Fee(1000).FromTx(txChild));
+    addContractTx(pool, txGrandChild, SENDER_A, 200000, 40);
+    addContractTx(pool, txOther, SENDER_A, 50000, 40);
+    BOOST_CHECK_EQUAL(pool.GetSenderGas(SENDER_A), 350000U);
+
+    // A replacement of the parent releases the gas of the descendants it evicts too
+    CTxMemPool::setEntries conflicts{*pool.GetIter(txParent.GetHash())};
+    BOOST_CHECK_EQUAL(pool.GetSenderGasWithout(SENDER_A, conflicts), 50000U);
+    BOOST_CHECK_EQUAL(pool.GetSenderGasWithout(SENDER_B, conflicts), 0U);
+    pool.removeRecursive(CTransaction(txParent), MemPoolRemovalReason::REPLACED);
+    BOOST_CHECK_EQUAL(pool.GetSenderGas(SENDER_A), 50000U);
+
+    // The descendants of another sender are not charged to this one
+    CMutableTransaction txOtherChild = spendTx(txOther.GetHash());
+    addContractTx(pool, txOtherChild, SENDER_B, 100000, 40);
+    conflicts = {*pool.GetIter(txOther.GetHash())};
+    BOOST_CHECK_EQUAL(pool.GetSenderGasWithout(SENDER_A, conflicts), 0U);
+    BOOST_CHECK_EQUAL(pool.GetSenderGasWithout(SENDER_B, conflicts), 0U);
+    BOOST_CHECK_EQUAL(pool.GetSenderGas(SENDER_B), 100000U);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+}
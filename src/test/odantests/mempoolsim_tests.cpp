@@ -0,0 +1,131 @@
+#include <boost/test/unit_test.hpp>
+#include <test/util/setup_common.h>
+#include <test/util/txmempool.h>
+#include <odantests/test_utils.h>
+#include <odan/mempoolsim.h>
+#include <txmempool.h>
+
+namespace MempoolSimTest{
+
+const dev::u256 GASLIMIT = dev::u256(500000);
+const dev::h256 HASHTX = dev::h256(ParseHex("dddddddddddddddddddddddddddddddddddddddddddddddddddddddddddddddd"));
+// Init code returning the runtime code SSTORE(calldata[0], calldata[32])
+const valtype CODE = valtype(ParseHex("67602035600035550060005260086018f3"));
+// PUSH1 0 PUSH1 0 REVERT
+const valtype CODE_REVERT = valtype(ParseHex("60006000fd"));
+
+OdanTransaction storeTx(const dev::Address& contract, uint64_t slot, uint64_t value){
+    valtype data = dev::h256(slot).asBytes();
+    valtype word = dev::h256(value).asBytes();
+    data.insert(data.end(), word.begin(), word.end());
+    return createOdanTransaction(data, 0, GASLIMIT, dev::u256(1), dev::sha3(dev::h256(slot * 1000 + value)), contract);
+}
+
+dev::Address deployContract(ChainstateManager& chainman){
+    initState();
+    std::vector<OdanTransaction> txs = {createOdanTransaction(CODE, 0, GASLIMIT, dev::u256(1), HASHTX, dev::Address())};
+    executeBC(txs, chainman);
+    return createOdanAddress(HASHTX, 0);
+}
+
+BOOST_FIXTURE_TEST_SUITE(mempoolsim_tests, TestingSetup)
+
+BOOST_AUTO_TEST_CASE(mempoolsim_simulate){
+    dev::Address contract = deployContract(*m_node.chainman);
+    dev::h256 hashStateRoot(globalState->rootHash());
+    std::shared_ptr<const ContractCallSnapshot> snapshot = GetContractCallSnapshot(m_node.chainman->ActiveChainstate());
+
+    ContractSimulation simulation;
+    snapshot->Simulate({storeTx(contract, 5, 1), storeTx(contract, 6, 1)}, simulation);
+    BOOST_CHECK(!simulation.failed);
+    BOOST_CHECK(!simulation.blockContextRead);
+    BOOST_CHECK(simulation.gasUsed > 2 * 21000);
+    BOOST_CHECK(simulation.keys.state.accounts.count(contract));
+    BOOST_CHECK(simulation.keys.state.storage.count(std::make_pair(contract, dev::u256(5))));
+    BOOST_CHECK(simulation.keys.state.storage.count(std::make_pair(contract, dev::u256(6))));
+    BOOST_CHECK(globalState->rootHash() == hashStateRoot);
+
+    // A call to a missing contract and a reverted creation
+    ContractSimulation missing;
+    snapshot->Simulate({storeTx(dev::Address(1), 5, 1)}, missing);
+    BOOST_CHECK(missing.failed);
+    ContractSimulation reverted;
+    snapshot->Simulate({createOdanTransaction(CODE_REVERT, 0, GASLIMIT, dev::u256(1), HASHTX, dev::Address(), 1)}, reverted);
+    BOOST_CHECK(reverted.failed);
+}
+
+BOOST_AUTO_TEST_CASE(mempoolsim_unchanged){
+    dev::Address contract = deployContract(*m_node.chainman);
+    Chainstate& chainstate = m_node.chainman->ActiveChainstate();
+    std::shared_ptr<const ContractCallSnapshot> snapshot = GetContractCallSnapshot(chainstate);
+    ContractSimulation simulation;
+    snapshot->Simulate({storeTx(contract, 5, 1)}, simulation);
+
+    // Another slot of the same contract changed
+    executeBC({storeTx(contract, 7, 1)}, *m_node.chainman);
+    std::shared_ptr<const ContractCallSnapshot> other = GetContractCallSnapshot(chainstate);
+    BOOST_CHECK(other != snapshot);
+    BOOST_CHECK(other->Unchanged(*snapshot, simulation.keys));
+
+    // The slot written by the simulated tx changed
+    executeBC({storeTx(contract, 5, 2)}, *m_node.chainman);
+    std::shared_ptr<const ContractCallSnapshot> changed = GetContractCallSnapshot(chainstate);
+    BOOST_CHECK(!changed->Unchanged(*snapshot, simulation.keys));
+    BOOST_CHECK(!changed->Unchanged(*other, simulation.keys));
+}
+
+BOOST_AUTO_TEST_CASE(mempoolsim_block_state){
+    dev::Address contract = deployContract(*m_node.chainman);
+    std::shared_ptr<const ContractCallSnapshot> snapshot = GetContractCallSnapshot(m_node.chainman->ActiveChainstate());
+    ContractSimulation simulation;
+    snapshot->Simulate({storeTx(contract, 5, 1)}, simulation);
+    LOCK(cs_main);
+    BOOST_CHECK(snapshot->UnchangedInGlobalState(simulation.keys));
+
+    // An earlier tx of the block wrote another slot, then the slot of the simulated tx
+    executeBC({storeTx(contract, 7, 1)}, *m_node.chainman);
+    BOOST_CHECK(snapshot->UnchangedInGlobalState(simulation.keys));
+    executeBC({storeTx(contract, 5, 2)}, *m_node.chainman);
+    BOOST_CHECK(!snapshot->UnchangedInGlobalState(simulation.keys));
+}
+
+BOOST_AUTO_TEST_CASE(mempoolsim_entry){
+    dev::Address contract = deployContract(*m_node.chainman);
+    CTxMemPool& pool = *Assert(m_node.mempool);
+    CMutableTransaction tx;
+    tx.vin.resize(1);
+    tx.vout.resize(1);
+    tx.vout[0].nValue = 1;
+    const uint256 hash = tx.GetHash();
+    {
+        LOCK2(cs_main, pool.cs);
+        pool.addUnchecked(TestMemPoolEntryHelper().FromTx(tx));
+    }
+
+    MempoolSimulator simulator(pool, *m_node.chainman, 2);
+    simulator.Push(hash, {storeTx(contract, 5, 1)});
+    simulator.Flush();
+    BOOST_CHECK_EQUAL(simulator.GetSimulated(), 1U);
+    {
+        LOCK(pool.cs);
+        std::shared_ptr<const ContractSimulation> simulation = (*pool.GetIter(hash))->GetContractSimulation();
+        BOOST_REQUIRE(simulation);
+        BOOST_CHECK(!simulation->failed);
+        BOOST_CHECK(simulation->snapshot == GetContractCallSnapshot(m_node.chainman->ActiveChainstate()));
+    }
+
+    // Nothing is executed again while the snapshot is current, or once the tx left the mempool
+    simulator.Push(hash, {storeTx(contract, 5, 1)});
+    simulator.Flush();
+    {
+        LOCK(pool.cs);
+        pool.removeRecursive(CTransaction(tx), MemPoolRemovalReason::REPLACED);
+    }
+    simulator.Push(hash, {storeTx(contract, 5, 1)});
+    simulator.Flush();
+    BOOST_CHECK_EQUAL(simulator.GetSimulated(), 1U);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+}
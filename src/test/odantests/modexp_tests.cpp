@@ -0,0 +1,98 @@
+#include <boost/test/unit_test.hpp>
+#include <test/util/random.h>
+#include <test/util/setup_common.h>
+#include <libdevcore/CommonData.h>
+#include <libdevcrypto/ModExp.h>
+#include <libethcore/Precompiled.h>
+
+namespace ModExpTest{
+
+/** Compare the Montgomery engine with boost */
+static dev::bigint modexp(const dev::bigint& base, const dev::bytes& exp, const dev::bigint& mod)
+{
+    dev::bigint result = dev::crypto::modexp(base, &exp, mod);
+    BOOST_CHECK(result == dev::crypto::modexpReference(base, &exp, mod));
+    return result;
+}
+
+static dev::bigint randomNumber(size_t size)
+{
+    return dev::fromBigEndian<dev::bigint>(g_insecure_rand_ctx.randbytes<uint8_t>(size));
+}
+
+static dev::bytes precompile(const dev::bytes& input)
+{
+    auto result = dev::eth::PrecompiledRegistrar::executor("modexp")(&input);
+    BOOST_CHECK(result.first);
+    return result.second;
+}
+
+static dev::bytes lengths(size_t base, size_t exp, size_t mod)
+{
+    dev::bytes input = dev::h256(base).asBytes();
+    dev::bytes expLength = dev::h256(exp).asBytes();
+    dev::bytes modLength = dev::h256(mod).asBytes();
+    input.insert(input.end(), expLength.begin(), expLength.end());
+    input.insert(input.end(), modLength.begin(), modLength.end());
+    return input;
+}
+
+BOOST_FIXTURE_TEST_SUITE(modexp_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(modexp_edge_cases){
+    const dev::bytes none;
+    for (int mod : {0, 1, 2, 3, 7, 9}) {
+        for (int base : {0, 1, 2, 8}) {
+            modexp(base, none, mod);
+            modexp(base, {0}, mod);
+            modexp(base, {1}, mod);
+            modexp(base, {0, 0, 5}, mod);
+        }
+    }
+    BOOST_CHECK(modexp(0, none, 7) == 1);
+    BOOST_CHECK(modexp(0, {3}, 7) == 0);
+    BOOST_CHECK(modexp(5, {3}, 0) == 0);
+    BOOST_CHECK(modexp(5, none, 1) == 0);
+    // The base is reduced first
+    BOOST_CHECK(modexp(dev::bigint(1) << 300, {2}, 11) == modexp((dev::bigint(1) << 300) % 11, {2}, 11));
+}
+
+BOOST_AUTO_TEST_CASE(modexp_random){
+    for (int i = 0; i < 100; i++) {
+        // All the limb specializations, the even moduli and the moduli that are too big use boost
+        dev::bigint mod = randomNumber(1 + InsecureRandRange(600));
+        if (InsecureRandBool())
+            mod |= 1;
+        dev::bigint base = randomNumber(InsecureRandRange(700));
+        dev::bytes exp = g_insecure_rand_ctx.randbytes<uint8_t>(InsecureRandRange(i % 10 == 0 ? 64 : 8));
+        modexp(base, exp, mod);
+        // Moduli with limbs set to zero or to all ones
+        modexp(base, exp, (dev::bigint(1) << (64 * InsecureRandRange(65))) - 1);
+        modexp(base, exp, (dev::bigint(1) << (64 * InsecureRandRange(65))) + 1);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(modexp_precompile){
+    // The result has the size of the modulus even when the modulus is zero
+    BOOST_CHECK(precompile(lengths(0, 0, 0)).empty());
+    BOOST_CHECK(precompile(lengths(1, 1, 0)).empty());
+    BOOST_CHECK(precompile(lengths(0, 0, 3)) == dev::bytes(3, 0));
+    dev::bytes input = lengths(1, 1, 2);
+    input.insert(input.end(), {3, 5, 0, 7});
+    BOOST_CHECK(precompile(input) == dev::bytes({0, 5}));
+    // 3^5 mod 0x700 = 0xf3, the modulus is right-padded with zeros
+    input.resize(input.size() - 2);
+    input.push_back(7);
+    BOOST_CHECK(precompile(input) == dev::bytes({0, 0xf3}));
+    // 3^0x500 mod 7 = 2, the exponent is right-padded with zeros
+    input = lengths(1, 2, 1);
+    input.insert(input.end(), {3, 5});
+    BOOST_CHECK(precompile(input) == dev::bytes({0}));
+    input.push_back(0);
+    input.push_back(7);
+    BOOST_CHECK(precompile(input) == dev::bytes({2}));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+}
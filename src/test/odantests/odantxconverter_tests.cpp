@@ -180,4 +180,38 @@ BOOST_AUTO_TEST_CASE(parse_incorrect_txcall_overflow){
     runFailingTest(m_node.chainman->ActiveChainstate(), MakeMempool(m_node), false, 120, script1, script2);
 }
 
+BOOST_AUTO_TEST_CASE(parse_sender_from_block){
+    LOCK(::cs_main);
+    CTxMemPool& mempool = MakeMempool(m_node);
+    CScript script1 = CScript() << CScriptNum(VersionVM::GetEVMDefault().toRaw()) << CScriptNum(int64_t(gasLimit)) << CScriptNum(int64_t(gasPrice)) << data << address << OP_CALL;
+    std::vector<CTxOut> outs1 = {CTxOut(value, CScript() << OP_DUP << OP_HASH160 << address << OP_EQUALVERIFY << OP_CHECKSIG)};
+    CTransactionRef tx1 = MakeTransactionRef(createTX(outs1));
+    CTransaction transaction(createTX({CTxOut(value, script1)}, tx1->GetHash()));
+
+    // The parent is only in the block
+    BlockTxMap blockTxs;
+    blockTxs.emplace(tx1->GetHash(), tx1);
+    OdanTxConverter converter(transaction, m_node.chainman->ActiveChainstate(), &mempool, NULL, &blockTxs);
+    ExtractOdanTX odanTx;
+    BOOST_CHECK(converter.extractionOdanTransactions(odanTx));
+    BOOST_CHECK(converter.getInputSender() == address);
+    checkResult(false, odanTx.first, transaction.GetHash());
+}
+
+BOOST_AUTO_TEST_CASE(parse_cached_sender){
+    LOCK(::cs_main);
+    CTxMemPool& mempool = MakeMempool(m_node);
+    CScript script1 = CScript() << CScriptNum(VersionVM::GetEVMDefault().toRaw()) << CScriptNum(int64_t(gasLimit)) << CScriptNum(int64_t(gasPrice)) << data << OP_CREATE;
+    CTransaction transaction(createTX({CTxOut(value, script1), CTxOut(value, script1)}, uint256::ONE));
+
+    // The parent is unknown, the sender resolved before is used for all the outputs
+    const valtype cachedSender = address;
+    OdanTxConverter converter(transaction, m_node.chainman->ActiveChainstate(), &mempool, NULL, NULL, SCRIPT_EXEC_BYTE_CODE, &cachedSender);
+    ExtractOdanTX odanTx;
+    BOOST_CHECK(converter.extractionOdanTransactions(odanTx));
+    BOOST_CHECK(odanTx.first.size() == 2);
+    checkResult(true, odanTx.first, transaction.GetHash());
+    BOOST_CHECK(odanTx.first[0].getRefundSender() == dev::Address(address));
+}
+
 BOOST_AUTO_TEST_SUITE_END()
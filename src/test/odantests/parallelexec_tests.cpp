@@ -0,0 +1,132 @@
+#include <boost/test/unit_test.hpp>
+#include <test/util/setup_common.h>
+#include <odantests/test_utils.h>
+#include <odan/odanDGP.h>
+#include <odan/parallelexec.h>
+#include <checkqueue.h>
+
+namespace ParallelExecTest{
+
+const dev::u256 GASLIMIT = dev::u256(500000);
+const dev::h256 HASHTX = dev::h256(ParseHex("bbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbb"));
+// Init code returning the runtime code SSTORE(calldata[0], calldata[32])
+const valtype CODE = valtype(ParseHex("67602035600035550060005260086018f3"));
+// Init code returning the runtime code TIMESTAMP POP STOP
+const valtype CODE_TIMESTAMP = valtype(ParseHex("624250006000526003601df3"));
+
+valtype storeData(uint64_t slot, uint64_t value){
+    valtype data = dev::h256(slot).asBytes();
+    valtype word = dev::h256(value).asBytes();
+    data.insert(data.end(), word.begin(), word.end());
+    return data;
+}
+
+std::vector<std::vector<OdanTransaction>> createCalls(const dev::Address& contract, const std::vector<uint64_t>& slots){
+    std::vector<std::vector<OdanTransaction>> txs;
+    for(size_t i = 0; i < slots.size(); i++){
+        dev::h256 hash(dev::sha3(dev::h256(i)));
+        // Two outputs per transaction, executed in order by the same job
+        txs.push_back({createOdanTransaction(storeData(slots[i], i + 1), 0, GASLIMIT, dev::u256(1), hash, contract, 0),
+                       createOdanTransaction(storeData(slots[i] + 1000, i + 1), 0, GASLIMIT, dev::u256(1), hash, contract, 1)});
+    }
+    return txs;
+}
+
+std::vector<ResultExecute> execute(const std::vector<std::vector<OdanTransaction>>& txs, ChainstateManager& chainman, bool parallel, std::vector<bool>* contextRead = nullptr){
+    LOCK(cs_main);
+    CChain& chain = chainman.ActiveChain();
+    CBlock block(generateBlock());
+    uint64_t blockGasLimit = DEFAULT_BLOCK_GAS_LIMIT_DGP;
+    CCheckQueue<CContractExecCheck> queue{/*batch_size=*/1, /*worker_threads_num=*/2};
+
+    std::unique_ptr<ParallelContractExec> parallelExec;
+    if(parallel){
+        parallelExec = std::make_unique<ParallelContractExec>(block, chain.Tip(), blockGasLimit, chain);
+        for(size_t i = 0; i < txs.size(); i++)
+            parallelExec->Add(i, txs[i]);
+        parallelExec->Run(queue);
+    }
+
+    std::vector<ResultExecute> results;
+    for(size_t i = 0; i < txs.size(); i++){
+        ByteCodeExec exec(block, txs[i], blockGasLimit, chain.Tip(), chain);
+        BOOST_CHECK(parallelExec ? parallelExec->Execute(i, txs[i], exec) : exec.performByteCode());
+        for(const ResultExecute& result : exec.getResult())
+            results.push_back(result);
+        if(contextRead)
+            contextRead->push_back(exec.readBlockContext());
+    }
+    return results;
+}
+
+void checkSameResults(const std::vector<uint64_t>& slots, ChainstateManager& chainman){
+    initState();
+    std::vector<OdanTransaction> txsCreate = {createOdanTransaction(CODE, 0, GASLIMIT, dev::u256(1), HASHTX, dev::Address())};
+    executeBC(txsCreate, chainman);
+    dev::Address contract = createOdanAddress(HASHTX, 0);
+    std::vector<std::vector<OdanTransaction>> txs = createCalls(contract, slots);
+
+    dev::h256 oldHashStateRoot(globalState->rootHash());
+    dev::h256 oldHashUTXORoot(globalState->rootHashUTXO());
+    std::vector<ResultExecute> serial = execute(txs, chainman, false);
+    dev::h256 serialHashStateRoot(globalState->rootHash());
+
+    globalState->setRoot(oldHashStateRoot);
+    globalState->setRootUTXO(oldHashUTXORoot);
+    std::vector<ResultExecute> parallel = execute(txs, chainman, true);
+
+    BOOST_CHECK(serialHashStateRoot == globalState->rootHash());
+    BOOST_CHECK(serialHashStateRoot != oldHashStateRoot);
+    BOOST_CHECK(globalState->storage(contract, dev::u256(slots.back())) == dev::u256(slots.size()));
+    BOOST_REQUIRE(serial.size() == parallel.size());
+    for(size_t i = 0; i < serial.size(); i++){
+        BOOST_CHECK(serial[i].txRec.stateRoot() == parallel[i].txRec.stateRoot());
+        BOOST_CHECK(serial[i].txRec.utxoRoot() == parallel[i].txRec.utxoRoot());
+        BOOST_CHECK(serial[i].execRes.gasUsed == parallel[i].execRes.gasUsed);
+        BOOST_CHECK(serial[i].execRes.excepted == parallel[i].execRes.excepted);
+        BOOST_CHECK(serial[i].tx.GetHash() == parallel[i].tx.GetHash());
+    }
+}
+
+BOOST_FIXTURE_TEST_SUITE(parallelexec_tests, TestingSetup)
+
+BOOST_AUTO_TEST_CASE(parallelexec_independent_txs){
+    checkSameResults({1, 2, 3, 4, 5, 6, 7, 8}, *m_node.chainman);
+}
+
+BOOST_AUTO_TEST_CASE(parallelexec_conflicting_txs){
+    checkSameResults({1, 2, 1, 3, 2, 2, 4, 1}, *m_node.chainman);
+}
+
+BOOST_AUTO_TEST_CASE(parallelexec_block_context){
+    initState();
+    std::vector<OdanTransaction> txsCreate = {createOdanTransaction(CODE, 0, GASLIMIT, dev::u256(1), HASHTX, dev::Address()),
+                                              createOdanTransaction(CODE_TIMESTAMP, 0, GASLIMIT, dev::u256(1), HASHTX, dev::Address(), 1)};
+    executeBC(txsCreate, *m_node.chainman);
+    dev::Address contract = createOdanAddress(HASHTX, 0);
+    dev::Address contractTimestamp = createOdanAddress(HASHTX, 1);
+
+    // Every other transaction reads the timestamp of the block
+    std::vector<std::vector<OdanTransaction>> txs = createCalls(contract, {1, 2, 3, 4, 5, 6});
+    for(size_t i = 1; i < txs.size(); i += 2)
+        txs[i][1] = createOdanTransaction(valtype(), 0, GASLIMIT, dev::u256(1), txs[i][1].getHashWith(), contractTimestamp, 1);
+
+    dev::h256 oldHashStateRoot(globalState->rootHash());
+    dev::h256 oldHashUTXORoot(globalState->rootHashUTXO());
+    std::vector<bool> serialContextRead;
+    execute(txs, *m_node.chainman, false, &serialContextRead);
+
+    globalState->setRoot(oldHashStateRoot);
+    globalState->setRootUTXO(oldHashUTXORoot);
+    std::vector<bool> parallelContextRead;
+    execute(txs, *m_node.chainman, true, &parallelContextRead);
+
+    BOOST_REQUIRE_EQUAL(serialContextRead.size(), txs.size());
+    BOOST_CHECK(serialContextRead == parallelContextRead);
+    for(size_t i = 0; i < txs.size(); i++)
+        BOOST_CHECK_EQUAL(serialContextRead[i], i % 2 == 1);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+}
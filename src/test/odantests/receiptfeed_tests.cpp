@@ -0,0 +1,155 @@
+#include <boost/test/unit_test.hpp>
+#include <test/util/setup_common.h>
+#include <odan/receiptfeed.h>
+#include <chain.h>
+#include <streams.h>
+#include <validation.h>
+#include <validationinterface.h>
+
+namespace ReceiptFeedTest{
+
+const dev::Address CONTRACT_A = dev::Address("aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa");
+const dev::Address CONTRACT_B = dev::Address("bbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbb");
+const dev::h256 TOPIC_1 = dev::h256("1111111111111111111111111111111111111111111111111111111111111111");
+const dev::h256 TOPIC_2 = dev::h256("2222222222222222222222222222222222222222222222222222222222222222");
+
+TransactionReceiptInfo receipt(uint32_t txIndex, const dev::eth::LogEntries& logs){
+    TransactionReceiptInfo tri{};
+    tri.transactionHash = uint256(txIndex + 1);
+    tri.transactionIndex = txIndex;
+    tri.gasUsed = 21000;
+    tri.cumulativeGasUsed = 21000 * (txIndex + 1);
+    tri.logs = logs;
+    return tri;
+}
+
+uint256 blockHash(uint32_t height){
+    return uint256(uint8_t(0x80 + height));
+}
+
+void connect(ReceiptFeed& feed, uint32_t height, const std::vector<TransactionReceiptInfo>& receipts, bool connected = true){
+    CBlockIndex index;
+    const uint256 hash = blockHash(height);
+    index.phashBlock = &hash;
+    index.nHeight = height;
+    if(connected){
+        feed.AddBlock(hash, height, receipts);
+        GetMainSignals().BlockConnected(ChainstateRole::NORMAL, std::make_shared<const CBlock>(), &index);
+    } else {
+        GetMainSignals().BlockDisconnected(std::make_shared<const CBlock>(), &index);
+    }
+    SyncWithValidationInterfaceQueue();
+}
+
+// Hash, height and connected flag at the start of every message
+void checkHeader(DataStream& ss, uint32_t height, bool connected){
+    uint256 hash;
+    uint32_t nHeight;
+    uint8_t flag;
+    ss >> hash >> nHeight >> flag;
+    BOOST_CHECK(hash == blockHash(height));
+    BOOST_CHECK_EQUAL(nHeight, height);
+    BOOST_CHECK_EQUAL(flag, connected ? 'C' : 'D');
+}
+
+BOOST_FIXTURE_TEST_SUITE(receiptfeed_tests, TestingSetup)
+
+BOOST_AUTO_TEST_CASE(receiptfeed_messages){
+    ReceiptFeed feed(10, 0);
+    RegisterValidationInterface(&feed);
+    dev::eth::LogEntries logs = {dev::eth::LogEntry(CONTRACT_A, {TOPIC_1, TOPIC_2}, {1, 2}),
+                                 dev::eth::LogEntry(CONTRACT_B, {TOPIC_2}, {3})};
+    connect(feed, 1, {receipt(0, {}), receipt(1, logs)});
+
+    std::optional<std::string> receipts = feed.GetReceiptsMessage(blockHash(1), true);
+    BOOST_REQUIRE(receipts);
+    DataStream ss(MakeByteSpan(*receipts));
+    checkHeader(ss, 1, true);
+    BOOST_CHECK_EQUAL(ReadCompactSize(ss), 2U);
+    BOOST_CHECK(!feed.GetReceiptsMessage(blockHash(2), true));
+
+    // One log message per log entry, with the address and the first topic as subtopic
+    std::vector<std::pair<std::string, std::string>> messages = feed.GetContractLogMessages(blockHash(1), false);
+    BOOST_REQUIRE_EQUAL(messages.size(), 2U);
+    BOOST_CHECK_EQUAL(messages[0].first.size(), 52U);
+    BOOST_CHECK(messages[0].first.compare(0, 20, std::string((const char*)CONTRACT_A.data(), 20)) == 0);
+    BOOST_CHECK_EQUAL(messages[1].first.size(), 52U);
+    DataStream log(MakeByteSpan(messages[1].second));
+    checkHeader(log, 1, false);
+    uint256 txHash;
+    uint32_t txIndex, outputIndex, logIndex;
+    log >> txHash >> txIndex >> outputIndex >> logIndex;
+    BOOST_CHECK(txHash == uint256(2));
+    BOOST_CHECK_EQUAL(txIndex, 1U);
+    BOOST_CHECK_EQUAL(logIndex, 1U);
+
+    UnregisterValidationInterface(&feed);
+}
+
+BOOST_AUTO_TEST_CASE(receiptfeed_filter){
+    ContractLogRecord log{CONTRACT_A, {TOPIC_1, TOPIC_2}, ""};
+    ContractLogFilter filter;
+    BOOST_CHECK(filter.Match(log));
+    filter.addresses = {CONTRACT_B};
+    BOOST_CHECK(!filter.Match(log));
+    filter.addresses.insert(CONTRACT_A);
+    BOOST_CHECK(filter.Match(log));
+
+    // Topics are matched by position, an empty one matches any topic
+    filter.topics = {std::nullopt, TOPIC_2};
+    BOOST_CHECK(filter.Match(log));
+    filter.topics = {TOPIC_2};
+    BOOST_CHECK(!filter.Match(log));
+    filter.topics = {TOPIC_1, TOPIC_2, std::nullopt};
+    BOOST_CHECK(!filter.Match(log));
+}
+
+BOOST_AUTO_TEST_CASE(receiptfeed_wait){
+    ReceiptFeed feed(3, 0);
+    RegisterValidationInterface(&feed);
+    std::optional<uint64_t> cursor = feed.GetCursor(1);
+    BOOST_REQUIRE(cursor);
+    std::vector<ReceiptFeedEvent> events;
+    BOOST_CHECK(feed.Wait(*cursor, events, std::chrono::milliseconds{1}));
+    BOOST_CHECK(events.empty());
+
+    dev::eth::LogEntries logs = {dev::eth::LogEntry(CONTRACT_A, {TOPIC_1}, {}),
+                                 dev::eth::LogEntry(CONTRACT_B, {TOPIC_1}, {})};
+    connect(feed, 1, {receipt(0, logs)});
+    connect(feed, 1, {}, false);
+    BOOST_CHECK(feed.Wait(*cursor, events, std::chrono::milliseconds{1}));
+    BOOST_REQUIRE_EQUAL(events.size(), 2U);
+    BOOST_CHECK(events[0].connected);
+    BOOST_CHECK(!events[1].connected);
+    BOOST_CHECK(events[0].block == events[1].block);
+
+    // The filtered subscribers only get the matching logs
+    ContractLogFilter filter;
+    filter.addresses = {CONTRACT_B};
+    DataStream ss(MakeByteSpan(ContractLogsMessage(events[1], filter)));
+    checkHeader(ss, 1, false);
+    BOOST_CHECK_EQUAL(ReadCompactSize(ss), 1U);
+
+    // A height connected again can be followed from, older ones fell behind the kept events
+    connect(feed, 1, {});
+    connect(feed, 2, {});
+    connect(feed, 3, {});
+    connect(feed, 4, {});
+    BOOST_CHECK(!feed.GetCursor(1));
+    BOOST_CHECK(feed.GetCursor(2));
+    BOOST_CHECK(feed.GetCursor(5));
+    events.clear();
+    BOOST_CHECK(!feed.Wait(*cursor, events, std::chrono::milliseconds{1}));
+    cursor = feed.GetCursor(4);
+    BOOST_CHECK(feed.Wait(*cursor, events, std::chrono::milliseconds{1}));
+    BOOST_REQUIRE_EQUAL(events.size(), 1U);
+    BOOST_CHECK_EQUAL(events[0].block->height, 4U);
+
+    feed.Interrupt();
+    BOOST_CHECK(!feed.Wait(*cursor, events, std::chrono::seconds{10}));
+    UnregisterValidationInterface(&feed);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+}
@@ -0,0 +1,97 @@
+#include <boost/test/unit_test.hpp>
+#include <test/util/setup_common.h>
+#include <undo.h>
+#include <validation.h>
+
+namespace RecentSpentCoinsTest{
+
+const int DEPTH = 3;
+
+COutPoint prevout(int n){
+    return COutPoint(Txid::FromUint256(uint256(n)), 0);
+}
+
+// Block spending prevout(n) that was created at height n - 1
+void connectBlock(RecentSpentCoins& spentCoins, const CBlockIndex* pindex, int n){
+    CBlock block;
+    block.vtx.push_back(MakeTransactionRef(CMutableTransaction()));
+    CMutableTransaction tx;
+    tx.vin.push_back(CTxIn(prevout(n)));
+    block.vtx.push_back(MakeTransactionRef(tx));
+
+    CBlockUndo blockundo;
+    blockundo.vtxundo.emplace_back();
+    blockundo.vtxundo[0].vprevout.push_back(Coin(CTxOut(n, CScript()), n - 1, false, false));
+    spentCoins.ConnectBlock(block, blockundo, pindex, DEPTH);
+}
+
+struct TestChain{
+    std::vector<uint256> hashes;
+    std::vector<CBlockIndex> blocks;
+
+    TestChain(int count) : hashes(count), blocks(count){
+        for(int i = 0; i < count; i++){
+            hashes[i] = uint256(i + 100);
+            blocks[i].phashBlock = &hashes[i];
+            blocks[i].nHeight = i;
+            blocks[i].pprev = i > 0 ? &blocks[i - 1] : nullptr;
+        }
+    }
+};
+
+BOOST_FIXTURE_TEST_SUITE(recentspentcoins_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(recentspentcoins_find){
+    TestChain chain(6);
+    RecentSpentCoins spentCoins;
+    for(int i = 1; i < 6; i++)
+        connectBlock(spentCoins, &chain.blocks[i], i);
+
+    Coin coin;
+    int nFirstHeight = 0;
+    BOOST_CHECK(spentCoins.Find(&chain.blocks[5], &chain.blocks[1], prevout(4), &coin, nFirstHeight));
+    BOOST_CHECK_EQUAL(coin.out.nValue, 4);
+    BOOST_CHECK_EQUAL(coin.nHeight, 3U);
+    BOOST_CHECK_EQUAL(nFirstHeight, 3);
+
+    // The blocks below the depth are not kept
+    BOOST_CHECK(!spentCoins.Find(&chain.blocks[5], &chain.blocks[1], prevout(2), &coin, nFirstHeight));
+    BOOST_CHECK_EQUAL(nFirstHeight, 3);
+
+    // Spent before the fork
+    BOOST_CHECK(!spentCoins.Find(&chain.blocks[5], &chain.blocks[4], prevout(4), &coin, nFirstHeight));
+    BOOST_CHECK_EQUAL(nFirstHeight, 5);
+
+    // Not spent
+    BOOST_CHECK(!spentCoins.Find(&chain.blocks[5], &chain.blocks[3], prevout(7), &coin, nFirstHeight));
+    BOOST_CHECK_EQUAL(nFirstHeight, 4);
+}
+
+BOOST_AUTO_TEST_CASE(recentspentcoins_disconnect){
+    TestChain chain(6);
+    RecentSpentCoins spentCoins;
+    for(int i = 1; i < 6; i++)
+        connectBlock(spentCoins, &chain.blocks[i], i);
+
+    spentCoins.DisconnectBlock(&chain.blocks[5]);
+    Coin coin;
+    int nFirstHeight = 0;
+    // The index does not end at this tip anymore
+    BOOST_CHECK(!spentCoins.Find(&chain.blocks[5], &chain.blocks[3], prevout(5), &coin, nFirstHeight));
+    BOOST_CHECK_EQUAL(nFirstHeight, 6);
+    BOOST_CHECK(!spentCoins.Find(&chain.blocks[4], &chain.blocks[2], prevout(5), &coin, nFirstHeight));
+    BOOST_CHECK_EQUAL(nFirstHeight, 3);
+    BOOST_CHECK(spentCoins.Find(&chain.blocks[4], &chain.blocks[2], prevout(4), &coin, nFirstHeight));
+
+    // Connecting a block that does not follow the last one resets the index
+    TestChain fork(6);
+    fork.hashes[4] = uint256(200);
+    connectBlock(spentCoins, &fork.blocks[5], 5);
+    BOOST_CHECK(!spentCoins.Find(&fork.blocks[5], &fork.blocks[2], prevout(4), &coin, nFirstHeight));
+    BOOST_CHECK_EQUAL(nFirstHeight, 5);
+    BOOST_CHECK(spentCoins.Find(&fork.blocks[5], &fork.blocks[2], prevout(5), &coin, nFirstHeight));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+}
@@ -0,0 +1,109 @@
+#include <boost/test/unit_test.hpp>
+#include <test/util/setup_common.h>
+#include <node/miner.h>
+#include <timedata.h>
+#include <validation.h>
+
+namespace SpeculativeBlockTest{
+
+// Template with a coinstake paying to the author, like the speculative block of the staker
+node::CBlockTemplate speculativeTemplate(const uint256& hashPrevBlock, uint32_t nBits, uint32_t nTime, const CScript& author){
+    node::CBlockTemplate speculative;
+    speculative.block.hashPrevBlock = hashPrevBlock;
+    speculative.block.nBits = nBits;
+    speculative.block.nTime = nTime;
+    CMutableTransaction coinbase;
+    coinbase.vin.resize(1);
+    coinbase.vout.resize(1);
+    CMutableTransaction coinstake;
+    coinstake.vin.resize(1);
+    coinstake.vout.resize(2);
+    coinstake.vout[1].scriptPubKey = author;
+    speculative.block.vtx = {MakeTransactionRef(coinbase), MakeTransactionRef(coinstake)};
+    return speculative;
+}
+
+BOOST_FIXTURE_TEST_SUITE(speculativeblock_tests, TestChain100Setup)
+
+BOOST_AUTO_TEST_CASE(speculativeblock_use){
+    const CScript author = CScript() << ToByteVector(coinbaseKey.GetPubKey()) << OP_CHECKSIG;
+    const CScript other = CScript() << OP_TRUE;
+    const uint256 hashPrevBlock = WITH_LOCK(cs_main, return m_node.chainman->ActiveChain().Tip()->GetBlockHash());
+    CBlockHeader header;
+    header.hashPrevBlock = hashPrevBlock;
+    header.nBits = 0x207fffff;
+    const uint32_t blockTime = 1598888000;
+
+    node::CBlockTemplate speculative = speculativeTemplate(hashPrevBlock, header.nBits, blockTime - 16, author);
+    BOOST_CHECK(node::CanUseSpeculativeBlock(speculative, header, blockTime, author));
+
+    // The contracts were executed for another author or tip
+    BOOST_CHECK(!node::CanUseSpeculativeBlock(speculative, header, blockTime, other));
+    CBlockHeader otherTip = header;
+    otherTip.hashPrevBlock = uint256::ONE;
+    BOOST_CHECK(!node::CanUseSpeculativeBlock(speculative, otherTip, blockTime, author));
+    CBlockHeader otherBits = header;
+    otherBits.nBits = 0x1d00ffff;
+    BOOST_CHECK(!node::CanUseSpeculativeBlock(speculative, otherBits, blockTime, author));
+
+    // The time of the kernel only matters when a contract read the block context
+    speculative.fBlockContextRead = true;
+    BOOST_CHECK(!node::CanUseSpeculativeBlock(speculative, header, blockTime, author));
+    speculative.block.nTime = blockTime;
+    BOOST_CHECK(node::CanUseSpeculativeBlock(speculative, header, blockTime, author));
+
+    // A block stopped by the time limit is built again for the kernel
+    speculative.fTimeLimitReached = true;
+    BOOST_CHECK(!node::CanUseSpeculativeBlock(speculative, header, blockTime, author));
+
+    // A template without a coinstake is never used
+    node::CBlockTemplate empty = speculativeTemplate(hashPrevBlock, header.nBits, blockTime, author);
+    empty.block.vtx.resize(1);
+    BOOST_CHECK(!node::CanUseSpeculativeBlock(empty, header, blockTime, author));
+}
+
+BOOST_AUTO_TEST_CASE(speculativeblock_time_limit){
+    // The speculative block gets only a small part of the time limit for a found kernel
+    const int64_t nNow = GetAdjustedTimeSeconds();
+    const int32_t nTimeLimit = nNow + 60;
+    const int32_t nSpeculativeLimit = node::SpeculativeBlockTimeLimit(nNow, nTimeLimit);
+    BOOST_CHECK(nSpeculativeLimit < nTimeLimit);
+    BOOST_CHECK(nSpeculativeLimit > nNow);
+    BOOST_CHECK_EQUAL(node::SpeculativeBlockTimeLimit(nNow, nNow), nNow);
+
+    // Mempool transactions left out by the time limit are reported with the template
+    const CScript script = CScript() << OP_TRUE;
+    CreateValidMempoolTransaction(m_coinbase_txns[0], 0, 0, coinbaseKey, script);
+    Chainstate& chainstate = m_node.chainman->ActiveChainstate();
+    std::unique_ptr<node::CBlockTemplate> late = node::BlockAssembler(chainstate, m_node.mempool.get()).CreateNewBlock(script, false, nullptr, 0, nNow - 1);
+    BOOST_REQUIRE(late);
+    BOOST_CHECK(late->fTimeLimitReached);
+    BOOST_CHECK_EQUAL(late->block.vtx.size(), 1U);
+
+    std::unique_ptr<node::CBlockTemplate> full = node::BlockAssembler(chainstate, m_node.mempool.get()).CreateNewBlock(script, false, nullptr, 0, nTimeLimit);
+    BOOST_REQUIRE(full);
+    BOOST_CHECK(!full->fTimeLimitReached);
+    BOOST_CHECK_EQUAL(full->block.vtx.size(), 2U);
+}
+
+BOOST_AUTO_TEST_CASE(speculativeblock_snapshot){
+    // The block built on a snapshot of the state is the same as the one built on globalState
+    const CScript script = CScript() << OP_TRUE;
+    CreateValidMempoolTransaction(m_coinbase_txns[0], 0, 0, coinbaseKey, script);
+    Chainstate& chainstate = m_node.chainman->ActiveChainstate();
+    const dev::h256 oldHashStateRoot = WITH_LOCK(cs_main, return globalState->rootHash());
+    std::unique_ptr<node::CBlockTemplate> global = node::BlockAssembler(chainstate, m_node.mempool.get()).CreateNewBlock(script);
+    std::unique_ptr<node::CBlockTemplate> snapshot = node::BlockAssembler(chainstate, m_node.mempool.get()).CreateNewBlock(script, false, nullptr, 0, 0, /*fSnapshot=*/true);
+    BOOST_REQUIRE(global);
+    BOOST_REQUIRE(snapshot);
+    BOOST_CHECK_EQUAL(snapshot->block.vtx.size(), 2U);
+    BOOST_CHECK_EQUAL(snapshot->block.vtx.size(), global->block.vtx.size());
+    BOOST_CHECK(snapshot->block.hashPrevBlock == global->block.hashPrevBlock);
+    BOOST_CHECK(snapshot->block.hashStateRoot == global->block.hashStateRoot);
+    BOOST_CHECK(snapshot->block.hashUTXORoot == global->block.hashUTXORoot);
+    BOOST_CHECK(WITH_LOCK(cs_main, return globalState->rootHash()) == oldHashStateRoot);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+}
@@ -0,0 +1,104 @@
+#include <boost/test/unit_test.hpp>
+#include <test/util/setup_common.h>
+#include <test/util/random.h>
+#include <pos.h>
+
+namespace StakeKernelTest{
+
+struct StakeCoin{
+    COutPoint prevout;
+    CStakeCache stake;
+};
+
+std::vector<StakeCoin> createCoins(size_t count){
+    std::vector<StakeCoin> coins;
+    for(size_t i = 0; i < count; i++){
+        COutPoint prevout(Txid::FromUint256(InsecureRand256()), InsecureRandRange(10));
+        CAmount amount = 1 + InsecureRandRange(1000 * COIN);
+        coins.push_back({prevout, CStakeCache(1000 + InsecureRandRange(1000), amount)});
+    }
+    return coins;
+}
+
+// Check the batch against CheckStakeKernelHash for every coin and block time, returns the number of kernels found
+size_t checkSameResults(CBlockIndex* pindexPrev, unsigned int nBits, const std::vector<StakeCoin>& coins){
+    StakeKernelBatch batch(pindexPrev, nBits);
+    for(const StakeCoin& coin : coins)
+        BOOST_CHECK(batch.Add(coin.prevout, coin.stake));
+    BOOST_REQUIRE_EQUAL(batch.Size(), coins.size());
+
+    size_t found = 0;
+    for(uint32_t nTimeBlock = 1500; nTimeBlock < 2500; nTimeBlock += 16){
+        std::vector<std::pair<size_t, uint256>> solved;
+        batch.Check(0, batch.Size(), nTimeBlock, solved);
+        size_t j = 0;
+        for(size_t i = 0; i < coins.size(); i++){
+            uint256 hashProofOfStake, targetProofOfStake;
+            bool ret = nTimeBlock >= coins[i].stake.blockFromTime &&
+                CheckStakeKernelHash(pindexPrev, nBits, coins[i].stake.blockFromTime, coins[i].stake.amount, coins[i].prevout, nTimeBlock, hashProofOfStake, targetProofOfStake);
+            bool inSolved = j < solved.size() && solved[j].first == i;
+            BOOST_CHECK_EQUAL(ret, inSolved);
+            if(ret && inSolved){
+                BOOST_CHECK(solved[j].second == hashProofOfStake);
+                found++;
+            }
+            if(inSolved) j++;
+        }
+        BOOST_CHECK_EQUAL(j, solved.size());
+    }
+    return found;
+}
+
+BOOST_FIXTURE_TEST_SUITE(stakekernel_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(stakekernel_batch_weight_divided){
+    CBlockIndex index;
+    index.nHeight = 1000;
+    index.nStakeModifier = InsecureRand256();
+    BOOST_REQUIRE(index.nHeight + 1 >= Params().GetConsensus().QIP9Height);
+
+    std::vector<StakeCoin> coins = createCoins(100);
+    size_t found = checkSameResults(&index, 0x1c00ffff, coins);
+    BOOST_CHECK(found > 0);
+    BOOST_CHECK(checkSameResults(&index, 0x1a00ffff, coins) < found);
+    // The weighted target overflows
+    BOOST_CHECK(checkSameResults(&index, 0x2100ffff, coins) > found);
+}
+
+BOOST_AUTO_TEST_CASE(stakekernel_batch_target_multiplied){
+    SelectParams(ChainType::TESTNET);
+    CBlockIndex index;
+    index.nHeight = 1000;
+    index.nStakeModifier = InsecureRand256();
+    BOOST_REQUIRE(index.nHeight + 1 < Params().GetConsensus().QIP9Height);
+
+    std::vector<StakeCoin> coins = createCoins(100);
+    BOOST_CHECK(checkSameResults(&index, 0x1c00ffff, coins) > 0);
+    checkSameResults(&index, 0x1a00ffff, coins);
+    // The weighted target wraps around
+    checkSameResults(&index, 0x2100ffff, coins);
+}
+
+BOOST_AUTO_TEST_CASE(stakekernel_batch_skipped){
+    CBlockIndex index;
+    index.nHeight = 1000;
+    StakeKernelBatch batch(&index, 0x1d00ffff);
+    std::map<COutPoint, CStakeCache> cache;
+    COutPoint prevout(Txid::FromUint256(InsecureRand256()), 0);
+    BOOST_CHECK(!batch.Add(prevout, cache));
+    BOOST_CHECK(!batch.Add(prevout, CStakeCache(1000, 0)));
+    cache.insert(std::make_pair(prevout, CStakeCache(1000, COIN)));
+    BOOST_CHECK(batch.Add(prevout, cache));
+    BOOST_CHECK_EQUAL(batch.Size(), 1U);
+    BOOST_CHECK(batch.GetPrevout(0) == prevout);
+    BOOST_CHECK(batch.IsFor(&index, 0x1d00ffff));
+    BOOST_CHECK(!batch.IsFor(&index, 0x1a00ffff));
+
+    // Block time before the time of the coin
+    uint256 hashProofOfStake;
+    BOOST_CHECK(!batch.Check(0, 999, hashProofOfStake));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+}
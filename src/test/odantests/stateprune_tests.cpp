@@ -0,0 +1,179 @@
+#include <boost/test/unit_test.hpp>
+#include <test/util/setup_common.h>
+#include <odan/stateprune.h>
+#include <libdevcore/DBFactory.h>
+#include <libdevcore/Address.h>
+#include <libethereum/SecureTrieDB.h>
+
+namespace StatePruneTest{
+
+using Trie = dev::eth::SecureTrieDB<dev::Address, dev::OverlayDB>;
+
+dev::Address address(size_t i){
+    return dev::Address(dev::u160(i + 1));
+}
+
+// Long enough to be stored in its own node
+dev::bytes value(size_t i, uint8_t version){
+    return dev::bytes(40, uint8_t(i + version * 7));
+}
+
+void update(Trie& trie, dev::OverlayDB& db, size_t count, uint8_t version){
+    for(size_t i = 0; i < count; i++)
+        trie.insert(address(i * 3), value(i * 3, version));
+    db.commit();
+}
+
+bool readable(dev::OverlayDB& db, const dev::h256& root){
+    return WalkTrie(*db.backend(), root, [](const dev::h256&, const std::string&) { return true; },
+                    [](const dev::bytes&, dev::bytesConstRef) { return true; });
+}
+
+BOOST_FIXTURE_TEST_SUITE(stateprune_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(stateprune_reorg_window){
+    dev::OverlayDB db(dev::db::DBFactory::create(fs::PathToString(m_path_root / "state")));
+    Trie trie(&db);
+    trie.init();
+    for(size_t i = 0; i < 100; i++)
+        trie.insert(address(i), value(i, 0));
+    db.commit();
+
+    StatePruner pruner(false, 2);
+    BOOST_CHECK(!pruner.Load(db, 0));
+    BOOST_REQUIRE(pruner.Build(db, {trie.root()}, 0));
+    db.setTrackRefs(true);
+
+    std::vector<dev::h256> roots{trie.root()};
+    for(int height = 1; height <= 2; height++){
+        update(trie, db, 10, height);
+        pruner.Commit(db, height);
+        roots.push_back(trie.root());
+    }
+    BOOST_CHECK(readable(db, roots[0]));
+
+    // Reorg of the block at height 2
+    trie.setRoot(roots[1]);
+    update(trie, db, 20, 5);
+    pruner.Commit(db, 2);
+    roots[2] = trie.root();
+    BOOST_CHECK(readable(db, roots[1]));
+
+    // The state of height 0 is out of the window at height 3
+    update(trie, db, 10, 6);
+    pruner.Commit(db, 3);
+    roots.push_back(trie.root());
+    BOOST_CHECK(!readable(db, roots[0]));
+    for(size_t i = 1; i < roots.size(); i++)
+        BOOST_CHECK(readable(db, roots[i]));
+    for(size_t i = 0; i < 100; i++){
+        uint8_t version = i % 3 ? 0 : (i / 3 < 10 ? 6 : (i / 3 < 20 ? 5 : 0));
+        BOOST_CHECK(dev::asBytes(trie.at(address(i))) == value(i, version));
+    }
+
+    // Reloaded after a restart
+    StatePruner reloaded(false, 2);
+    BOOST_CHECK(reloaded.Load(db, 3));
+    BOOST_CHECK(!reloaded.Load(db, 4));
+    // Below the oldest journal
+    StatePruner invalid(false, 2);
+    BOOST_CHECK(invalid.Load(db, 3));
+    invalid.Commit(db, 1);
+    BOOST_CHECK(!invalid.IsValid());
+    BOOST_CHECK(!reloaded.Load(db, 3));
+}
+
+BOOST_AUTO_TEST_CASE(stateprune_discarded_template){
+    dev::OverlayDB db(dev::db::DBFactory::create(fs::PathToString(m_path_root / "state")));
+    Trie trie(&db);
+    trie.init();
+    update(trie, db, 50, 0);
+    StatePruner pruner(false, 1);
+    BOOST_REQUIRE(pruner.Build(db, {trie.root()}, 10));
+    db.setTrackRefs(true);
+    dev::h256 tip = trie.root();
+
+    // Block template on the tip, then the state is reset
+    update(trie, db, 5, 1);
+    dev::h256 templateRoot = trie.root();
+    trie.setRoot(tip);
+    pruner.Discard(db, 10);
+
+    // Released at the tip, deleted depth blocks later
+    update(trie, db, 5, 2);
+    pruner.Commit(db, 11);
+    BOOST_CHECK(!readable(db, templateRoot));
+    BOOST_CHECK(readable(db, tip));
+    update(trie, db, 5, 3);
+    pruner.Commit(db, 12);
+    BOOST_CHECK(!readable(db, tip));
+    BOOST_CHECK(readable(db, trie.root()));
+}
+
+BOOST_AUTO_TEST_CASE(stateprune_stale_coins_tip){
+    dev::OverlayDB db(dev::db::DBFactory::create(fs::PathToString(m_path_root / "state")));
+    Trie trie(&db);
+    trie.init();
+    update(trie, db, 50, 0);
+    StatePruner pruner(false, 1);
+    BOOST_REQUIRE(pruner.Build(db, {trie.root()}, 0));
+    db.setTrackRefs(true);
+
+    // The coins are flushed at height 1, the blocks after it are only in the state
+    std::vector<dev::h256> roots{trie.root()};
+    for(int height = 1; height <= 5; height++){
+        update(trie, db, 10, height);
+        pruner.Commit(db, height, 1);
+        roots.push_back(trie.root());
+    }
+    BOOST_CHECK(!readable(db, roots[0]));
+    for(size_t i = 1; i < roots.size(); i++)
+        BOOST_CHECK(readable(db, roots[i]));
+
+    // Restart from the coins tip after a crash, the blocks after it are connected again
+    StatePruner reloaded(false, 1);
+    BOOST_REQUIRE(reloaded.Load(db, 1));
+    trie.setRoot(roots[1]);
+    for(int height = 2; height <= 5; height++){
+        update(trie, db, 10, height);
+        reloaded.Commit(db, height, 1);
+        BOOST_CHECK(trie.root() == roots[height]);
+    }
+
+    // Once the coins are flushed again the states out of the window are pruned
+    update(trie, db, 10, 6);
+    reloaded.Commit(db, 6, 6);
+    for(size_t i = 1; i < 5; i++)
+        BOOST_CHECK(!readable(db, roots[i]));
+    BOOST_CHECK(readable(db, roots[5]));
+    BOOST_CHECK(readable(db, trie.root()));
+    for(size_t i = 0; i < 50; i++)
+        BOOST_CHECK(dev::asBytes(trie.at(address(i * 3))) == value(i * 3, i < 10 ? 6 : 0));
+}
+
+BOOST_AUTO_TEST_CASE(stateprune_compact){
+    std::string path = fs::PathToString(m_path_root / "state");
+    dev::h256 oldRoot, root;
+    {
+        dev::OverlayDB db(dev::db::DBFactory::create(path));
+        Trie trie(&db);
+        trie.init();
+        update(trie, db, 50, 0);
+        oldRoot = trie.root();
+        update(trie, db, 25, 1);
+        root = trie.root();
+    }
+    BOOST_REQUIRE(CompactStateDB(path, false, {root}));
+
+    dev::OverlayDB db(dev::db::DBFactory::create(path));
+    BOOST_CHECK(readable(db, root));
+    BOOST_CHECK(!readable(db, oldRoot));
+    Trie trie(&db, root);
+    BOOST_CHECK(dev::asBytes(trie.at(address(3))) == value(3, 1));
+    // The key preimages are kept
+    BOOST_CHECK(!db.lookupAux(dev::sha3(address(3))).empty());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+}
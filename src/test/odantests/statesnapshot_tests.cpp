@@ -0,0 +1,154 @@
+#include <boost/test/unit_test.hpp>
+#include <test/util/setup_common.h>
+#include <odan/statesnapshot.h>
+#include <libdevcore/Address.h>
+#include <libdevcore/DBFactory.h>
+#include <libdevcore/OverlayDB.h>
+#include <libdevcore/SHA3.h>
+#include <libdevcore/TrieCommon.h>
+#include <libethereum/SecureTrieDB.h>
+
+namespace StateSnapshotTest{
+
+static dev::h256 hashedKey(size_t i)
+{
+    return dev::sha3(dev::Address(dev::u160(i + 1)));
+}
+
+static dev::bytes readEntry(const dev::eth::SnapshotLayer& layer, const dev::h256& key)
+{
+    dev::bytes value;
+    BOOST_CHECK(layer.entry(key, value));
+    return value;
+}
+
+static dev::bytes readStorage(const dev::eth::SnapshotLayer& layer, const dev::h256& key, const dev::h256& slot)
+{
+    dev::bytes value;
+    BOOST_CHECK(layer.storage(key, slot, value));
+    return value;
+}
+
+BOOST_FIXTURE_TEST_SUITE(statesnapshot_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(statesnapshot_generate_and_cap){
+    dev::OverlayDB db(dev::db::DBFactory::create(fs::PathToString(m_path_root / "utxo")));
+    dev::eth::SecureTrieDB<dev::Address, dev::OverlayDB> trie(&db);
+    trie.init();
+    for(size_t i = 0; i < 20; i++)
+        trie.insert(dev::Address(dev::u160(i + 1)), dev::bytes(40, uint8_t(i)));
+    db.commit();
+    dev::h256 root0 = trie.root();
+
+    // The snapshot is generated from the trie
+    StateSnapshotTree tree(m_path_root / "snapshot", false);
+    BOOST_CHECK(!tree.Load(root0));
+    BOOST_CHECK(tree.Generate(*db.backend(), root0));
+    auto layer0 = tree.layer(root0);
+    BOOST_REQUIRE(layer0);
+    for(size_t i = 0; i < 20; i++)
+        BOOST_CHECK(readEntry(*layer0, hashedKey(i)) == dev::bytes(40, uint8_t(i)));
+    BOOST_CHECK(readEntry(*layer0, hashedKey(100)).empty());
+
+    // The changes of the view are read before the layer
+    dev::eth::SnapshotView view;
+    view.setProvider(&tree);
+    dev::eth::SnapshotDiff* diff = view.beginCommit(root0);
+    BOOST_REQUIRE(diff);
+    diff->entries[hashedKey(0)] = dev::bytes(1, 0xaa);
+    diff->entries[hashedKey(1)].clear();
+    dev::h256 root1 = dev::sha3(std::string("root1"));
+    view.endCommit(root1);
+    dev::bytes value;
+    BOOST_CHECK(view.entry(root1, hashedKey(0), value) && value == dev::bytes(1, 0xaa));
+    BOOST_CHECK(view.entry(root1, hashedKey(2), value) && value == dev::bytes(40, 2));
+
+    // Diff layers of a block and of a fork at the same height
+    auto layer1 = tree.Update(view.baseRoot(), root1, 1, view.diff());
+    BOOST_REQUIRE(layer1);
+    dev::eth::SnapshotDiff forkDiff;
+    forkDiff.entries[hashedKey(0)] = dev::bytes(1, 0xbb);
+    dev::h256 fork1 = dev::sha3(std::string("fork1"));
+    auto layerFork = tree.Update(root0, fork1, 1, forkDiff);
+    BOOST_REQUIRE(layerFork);
+    dev::eth::SnapshotDiff diff2;
+    diff2.entries[hashedKey(2)] = dev::bytes(1, 0xcc);
+    dev::h256 root2 = dev::sha3(std::string("root2"));
+    auto layer2 = tree.Update(root1, root2, 2, diff2);
+    BOOST_REQUIRE(layer2);
+    BOOST_CHECK(!tree.Update(dev::sha3(std::string("unknown")), dev::sha3(std::string("root3")), 3, diff2));
+    BOOST_CHECK_EQUAL(tree.LayerCount(), 3U);
+
+    BOOST_CHECK(readEntry(*layer2, hashedKey(0)) == dev::bytes(1, 0xaa));
+    BOOST_CHECK(readEntry(*layer2, hashedKey(1)).empty());
+    BOOST_CHECK(readEntry(*layer2, hashedKey(2)) == dev::bytes(1, 0xcc));
+    BOOST_CHECK(readEntry(*layerFork, hashedKey(0)) == dev::bytes(1, 0xbb));
+    BOOST_CHECK(readEntry(*layerFork, hashedKey(1)) == dev::bytes(40, 1));
+    BOOST_CHECK(readEntry(*layer0, hashedKey(0)) == dev::bytes(40, 0));
+
+    // Writing the block 1 to the disk makes the older layers and the fork stale
+    tree.Cap(root2, 1);
+    BOOST_CHECK(tree.DiskRoot() == root1);
+    BOOST_CHECK_EQUAL(tree.LayerCount(), 1U);
+    BOOST_CHECK(!layer0->entry(hashedKey(0), value));
+    BOOST_CHECK(!layerFork->entry(hashedKey(0), value));
+    BOOST_CHECK(!tree.layer(fork1));
+    BOOST_CHECK(readEntry(*layer2, hashedKey(0)) == dev::bytes(1, 0xaa));
+    BOOST_CHECK(readEntry(*layer2, hashedKey(1)).empty());
+    BOOST_CHECK(readEntry(*layer2, hashedKey(2)) == dev::bytes(1, 0xcc));
+    BOOST_CHECK(readEntry(*layer2, hashedKey(3)) == dev::bytes(40, 3));
+    auto disk = tree.layer(root1);
+    BOOST_REQUIRE(disk);
+    BOOST_CHECK(readEntry(*disk, hashedKey(2)) == dev::bytes(40, 2));
+}
+
+BOOST_AUTO_TEST_CASE(statesnapshot_storage_and_journal){
+    dev::OverlayDB db(dev::db::DBFactory::create(fs::PathToString(m_path_root / "state")));
+    dev::h256 key = hashedKey(0);
+    dev::h256 slotA = dev::sha3(std::string("a")), slotB = dev::sha3(std::string("b"));
+    dev::h256 root1 = dev::sha3(std::string("root1")), root2 = dev::sha3(std::string("root2"));
+    {
+        StateSnapshotTree tree(m_path_root / "snapshot", true);
+        BOOST_CHECK(tree.Generate(*db.backend(), dev::EmptyTrie));
+
+        dev::eth::SnapshotDiff diff1;
+        diff1.storage[key].slots[slotA] = dev::bytes(1, 1);
+        diff1.storage[key].slots[slotB] = dev::bytes(1, 2);
+        BOOST_REQUIRE(tree.Update(dev::EmptyTrie, root1, 1, diff1));
+
+        // The storage is cleared and one slot written again
+        dev::eth::SnapshotDiff diff2;
+        diff2.wipeStorage(key);
+        diff2.storage[key].slots[slotB] = dev::bytes(1, 3);
+        auto layer2 = tree.Update(root1, root2, 2, diff2);
+        BOOST_REQUIRE(layer2);
+        BOOST_CHECK(readStorage(*layer2, key, slotA).empty());
+        BOOST_CHECK(readStorage(*layer2, key, slotB) == dev::bytes(1, 3));
+        BOOST_CHECK(readStorage(*tree.layer(root1), key, slotA) == dev::bytes(1, 1));
+
+        tree.Cap(root2, 1);
+        BOOST_CHECK(readStorage(*layer2, key, slotA).empty());
+        tree.Journal();
+    }
+
+    // The diff layers are loaded on top of the disk layer
+    StateSnapshotTree tree(m_path_root / "snapshot", true);
+    BOOST_CHECK(tree.Load(root2));
+    BOOST_CHECK(tree.DiskRoot() == root1);
+    BOOST_CHECK_EQUAL(tree.LayerCount(), 1U);
+    auto layer2 = tree.layer(root2);
+    BOOST_REQUIRE(layer2);
+    BOOST_CHECK(readStorage(*layer2, key, slotA).empty());
+    BOOST_CHECK(readStorage(*layer2, key, slotB) == dev::bytes(1, 3));
+
+    // The wiped slots are deleted from the disk
+    tree.Cap(root2, 2);
+    auto disk = tree.layer(root2);
+    BOOST_REQUIRE(disk);
+    BOOST_CHECK(readStorage(*disk, key, slotA).empty());
+    BOOST_CHECK(readStorage(*disk, key, slotB) == dev::bytes(1, 3));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+}
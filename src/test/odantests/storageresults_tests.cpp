@@ -0,0 +1,185 @@
+#include <boost/test/unit_test.hpp>
+#include <test/util/setup_common.h>
+#include <odan/storageresults.h>
+#include <util/convert.h>
+#include <util/fs.h>
+
+namespace StorageResultsTest{
+
+TransactionReceiptInfo createReceipt(uint32_t n, size_t nLogs){
+    TransactionReceiptInfo tri;
+    tri.blockHash = h256Touint(dev::sha3(dev::h256(n)));
+    tri.blockNumber = n;
+    tri.transactionHash = h256Touint(dev::sha3(dev::h256(n + 1)));
+    tri.transactionIndex = n + 2;
+    tri.from = dev::Address(n + 3);
+    tri.to = dev::Address(n + 4);
+    tri.cumulativeGasUsed = 1000000 + n;
+    tri.gasUsed = 21000 + n;
+    tri.contractAddress = dev::Address(n + 5);
+    for(size_t i = 0; i < nLogs; i++){
+        dev::h256s topics{dev::h256(n + i), dev::h256(i)};
+        tri.logs.push_back(dev::eth::LogEntry(dev::Address(n + 6), topics, dev::bytes(i * 7, uint8_t(n))));
+    }
+    tri.excepted = n % 2 ? dev::eth::TransactionException::RevertInstruction : dev::eth::TransactionException::None;
+    tri.exceptedMessage = n % 2 ? "revert reason" : "";
+    tri.outputIndex = n;
+    tri.bloom = dev::eth::LogBloom(dev::sha3(dev::h256(n + 7)));
+    tri.stateRoot = dev::sha3(dev::h256(n + 8));
+    tri.utxoRoot = dev::sha3(dev::h256(n + 9));
+    return tri;
+}
+
+void checkLogs(const dev::eth::LogEntries& a, const dev::eth::LogEntries& b){
+    BOOST_REQUIRE_EQUAL(a.size(), b.size());
+    for(size_t i = 0; i < a.size(); i++){
+        BOOST_CHECK(a[i].address == b[i].address);
+        BOOST_CHECK(a[i].topics == b[i].topics);
+        BOOST_CHECK(a[i].data == b[i].data);
+    }
+}
+
+void checkReceipt(const TransactionReceiptInfo& a, const TransactionReceiptInfo& b){
+    BOOST_CHECK(a.blockHash == b.blockHash);
+    BOOST_CHECK_EQUAL(a.blockNumber, b.blockNumber);
+    BOOST_CHECK(a.transactionHash == b.transactionHash);
+    BOOST_CHECK_EQUAL(a.transactionIndex, b.transactionIndex);
+    BOOST_CHECK(a.from == b.from);
+    BOOST_CHECK(a.to == b.to);
+    BOOST_CHECK_EQUAL(a.cumulativeGasUsed, b.cumulativeGasUsed);
+    BOOST_CHECK_EQUAL(a.gasUsed, b.gasUsed);
+    BOOST_CHECK(a.contractAddress == b.contractAddress);
+    checkLogs(a.logs, b.logs);
+    BOOST_CHECK(a.excepted == b.excepted);
+    BOOST_CHECK_EQUAL(a.exceptedMessage, b.exceptedMessage);
+    BOOST_CHECK_EQUAL(a.outputIndex, b.outputIndex);
+    BOOST_CHECK(a.bloom == b.bloom);
+    BOOST_CHECK(a.stateRoot == b.stateRoot);
+    BOOST_CHECK(a.utxoRoot == b.utxoRoot);
+}
+
+// Receipts as written to resultsDB before the columnar format
+void writeLegacyResult(const std::string& path, const dev::h256& hashTx, const std::vector<TransactionReceiptInfo>& result){
+    TransactionReceiptInfoSerialized tris;
+    for(const TransactionReceiptInfo& tri : result){
+        logEntriesSerialize logs;
+        for(const dev::eth::LogEntry& log : tri.logs)
+            logs.push_back(std::make_pair(log.address, std::make_pair(log.topics, log.data)));
+        tris.blockHashes.push_back(uintToh256(tri.blockHash));
+        tris.blockNumbers.push_back(tri.blockNumber);
+        tris.transactionHashes.push_back(uintToh256(tri.transactionHash));
+        tris.transactionIndexes.push_back(tri.transactionIndex);
+        tris.senders.push_back(tri.from);
+        tris.receivers.push_back(tri.to);
+        tris.cumulativeGasUsed.push_back(dev::u256(tri.cumulativeGasUsed));
+        tris.gasUsed.push_back(dev::u256(tri.gasUsed));
+        tris.contractAddresses.push_back(tri.contractAddress);
+        tris.logs.push_back(logs);
+        tris.excepted.push_back(uint32_t(static_cast<int>(tri.excepted)));
+        tris.exceptedMessage.push_back(tri.exceptedMessage);
+        tris.outputIndexes.push_back(tri.outputIndex);
+        tris.blooms.push_back(tri.bloom);
+        tris.stateRoots.push_back(tri.stateRoot);
+        tris.utxoRoots.push_back(tri.utxoRoot);
+    }
+
+    dev::RLPStream streamRLP(16);
+    streamRLP << tris.blockHashes << tris.blockNumbers << tris.transactionHashes << tris.transactionIndexes << tris.senders;
+    streamRLP << tris.receivers << tris.cumulativeGasUsed << tris.gasUsed << tris.contractAddresses << tris.logs << tris.excepted << tris.exceptedMessage << tris.outputIndexes << tris.blooms << tris.stateRoots << tris.utxoRoots;
+    dev::bytes data = streamRLP.out();
+
+    leveldb::DB* db;
+    leveldb::Options options;
+    options.create_if_missing = true;
+    BOOST_REQUIRE(leveldb::DB::Open(options, path + "/resultsDB", &db).ok());
+    BOOST_CHECK(db->Put(leveldb::WriteOptions(), hashTx.hex(), std::string(data.begin(), data.end())).ok());
+    delete db;
+}
+
+BOOST_FIXTURE_TEST_SUITE(storageresults_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(storageresults_commit_and_read){
+    fs::path dir = m_path_root / "receipts";
+    fs::create_directories(dir);
+    StorageResults results(fs::PathToString(dir));
+
+    std::vector<TransactionReceiptInfo> receipts{createReceipt(1, 0), createReceipt(2, 3)};
+    dev::h256 hashTx = dev::sha3(dev::h256(100));
+    results.addResult(hashTx, receipts);
+    results.commitResults();
+
+    std::vector<TransactionReceiptInfo> read = results.getResult(hashTx);
+    BOOST_REQUIRE_EQUAL(read.size(), receipts.size());
+    for(size_t i = 0; i < read.size(); i++)
+        checkReceipt(read[i], receipts[i]);
+
+    std::vector<dev::eth::LogEntries> logs;
+    BOOST_CHECK(results.getResultLogs(hashTx, logs));
+    BOOST_REQUIRE_EQUAL(logs.size(), receipts.size());
+    BOOST_CHECK(logs[0].empty());
+    checkLogs(logs[1], receipts[1].logs);
+
+    std::vector<dev::eth::LogBloom> blooms;
+    BOOST_CHECK(results.getResultBlooms(hashTx, blooms));
+    BOOST_REQUIRE_EQUAL(blooms.size(), receipts.size());
+    BOOST_CHECK(blooms[1] == receipts[1].bloom);
+
+    // Unknown transaction
+    BOOST_CHECK(results.getResult(dev::sha3(dev::h256(101))).empty());
+    BOOST_CHECK(!results.getResultLogs(dev::sha3(dev::h256(101)), logs));
+    BOOST_CHECK(logs.empty());
+}
+
+BOOST_AUTO_TEST_CASE(storageresults_delete){
+    fs::path dir = m_path_root / "receipts";
+    fs::create_directories(dir);
+    StorageResults results(fs::PathToString(dir));
+
+    CMutableTransaction mtx;
+    mtx.nLockTime = 1;
+    CTransactionRef tx = MakeTransactionRef(mtx);
+    dev::h256 hashTx = uintToh256(tx->GetHash());
+    std::vector<TransactionReceiptInfo> receipts{createReceipt(3, 2)};
+    results.addResult(hashTx, receipts);
+    results.commitResults();
+    BOOST_CHECK_EQUAL(results.getResult(hashTx).size(), 1U);
+
+    results.deleteResults({tx});
+    BOOST_CHECK(results.getResult(hashTx).empty());
+    std::vector<dev::eth::LogBloom> blooms;
+    BOOST_CHECK(!results.getResultBlooms(hashTx, blooms));
+}
+
+BOOST_AUTO_TEST_CASE(storageresults_upgrade){
+    fs::path dir = m_path_root / "receipts";
+    fs::create_directories(dir);
+    std::string path = fs::PathToString(dir);
+
+    std::vector<TransactionReceiptInfo> receipts{createReceipt(4, 1), createReceipt(5, 2)};
+    dev::h256 hashTx = dev::sha3(dev::h256(102));
+    writeLegacyResult(path, hashTx, receipts);
+
+    {
+        StorageResults results(path);
+        std::vector<TransactionReceiptInfo> read = results.getResult(hashTx);
+        BOOST_REQUIRE_EQUAL(read.size(), receipts.size());
+        for(size_t i = 0; i < read.size(); i++)
+            checkReceipt(read[i], receipts[i]);
+    }
+
+    // The legacy record is gone and the upgrade is not repeated
+    leveldb::DB* db;
+    BOOST_REQUIRE(leveldb::DB::Open(leveldb::Options(), path + "/resultsDB", &db).ok());
+    std::string value;
+    BOOST_CHECK(db->Get(leveldb::ReadOptions(), hashTx.hex(), &value).IsNotFound());
+    BOOST_CHECK(db->Get(leveldb::ReadOptions(), std::string(1, RECEIPTS_VERSION_KEY), &value).ok());
+    BOOST_CHECK_EQUAL(value, std::string(1, char(RECEIPTS_DB_VERSION)));
+    delete db;
+
+    StorageResults results(path);
+    BOOST_CHECK_EQUAL(results.getResult(hashTx).size(), receipts.size());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+}
@@ -0,0 +1,166 @@
+#include <boost/test/unit_test.hpp>
+#include <test/util/random.h>
+#include <test/util/setup_common.h>
+#include <arith_uint256.h>
+#include <chain.h>
+#include <node/blockstorage.h>
+#include <validation.h>
+#include <util/convert.h>
+#include <libethcore/LogEntry.h>
+
+namespace TokenIndexTest{
+
+const uint160 TOKEN = uint160S("70");
+const uint160 ADDRESS_A = uint160S("aa");
+const uint160 ADDRESS_B = uint160S("bb");
+
+CTokenTransfer tokenTransfer(const uint160& sender, const uint160& receiver, uint64_t value, uint8_t type = TOKEN_TRANSFER){
+    CTokenTransfer transfer;
+    transfer.type = type;
+    transfer.contract = TOKEN;
+    transfer.sender = sender;
+    transfer.receiver = receiver;
+    transfer.txhash = InsecureRand256();
+    transfer.value = u256Touint(value);
+    return transfer;
+}
+
+// The block hash only marks the height
+CIndexBestBlock indexBest(int height){
+    return CIndexBestBlock(ArithToUint256(arith_uint256(height)), uint256());
+}
+
+uint64_t balance(kernel::BlockTreeDB& db, const uint160& holder, int height = -1){
+    uint256 balance;
+    BOOST_REQUIRE(db.ReadTokenBalance(TOKEN, holder, height, balance));
+    return uint64_t(uintTou256(balance));
+}
+
+dev::eth::LogEntry tokenLog(const dev::h256& signature, std::vector<dev::h160> addresses, uint64_t value){
+    dev::h256s topics{signature};
+    for(const dev::h160& address : addresses)
+        topics.push_back(dev::h256(address, dev::h256::AlignRight));
+    return dev::eth::LogEntry(uintToh160(TOKEN), topics, dev::h256(value).asBytes());
+}
+
+BOOST_FIXTURE_TEST_SUITE(tokenindex_tests, TestingSetup)
+
+BOOST_AUTO_TEST_CASE(tokenindex_connect_disconnect){
+    kernel::BlockTreeDB& db = *m_node.chainman->m_blockman.m_block_tree_db;
+
+    // Mint to A at height 10, A pays B twice at height 20, B burns at height 30
+    BOOST_CHECK(db.UpdateTokenIndex(10, {tokenTransfer(uint160(), ADDRESS_A, 1000)}, indexBest(10)));
+    BOOST_CHECK(db.UpdateTokenIndex(20, {tokenTransfer(ADDRESS_A, ADDRESS_B, 100), tokenTransfer(ADDRESS_A, ADDRESS_B, 50), tokenTransfer(ADDRESS_A, ADDRESS_A, 7)}, indexBest(20)));
+    BOOST_CHECK(db.UpdateTokenIndex(30, {tokenTransfer(ADDRESS_B, uint160(), 30, TOKEN_BURN)}, indexBest(30)));
+    CIndexBestBlock best;
+    BOOST_CHECK(db.ReadTokenIndexBest(best));
+    BOOST_CHECK(best.blockHash == indexBest(30).blockHash);
+
+    BOOST_CHECK_EQUAL(balance(db, ADDRESS_A), 850U);
+    BOOST_CHECK_EQUAL(balance(db, ADDRESS_B), 120U);
+    BOOST_CHECK_EQUAL(balance(db, ADDRESS_A, 9), 0U);
+    BOOST_CHECK_EQUAL(balance(db, ADDRESS_A, 15), 1000U);
+    BOOST_CHECK_EQUAL(balance(db, ADDRESS_B, 25), 150U);
+    BOOST_CHECK_EQUAL(balance(db, ADDRESS_B, 30), 120U);
+    BOOST_CHECK_EQUAL(balance(db, uint160()), 0U);
+
+    // The history of a holder with the running balance, a transfer to self is listed once
+    std::vector<std::pair<CTokenIndexKey, CTokenIndexValue>> entries;
+    BOOST_CHECK(db.ReadTokenIndex(TOKEN, ADDRESS_A, 0, -1, entries));
+    BOOST_REQUIRE_EQUAL(entries.size(), 4U);
+    BOOST_CHECK_EQUAL(entries[0].first.blockHeight, 10);
+    BOOST_CHECK_EQUAL(uint64_t(uintTou256(entries[1].second.balance)), 900U);
+    BOOST_CHECK_EQUAL(uint64_t(uintTou256(entries[2].second.balance)), 850U);
+    BOOST_CHECK(entries[3].second.sender == ADDRESS_A && entries[3].second.receiver == ADDRESS_A);
+    BOOST_CHECK_EQUAL(uint64_t(uintTou256(entries[3].second.balance)), 850U);
+    entries.clear();
+    BOOST_CHECK(db.ReadTokenIndex(TOKEN, ADDRESS_B, 21, 30, entries));
+    BOOST_REQUIRE_EQUAL(entries.size(), 1U);
+    BOOST_CHECK(entries[0].second.type == TOKEN_BURN);
+
+    // Disconnect the blocks at heights 30 and 20
+    BOOST_CHECK(db.EraseTokenIndex(30, indexBest(20)));
+    BOOST_CHECK_EQUAL(balance(db, ADDRESS_B), 150U);
+    BOOST_CHECK(db.EraseTokenIndex(20, indexBest(10)));
+    BOOST_CHECK_EQUAL(balance(db, ADDRESS_A), 1000U);
+    BOOST_CHECK_EQUAL(balance(db, ADDRESS_B), 0U);
+    entries.clear();
+    BOOST_CHECK(db.ReadTokenIndex(TOKEN, ADDRESS_B, 0, -1, entries));
+    BOOST_CHECK(entries.empty());
+    BOOST_CHECK(db.EraseTokenIndex(25, indexBest(24)));
+    BOOST_CHECK(db.ReadTokenIndexBest(best));
+    BOOST_CHECK(best.blockHash == indexBest(24).blockHash);
+
+    BOOST_CHECK(db.WipeTokenIndex(CIndexBestBlock()));
+    BOOST_CHECK_EQUAL(balance(db, ADDRESS_A), 0U);
+    BOOST_CHECK(db.ReadTokenIndexBest(best));
+    BOOST_CHECK(best.IsNull());
+}
+
+BOOST_AUTO_TEST_CASE(tokenindex_saturate){
+    kernel::BlockTreeDB& db = *m_node.chainman->m_blockman.m_block_tree_db;
+
+    // A token minted without a Transfer log, the holder spends more than its logged balance
+    BOOST_CHECK(db.UpdateTokenIndex(10, {tokenTransfer(uint160(), ADDRESS_A, 100)}, indexBest(10)));
+    BOOST_CHECK(db.UpdateTokenIndex(20, {tokenTransfer(ADDRESS_A, ADDRESS_B, 500)}, indexBest(20)));
+    BOOST_CHECK_EQUAL(balance(db, ADDRESS_A), 0U);
+    BOOST_CHECK_EQUAL(balance(db, ADDRESS_B), 500U);
+
+    // The balances are restored from the undo records
+    BOOST_CHECK(db.EraseTokenIndex(20, indexBest(10)));
+    BOOST_CHECK_EQUAL(balance(db, ADDRESS_A), 100U);
+    BOOST_CHECK(db.WipeTokenIndex(CIndexBestBlock()));
+}
+
+BOOST_AUTO_TEST_CASE(tokenindex_rewind){
+    kernel::BlockTreeDB& db = *m_node.chainman->m_blockman.m_block_tree_db;
+
+    // The index is two blocks ahead of the coins tip after an unclean shutdown
+    std::vector<uint256> hashes;
+    for(int height = 0; height <= 3; height++)
+        hashes.push_back(indexBest(height).blockHash);
+    CBlockIndex indexes[4];
+    for(int height = 0; height <= 3; height++){
+        indexes[height].phashBlock = &hashes[height];
+        indexes[height].nHeight = height;
+        indexes[height].pprev = height ? &indexes[height - 1] : nullptr;
+    }
+    BOOST_CHECK(db.WipeTokenIndex(CIndexBestBlock(&indexes[0])));
+    BOOST_CHECK(db.UpdateTokenIndex(1, {tokenTransfer(uint160(), ADDRESS_A, 1000)}, CIndexBestBlock(&indexes[1])));
+    BOOST_CHECK(db.UpdateTokenIndex(2, {tokenTransfer(ADDRESS_A, ADDRESS_B, 100)}, CIndexBestBlock(&indexes[2])));
+    BOOST_CHECK(db.UpdateTokenIndex(3, {}, CIndexBestBlock(&indexes[3])));
+
+    BOOST_CHECK(db.RewindTokenIndex(&indexes[3], &indexes[1]));
+    CIndexBestBlock best;
+    BOOST_CHECK(db.ReadTokenIndexBest(best));
+    BOOST_CHECK(best.blockHash == hashes[1]);
+    BOOST_CHECK_EQUAL(balance(db, ADDRESS_A), 1000U);
+    BOOST_CHECK_EQUAL(balance(db, ADDRESS_B), 0U);
+    std::vector<std::pair<CTokenIndexKey, CTokenIndexValue>> entries;
+    BOOST_CHECK(db.ReadTokenIndex(TOKEN, ADDRESS_A, 0, -1, entries));
+    BOOST_CHECK_EQUAL(entries.size(), 1U);
+    BOOST_CHECK(db.WipeTokenIndex(CIndexBestBlock()));
+}
+
+BOOST_AUTO_TEST_CASE(tokenindex_logs){
+    const dev::h160 a = uintToh160(ADDRESS_A);
+    const dev::h160 b = uintToh160(ADDRESS_B);
+    CTokenTransfer transfer;
+
+    BOOST_CHECK(GetTokenTransfer(tokenLog(TokenTransferTopic(), {a, b}, 42), transfer));
+    BOOST_CHECK(transfer.type == TOKEN_TRANSFER && transfer.contract == TOKEN);
+    BOOST_CHECK(transfer.sender == ADDRESS_A && transfer.receiver == ADDRESS_B);
+    BOOST_CHECK_EQUAL(uint64_t(uintTou256(transfer.value)), 42U);
+
+    BOOST_CHECK(GetTokenTransfer(tokenLog(TokenBurnTopic(), {a}, 5), transfer));
+    BOOST_CHECK(transfer.type == TOKEN_BURN && transfer.sender == ADDRESS_A && transfer.receiver.IsNull());
+
+    // The transfers of an indexed token id and other events are skipped
+    BOOST_CHECK(!GetTokenTransfer(tokenLog(TokenTransferTopic(), {a, b, a}, 1), transfer));
+    BOOST_CHECK(!GetTokenTransfer(tokenLog(TokenBurnTopic(), {a, b}, 1), transfer));
+    BOOST_CHECK(!GetTokenTransfer(tokenLog(dev::sha3(std::string("Approval(address,address,uint256)")), {a, b}, 1), transfer));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+}
@@ -0,0 +1,106 @@
+#include <boost/test/unit_test.hpp>
+#include <test/util/setup_common.h>
+#include <libdevcore/Address.h>
+#include <libdevcore/DBFactory.h>
+#include <libdevcore/OverlayDB.h>
+#include <libdevcore/SHA3.h>
+#include <libdevcore/TrieNodeCache.h>
+#include <libethereum/SecureTrieDB.h>
+#include <validation.h>
+
+namespace TrieNodeCacheTest{
+
+BOOST_FIXTURE_TEST_SUITE(trienodecache_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(trienodecache_lookup_and_eviction){
+    dev::TrieNodeCache cache;
+    std::string node(100, 'n'), value;
+    size_t shardBytes = dev::TrieNodeCache::entrySize(node.size()) * 2;
+
+    // Nothing is cached without a budget
+    dev::h256 hashA = dev::sha3(std::string("a")), hashB = dev::sha3(std::string("b")), hashC = dev::sha3(std::string("c"));
+    cache.insert(hashA, node);
+    BOOST_CHECK(!cache.lookup(hashA, value));
+
+    // Same first byte of the hash, so the nodes are in the same shard
+    cache.setMaxBytes(shardBytes * 16);
+    hashB[0] = hashA[0];
+    hashC[0] = hashA[0];
+    cache.insert(hashA, node);
+    cache.insert(hashB, node);
+    BOOST_CHECK(cache.lookup(hashA, value));
+    BOOST_CHECK(value == node);
+
+    // The least recently used node is evicted
+    cache.insert(hashC, node);
+    BOOST_CHECK(cache.lookup(hashA, value));
+    BOOST_CHECK(!cache.lookup(hashB, value));
+    BOOST_CHECK(cache.lookup(hashC, value));
+
+    // Deleted nodes and values larger than a node
+    cache.remove(hashC);
+    BOOST_CHECK(!cache.lookup(hashC, value));
+    cache.insert(hashC, std::string(2000, 'c'));
+    BOOST_CHECK(!cache.lookup(hashC, value));
+
+    dev::TrieNodeCache::Stats stats = cache.stats();
+    BOOST_CHECK_EQUAL(stats.entries, 1U);
+    BOOST_CHECK_EQUAL(stats.bytes, shardBytes / 2);
+    BOOST_CHECK_EQUAL(stats.hits, 3U);
+    BOOST_CHECK_EQUAL(stats.misses, 4U);
+    BOOST_CHECK_EQUAL(stats.evictions, 1U);
+}
+
+BOOST_AUTO_TEST_CASE(trienodecache_overlaydb){
+    dev::TrieNodeCache cache;
+    cache.setMaxBytes(1 << 20);
+    dev::OverlayDB db(dev::db::DBFactory::create(fs::PathToString(m_path_root / "state")));
+    db.setNodeCache(&cache);
+    dev::eth::SecureTrieDB<dev::Address, dev::OverlayDB> trie(&db);
+    trie.init();
+    for(size_t i = 0; i < 100; i++)
+        trie.insert(dev::Address(dev::u160(i + 1)), dev::bytes(40, uint8_t(i)));
+
+    // The committed nodes are cached, the reads of the trie do not go to the database
+    db.commit();
+    size_t entries = cache.stats().entries;
+    uint64_t misses = cache.stats().misses;
+    BOOST_CHECK(entries > 0);
+    for(size_t i = 0; i < 100; i++)
+        BOOST_CHECK(dev::asBytes(trie.at(dev::Address(dev::u160(i + 1)))) == dev::bytes(40, uint8_t(i)));
+    dev::TrieNodeCache::Stats stats = cache.stats();
+    BOOST_CHECK(stats.hits > 0);
+    BOOST_CHECK_EQUAL(stats.misses, misses);
+    BOOST_CHECK_EQUAL(stats.entries, entries);
+
+    // Read back from the database after the cache is cleared
+    cache.clear();
+    BOOST_CHECK(db.exists(trie.root()));
+    BOOST_CHECK(!db.lookup(trie.root()).empty());
+    BOOST_CHECK_EQUAL(cache.stats().entries, 1U);
+}
+
+BOOST_FIXTURE_TEST_CASE(trienodecache_rebalance, TestChain100Setup){
+    ChainstateManager& chainman = *m_node.chainman;
+    Chainstate& chainstate = chainman.ActiveChainstate();
+    dev::TrieNodeCache& cache = dev::TrieNodeCache::instance();
+    const int64_t total_coinstip_cache = chainman.m_total_coinstip_cache;
+    const int64_t total_state_trie_cache = chainman.m_total_state_trie_cache;
+
+    // The budget of the coins tip cache is shared with the trie node cache after the initial block download
+    LOCK(cs_main);
+    BOOST_REQUIRE(!chainman.IsInitialBlockDownload());
+    chainman.m_total_coinstip_cache = 20000;
+    chainman.m_total_state_trie_cache = 10000;
+    chainman.MaybeRebalanceCaches();
+    BOOST_CHECK_EQUAL(chainstate.m_coinstip_cache_size_bytes, 10000U);
+    BOOST_CHECK_EQUAL(cache.maxBytes(), 20000U);
+
+    chainman.m_total_coinstip_cache = total_coinstip_cache;
+    chainman.m_total_state_trie_cache = total_state_trie_cache;
+    chainman.MaybeRebalanceCaches();
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+}
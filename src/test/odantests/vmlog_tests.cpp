@@ -0,0 +1,149 @@
+#include <boost/test/unit_test.hpp>
+#include <test/util/setup_common.h>
+#include <odan/vmlog.h>
+#include <util/fs.h>
+
+#include <fstream>
+
+namespace VMLogTest{
+
+VMLogRecord createRecord(uint32_t n, const uint256& blockHash, const uint256& txid, size_t nEntries){
+    VMLogRecord record;
+    record.txid = txid;
+    record.blockHash = blockHash;
+    record.blockHeight = n;
+    record.time = 1000 + n;
+    record.address = uint160(std::vector<unsigned char>(20, uint8_t(n)));
+    for(size_t i = 0; i < nEntries; i++){
+        VMLogEntry entry;
+        entry.address = uint160(std::vector<unsigned char>(20, uint8_t(i)));
+        entry.topics = {uint256(uint8_t(n)), uint256(uint8_t(i))};
+        entry.data = std::vector<unsigned char>(i * 3, uint8_t(n));
+        record.entries.push_back(entry);
+    }
+    return record;
+}
+
+void checkRecord(const VMLogRecord& a, const VMLogRecord& b){
+    BOOST_CHECK(a.txid == b.txid);
+    BOOST_CHECK(a.blockHash == b.blockHash);
+    BOOST_CHECK_EQUAL(a.blockHeight, b.blockHeight);
+    BOOST_CHECK_EQUAL(a.time, b.time);
+    BOOST_CHECK(a.address == b.address);
+    BOOST_REQUIRE_EQUAL(a.entries.size(), b.entries.size());
+    for(size_t i = 0; i < a.entries.size(); i++){
+        BOOST_CHECK(a.entries[i].address == b.entries[i].address);
+        BOOST_CHECK(a.entries[i].topics == b.entries[i].topics);
+        BOOST_CHECK(a.entries[i].data == b.entries[i].data);
+    }
+}
+
+BOOST_FIXTURE_TEST_SUITE(vmlog_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(vmlog_read_block_and_tx){
+    fs::path dir = m_path_root / "vmlogs";
+    uint256 blockA = uint256S("aa"), blockB = uint256S("bb");
+    uint256 txA = uint256S("01"), txB = uint256S("02"), txC = uint256S("03");
+    std::vector<VMLogRecord> records{createRecord(1, blockA, txA, 0), createRecord(2, blockA, txA, 2),
+                                     createRecord(3, blockA, txB, 1), createRecord(4, uint256(), uint256(), 3),
+                                     createRecord(5, blockB, txC, 2)};
+    {
+        VMLogWriter writer(dir);
+        for(VMLogRecord record : records)
+            writer.Push(std::move(record));
+        writer.Flush();
+
+        std::vector<VMLogRecord> read;
+        BOOST_CHECK(writer.ReadBlock(blockA, read));
+        BOOST_REQUIRE_EQUAL(read.size(), 3U);
+        for(size_t i = 0; i < read.size(); i++)
+            checkRecord(read[i], records[i]);
+
+        read.clear();
+        BOOST_CHECK(writer.ReadTx(txA, read));
+        BOOST_CHECK_EQUAL(read.size(), 2U);
+
+        read.clear();
+        BOOST_CHECK(!writer.ReadTx(uint256S("04"), read));
+        BOOST_CHECK(read.empty());
+
+        // The record of callcontract is only in the segment
+        BOOST_CHECK(writer.ReadSegment(0, read));
+        BOOST_REQUIRE_EQUAL(read.size(), records.size());
+        checkRecord(read[3], records[3]);
+    }
+
+    // The records of a block are appended after a restart
+    VMLogWriter writer(dir);
+    writer.Push(createRecord(6, blockB, txC, 1));
+    writer.Flush();
+    std::vector<VMLogRecord> read;
+    BOOST_CHECK(writer.ReadTx(txC, read));
+    BOOST_REQUIRE_EQUAL(read.size(), 2U);
+    checkRecord(read[0], records[4]);
+    BOOST_CHECK_EQUAL(read[1].blockHeight, 6);
+
+    UniValue json = VMLogRecordToJSON(read[0]);
+    BOOST_CHECK_EQUAL(json["txid"].get_str(), txC.GetHex());
+    BOOST_CHECK_EQUAL(json["blockhash"].get_str(), blockB.GetHex());
+    BOOST_CHECK_EQUAL(json["entries"].size(), 2U);
+    BOOST_CHECK(VMLogRecordToJSON(records[3])["txid"].isNull());
+}
+
+BOOST_AUTO_TEST_CASE(vmlog_segments){
+    fs::path dir = m_path_root / "vmlogs";
+    uint256 block = uint256S("aa");
+    {
+        VMLogWriter writer(dir, false, 1000);
+        for(uint32_t n = 0; n < 50; n++)
+            writer.Push(createRecord(n, block, uint256(uint8_t(n + 1)), 2));
+        writer.Flush();
+        BOOST_CHECK(writer.GetLastSegment() > 0);
+
+        std::vector<VMLogRecord> read;
+        BOOST_CHECK(writer.ReadBlock(block, read));
+        BOOST_REQUIRE_EQUAL(read.size(), 50U);
+        for(uint32_t n = 0; n < 50; n++)
+            BOOST_CHECK_EQUAL(read[n].blockHeight, int32_t(n));
+
+        size_t count = 0;
+        for(uint32_t segment = 0; segment <= writer.GetLastSegment(); segment++){
+            read.clear();
+            BOOST_CHECK(writer.ReadSegment(segment, read));
+            count += read.size();
+        }
+        BOOST_CHECK_EQUAL(count, 50U);
+        BOOST_CHECK(!writer.ReadSegment(writer.GetLastSegment() + 1, read));
+    }
+
+    // A record left incomplete by a crash is dropped
+    uint32_t last;
+    fs::path path;
+    {
+        VMLogWriter writer(dir, false, 1000);
+        last = writer.GetLastSegment();
+        path = writer.GetSegmentPath(last);
+    }
+    uint64_t size = fs::file_size(path);
+    {
+        std::ofstream file(fs::PathToString(path), std::ios::binary | std::ios::app);
+        file << std::string("\x10\x00\x00\x00\x01", 5);
+    }
+    {
+        VMLogWriter reopened(dir, false, 1000);
+        BOOST_CHECK_EQUAL(fs::file_size(path), size);
+        BOOST_CHECK_EQUAL(reopened.GetLastSegment(), last);
+    }
+
+    // Wiped on reindex
+    VMLogWriter wiped(dir, true, 1000);
+    std::vector<VMLogRecord> read;
+    BOOST_CHECK(!wiped.ReadBlock(block, read));
+    BOOST_CHECK_EQUAL(wiped.GetLastSegment(), 0U);
+    BOOST_CHECK(wiped.ReadSegment(0, read));
+    BOOST_CHECK(read.empty());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+}
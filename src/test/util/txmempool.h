@@ -25,6 +25,9 @@ struct TestMemPoolEntryHelper {
     bool spendsCoinbase{false};
     unsigned int sigOpCost{4};
     LockPoints lp;
+    CAmount nMinGasPrice{0};
+    std::optional<std::vector<unsigned char>> contractSender;
+    uint64_t nGasLimit{0};
 
     CTxMemPoolEntry FromTx(const CMutableTransaction& tx) const;
     CTxMemPoolEntry FromTx(const CTransactionRef& tx) const;
@@ -36,6 +39,9 @@ struct TestMemPoolEntryHelper {
     TestMemPoolEntryHelper& Sequence(uint64_t _seq) { m_sequence = _seq; return *this; }
     TestMemPoolEntryHelper& SpendsCoinbase(bool _flag) { spendsCoinbase = _flag; return *this; }
     TestMemPoolEntryHelper& SigOpsCost(unsigned int _sigopsCost) { sigOpCost = _sigopsCost; return *this; }
+    TestMemPoolEntryHelper& MinGasPrice(CAmount _minGasPrice) { nMinGasPrice = _minGasPrice; return *this; }
+    TestMemPoolEntryHelper& Sender(std::vector<unsigned char> _sender) { contractSender = std::move(_sender); return *this; }
+    TestMemPoolEntryHelper& GasLimit(uint64_t _gasLimit) { nGasLimit = _gasLimit; return *this; }
 };
 
 /** Check expected properties for every PackageMempoolAcceptResult, regardless of value. Returns
@@ -29,6 +29,8 @@ static constexpr int MAX_BLOCK_COINSDB_USAGE = 10 * DB_PEAK_USAGE_FACTOR;
 static const int64_t nDefaultDbCache = 450;
 //! -dbbatchsize default (bytes)
 static const int64_t nDefaultDbBatchSize = 16 << 20;
+//! Size of the block tree DB batches written while building the address weight index (bytes)
+static constexpr size_t ADDRESS_WEIGHT_BATCH_SIZE{16 << 20};
 //! max. -dbcache (MiB)
 static const int64_t nMaxDbCache = sizeof(void*) > 4 ? 16384 : 1024;
 //! min. -dbcache (MiB)
@@ -43,6 +45,8 @@ static const int64_t nMaxTxIndexCache = 1024;
 static const int64_t max_filter_index_cache = 1024;
 //! Max memory allocated to coin DB specific cache (MiB)
 static const int64_t nMaxCoinsDBCache = 8;
+//! Max memory allocated to the contract state trie node cache (MiB)
+static const int64_t nMaxStateTrieCache = 512;
 
 //! User-controlled performance and debug options.
 struct CoinsViewOptions {
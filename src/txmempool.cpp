@@ -401,6 +401,8 @@ void CTxMemPoolEntry::UpdateAncestorState(int32_t modifySize, CAmount modifyFee,
 CTxMemPool::CTxMemPool(const Options& opts)
     : m_check_ratio{opts.check_ratio},
       m_max_size_bytes{opts.max_size_bytes},
+      m_max_gas{opts.max_gas},
+      m_max_sender_gas{opts.max_sender_gas},
       m_expiry{opts.expiry},
       m_incremental_relay_feerate{opts.incremental_relay_feerate},
       m_min_relay_feerate{opts.min_relay_feerate},
@@ -474,6 +476,11 @@ void CTxMemPool::addUnchecked(const CTxMemPoolEntry &entry, setEntries &setAnces
     nTransactionsUpdated++;
     totalTxSize += entry.GetTxSize();
     m_total_fee += entry.GetFee();
+    m_total_gas_limit += entry.GetGasLimit();
+    m_total_gas += entry.GetGas();
+    if (entry.GetGasLimit() && entry.GetContractSender()) {
+        m_sender_gas[*entry.GetContractSender()] += entry.GetGasLimit();
+    }
 
     txns_randomized.emplace_back(newit->GetSharedTx());
     newit->idx_randomized = txns_randomized.size() - 1;
@@ -524,6 +531,14 @@ void CTxMemPool::removeUnchecked(txiter it, MemPoolRemovalReason reason)
 
     totalTxSize -= it->GetTxSize();
     m_total_fee -= it->GetFee();
+    m_total_gas_limit -= it->GetGasLimit();
+    m_total_gas -= it->GetGas();
+    if (it->GetGasLimit() && it->GetContractSender()) {
+        auto sender = m_sender_gas.find(*it->GetContractSender());
+        assert(sender != m_sender_gas.end() && sender->second >= it->GetGasLimit());
+        sender->second -= it->GetGasLimit();
+        if (sender->second == 0) m_sender_gas.erase(sender);
+    }
     cachedInnerUsage -= it->DynamicMemoryUsage();
     cachedInnerUsage -= memusage::DynamicUsage(it->GetMemPoolParentsConst()) + memusage::DynamicUsage(it->GetMemPoolChildrenConst());
     mapTx.erase(it);
@@ -536,6 +551,20 @@ void CTxMemPool::removeUnchecked(txiter it, MemPoolRemovalReason reason)
 // Also assumes that if an entry is in setDescendants already, then all
 // in-mempool descendants of it are already in setDescendants as well, so that we
 // can save time by not iterating over those entries.
+uint64_t CTxMemPool::GetSenderGasWithout(const std::vector<unsigned char>& sender, const setEntries& conflicts) const
+{
+    AssertLockHeld(cs);
+    setEntries allConflicting;
+    for (txiter it : conflicts) {
+        CalculateDescendants(it, allConflicting);
+    }
+    uint64_t senderGas = GetSenderGas(sender);
+    for (txiter it : allConflicting) {
+        if (it->GetContractSender() == sender) senderGas -= it->GetGasLimit();
+    }
+    return senderGas;
+}
+
 void CTxMemPool::CalculateDescendants(txiter entryit, setEntries& setDescendants) const
 {
     setEntries stage;
@@ -668,6 +697,9 @@ void CTxMemPool::check(const CCoinsViewCache& active_coins_tip, int64_t spendhei
 
     uint64_t checkTotal = 0;
     CAmount check_total_fee{0};
+    uint64_t check_total_gas_limit{0};
+    uint64_t check_total_gas{0};
+    std::map<std::vector<unsigned char>, uint64_t> check_sender_gas;
     uint64_t innerUsage = 0;
     uint64_t prev_ancestor_count{0};
 
@@ -676,6 +708,11 @@ void CTxMemPool::check(const CCoinsViewCache& active_coins_tip, int64_t spendhei
     for (const auto& it : GetSortedDepthAndScore()) {
         checkTotal += it->GetTxSize();
         check_total_fee += it->GetFee();
+        check_total_gas_limit += it->GetGasLimit();
+        check_total_gas += it->GetGas();
+        if (it->GetGasLimit() && it->GetContractSender()) {
+            check_sender_gas[*it->GetContractSender()] += it->GetGasLimit();
+        }
         innerUsage += it->DynamicMemoryUsage();
         const CTransaction& tx = it->GetTx();
         innerUsage += memusage::DynamicUsage(it->GetMemPoolParentsConst()) + memusage::DynamicUsage(it->GetMemPoolChildrenConst());
@@ -758,6 +795,9 @@ void CTxMemPool::check(const CCoinsViewCache& active_coins_tip, int64_t spendhei
 
     assert(totalTxSize == checkTotal);
     assert(m_total_fee == check_total_fee);
+    assert(m_total_gas_limit == check_total_gas_limit);
+    assert(m_total_gas == check_total_gas);
+    assert(m_sender_gas == check_sender_gas);
     assert(innerUsage == cachedInnerUsage);
 }
 
@@ -1035,7 +1075,7 @@ void CCoinsViewMemPool::Reset()
 size_t CTxMemPool::DynamicMemoryUsage() const {
     LOCK(cs);
     // Estimate the overhead of mapTx to be 15 pointers + an allocation, as no exact formula for boost::multi_index_contained is implemented.
-    return memusage::MallocUsage(sizeof(CTxMemPoolEntry) + 15 * sizeof(void*)) * mapTx.size() + memusage::DynamicUsage(mapNextTx) + memusage::DynamicUsage(mapDeltas) + memusage::DynamicUsage(txns_randomized) + cachedInnerUsage;
+    return memusage::MallocUsage(sizeof(CTxMemPoolEntry) + 15 * sizeof(void*)) * mapTx.size() + memusage::DynamicUsage(mapNextTx) + memusage::DynamicUsage(mapDeltas) + memusage::DynamicUsage(txns_randomized) + memusage::DynamicUsage(m_sender_gas) + cachedInnerUsage;
 }
 
 void CTxMemPool::RemoveUnbroadcastTx(const uint256& txid, const bool unchecked) {
@@ -1149,32 +1189,64 @@ void CTxMemPool::TrimToSize(size_t sizelimit, std::vector<COutPoint>* pvNoSpends
         trackPackageRemoved(removed);
         maxFeeRateRemoved = std::max(maxFeeRateRemoved, removed);
 
-        setEntries stage;
-        CalculateDescendants(mapTx.project<0>(it), stage);
-        nTxnRemoved += stage.size();
+        nTxnRemoved += RemoveForLimit(mapTx.project<0>(it), pvNoSpendsRemaining);
+    }
 
-        std::vector<CTransaction> txn;
-        if (pvNoSpendsRemaining) {
-            txn.reserve(stage.size());
-            for (txiter iter : stage)
-                txn.push_back(iter->GetTx());
-        }
-        RemoveStaged(stage, false, MemPoolRemovalReason::SIZELIMIT);
-        if (pvNoSpendsRemaining) {
-            for (const CTransaction& tx : txn) {
-                for (const CTxIn& txin : tx.vin) {
-                    if (exists(GenTxid::Txid(txin.prevout.hash))) continue;
-                    if (!mapNextTx.count(txin.prevout)) {
-                        pvNoSpendsRemaining->push_back(txin.prevout);
-                    }
+    if (maxFeeRateRemoved > CFeeRate(0)) {
+        LogPrint(BCLog::MEMPOOL, "Removed %u txn, rolling minimum fee bumped to %s\n", nTxnRemoved, maxFeeRateRemoved.ToString());
+    }
+}
+
+void CTxMemPool::TrimToGas(uint64_t gaslimit, std::vector<COutPoint>* pvNoSpendsRemaining) {
+    AssertLockHeld(cs);
+
+    // The rolling minimum fee is per virtual byte and is left untouched, a contract tx
+    // with a gas price too low to stay is evicted again after being accepted.
+    unsigned nTxnRemoved = 0;
+    while (!mapTx.empty() && m_total_gas > gaslimit) {
+        indexed_transaction_set::index<gas_score>::type::iterator it = mapTx.get<gas_score>().begin();
+        if (it->GetGas() == 0) break;
+        nTxnRemoved += RemoveForLimit(mapTx.project<0>(it), pvNoSpendsRemaining);
+    }
+
+    if (nTxnRemoved) {
+        LogPrint(BCLog::MEMPOOL, "Removed %u txn, mempool gas reduced to %u\n", nTxnRemoved, m_total_gas);
+    }
+}
+
+unsigned int CTxMemPool::RemoveForLimit(txiter it, std::vector<COutPoint>* pvNoSpendsRemaining) {
+    AssertLockHeld(cs);
+
+    setEntries stage;
+    CalculateDescendants(it, stage);
+
+    std::vector<CTransaction> txn;
+    if (pvNoSpendsRemaining) {
+        txn.reserve(stage.size());
+        for (txiter iter : stage)
+            txn.push_back(iter->GetTx());
+    }
+    RemoveStaged(stage, false, MemPoolRemovalReason::SIZELIMIT);
+    if (pvNoSpendsRemaining) {
+        for (const CTransaction& tx : txn) {
+            for (const CTxIn& txin : tx.vin) {
+                if (exists(GenTxid::Txid(txin.prevout.hash))) continue;
+                if (!mapNextTx.count(txin.prevout)) {
+                    pvNoSpendsRemaining->push_back(txin.prevout);
                 }
             }
         }
     }
+    return stage.size();
+}
 
-    if (maxFeeRateRemoved > CFeeRate(0)) {
-        LogPrint(BCLog::MEMPOOL, "Removed %u txn, rolling minimum fee bumped to %s\n", nTxnRemoved, maxFeeRateRemoved.ToString());
-    }
+void CTxMemPool::UpdateContractSimulation(txiter it, std::shared_ptr<const ContractSimulation> simulation, uint64_t gas)
+{
+    AssertLockHeld(cs);
+    it->UpdateContractSimulation(std::move(simulation));
+    m_total_gas -= it->GetGas();
+    mapTx.modify(it, [gas](CTxMemPoolEntry& e) { e.UpdateGas(gas); });
+    m_total_gas += it->GetGas();
 }
 
 uint64_t CTxMemPool::CalculateDescendantMaximum(txiter entry) const {
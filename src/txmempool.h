@@ -331,12 +331,38 @@ public:
     }
 };
 
+/** \class CompareTxMemPoolEntryByGasScore
+ *
+ *  Sort the contract entries by fee per gas in ascending order, followed by the
+ *  entries without gas. The gas used on the tip state is counted once simulated.
+ */
+class CompareTxMemPoolEntryByGasScore
+{
+public:
+    bool operator()(const CTxMemPoolEntry& a, const CTxMemPoolEntry& b) const
+    {
+        if ((a.GetGas() == 0) != (b.GetGas() == 0)) {
+            return b.GetGas() == 0;
+        }
+
+        // Avoid division by rewriting (a/b < c/d) as (a*d < c*b).
+        double f1 = (double)a.GetModifiedFeeForGas() * b.GetGas();
+        double f2 = (double)b.GetModifiedFeeForGas() * a.GetGas();
+
+        if (f1 == f2) {
+            return b.GetTx().GetHash() < a.GetTx().GetHash();
+        }
+        return f1 < f2;
+    }
+};
+
 // Multi_index tag names
 struct descendant_score {};
 struct entry_time {};
 struct ancestor_score {};
 struct index_by_wtxid {};
 struct ancestor_score_or_gas_price {};
+struct gas_score {};
 
 /**
  * Information about a mempool transaction.
@@ -441,6 +467,9 @@ protected:
     uint64_t totalTxSize GUARDED_BY(cs){0};      //!< sum of all mempool tx's virtual sizes. Differs from serialized tx size since witness data is discounted. Defined in BIP 141.
     CAmount m_total_fee GUARDED_BY(cs){0};       //!< sum of all mempool tx's fees (NOT modified fee)
     uint64_t cachedInnerUsage GUARDED_BY(cs){0}; //!< sum of dynamic memory usage of all the map elements (NOT the maps themselves)
+    uint64_t m_total_gas_limit GUARDED_BY(cs){0}; //!< sum of the gas limits of all mempool contract txs
+    uint64_t m_total_gas GUARDED_BY(cs){0};       //!< sum of the gas of all mempool contract txs, the simulated gas used when known
+    std::map<std::vector<unsigned char>, uint64_t> m_sender_gas GUARDED_BY(cs); //!< sum of the gas limits of the mempool contract txs per sender
 
     mutable int64_t lastRollingFeeUpdate GUARDED_BY(cs){GetTime()};
     mutable bool blockSinceLastRollingFeeBump GUARDED_BY(cs){false};
@@ -496,6 +525,12 @@ public:
                 boost::multi_index::tag<ancestor_score_or_gas_price>,
                 boost::multi_index::identity<CTxMemPoolEntry>,
                 CompareTxMemPoolEntryByAncestorFeeOrGasPrice
+            >,
+            // sorted by fee per gas of contract txs
+            boost::multi_index::ordered_non_unique<
+                boost::multi_index::tag<gas_score>,
+                boost::multi_index::identity<CTxMemPoolEntry>,
+                CompareTxMemPoolEntryByGasScore
             >
         >
     > indexed_transaction_set;
@@ -590,6 +625,8 @@ public:
     using Options = kernel::MemPoolOptions;
 
     const int64_t m_max_size_bytes;
+    const uint64_t m_max_gas;
+    const uint64_t m_max_sender_gas;
     const std::chrono::seconds m_expiry;
     const CFeeRate m_incremental_relay_feerate;
     const CFeeRate m_min_relay_feerate;
@@ -796,6 +833,15 @@ public:
       */
     void TrimToSize(size_t sizelimit, std::vector<COutPoint>* pvNoSpendsRemaining = nullptr) EXCLUSIVE_LOCKS_REQUIRED(cs);
 
+    /** Remove the contract transactions with the lowest fee per gas (and their descendants)
+      *  until the gas of the mempool is at most gaslimit.
+      *  pvNoSpendsRemaining is filled like in TrimToSize.
+      */
+    void TrimToGas(uint64_t gaslimit, std::vector<COutPoint>* pvNoSpendsRemaining = nullptr) EXCLUSIVE_LOCKS_REQUIRED(cs);
+
+    /** Store the outcome of the contract outputs of an entry on the tip state with the gas they use */
+    void UpdateContractSimulation(txiter it, std::shared_ptr<const ContractSimulation> simulation, uint64_t gas) EXCLUSIVE_LOCKS_REQUIRED(cs);
+
     /** Expire all transaction (and their dependencies) in the mempool older than time. Return the number of removed transactions. */
     int Expire(std::chrono::seconds time) EXCLUSIVE_LOCKS_REQUIRED(cs);
 
@@ -837,6 +883,28 @@ public:
         return m_total_fee;
     }
 
+    uint64_t GetTotalGasLimit() const EXCLUSIVE_LOCKS_REQUIRED(cs)
+    {
+        AssertLockHeld(cs);
+        return m_total_gas_limit;
+    }
+
+    uint64_t GetTotalGas() const EXCLUSIVE_LOCKS_REQUIRED(cs)
+    {
+        AssertLockHeld(cs);
+        return m_total_gas;
+    }
+
+    uint64_t GetSenderGas(const std::vector<unsigned char>& sender) const EXCLUSIVE_LOCKS_REQUIRED(cs)
+    {
+        AssertLockHeld(cs);
+        auto it = m_sender_gas.find(sender);
+        return it != m_sender_gas.end() ? it->second : 0;
+    }
+
+    /** Gas of the sender left in the mempool once the conflicts and all their descendants are removed */
+    uint64_t GetSenderGasWithout(const std::vector<unsigned char>& sender, const setEntries& conflicts) const EXCLUSIVE_LOCKS_REQUIRED(cs);
+
     bool exists(const GenTxid& gtxid) const
     {
         LOCK(cs);
@@ -947,6 +1015,8 @@ private:
     void UpdateForRemoveFromMempool(const setEntries &entriesToRemove, bool updateDescendants) EXCLUSIVE_LOCKS_REQUIRED(cs);
     /** Sever link between specified transaction and direct children. */
     void UpdateChildrenForRemoval(txiter entry) EXCLUSIVE_LOCKS_REQUIRED(cs);
+    /** Remove an entry and its descendants to enforce a limit, returns the number of txs removed */
+    unsigned int RemoveForLimit(txiter it, std::vector<COutPoint>* pvNoSpendsRemaining) EXCLUSIVE_LOCKS_REQUIRED(cs);
 
     /** Before calling removeUnchecked for a given transaction,
      *  UpdateForRemoveFromMempool must be called on the entire (dependent) set
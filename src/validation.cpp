@@ -72,7 +72,11 @@
 #include <libethcore/ABI.h>
 #include <univalue.h>
 #include <util/signstr.h>
+#include <odan/odandelegation.h>
 #include <odan/odanutils.h>
+#include <odan/parallelexec.h>
+#include <odan/mempoolsim.h>
+#include <odan/receiptfeed.h>
 #include <common/args.h>
 #include <addresstype.h>
 
@@ -124,8 +128,12 @@ static constexpr int PRUNE_LOCK_BUFFER{10};
 std::unique_ptr<OdanState> globalState;
 std::shared_ptr<dev::eth::SealEngineFace> globalSealEngine;
 std::unique_ptr<StorageResults> pstorageresult;
+std::unique_ptr<VMLogWriter> pvmlogwriter;
+std::unique_ptr<MempoolSimulator> pmempoolsimulator;
+std::unique_ptr<ReceiptFeed> preceiptfeed;
+std::unique_ptr<OdanStatePruner> pstatepruner;
+std::unique_ptr<OdanStateSnapshot> pstatesnapshot;
 bool fRecordLogOpcodes = false;
-bool fIsVMlogFile = false;
 bool fGettingValuesDGP = false;
 std::set<std::pair<COutPoint, unsigned int>> setStakeSeen;
 
@@ -133,6 +141,8 @@ GlobalMutex g_best_block_mutex;
 std::condition_variable g_best_block_cv;
 uint256 g_best_block;
 bool fAddressIndex = false; // odan
+bool fDelegationIndex = false; // odan
+bool fTokenIndex = false; // odan
 bool fLogEvents = false;
 
 const CBlockIndex* Chainstate::FindForkInGlobalIndex(const CBlockLocator& locator) const
@@ -302,6 +312,7 @@ static void LimitMempoolSize(CTxMemPool& pool, CCoinsViewCache& coins_cache)
 
     std::vector<COutPoint> vNoSpendsRemaining;
     pool.TrimToSize(pool.m_max_size_bytes, &vNoSpendsRemaining);
+    pool.TrimToGas(pool.m_max_gas, &vNoSpendsRemaining);
     for (const COutPoint& removed : vNoSpendsRemaining)
         coins_cache.Uncache(removed);
 }
@@ -657,6 +668,9 @@ private:
         /** A temporary cache containing serialized transaction data for signature verification.
          * Reused across PolicyScriptChecks and ConsensusScriptChecks. */
         PrecomputedTransactionData m_precomputed_txdata;
+
+        /** Contract outputs of the transaction, queued for the mempool simulation in Finalize(). */
+        std::vector<OdanTransaction> m_odan_transactions;
     };
 
     // Run the policy checks on a given transaction, excluding any script checks.
@@ -890,6 +904,8 @@ bool MemPoolAccept::PreChecks(ATMPArgs& args, Workspace& ws)
     int64_t nSigOpsCost = GetTransactionSigOpCost(tx, m_view, STANDARD_SCRIPT_VERIFY_FLAGS);
 
     dev::u256 txMinGasPrice = 0;
+    uint64_t txGasLimit = 0;
+    std::optional<valtype> contractSender;
 
     //////////////////////////////////////////////////////////// // odan
     if(!CheckOpSender(tx, chainparams, m_active_chainstate.m_chain.Height() + 1)){
@@ -908,11 +924,13 @@ bool MemPoolAccept::PreChecks(ATMPArgs& args, Workspace& ws)
         for(const CTxOut& o : tx.vout)
             count += o.scriptPubKey.HasOpCreate() || o.scriptPubKey.HasOpCall() ? 1 : 0;
         unsigned int contractflags = GetContractScriptFlags(m_active_chainstate.m_chain.Height() + 1, chainparams.GetConsensus());
-        OdanTxConverter converter(tx, m_active_chainstate, &m_pool, NULL, NULL, contractflags);
+        // The inputs are in m_view, the sender is cached in the mempool entry for the block assembly
+        OdanTxConverter converter(tx, m_active_chainstate, &m_pool, &m_view, NULL, contractflags);
         ExtractOdanTX resultConverter;
         if(!converter.extractionOdanTransactions(resultConverter)){
             return state.Invalid(TxValidationResult::TX_CONSENSUS, "bad-tx-bad-contract-format", "AcceptToMempool(): Contract transaction of the wrong format");
         }
+        contractSender = converter.getInputSender();
         std::vector<OdanTransaction> odanTransactions = resultConverter.first;
         std::vector<EthTransactionParams> odanETP = resultConverter.second;
 
@@ -969,6 +987,10 @@ bool MemPoolAccept::PreChecks(ATMPArgs& args, Workspace& ws)
 
         if(count > odanTransactions.size())
             return state.Invalid(TxValidationResult::TX_CONSENSUS, "bad-txns-incorrect-format");
+
+        txGasLimit = uint64_t(gasAllTxs);
+        if(pmempoolsimulator)
+            ws.m_odan_transactions = std::move(odanTransactions);
     }
     ////////////////////////////////////////////////////////////
 
@@ -991,7 +1013,7 @@ bool MemPoolAccept::PreChecks(ATMPArgs& args, Workspace& ws)
     // reorg to be marked earlier than any child txs that were already in the mempool.
     const uint64_t entry_sequence = bypass_limits ? 0 : m_pool.GetSequence();
     entry.reset(new CTxMemPoolEntry(ptx, ws.m_base_fees, nAcceptTime, m_active_chainstate.m_chain.Height(), entry_sequence,
-                                    fSpendsCoinbase, nSigOpsCost, lock_points.value(), CAmount(txMinGasPrice)));
+                                    fSpendsCoinbase, nSigOpsCost, lock_points.value(), CAmount(txMinGasPrice), contractSender, txGasLimit));
     ws.m_vsize = entry->GetTxSize();
 
     if (nSigOpsCost > dgpMaxTxSigOps)
@@ -1017,6 +1039,15 @@ bool MemPoolAccept::PreChecks(ATMPArgs& args, Workspace& ws)
 
     ws.m_iters_conflicting = m_pool.GetIterSet(ws.m_conflicts);
 
+    // Per sender quota of contract gas, the gas of the txs this one replaces and of their descendants is released
+    if (!bypass_limits && entry->GetGasLimit() && contractSender) {
+        uint64_t senderGas = m_pool.GetSenderGasWithout(*contractSender, ws.m_iters_conflicting);
+        if (senderGas + entry->GetGasLimit() > m_pool.m_max_sender_gas) {
+            return state.Invalid(TxValidationResult::TX_MEMPOOL_POLICY, "too-much-sender-gas",
+                                 strprintf("%u + %u > %u", senderGas, entry->GetGasLimit(), m_pool.m_max_sender_gas));
+        }
+    }
+
     // Note that these modifications are only applicable to single transaction scenarios;
     // carve-outs and package RBF are disabled for multi-transaction evaluations.
     CTxMemPool::Limits maybe_rbf_limits = m_pool.m_limits;
@@ -1282,6 +1313,11 @@ bool MemPoolAccept::Finalize(const ATMPArgs& args, Workspace& ws)
     // Store transaction in memory
     m_pool.addUnchecked(*entry, ws.m_ancestors);
 
+    // Execute the contracts on the tip state in the background
+    if (pmempoolsimulator && !ws.m_odan_transactions.empty()) {
+        pmempoolsimulator->Push(hash, std::move(ws.m_odan_transactions));
+    }
+
     // trim mempool and check if tx was trimmed
     // If we are validating a package, don't trim here because we could evict a previous transaction
     // in the package. LimitMempoolSize() should be called at the very end to make sure the mempool
@@ -2272,6 +2308,37 @@ int ApplyTxInUndo(Coin&& undo, CCoinsViewCache& view, const COutPoint& out)
     return fClean ? DISCONNECT_OK : DISCONNECT_UNCLEAN;
 }
 
+/** Events that restore the delegations from before the block at nHeight, read before the block is disconnected */
+static void GetDelegationUndoEvents(int nHeight, std::vector<DelegationEvent>& events, node::BlockTreeDB& blocktree)
+{
+    std::vector<std::pair<uint160, Delegation> > undo;
+    if (!blocktree.ReadDelegationUndo(nHeight, undo))
+        return;
+
+    for (const auto& [address, previous] : undo) {
+        Delegation current;
+        blocktree.ReadDelegationIndex(address, current);
+        if (current == previous)
+            continue;
+
+        // A delegation moved back to another staker is removed from the current one first, like the contract does
+        if (!current.IsNull() && (previous.IsNull() || current.staker != previous.staker)) {
+            DelegationEvent event;
+            static_cast<Delegation&>(event.item) = current;
+            event.item.delegate = address;
+            event.type = DELEGATION_REMOVE;
+            events.push_back(event);
+        }
+        if (!previous.IsNull()) {
+            DelegationEvent event;
+            static_cast<Delegation&>(event.item) = previous;
+            event.item.delegate = address;
+            event.type = DELEGATION_ADD;
+            events.push_back(event);
+        }
+    }
+}
+
 /** Undo the effects of this block (with given index) on the UTXO set represented by coins.
  *  When FAILED is returned, view is left in an indeterminate state. */
 DisconnectResult Chainstate::DisconnectBlock(const CBlock& block, const CBlockIndex* pindex, CCoinsViewCache& view, bool* pfClean)
@@ -2295,6 +2362,7 @@ DisconnectResult Chainstate::DisconnectBlock(const CBlock& block, const CBlockIn
     /////////////////////////////////////////////////////////// // odan
     std::vector<std::pair<CAddressIndexKey, CAmount> > addressIndex;
     std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > addressUnspentIndex;
+    std::vector<std::pair<CAddressIndexIteratorKey, CAddressWeightDelta> > addressWeightIndex;
     ///////////////////////////////////////////////////////////
 
     // Ignore blocks that contain transactions which are 'overwritten' by later transactions,
@@ -2347,6 +2415,7 @@ DisconnectResult Chainstate::DisconnectBlock(const CBlock& block, const CBlockIn
                     addressIndex.push_back(std::make_pair(CAddressIndexKey(addressIndexType, uint256(addressBytes), pindex->nHeight, i, hash, k, false), out.nValue));
                     // undo unspent index
                     addressUnspentIndex.push_back(std::make_pair(CAddressUnspentKey(addressIndexType, uint256(addressBytes), hash, k), CAddressUnspentValue()));
+                    addressWeightIndex.push_back(std::make_pair(CAddressIndexIteratorKey(addressIndexType, uint256(addressBytes)), CAddressWeightDelta(pindex->nHeight, out.nValue * -1, out.nValue * -1)));
                 }
             }
         }
@@ -2385,6 +2454,7 @@ DisconnectResult Chainstate::DisconnectBlock(const CBlock& block, const CBlockIn
                         addressIndex.push_back(std::make_pair(CAddressIndexKey(addressIndexType, uint256(addressBytes), pindex->nHeight, i, hash, j, true), prevout.nValue * -1));
                         // restore unspent index
                         addressUnspentIndex.push_back(std::make_pair(CAddressUnspentKey(addressIndexType, uint256(addressBytes), input.prevout.hash, input.prevout.n), CAddressUnspentValue(prevout.nValue, prevout.scriptPubKey, undo.nHeight, isTxCoinStake)));
+                        addressWeightIndex.push_back(std::make_pair(CAddressIndexIteratorKey(addressIndexType, uint256(addressBytes)), CAddressWeightDelta(undo.nHeight, prevout.nValue, 0)));
                     }
                 }
             }
@@ -2412,8 +2482,34 @@ DisconnectResult Chainstate::DisconnectBlock(const CBlock& block, const CBlockIn
             m_blockman.m_block_tree_db->EraseDelegateIndex(pindex->nHeight);
     }
 
+    // The background chainstate of a UTXO snapshot does not write the indexes
+    const bool fBackground{GetRole() == ChainstateRole::BACKGROUND};
+
+    // The delegation index only follows the blocks of its best chain
+    CIndexBestBlock delegationBest;
+    if (pfClean == NULL && fDelegationIndex && !fBackground && m_blockman.m_block_tree_db->ReadDelegationIndexBest(delegationBest) &&
+        delegationBest.blockHash == pindex->GetBlockHash()) {
+        std::vector<DelegationEvent> delegationEvents;
+        GetDelegationUndoEvents(pindex->nHeight, delegationEvents, *m_blockman.m_block_tree_db);
+        if (!m_blockman.m_block_tree_db->EraseDelegationIndex(pindex->nHeight, CIndexBestBlock(pindex->pprev))) {
+            error("Failed to restore delegation index");
+            return DISCONNECT_FAILED;
+        }
+        if (!delegationEvents.empty())
+            GetMainSignals().DelegationEvents(delegationEvents, pindex->nHeight - 1);
+    }
+
+    CIndexBestBlock tokenBest;
+    if (pfClean == NULL && fTokenIndex && !fBackground && m_blockman.m_block_tree_db->ReadTokenIndexBest(tokenBest) &&
+        tokenBest.blockHash == pindex->GetBlockHash()) {
+        if (!m_blockman.m_block_tree_db->EraseTokenIndex(pindex->nHeight, CIndexBestBlock(pindex->pprev))) {
+            error("Failed to restore token index");
+            return DISCONNECT_FAILED;
+        }
+    }
+
     //////////////////////////////////////////////////// // odan
-    if (pfClean == NULL && fAddressIndex) {
+    if (pfClean == NULL && fAddressIndex && !fBackground) {
         if (!m_blockman.m_block_tree_db->EraseAddressIndex(addressIndex)) {
             error("Failed to delete address index");
             return DISCONNECT_FAILED;
@@ -2422,9 +2518,17 @@ DisconnectResult Chainstate::DisconnectBlock(const CBlock& block, const CBlockIn
             error("Failed to write address unspent index");
             return DISCONNECT_FAILED;
         }
+        if (!m_blockman.m_block_tree_db->UpdateAddressWeightIndex(addressWeightIndex, 0)) {
+            error("Failed to write address weight index");
+            return DISCONNECT_FAILED;
+        }
     }
     ////////////////////////////////////////////////////
 
+    if (pfClean == NULL) {
+        m_recent_spent_coins.DisconnectBlock(pindex);
+    }
+
     return fClean ? DISCONNECT_OK : DISCONNECT_UNCLEAN;
 }
 
@@ -2557,6 +2661,87 @@ bool GetSpentCoinFromBlock(const CBlockIndex* pindex, COutPoint prevout, Coin* c
     return false;
 }
 
+void RecentSpentCoins::ConnectBlock(const CBlock& block, const CBlockUndo& blockundo, const CBlockIndex* pindex, int nDepth)
+{
+    LOCK(m_mutex);
+
+    // Only a contiguous range of blocks is kept
+    if (!m_blocks.empty()) {
+        const auto& last = *m_blocks.rbegin();
+        if (!pindex->pprev || last.first != pindex->pprev->nHeight || last.second.first != pindex->pprev->GetBlockHash()) {
+            m_coins.clear();
+            m_blocks.clear();
+        }
+    }
+
+    auto& [hash, outpoints] = m_blocks[pindex->nHeight];
+    hash = pindex->GetBlockHash();
+    for (size_t i = 1; i < block.vtx.size(); i++) {
+        const CTransaction& tx = *block.vtx[i];
+        const CTxUndo& txundo = blockundo.vtxundo[i - 1];
+        for (size_t j = 0; j < tx.vin.size(); j++) {
+            outpoints.push_back(tx.vin[j].prevout);
+            m_coins[tx.vin[j].prevout] = SpentCoin{pindex->nHeight, txundo.vprevout[j]};
+        }
+    }
+
+    while (!m_blocks.empty() && m_blocks.begin()->first <= pindex->nHeight - nDepth) {
+        for (const COutPoint& prevout : m_blocks.begin()->second.second) {
+            m_coins.erase(prevout);
+        }
+        m_blocks.erase(m_blocks.begin());
+    }
+}
+
+void RecentSpentCoins::DisconnectBlock(const CBlockIndex* pindex)
+{
+    LOCK(m_mutex);
+
+    if (m_blocks.empty()) {
+        return;
+    }
+    auto last = std::prev(m_blocks.end());
+    if (last->first != pindex->nHeight || last->second.first != pindex->GetBlockHash()) {
+        m_coins.clear();
+        m_blocks.clear();
+        return;
+    }
+    for (const COutPoint& prevout : last->second.second) {
+        m_coins.erase(prevout);
+    }
+    m_blocks.erase(last);
+}
+
+bool RecentSpentCoins::Find(const CBlockIndex* pindexTip, const CBlockIndex* pforkBase, const COutPoint& prevout, Coin* coin, int& nFirstHeight) const
+{
+    LOCK(m_mutex);
+
+    nFirstHeight = pindexTip->nHeight + 1;
+    if (m_blocks.empty() || m_blocks.rbegin()->first != pindexTip->nHeight || m_blocks.rbegin()->second.first != pindexTip->GetBlockHash()) {
+        return false;
+    }
+    nFirstHeight = std::max(m_blocks.begin()->first, pforkBase->nHeight + 1);
+
+    auto it = m_coins.find(prevout);
+    if (it == m_coins.end()) {
+        return false;
+    }
+    if (it->second.nHeight <= pforkBase->nHeight) {
+        // Spent before the fork, the blocks below the index do not need to be searched
+        nFirstHeight = pforkBase->nHeight + 1;
+        return false;
+    }
+    *coin = it->second.coin;
+    return true;
+}
+
+void RecentSpentCoins::Clear()
+{
+    LOCK(m_mutex);
+    m_coins.clear();
+    m_blocks.clear();
+}
+
 bool GetSpentCoinFromMainChain(const CBlockIndex* pforkPrev, COutPoint prevoutStake, Coin* coin, Chainstate& chainstate) {
     const CBlockIndex* pforkBase = chainstate.m_chain.FindFork(pforkPrev);
 
@@ -2582,8 +2767,14 @@ bool GetSpentCoinFromMainChain(const CBlockIndex* pforkPrev, COutPoint prevoutSt
 
     // Scan through blocks until we reach the forkbase to check if the prevoutStake has been spent in one of those blocks
     // If it not in any of those blocks, and not in the utxo set, it can't be spendable in the orphan chain.
+    // The last blocks are looked up in the recent spent coins, only the blocks below them are read from disk.
     {
         CBlockIndex* pindex = chainstate.m_chain.Tip();
+        int nFirstHeight = 0;
+        if(chainstate.m_recent_spent_coins.Find(pindex, pforkBase, prevoutStake, coin, nFirstHeight)) {
+            return true;
+        }
+        pindex = pindex->GetAncestor(nFirstHeight - 1);
         while(pindex && pindex != pforkBase) {
             if(GetSpentCoinFromBlock(pindex, prevoutStake, coin, chainstate)) {
                 return true;
@@ -2667,7 +2858,7 @@ bool CheckSenderScript(const CCoinsViewCache& view, const CTransaction& tx){
     return true;
 }
 
-std::vector<ResultExecute> CallContract(const dev::Address& addrContract, std::vector<unsigned char> opcode, Chainstate& chainstate, const dev::Address& sender, uint64_t gasLimit, CAmount nAmount){
+std::vector<ResultExecute> CallContract(const dev::Address& addrContract, std::vector<unsigned char> opcode, Chainstate& chainstate, const dev::Address& sender, uint64_t gasLimit, CAmount nAmount, bool* blockContextRead){
     CBlock block;
     CMutableTransaction tx;
 
@@ -2706,6 +2897,8 @@ std::vector<ResultExecute> CallContract(const dev::Address& addrContract, std::v
     
     ByteCodeExec exec(block, std::vector<OdanTransaction>(1, callTransaction), blockGasLimit, pblockindex, chainstate.m_chain);
     exec.performByteCode(dev::eth::Permanence::Reverted);
+    if(blockContextRead)
+        *blockContextRead = exec.readBlockContext();
     return exec.getResult();
 }
 
@@ -2802,27 +2995,36 @@ bool CheckReward(const CBlock& block, BlockValidationState& state, int nHeight,
     return true;
 }
 
-valtype GetSenderAddress(const CTransaction& tx, const CCoinsViewCache* coinsView, const std::vector<CTransactionRef>* blockTxs, Chainstate& chainstate, const CTxMemPool* mempool, int nOut = -1){
+valtype GetSenderAddress(const CScript& script){
+	CTxDestination addressBit;
+    TxoutType txType=TxoutType::NONSTANDARD;
+	if(ExtractDestination(script, addressBit, &txType, true)){
+		if ((txType == TxoutType::PUBKEY || txType == TxoutType::PUBKEYHASH) &&
+                std::holds_alternative<PKHash>(addressBit)){
+			PKHash senderAddress(std::get<PKHash>(addressBit));
+			return valtype(senderAddress.begin(), senderAddress.end());
+		}
+	}
+    //prevout is not a standard transaction format, so just return 0
+    return valtype();
+}
+
+// Get the address of the owner of the output spent by vin[0]
+valtype GetSenderAddress(const CTransaction& tx, const CCoinsViewCache* coinsView, const BlockTxMap* blockTxs, Chainstate& chainstate, const CTxMemPool* mempool){
     CScript script;
     bool scriptFilled=false; //can't use script.empty() because an empty script is technically valid
 
-    // Try get the sender script from the output script
-    if(nOut > -1)
-        scriptFilled = ExtractSenderData(tx.vout[nOut].scriptPubKey, &script, nullptr);
-
     // Check if the transaction has inputs
     if(tx.vin.size() == 0) {
         return valtype();
     }
 
     // Check the current (or in-progress) block for zero-confirmation change spending that won't yet be in txindex
-    if(!scriptFilled && blockTxs){
-        for(auto btx : *blockTxs){
-            if(btx->GetHash() == tx.vin[0].prevout.hash){
-                script = btx->vout[tx.vin[0].prevout.n].scriptPubKey;
-                scriptFilled=true;
-                break;
-            }
+    if(blockTxs){
+        auto it = blockTxs->find(tx.vin[0].prevout.hash);
+        if(it != blockTxs->end()){
+            script = it->second->vout[tx.vin[0].prevout.n].scriptPubKey;
+            scriptFilled=true;
         }
     }
     if(!scriptFilled && coinsView){
@@ -2842,79 +3044,37 @@ valtype GetSenderAddress(const CTransaction& tx, const CCoinsViewCache* coinsVie
         }
     }
 
-	CTxDestination addressBit;
-    TxoutType txType=TxoutType::NONSTANDARD;
-	if(ExtractDestination(script, addressBit, &txType, true)){
-		if ((txType == TxoutType::PUBKEY || txType == TxoutType::PUBKEYHASH) &&
-                std::holds_alternative<PKHash>(addressBit)){
-			PKHash senderAddress(std::get<PKHash>(addressBit));
-			return valtype(senderAddress.begin(), senderAddress.end());
-		}
-	}
-    //prevout is not a standard transaction format, so just return 0
-    return valtype();
-}
-
-UniValue vmLogToJSON(const ResultExecute& execRes, const CTransaction& tx, const CBlock& block, CChain& chain){
-    UniValue result(UniValue::VOBJ);
-    if(tx != CTransaction())
-        result.pushKV("txid", tx.GetHash().GetHex());
-    result.pushKV("address", execRes.execRes.newAddress.hex());
-    if(block.GetHash() != CBlock().GetHash()){
-        result.pushKV("time", block.GetBlockTime());
-        result.pushKV("blockhash", block.GetHash().GetHex());
-        result.pushKV("blockheight", chain.Tip()->nHeight + 1);
-    } else {
-        result.pushKV("time", GetAdjustedTimeSeconds());
-        result.pushKV("blockheight", chain.Tip()->nHeight);
-    }
-    UniValue logEntries(UniValue::VARR);
-    dev::eth::LogEntries logs = execRes.txRec.log();
-    for(dev::eth::LogEntry log : logs){
-        UniValue logEntrie(UniValue::VOBJ);
-        logEntrie.pushKV("address", log.address.hex());
-        UniValue topics(UniValue::VARR);
-        for(dev::h256 l : log.topics){
-            UniValue topicPair(UniValue::VOBJ);
-            topicPair.pushKV("raw", l.hex());
-            topics.push_back(topicPair);
-            //TODO add "pretty" field for human readable data
-        }
-        UniValue dataPair(UniValue::VOBJ);
-        dataPair.pushKV("raw", HexStr(log.data));
-        logEntrie.pushKV("data", dataPair);
-        logEntrie.pushKV("topics", topics);
-        logEntries.push_back(logEntrie);
-    }
-    result.pushKV("entries", logEntries);
-    return result;
+    return GetSenderAddress(script);
 }
 
 void writeVMlog(const std::vector<ResultExecute>& res, CChain& chain, const CTransaction& tx, const CBlock& block){
-    fs::path odanDir = gArgs.GetDataDirNet() / "vmExecLogs.json";
-    std::stringstream ss;
-    if(fIsVMlogFile){
-        ss << ",";
-    } else {
-        std::ofstream file(PathToString(odanDir), std::ios::out | std::ios::app);
-        file << "{\"logs\":[]}";
-        file.close();
-    }
+    if(!pvmlogwriter)
+        return;
 
-    for(size_t i = 0; i < res.size(); i++){
-        ss << vmLogToJSON(res[i], tx, block, chain).write();
-        if(i != res.size() - 1){
-            ss << ",";
+    for(const ResultExecute& execRes : res){
+        VMLogRecord record;
+        if(tx != CTransaction())
+            record.txid = tx.GetHash().ToUint256();
+        record.address = uint160(execRes.execRes.newAddress.asBytes());
+        if(block.GetHash() != CBlock().GetHash()){
+            record.time = block.GetBlockTime();
+            record.blockHash = block.GetHash();
+            record.blockHeight = chain.Tip()->nHeight + 1;
         } else {
-            ss << "]}";
+            record.time = GetAdjustedTimeSeconds();
+            record.blockHeight = chain.Tip()->nHeight;
+        }
+        for(const dev::eth::LogEntry& log : execRes.txRec.log()){
+            VMLogEntry entry;
+            entry.address = uint160(log.address.asBytes());
+            for(const dev::h256& topic : log.topics)
+                entry.topics.push_back(uint256(topic.asBytes()));
+            entry.data = log.data;
+            record.entries.push_back(std::move(entry));
         }
+        // Written to the segments by the VM log thread
+        pvmlogwriter->Push(std::move(record));
     }
-    
-    std::ofstream file(PathToString(odanDir), std::ios::in | std::ios::out);
-    file.seekp(-2, std::ios::end);
-    file << ss.str();
-    file.close();
-    fIsVMlogFile = true;
 }
 
 LastHashes::LastHashes()
@@ -2946,16 +3106,21 @@ void LastHashes::clear()
 class ExecTransientStorage
 {
 public:
+    explicit ExecTransientStorage(OdanState& _state) : state(_state) {}
     void init() {
-        globalState->clearTransientStorage();
+        state.clearTransientStorage();
     }
     ~ExecTransientStorage() {
-        globalState->clearTransientStorage();
+        state.clearTransientStorage();
     }
+private:
+    OdanState& state;
 };
 
 bool ByteCodeExec::performByteCode(dev::eth::Permanence type){
-    ExecTransientStorage storage;
+    OdanState& execState = this->execState();
+    dev::eth::SealEngineFace& execSealEngine = this->execSealEngine();
+    ExecTransientStorage storage(execState);
     storage.init();
     for(OdanTransaction& tx : txs){
         //validate VM version
@@ -2963,17 +3128,23 @@ bool ByteCodeExec::performByteCode(dev::eth::Permanence type){
             return false;
         }
         dev::eth::EnvInfo envInfo(BuildEVMEnvironment());
-        if(!tx.isCreation() && !globalState->addressInUse(tx.receiveAddress())){
+        std::atomic<bool> contextRead{false};
+        envInfo.setBlockContextFlag(&contextRead);
+        if(!tx.isCreation() && !execState.addressInUse(tx.receiveAddress())){
             dev::eth::ExecutionResult execRes;
             execRes.excepted = dev::eth::TransactionException::Unknown;
             result.push_back(ResultExecute{execRes, OdanTransactionReceipt(dev::h256(), dev::h256(), dev::u256(), dev::eth::LogEntries()), CTransaction()});
             continue;
         }
-        result.push_back(globalState->execute(envInfo, *globalSealEngine.get(), tx, chain, type, OnOpFunc()));
+        result.push_back(execState.execute(envInfo, execSealEngine, tx, chainHeight(), type, OnOpFunc()));
+        blockContextRead |= contextRead.load();
+    }
+    // The changes of a private state stay in its overlay
+    if(!state){
+        globalState->db().commit();
+        globalState->dbUtxo().commit();
     }
-    globalState->db().commit();
-    globalState->dbUtxo().commit();
-    globalSealEngine.get()->deleteAddresses.clear();
+    execSealEngine.deleteAddresses.clear();
     return true;
 }
 
@@ -2991,12 +3162,12 @@ bool ByteCodeExec::processingResults(ByteCodeExecResult& resultBCE){
         		tx.vout.push_back(CTxOut(CAmount(txs[i].value()), script));
         		resultBCE.valueTransfers.push_back(CTransaction(tx));
         	}
-        	if(!(chain.Height() >= consensusParams.QIP7Height && result[i].execRes.excepted == dev::eth::TransactionException::RevertInstruction)){
+        	if(!(chainHeight() >= consensusParams.QIP7Height && result[i].execRes.excepted == dev::eth::TransactionException::RevertInstruction)){
         	resultBCE.usedGas += gasUsed;
         	}
         }
 
-        if(result[i].execRes.excepted == dev::eth::TransactionException::None || (chain.Height() >= consensusParams.QIP7Height && result[i].execRes.excepted == dev::eth::TransactionException::RevertInstruction)){
+        if(result[i].execRes.excepted == dev::eth::TransactionException::None || (chainHeight() >= consensusParams.QIP7Height && result[i].execRes.excepted == dev::eth::TransactionException::RevertInstruction)){
         	if(txs[i].gas() > UINT64_MAX ||
         			result[i].execRes.gasUsed > UINT64_MAX ||
 					txs[i].gasPrice() > UINT64_MAX){
@@ -3041,7 +3212,7 @@ dev::eth::EnvInfo ByteCodeExec::BuildEVMEnvironment(){
         header.setAuthor(EthAddrFromScript(block.vtx[0]->vout[0].scriptPubKey));
     }
     dev::u256 gasUsed;
-    int &chainID = const_cast<int&>(globalSealEngine->chainParams().chainID);
+    int &chainID = const_cast<int&>(execSealEngine().chainParams().chainID);
     chainID = odanutils::eth_getChainId(tip->nHeight);
     dev::eth::EnvInfo env(header, lastHashes, gasUsed, chainID);
     return env;
@@ -3064,7 +3235,9 @@ dev::Address ByteCodeExec::EthAddrFromScript(const CScript& script){
 
 bool OdanTxConverter::extractionOdanTransactions(ExtractOdanTX& odantx){
     // Get the address of the sender that pay the coins for the contract transactions
-    refundSender = dev::Address(GetSenderAddress(txBit, view, blockTransactions, chainstate, mempool));
+    if(!inputSender)
+        inputSender = GetSenderAddress(txBit, view, blockTransactions, chainstate, mempool);
+    refundSender = dev::Address(*inputSender);
 
     // Extract contract transactions
     std::vector<OdanTransaction> resultTX;
@@ -3164,7 +3337,10 @@ OdanTransaction OdanTxConverter::createEthTX(const EthTransactionParams& etp, ui
     else{
         txEth = OdanTransaction(txBit.vout[nOut].nValue, etp.gasPrice, etp.gasLimit, etp.receiveAddress, etp.code, dev::u256(0));
     }
-    dev::Address sender(GetSenderAddress(txBit, view, blockTransactions, chainstate, mempool, (int)nOut));
+    // The OP_SENDER address of the output, otherwise the owner of vin[0]
+    CScript senderScript;
+    dev::Address sender(!txBit.vin.empty() && ExtractSenderData(txBit.vout[nOut].scriptPubKey, &senderScript, nullptr) ?
+                        GetSenderAddress(senderScript) : *inputSender);
     txEth.forceSender(sender);
     txEth.setHashWith(uintToh256(txBit.GetHash()));
     txEth.setNVout(nOut);
@@ -3227,6 +3403,18 @@ bool Chainstate::ConnectBlock(const CBlock& block, BlockValidationState& state,
     const CChainParams& params{m_chainman.GetParams()};
 
     ///////////////////////////////////////////////// // odan
+    // The blocks of the background chainstate of a UTXO snapshot only validate the chain below the snapshot,
+    // the indexes, the notifications and the contract state files follow the active chainstate
+    const bool fBackground{GetRole() == ChainstateRole::BACKGROUND};
+    // The references written by block templates and failed blocks since the last block are not part of the chain
+    if (pstatepruner && !fBackground)
+        pstatepruner->Discard(*globalState, pindex->nHeight - 1);
+    // The background chainstate connects its blocks with the same globalState, ConnectTip restores the roots of the active tip
+    if (pindex->pprev && pindex->pprev->hashStateRoot != uint256() && pindex->pprev->hashUTXORoot != uint256() &&
+        (h256Touint(globalState->rootHash()) != pindex->pprev->hashStateRoot || h256Touint(globalState->rootHashUTXO()) != pindex->pprev->hashUTXORoot)) {
+        globalState->setRoot(uintToh256(pindex->pprev->hashStateRoot));
+        globalState->setRootUTXO(uintToh256(pindex->pprev->hashUTXORoot));
+    }
     OdanDGP odanDGP(globalState.get(), *this, fGettingValuesDGP);
     globalSealEngine->setOdanSchedule(odanDGP.getGasSchedule(pindex->nHeight + (pindex->nHeight+1 >= params.GetConsensus().QIP7Height ? 0 : 1) ));
     uint32_t sizeBlockDGP = odanDGP.getBlockSize(pindex->nHeight + (pindex->nHeight+1 >= params.GetConsensus().QIP7Height ? 0 : 1));
@@ -3466,8 +3654,13 @@ bool Chainstate::ConnectBlock(const CBlock& block, BlockValidationState& state,
     ///////////////////////////////////////////////////////// // odan
     std::vector<std::pair<CAddressIndexKey, CAmount> > addressIndex;
     std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > addressUnspentIndex;
+    std::vector<std::pair<CAddressIndexIteratorKey, CAddressWeightDelta> > addressWeightIndex;
     std::vector<std::pair<CSpentIndexKey, CSpentIndexValue> > spentIndex;
     std::map<dev::Address, std::pair<CHeightTxIndexKey, std::vector<uint256>>> heightIndexes;
+    dev::eth::LogBloom blockLogBloom;
+    std::vector<DelegationEvent> delegationEvents;
+    std::vector<CTokenTransfer> tokenTransfers;
+    std::vector<TransactionReceiptInfo> blockReceipts;
     /////////////////////////////////////////////////////////
 
     uint64_t blockGasUsed = 0;
@@ -3485,6 +3678,34 @@ bool Chainstate::ConnectBlock(const CBlock& block, BlockValidationState& state,
         nValueCoinPrev = coin.out.nValue;
     }
 
+    ///////////////////////////////////////////////////////// // odan
+    // The transactions of the block by hash, for the senders of the contract transactions
+    BlockTxMap blockTxs;
+    for (const CTransactionRef& tx : block.vtx)
+        blockTxs.emplace(tx->GetHash(), tx);
+
+    // The senders resolved by the parallel pre-pass, reused by the block order loop
+    std::vector<std::optional<valtype>> blockSenders(block.vtx.size());
+
+    // Speculatively execute the contract transactions in parallel, the results
+    // are applied in block order below and the conflicting ones executed again
+    std::unique_ptr<ParallelContractExec> parallelExec;
+    if (m_chainman.GetContractExecQueue().HasThreads()) {
+        parallelExec = std::make_unique<ParallelContractExec>(block, pindex->pprev, blockGasLimit, m_chain);
+        for (unsigned int i = 0; i < block.vtx.size(); i++) {
+            const CTransaction &tx = *(block.vtx[i]);
+            if (!tx.HasCreateOrCall() || tx.HasOpSpend())
+                continue;
+            OdanTxConverter convert(tx, *this, m_mempool, &view, &blockTxs, contractflags);
+            ExtractOdanTX resultConvertOdanTX;
+            if (convert.extractionOdanTransactions(resultConvertOdanTX))
+                parallelExec->Add(i, std::move(resultConvertOdanTX.first));
+            blockSenders[i] = convert.getInputSender();
+        }
+        parallelExec->Run(m_chainman.GetContractExecQueue());
+    }
+    /////////////////////////////////////////////////////////
+
     for (unsigned int i = 0; i < block.vtx.size(); i++)
     {
         const CTransaction &tx = *(block.vtx[i]);
@@ -3540,6 +3761,7 @@ bool Chainstate::ConnectBlock(const CBlock& block, BlockValidationState& state,
 
                         // remove address from unspent index
                         addressUnspentIndex.push_back(std::make_pair(CAddressUnspentKey(addressIndexType, uint256(addressBytes), input.prevout.hash, input.prevout.n), CAddressUnspentValue()));
+                        addressWeightIndex.push_back(std::make_pair(CAddressIndexIteratorKey(addressIndexType, uint256(addressBytes)), CAddressWeightDelta(prevheights[j], prevout.nValue * -1, 0)));
                         spentIndex.push_back(std::make_pair(CSpentIndexKey(input.prevout.hash, input.prevout.n), CSpentIndexValue(tx.GetHash(), j, pindex->nHeight, prevout.nValue, addressIndexType, uint256(addressBytes))));
                     }
                 }
@@ -3567,7 +3789,10 @@ bool Chainstate::ConnectBlock(const CBlock& block, BlockValidationState& state,
             std::vector<CScriptCheck> vChecks;
             bool fCacheResults = fJustCheck; /* Don't cache results if we're actually connecting blocks (still consult the cache, though) */
             TxValidationState tx_state;
-            if (fScriptChecks && !CheckInputScripts(tx, tx_state, view, flags, fCacheResults, fCacheResults, txsdata[i], (hasOpSpend || tx.HasCreateOrCall()) ? nullptr : (parallel_script_checks ? &vChecks : nullptr))) {
+            // The input and OP_SENDER signatures of contract transactions are verified by the
+            // script check queue too, in parallel with the contract execution below. A failed
+            // check makes the block invalid and the caller reverts the contract state.
+            if (fScriptChecks && !CheckInputScripts(tx, tx_state, view, flags, fCacheResults, fCacheResults, txsdata[i], parallel_script_checks ? &vChecks : nullptr)) {
                 // Any transaction validation failure in ConnectBlock is a block consensus failure
                 state.Invalid(BlockValidationResult::BLOCK_CONSENSUS,
                               tx_state.GetRejectReason(), tx_state.GetDebugMessage());
@@ -3608,7 +3833,7 @@ bool Chainstate::ConnectBlock(const CBlock& block, BlockValidationState& state,
                 return state.Invalid(BlockValidationResult::BLOCK_CONSENSUS, "bad-txns-invalid-sender-script");
             }
 
-            OdanTxConverter convert(tx, *this, m_mempool, &view, &block.vtx, contractflags);
+            OdanTxConverter convert(tx, *this, m_mempool, &view, &blockTxs, contractflags, blockSenders[i] ? &*blockSenders[i] : nullptr);
 
             ExtractOdanTX resultConvertOdanTX;
             if(!convert.extractionOdanTransactions(resultConvertOdanTX)){
@@ -3678,7 +3903,7 @@ bool Chainstate::ConnectBlock(const CBlock& block, BlockValidationState& state,
                 }
             }
 
-            if(!exec.performByteCode()){
+            if(!(parallelExec ? parallelExec->Execute(i, resultConvertOdanTX.first, exec) : exec.performByteCode())){
                 return state.Invalid(BlockValidationResult::BLOCK_CONSENSUS, "bad-tx-unknown-error", "ConnectBlock(): Unknown error during contract execution");
             }
 
@@ -3688,17 +3913,46 @@ bool Chainstate::ConnectBlock(const CBlock& block, BlockValidationState& state,
                 return state.Invalid(BlockValidationResult::BLOCK_CONSENSUS, "bad-vm-exec-processing", "ConnectBlock(): Error processing VM execution results");
             }
 
+            if (fDelegationIndex && !fJustCheck && !fBackground)
+            {
+                OdanDelegation& odanDelegation = GetOdanDelegation();
+                for(size_t k = 0; k < resultConvertOdanTX.first.size(); k ++){
+                    for(auto& log : resultExec[k].txRec.log()) {
+                        DelegationEvent event;
+                        if(odanDelegation.GetDelegationEvent(log, event)) {
+                            delegationEvents.push_back(event);
+                        }
+                    }
+                }
+            }
+
+            if (fTokenIndex && !fJustCheck)
+            {
+                for(size_t k = 0; k < resultConvertOdanTX.first.size(); k ++){
+                    for(auto& log : resultExec[k].txRec.log()) {
+                        CTokenTransfer transfer;
+                        if(GetTokenTransfer(log, transfer)) {
+                            transfer.txhash = tx.GetHash();
+                            tokenTransfers.push_back(transfer);
+                        }
+                    }
+                }
+            }
+
             std::vector<TransactionReceiptInfo> tri;
-            if (fLogEvents && !fJustCheck)
+            if ((fLogEvents || preceiptfeed) && !fJustCheck)
             {
                 uint64_t countCumulativeGasUsed = blockGasUsed;
                 for(size_t k = 0; k < resultConvertOdanTX.first.size(); k ++){
-                    for(auto& log : resultExec[k].txRec.log()) {
-                        if(!heightIndexes.count(log.address)){
-                            heightIndexes[log.address].first = CHeightTxIndexKey(pindex->nHeight, log.address);
+                    if (fLogEvents) {
+                        for(auto& log : resultExec[k].txRec.log()) {
+                            if(!heightIndexes.count(log.address)){
+                                heightIndexes[log.address].first = CHeightTxIndexKey(pindex->nHeight, log.address);
+                            }
+                            heightIndexes[log.address].second.push_back(tx.GetHash());
                         }
-                        heightIndexes[log.address].second.push_back(tx.GetHash());
                     }
+                    blockLogBloom |= resultExec[k].txRec.bloom();
                     uint64_t gasUsed = uint64_t(resultExec[k].execRes.gasUsed);
                     countCumulativeGasUsed += gasUsed;
                     tri.push_back(TransactionReceiptInfo{
@@ -3721,7 +3975,10 @@ bool Chainstate::ConnectBlock(const CBlock& block, BlockValidationState& state,
                     });
                 }
 
-                pstorageresult->addResult(uintToh256(tx.GetHash()), tri);
+                if (preceiptfeed)
+                    blockReceipts.insert(blockReceipts.end(), tri.begin(), tri.end());
+                if (fLogEvents)
+                    pstorageresult->addResult(uintToh256(tx.GetHash()), tri);
             }
 
             blockGasUsed += bcer.usedGas;
@@ -3766,6 +4023,7 @@ bool Chainstate::ConnectBlock(const CBlock& block, BlockValidationState& state,
                     addressIndex.push_back(std::make_pair(CAddressIndexKey(addressIndexType, uint256(addressBytes), pindex->nHeight, i, tx.GetHash(), k, false), out.nValue));
                     // record unspent output
                     addressUnspentIndex.push_back(std::make_pair(CAddressUnspentKey(addressIndexType, uint256(addressBytes), tx.GetHash(), k), CAddressUnspentValue(out.nValue, out.scriptPubKey, pindex->nHeight, isTxCoinStake)));
+                    addressWeightIndex.push_back(std::make_pair(CAddressIndexIteratorKey(addressIndexType, uint256(addressBytes)), CAddressWeightDelta(pindex->nHeight, out.nValue, out.nValue)));
                 }
             }
         }
@@ -3784,6 +4042,10 @@ bool Chainstate::ConnectBlock(const CBlock& block, BlockValidationState& state,
              nInputs <= 1 ? 0 : Ticks<MillisecondsDouble>(time_3 - time_2) / (nInputs - 1),
              Ticks<SecondsDouble>(time_connect),
              Ticks<MillisecondsDouble>(time_connect) / num_blocks_total);
+    if (parallelExec) {
+        LogPrint(BCLog::BENCH, "      - Contract transactions: %u speculative results applied, %u executed again\n",
+                 parallelExec->GetApplied(), parallelExec->GetReexecuted());
+    }
 
     if(nFees < gasRefunds) { //make sure it won't overflow
         return state.Invalid(BlockValidationResult::BLOCK_CONSENSUS, "bad-blk-fees-greater-gasrefund", "ConnectBlock(): Less total fees than gas refund fees");
@@ -3906,6 +4168,10 @@ bool Chainstate::ConnectBlock(const CBlock& block, BlockValidationState& state,
 
     if (fLogEvents)
     {
+        // Written before the height index, so the indexed logs are always covered by a bloom
+        if (!heightIndexes.empty() && !m_blockman.m_block_tree_db->WriteLogBloomIndex(pindex->nHeight, blockLogBloom))
+            return FatalError(m_chainman.GetNotifications(), state, "Failed to write log bloom index");
+
         for (const auto& e: heightIndexes)
         {
             if (!m_blockman.m_block_tree_db->WriteHeightIndex(e.second.first, e.second.second))
@@ -3940,14 +4206,41 @@ bool Chainstate::ConnectBlock(const CBlock& block, BlockValidationState& state,
         }
     }
 
+    // Written after the delegation of the block is checked against the index of the previous block.
+    // The index moves with every block connected on top of its best block, the other blocks
+    // (verifydb, background chainstate) are not applied to it.
+    CIndexBestBlock delegationBest;
+    if (fDelegationIndex && !fBackground && m_blockman.m_block_tree_db->ReadDelegationIndexBest(delegationBest) &&
+        delegationBest.blockHash == pindex->pprev->GetBlockHash())
+    {
+        std::vector<std::pair<uint160, Delegation> > delegationIndex;
+        for (const DelegationEvent& event : delegationEvents)
+            delegationIndex.push_back(std::make_pair(event.item.delegate, event.type == DELEGATION_ADD ? Delegation(event.item) : Delegation()));
+        if (!m_blockman.m_block_tree_db->UpdateDelegationIndex(pindex->nHeight, delegationIndex, CIndexBestBlock(pindex)))
+            return FatalError(m_chainman.GetNotifications(), state, "Failed to write delegation index");
+        if (!delegationEvents.empty())
+            GetMainSignals().DelegationEvents(delegationEvents, pindex->nHeight);
+    }
+
+    CIndexBestBlock tokenBest;
+    if (fTokenIndex && !fBackground && m_blockman.m_block_tree_db->ReadTokenIndexBest(tokenBest) &&
+        tokenBest.blockHash == pindex->pprev->GetBlockHash())
+    {
+        if (!m_blockman.m_block_tree_db->UpdateTokenIndex(pindex->nHeight, tokenTransfers, CIndexBestBlock(pindex)))
+            return FatalError(m_chainman.GetNotifications(), state, "Failed to write token index");
+    }
+
     ///////////////////////////////////////////////////////////// // odan
-    if (fAddressIndex) {
+    if (fAddressIndex && !fBackground) {
         if (!m_blockman.m_block_tree_db->WriteAddressIndex(addressIndex)) {
             return FatalError(m_chainman.GetNotifications(), state, "Failed to write address index");
         }
         if (!m_blockman.m_block_tree_db->UpdateAddressUnspentIndex(addressUnspentIndex)) {
             return FatalError(m_chainman.GetNotifications(), state, "Failed to write address unspent index");
         }
+        if (!m_blockman.m_block_tree_db->UpdateAddressWeightIndex(addressWeightIndex, GetAddressWeightCompactHeight(pindex->nHeight, params.GetConsensus()))) {
+            return FatalError(m_chainman.GetNotifications(), state, "Failed to write address weight index");
+        }
 
         if (!m_blockman.m_block_tree_db->UpdateSpentIndex(spentIndex))
             return FatalError(m_chainman.GetNotifications(), state, "Failed to write transaction index");
@@ -3973,6 +4266,8 @@ bool Chainstate::ConnectBlock(const CBlock& block, BlockValidationState& state,
     }
     /////////////////////////////////////////////////////////////
 
+    m_recent_spent_coins.ConnectBlock(block, blockundo, pindex, params.GetConsensus().CoinbaseMaturity(pindex->nHeight));
+
     // add this block to the view's block chain
     view.SetBestBlock(pindex->GetBlockHash());
 
@@ -3995,6 +4290,19 @@ bool Chainstate::ConnectBlock(const CBlock& block, BlockValidationState& state,
     if (fLogEvents)
         pstorageresult->commitResults();
 
+    if (preceiptfeed && !fBackground)
+        preceiptfeed->AddBlock(block.GetHash(), pindex->nHeight, blockReceipts);
+
+    if (pstatepruner && !fBackground) {
+        // The node starts again from the coins flushed to disk after a crash, their state is kept
+        const CBlockIndex* pindexFlushed = m_blockman.LookupBlockIndex(CoinsDB().GetBestBlock());
+        const CBlockIndex* pindexKeep = pindexFlushed ? LastCommonAncestor(pindexFlushed, pindex) : nullptr;
+        pstatepruner->Commit(*globalState, pindex->nHeight, pindexKeep ? pindexKeep->nHeight : 0);
+    }
+
+    if (pstatesnapshot && !fBackground)
+        pstatesnapshot->Update(*globalState, pindex->nHeight);
+
     return true;
 }
 
@@ -4300,7 +4608,15 @@ bool Chainstate::DisconnectTip(BlockValidationState& state, DisconnectedBlockTra
     {
         CCoinsViewCache view(&CoinsTip());
         assert(view.GetBestBlock() == pindexDelete->GetBlockHash());
-        if (DisconnectBlock(block, pindexDelete, view, nullptr) != DISCONNECT_OK)
+        dev::h256 oldHashStateRoot(globalState->rootHash()); // odan
+        dev::h256 oldHashUTXORoot(globalState->rootHashUTXO()); // odan
+        DisconnectResult res = DisconnectBlock(block, pindexDelete, view, nullptr);
+        // The background chainstate leaves globalState at the tip of the active chainstate
+        if (GetRole() == ChainstateRole::BACKGROUND) { // odan
+            globalState->setRoot(oldHashStateRoot); // odan
+            globalState->setRootUTXO(oldHashUTXORoot); // odan
+        } // odan
+        if (res != DISCONNECT_OK)
             return error("DisconnectTip(): DisconnectBlock %s failed", pindexDelete->GetBlockHash().ToString());
         bool flushed = view.Flush();
         assert(flushed);
@@ -4427,6 +4743,11 @@ bool Chainstate::ConnectTip(BlockValidationState& state, CBlockIndex* pindexNew,
 
         bool rv = ConnectBlock(blockConnecting, state, pindexNew, view);
         GetMainSignals().BlockChecked(blockConnecting, state);
+        // The background chainstate leaves globalState at the tip of the active chainstate
+        if (GetRole() == ChainstateRole::BACKGROUND) { // odan
+            globalState->setRoot(oldHashStateRoot); // odan
+            globalState->setRootUTXO(oldHashUTXORoot); // odan
+        } // odan
         if (!rv) {
             if (state.IsInvalid())
                 InvalidBlockFound(pindexNew, state);
@@ -6626,6 +6947,14 @@ bool ChainstateManager::LoadBlockIndex()
         /////////////////////////////////////////////////////////////// // odan
         fAddressIndex = gArgs.GetBoolArg("-addrindex", DEFAULT_ADDRINDEX);
         m_blockman.m_block_tree_db->WriteFlag("addrindex", fAddressIndex);
+        m_blockman.m_block_tree_db->WriteFlag("addrweightindex", fAddressIndex);
+        fDelegationIndex = true;
+        m_blockman.m_block_tree_db->WriteFlag("delegationindex", fDelegationIndex);
+        const CBlock& genesis = GetParams().GenesisBlock();
+        m_blockman.m_block_tree_db->WriteDelegationIndexBest(CIndexBestBlock(genesis.GetHash(), genesis.hashStateRoot));
+        fTokenIndex = fLogEvents;
+        m_blockman.m_block_tree_db->WriteFlag("tokenindex", fTokenIndex);
+        m_blockman.m_block_tree_db->WriteTokenIndexBest(CIndexBestBlock(genesis.GetHash(), genesis.hashStateRoot));
         ///////////////////////////////////////////////////////////////
     }
     return true;
@@ -7404,6 +7733,10 @@ bool ChainstateManager::ActivateSnapshot(
     m_active_chainstate = m_snapshot_chainstate.get();
     m_blockman.m_snapshot_height = this->GetSnapshotBaseHeight();
 
+    // The contract state of the base block was loaded with the snapshot
+    globalState->setRoot(uintToh256(m_snapshot_chainstate->m_chain.Tip()->hashStateRoot)); // odan
+    globalState->setRootUTXO(uintToh256(m_snapshot_chainstate->m_chain.Tip()->hashUTXORoot)); // odan
+
     LogPrintf("[snapshot] successfully activated snapshot %s\n", base_blockhash.ToString());
     LogPrintf("[snapshot] (%.2f MB)\n",
         m_snapshot_chainstate->CoinsTip().DynamicMemoryUsage() / (1000 * 1000));
@@ -7816,16 +8149,34 @@ void ChainstateManager::MaybeRebalanceCaches()
     bool snapshot_usable = this->IsUsable(m_snapshot_chainstate.get());
     assert(ibd_usable || snapshot_usable);
 
+    // The coins tip cache matters most while the blocks are downloaded. After that the coins are
+    // flushed periodically, while the contract executions of the new blocks, the mempool simulations
+    // and the contract calls keep reading the state trie, so half of the coins tip cache goes to
+    // the trie node cache. The chainstates execute the contracts on the same state, so the trie
+    // node cache is not split between them.
+    int64_t total_coinstip_cache = m_total_coinstip_cache;
+    int64_t total_state_trie_cache = m_total_state_trie_cache;
+    if (!IsInitialBlockDownload()) {
+        total_state_trie_cache += total_coinstip_cache / 2;
+        total_coinstip_cache -= total_coinstip_cache / 2;
+    }
+
+    // Note: shrink caches first so that we don't inadvertently overwhelm available memory.
+    auto& trie_cache = dev::TrieNodeCache::instance();
+    if (size_t(total_state_trie_cache) < trie_cache.maxBytes()) {
+        trie_cache.setMaxBytes(total_state_trie_cache);
+    }
+
     if (ibd_usable && !snapshot_usable) {
         // Allocate everything to the IBD chainstate. This will always happen
         // when we are not using a snapshot.
-        m_ibd_chainstate->ResizeCoinsCaches(m_total_coinstip_cache, m_total_coinsdb_cache);
+        m_ibd_chainstate->ResizeCoinsCaches(total_coinstip_cache, m_total_coinsdb_cache);
     }
     else if (snapshot_usable && !ibd_usable) {
         // If background validation has completed and snapshot is our active chain...
         LogPrintf("[snapshot] allocating all cache to the snapshot chainstate\n");
         // Allocate everything to the snapshot chainstate.
-        m_snapshot_chainstate->ResizeCoinsCaches(m_total_coinstip_cache, m_total_coinsdb_cache);
+        m_snapshot_chainstate->ResizeCoinsCaches(total_coinstip_cache, m_total_coinsdb_cache);
     }
     else if (ibd_usable && snapshot_usable) {
         // If both chainstates exist, determine who needs more cache based on IBD status.
@@ -7833,16 +8184,18 @@ void ChainstateManager::MaybeRebalanceCaches()
         // Note: shrink caches first so that we don't inadvertently overwhelm available memory.
         if (IsInitialBlockDownload()) {
             m_ibd_chainstate->ResizeCoinsCaches(
-                m_total_coinstip_cache * 0.05, m_total_coinsdb_cache * 0.05);
+                total_coinstip_cache * 0.05, m_total_coinsdb_cache * 0.05);
             m_snapshot_chainstate->ResizeCoinsCaches(
-                m_total_coinstip_cache * 0.95, m_total_coinsdb_cache * 0.95);
+                total_coinstip_cache * 0.95, m_total_coinsdb_cache * 0.95);
         } else {
             m_snapshot_chainstate->ResizeCoinsCaches(
-                m_total_coinstip_cache * 0.05, m_total_coinsdb_cache * 0.05);
+                total_coinstip_cache * 0.05, m_total_coinsdb_cache * 0.05);
             m_ibd_chainstate->ResizeCoinsCaches(
-                m_total_coinstip_cache * 0.95, m_total_coinsdb_cache * 0.95);
+                total_coinstip_cache * 0.95, m_total_coinsdb_cache * 0.95);
         }
     }
+
+    trie_cache.setMaxBytes(total_state_trie_cache);
 }
 
 void ChainstateManager::ResetChainstates()
@@ -7867,6 +8220,7 @@ static ChainstateManager::Options&& Flatten(ChainstateManager::Options&& opts)
 
 ChainstateManager::ChainstateManager(const util::SignalInterrupt& interrupt, Options options, node::BlockManager::Options blockman_options)
     : m_script_check_queue{/*batch_size=*/128, options.worker_threads_num},
+      m_contract_exec_queue{/*batch_size=*/1, options.contract_exec_threads_num, /*thread_name=*/"contractch"},
       m_interrupt{interrupt},
       m_options{Flatten(std::move(options))},
       m_blockman{interrupt, std::move(blockman_options)}
@@ -8202,6 +8556,25 @@ CAmount GetTxGasFee(const CMutableTransaction& _tx, const CTxMemPool& mempool, C
     return nGasFee;
 }
 
+bool GetAddressBalance(uint256 addressHash, int type, CAddressWeightValue& value, node::BlockManager& blockman)
+{
+    value.SetNull();
+
+    if (!fAddressIndex)
+        return error("address index not enabled");
+
+    // No aggregate is stored for the addresses without activity
+    blockman.m_block_tree_db->ReadAddressWeightIndex(addressHash, type, value);
+
+    return true;
+}
+
+int GetAddressWeightCompactHeight(int nHeight, const Consensus::Params& params)
+{
+    // Keep the heights needed for the maturity of the unspent outputs, also after a reorganization
+    return std::max(nHeight - 2 * params.CoinbaseMaturity(nHeight + 1), 0);
+}
+
 bool GetAddressWeight(uint256 addressHash, int type, const std::map<COutPoint, uint32_t>& immatureStakes, int32_t nHeight, uint64_t& nWeight, node::BlockManager& blockman)
 {
     nWeight = 0;
@@ -8209,6 +8582,19 @@ bool GetAddressWeight(uint256 addressHash, int type, const std::map<COutPoint, u
     if (!fAddressIndex)
         return error("address index not enabled");
 
+    // Get the mature amount from the address aggregate, the immature stakes are
+    // the prevouts spent by the last blocks so they are not in the unspent outputs
+    const Consensus::Params& consensusParams = Params().GetConsensus();
+    CAddressWeightValue weightValue;
+    if (!GetAddressBalance(addressHash, type, weightValue, blockman))
+        return false;
+
+    CAmount amount = 0;
+    if (weightValue.GetAmount(nHeight + 1 - consensusParams.CoinbaseMaturity(nHeight + 1), amount)) {
+        nWeight = amount > 0 ? amount : 0;
+        return true;
+    }
+
     // Get address utxos
     std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > unspentOutputs;
     if (!GetAddressUnspent(addressHash, type, unspentOutputs, blockman)) {
@@ -8216,7 +8602,6 @@ bool GetAddressWeight(uint256 addressHash, int type, const std::map<COutPoint, u
     }
 
     // Add the utxos to the list if they are mature
-	const Consensus::Params& consensusParams = Params().GetConsensus();
     for (std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> >::const_iterator i=unspentOutputs.begin(); i!=unspentOutputs.end(); i++) {
 
         int nDepth = nHeight - i->second.blockHeight + 1;
@@ -41,6 +41,7 @@
 #include <string>
 #include <thread>
 #include <type_traits>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
@@ -54,18 +55,29 @@
 #include <libethashseal/GenesisInfo.h>
 #include <script/solver.h>
 #include <odan/storageresults.h>
+#include <odan/vmlog.h>
+#include <odan/stateprune.h>
+#include <odan/statesnapshot.h>
 
 
 extern std::unique_ptr<OdanState> globalState;
 extern std::shared_ptr<dev::eth::SealEngineFace> globalSealEngine;
 extern std::unique_ptr<StorageResults> pstorageresult;
+extern std::unique_ptr<VMLogWriter> pvmlogwriter;
+extern std::unique_ptr<OdanStatePruner> pstatepruner;
+extern std::unique_ptr<OdanStateSnapshot> pstatesnapshot;
+class MempoolSimulator;
+extern std::unique_ptr<MempoolSimulator> pmempoolsimulator;
+class ReceiptFeed;
+extern std::unique_ptr<ReceiptFeed> preceiptfeed;
 extern bool fRecordLogOpcodes;
-extern bool fIsVMlogFile;
 extern bool fGettingValuesDGP;
 
 struct EthTransactionParams;
 using valtype = std::vector<unsigned char>;
 using ExtractOdanTX = std::pair<std::vector<OdanTransaction>, std::vector<EthTransactionParams>>;
+/** The transactions of a block by hash, to find the outputs spent in the same block */
+using BlockTxMap = std::unordered_map<uint256, CTransactionRef, SaltedTxidHasher>;
 ///////////////////////////////////////////
 
 class Chainstate;
@@ -134,6 +146,9 @@ extern std::condition_variable g_best_block_cv;
 /** Used to notify getblocktemplate RPC of new tips. */
 extern uint256 g_best_block;
 extern bool fAddressIndex;
+/** Whether the delegations are read from the delegation index instead of the delegation contract */
+extern bool fDelegationIndex;
+extern bool fTokenIndex;
 extern bool fLogEvents;
 
 /** Documentation for argument 'checklevel'. */
@@ -423,6 +438,33 @@ static_assert(std::is_nothrow_move_assignable_v<CScriptCheck>);
 static_assert(std::is_nothrow_move_constructible_v<CScriptCheck>);
 static_assert(std::is_nothrow_destructible_v<CScriptCheck>);
 
+///////////////////////////////////////////////////////////////// // odan
+struct ContractExecJob;
+class ParallelContractExec;
+
+/**
+ * Closure representing the speculative execution of the contract outputs of one transaction
+ * @see ParallelContractExec
+ */
+class CContractExecCheck
+{
+private:
+    const ParallelContractExec* exec;
+    ContractExecJob* job;
+
+public:
+    CContractExecCheck(const ParallelContractExec& execIn, ContractExecJob& jobIn) :
+        exec(&execIn), job(&jobIn) { }
+
+    CContractExecCheck(const CContractExecCheck&) = delete;
+    CContractExecCheck& operator=(const CContractExecCheck&) = delete;
+    CContractExecCheck(CContractExecCheck&&) = default;
+    CContractExecCheck& operator=(CContractExecCheck&&) = default;
+
+    bool operator()();
+};
+/////////////////////////////////////////////////////////////////
+
 /** Initializes the script-execution cache */
 [[nodiscard]] bool InitScriptExecutionCache(size_t max_size_bytes);
 
@@ -438,6 +480,11 @@ bool GetAddressUnspent(uint256 addressHash, int type,
 
 bool GetTimestampIndex(const unsigned int &high, const unsigned int &low, const bool fActiveOnly, std::vector<std::pair<uint256, unsigned int> > &hashes, ChainstateManager& chainman);
 
+bool GetAddressBalance(uint256 addressHash, int type, CAddressWeightValue& value, node::BlockManager& blockman);
+
+/** Unspent outputs below this height are merged in the address weight index after connecting the block at nHeight */
+int GetAddressWeightCompactHeight(int nHeight, const Consensus::Params& params);
+
 bool GetAddressWeight(uint256 addressHash, int type, const std::map<COutPoint, uint32_t>& immatureStakes, int32_t nHeight, uint64_t& nWeight, node::BlockManager& blockman);
 
 std::map<COutPoint, uint32_t> GetImmatureStakes(ChainstateManager& chainman);
@@ -506,7 +553,7 @@ bool GetSpentCoinFromMainChain(const CBlockIndex* pforkPrev, COutPoint prevoutSt
 
 unsigned int GetContractScriptFlags(int nHeight, const Consensus::Params& consensusparams);
 
-std::vector<ResultExecute> CallContract(const dev::Address& addrContract, std::vector<unsigned char> opcode, Chainstate& chainstate, const dev::Address& sender = dev::Address(), uint64_t gasLimit=0, CAmount nAmount=0);
+std::vector<ResultExecute> CallContract(const dev::Address& addrContract, std::vector<unsigned char> opcode, Chainstate& chainstate, const dev::Address& sender = dev::Address(), uint64_t gasLimit=0, CAmount nAmount=0, bool* blockContextRead=nullptr);
 
 bool CheckOpSender(const CTransaction& tx, const CChainParams& chainparams, int nHeight);
 
@@ -545,10 +592,16 @@ class OdanTxConverter{
 
 public:
 
-    OdanTxConverter(CTransaction tx, Chainstate& _chainstate, const CTxMemPool* _mempool, CCoinsViewCache* v = NULL, const std::vector<CTransactionRef>* blockTxs = NULL, unsigned int flags = SCRIPT_EXEC_BYTE_CODE) : txBit(tx), view(v), blockTransactions(blockTxs), sender(false), nFlags(flags), chainstate(_chainstate), mempool(_mempool){}
+    OdanTxConverter(CTransaction tx, Chainstate& _chainstate, const CTxMemPool* _mempool, CCoinsViewCache* v = NULL, const BlockTxMap* blockTxs = NULL, unsigned int flags = SCRIPT_EXEC_BYTE_CODE, const valtype* _inputSender = NULL) : txBit(tx), view(v), blockTransactions(blockTxs), sender(false), nFlags(flags), chainstate(_chainstate), mempool(_mempool){
+        if(_inputSender)
+            inputSender = *_inputSender;
+    }
 
     bool extractionOdanTransactions(ExtractOdanTX& odanTx);
 
+    /** The owner of the output spent by vin[0], resolved by extractionOdanTransactions when it was not given */
+    const std::optional<valtype>& getInputSender() const { return inputSender; }
+
 private:
 
     bool receiveStack(const CScript& scriptPubKey);
@@ -563,8 +616,9 @@ private:
     const CCoinsViewCache* view;
     std::vector<valtype> stack;
     opcodetype opcode;
-    const std::vector<CTransactionRef> *blockTransactions;
+    const BlockTxMap *blockTransactions;
     bool sender;
+    std::optional<valtype> inputSender;
     dev::Address refundSender;
     unsigned int nFlags;
     Chainstate& chainstate;
@@ -598,12 +652,28 @@ public:
 
     std::vector<ResultExecute>& getResult(){ return result; }
 
-private:
+    // Whether a contract read the time or the author of the block, the results are only valid for them
+    bool readBlockContext() const { return blockContextRead; }
+
+    // Merge the block context flag of outputs executed outside of performByteCode
+    void addBlockContextRead(bool _read) { blockContextRead |= _read; }
+
+    // Execute on a private copy of the state with its own seal engine instead of globalState,
+    // pindex is then used as the tip so no cs_main is needed
+    void setPrivateState(OdanState* _state, dev::eth::SealEngineFace* _sealEngine) { state = _state; sealEngine = _sealEngine; }
 
     dev::eth::EnvInfo BuildEVMEnvironment();
 
+private:
+
     dev::Address EthAddrFromScript(const CScript& scriptIn);
 
+    OdanState& execState() { return state ? *state : *globalState; }
+
+    dev::eth::SealEngineFace& execSealEngine() { return sealEngine ? *sealEngine : *globalSealEngine; }
+
+    int chainHeight() const { return state ? pindex->nHeight : chain.Height(); }
+
     std::vector<OdanTransaction> txs;
 
     std::vector<ResultExecute> result;
@@ -617,6 +687,12 @@ private:
     LastHashes lastHashes;
 
     CChain& chain;
+
+    bool blockContextRead = false;
+
+    OdanState* state = nullptr;
+
+    dev::eth::SealEngineFace* sealEngine = nullptr;
 };
 
 enum DisconnectResult
@@ -628,6 +704,42 @@ enum DisconnectResult
 
 class ConnectTrace;
 
+/**
+ * Coins spent by the last connected blocks of a chainstate.
+ *
+ * Used by the stake checks of fork blocks, which need the coins spent on the main chain
+ * after the fork, without reading the blocks and their undo data from disk.
+ */
+class RecentSpentCoins
+{
+public:
+    /** Add the coins spent by a connected block, the blocks nDepth or more below it are removed */
+    void ConnectBlock(const CBlock& block, const CBlockUndo& blockundo, const CBlockIndex* pindex, int nDepth) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+    void DisconnectBlock(const CBlockIndex* pindex) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+    /**
+     * Find the coin spent by prevout in the blocks after pforkBase up to pindexTip.
+     * nFirstHeight is set to the lowest height searched, the blocks below it have to be read from disk.
+     */
+    bool Find(const CBlockIndex* pindexTip, const CBlockIndex* pforkBase, const COutPoint& prevout, Coin* coin, int& nFirstHeight) const EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+    void Clear() EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+private:
+    struct SpentCoin {
+        int nHeight;
+        Coin coin;
+    };
+
+    mutable Mutex m_mutex;
+
+    std::unordered_map<COutPoint, SpentCoin, SaltedOutpointHasher> m_coins GUARDED_BY(m_mutex);
+
+    /** Hash and spent outpoints of the blocks in the index, by height */
+    std::map<int, std::pair<uint256, std::vector<COutPoint>>> m_blocks GUARDED_BY(m_mutex);
+};
+
 /** @see Chainstate::FlushStateToDisk */
 enum class FlushStateMode {
     NONE,
@@ -728,6 +840,9 @@ protected:
     const CBlockIndex* m_cached_snapshot_base GUARDED_BY(::cs_main) {nullptr};
 
 public:
+    //! Coins spent by the last blocks of m_chain, for the stake checks of fork blocks
+    RecentSpentCoins m_recent_spent_coins;
+
     //! Reference to a BlockManager instance which itself is shared across all
     //! Chainstate instances.
     node::BlockManager& m_blockman;
@@ -1131,6 +1246,9 @@ private:
     //! A queue for script verifications that have to be performed by worker threads.
     CCheckQueue<CScriptCheck> m_script_check_queue;
 
+    //! A queue for contract transactions executed speculatively by worker threads. // odan
+    CCheckQueue<CContractExecCheck> m_contract_exec_queue;
+
 public:
     using Options = kernel::ChainstateManagerOpts;
 
@@ -1235,6 +1353,10 @@ public:
     //! The total number of bytes available for us to use across all leveldb
     //! coins databases. This will be split somehow across chainstates.
     int64_t m_total_coinsdb_cache{0};
+    //
+    //! The number of bytes of the contract state trie node cache, shared by
+    //! all chainstates since they execute the contracts on the same state.
+    int64_t m_total_state_trie_cache{0};
 
     //! Instantiate a new chainstate.
     //!
@@ -1483,6 +1605,8 @@ public:
 
     CCheckQueue<CScriptCheck>& GetCheckQueue() { return m_script_check_queue; }
 
+    CCheckQueue<CContractExecCheck>& GetContractExecQueue() { return m_contract_exec_queue; } // odan
+
     ~ChainstateManager();
 };
 
@@ -11,6 +11,7 @@
 #include <kernel/chain.h>
 #include <kernel/mempool_entry.h>
 #include <logging.h>
+#include <odan/odandelegation.h>
 #include <primitives/block.h>
 #include <primitives/transaction.h>
 #include <scheduler.h>
@@ -255,6 +256,16 @@ void CMainSignals::BlockDisconnected(const std::shared_ptr<const CBlock>& pblock
                           pindex->nHeight);
 }
 
+void CMainSignals::DelegationEvents(const std::vector<DelegationEvent>& events, int nHeight)
+{
+    auto event = [events, nHeight, this] {
+        m_internals->Iterate([&](CValidationInterface& callbacks) { callbacks.DelegationEvents(events, nHeight); });
+    };
+    ENQUEUE_AND_LOG_EVENT(event, "%s: events=%u block height=%d", __func__,
+                          events.size(),
+                          nHeight);
+}
+
 void CMainSignals::ChainStateFlushed(ChainstateRole role, const CBlockLocator &locator) {
     auto event = [role, locator, this] {
         m_internals->Iterate([&](CValidationInterface& callbacks) { callbacks.ChainStateFlushed(role, locator); });
@@ -13,6 +13,7 @@
 
 #include <functional>
 #include <memory>
+#include <vector>
 
 class BlockValidationState;
 class CBlock;
@@ -22,6 +23,7 @@ class CValidationInterface;
 class CScheduler;
 enum class MemPoolRemovalReason;
 struct RemovedMempoolTransactionInfo;
+struct DelegationEvent;
 struct NewMempoolTransactionInfo;
 
 /** Register subscriber */
@@ -156,6 +158,15 @@ protected:
      * background chainstates should never disconnect blocks.
      */
     virtual void BlockDisconnected(const std::shared_ptr<const CBlock> &block, const CBlockIndex* pindex) {}
+    /**
+     * Notifies listeners of the delegation contract events of a connected block.
+     * For a disconnected block, the events restore the delegations from before the block,
+     * so applying the events in order follows the delegations of the active chain.
+     * Only sent while the delegation index is enabled.
+     *
+     * Called on a background thread.
+     */
+    virtual void DelegationEvents(const std::vector<DelegationEvent>& events, int nHeight) {}
     /**
      * Notifies listeners of the new active block chain on-disk.
      *
@@ -216,6 +227,7 @@ public:
     void MempoolTransactionsRemovedForBlock(const std::vector<RemovedMempoolTransactionInfo>&, unsigned int nBlockHeight);
     void BlockConnected(ChainstateRole, const std::shared_ptr<const CBlock> &, const CBlockIndex *pindex);
     void BlockDisconnected(const std::shared_ptr<const CBlock> &, const CBlockIndex* pindex);
+    void DelegationEvents(const std::vector<DelegationEvent>&, int nHeight);
     void ChainStateFlushed(ChainstateRole, const CBlockLocator &);
     void BlockChecked(const CBlock&, const BlockValidationState&);
     void NewPoWValidBlock(const CBlockIndex *, const std::shared_ptr<const CBlock>&);
@@ -41,7 +41,9 @@ std::list<const CZMQAbstractNotifier*> CZMQNotificationInterface::GetActiveNotif
     return result;
 }
 
-std::unique_ptr<CZMQNotificationInterface> CZMQNotificationInterface::Create(std::function<bool(CBlock&, const CBlockIndex&)> get_block_by_index)
+std::unique_ptr<CZMQNotificationInterface> CZMQNotificationInterface::Create(std::function<bool(CBlock&, const CBlockIndex&)> get_block_by_index,
+                                                                             BlockMessagesFn get_receipts,
+                                                                             BlockMessagesFn get_contract_logs)
 {
     std::map<std::string, CZMQNotifierFactory> factories;
     factories["pubhashblock"] = CZMQAbstractNotifier::Create<CZMQPublishHashBlockNotifier>;
@@ -51,6 +53,16 @@ std::unique_ptr<CZMQNotificationInterface> CZMQNotificationInterface::Create(std
     };
     factories["pubrawtx"] = CZMQAbstractNotifier::Create<CZMQPublishRawTransactionNotifier>;
     factories["pubsequence"] = CZMQAbstractNotifier::Create<CZMQPublishSequenceNotifier>;
+    if (get_receipts) {
+        factories["pubreceipt"] = [&get_receipts]() -> std::unique_ptr<CZMQAbstractNotifier> {
+            return std::make_unique<CZMQPublishBlockMessagesNotifier>("receipt", get_receipts);
+        };
+    }
+    if (get_contract_logs) {
+        factories["pubcontractlog"] = [&get_contract_logs]() -> std::unique_ptr<CZMQAbstractNotifier> {
+            return std::make_unique<CZMQPublishBlockMessagesNotifier>("contractlog", get_contract_logs);
+        };
+    }
 
     std::list<std::unique_ptr<CZMQAbstractNotifier>> notifiers;
     for (const auto& entry : factories)
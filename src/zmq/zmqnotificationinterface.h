@@ -12,10 +12,14 @@
 #include <functional>
 #include <list>
 #include <memory>
+#include <string>
+#include <utility>
+#include <vector>
 
 class CBlock;
 class CBlockIndex;
 class CZMQAbstractNotifier;
+class uint256;
 struct NewMempoolTransactionInfo;
 
 class CZMQNotificationInterface final : public CValidationInterface
@@ -25,7 +29,11 @@ public:
 
     std::list<const CZMQAbstractNotifier*> GetActiveNotifiers() const;
 
-    static std::unique_ptr<CZMQNotificationInterface> Create(std::function<bool(CBlock&, const CBlockIndex&)> get_block_by_index);
+    using BlockMessagesFn = std::function<std::vector<std::pair<std::string, std::string>>(const uint256&, bool)>;
+
+    static std::unique_ptr<CZMQNotificationInterface> Create(std::function<bool(CBlock&, const CBlockIndex&)> get_block_by_index,
+                                                             BlockMessagesFn get_receipts = nullptr,
+                                                             BlockMessagesFn get_contract_logs = nullptr);
 
 protected:
     bool Initialize();
@@ -201,13 +201,18 @@ void CZMQAbstractPublishNotifier::Shutdown()
 }
 
 bool CZMQAbstractPublishNotifier::SendZmqMessage(const char *command, const void* data, size_t size)
+{
+    return SendZmqMessage(std::string{command}, data, size);
+}
+
+bool CZMQAbstractPublishNotifier::SendZmqMessage(const std::string& command, const void* data, size_t size)
 {
     assert(psocket);
 
     /* send three parts, command & data & a LE 4byte sequence number */
     unsigned char msgseq[sizeof(uint32_t)];
     WriteLE32(msgseq, nSequence);
-    int rc = zmq_send_multipart(psocket, command, strlen(command), data, size, msgseq, (size_t)sizeof(uint32_t), nullptr);
+    int rc = zmq_send_multipart(psocket, command.data(), command.size(), data, size, msgseq, (size_t)sizeof(uint32_t), nullptr);
     if (rc == -1)
         return false;
 
@@ -304,3 +309,25 @@ bool CZMQPublishSequenceNotifier::NotifyTransactionRemoval(const CTransaction &t
     LogPrint(BCLog::ZMQ, "Publish hashtx mempool removal %s to %s\n", hash.GetHex(), this->address);
     return SendSequenceMsg(*this, hash, /* Mempool (R)emoval */ 'R', mempool_sequence);
 }
+
+bool CZMQPublishBlockMessagesNotifier::SendBlockMessages(const CBlockIndex *pindex, bool connected)
+{
+    uint256 hash = pindex->GetBlockHash();
+    LogPrint(BCLog::ZMQ, "Publish %s block %s %s to %s\n", m_command, connected ? "connect" : "disconnect", hash.GetHex(), this->address);
+    for (const auto& [subtopic, message] : m_get_block_messages(hash, connected)) {
+        if (!SendZmqMessage(m_command + subtopic, message.data(), message.size())) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool CZMQPublishBlockMessagesNotifier::NotifyBlockConnect(const CBlockIndex *pindex)
+{
+    return SendBlockMessages(pindex, true);
+}
+
+bool CZMQPublishBlockMessagesNotifier::NotifyBlockDisconnect(const CBlockIndex *pindex)
+{
+    return SendBlockMessages(pindex, false);
+}
@@ -10,10 +10,18 @@
 #include <cstddef>
 #include <cstdint>
 #include <functional>
+#include <string>
+#include <utility>
+#include <vector>
 
 class CBlock;
 class CBlockIndex;
 class CTransaction;
+class uint256;
+
+/** The messages of a connected or disconnected block, with the subtopic appended to the command */
+using CZMQBlockMessages = std::vector<std::pair<std::string, std::string>>;
+using CZMQGetBlockMessages = std::function<CZMQBlockMessages(const uint256&, bool)>;
 
 class CZMQAbstractPublishNotifier : public CZMQAbstractNotifier
 {
@@ -29,6 +37,7 @@ public:
           * message sequence number
     */
     bool SendZmqMessage(const char *command, const void* data, size_t size);
+    bool SendZmqMessage(const std::string& command, const void* data, size_t size);
 
     bool Initialize(void *pcontext) override;
     void Shutdown() override;
@@ -63,6 +72,21 @@ public:
     bool NotifyTransaction(const CTransaction &transaction) override;
 };
 
+class CZMQPublishBlockMessagesNotifier : public CZMQAbstractPublishNotifier
+{
+private:
+    const char* m_command;
+    const CZMQGetBlockMessages m_get_block_messages;
+
+    bool SendBlockMessages(const CBlockIndex *pindex, bool connected);
+
+public:
+    CZMQPublishBlockMessagesNotifier(const char* command, CZMQGetBlockMessages get_block_messages)
+        : m_command{command}, m_get_block_messages{std::move(get_block_messages)} {}
+    bool NotifyBlockConnect(const CBlockIndex *pindex) override;
+    bool NotifyBlockDisconnect(const CBlockIndex *pindex) override;
+};
+
 class CZMQPublishSequenceNotifier : public CZMQAbstractPublishNotifier
 {
 public: